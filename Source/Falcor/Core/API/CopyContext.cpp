@@ -137,9 +137,13 @@ void CopyContext::waitForFalcor(cudaStream_t stream)
 }
 #endif
 
-CopyContext::ReadTextureTask::SharedPtr CopyContext::asyncReadTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex)
+CopyContext::ReadTextureTask::SharedPtr CopyContext::asyncReadTextureSubresource(
+    const Texture* pTexture,
+    uint32_t subresourceIndex,
+    ref<Buffer> pStagingBuffer
+)
 {
-    return CopyContext::ReadTextureTask::create(this, pTexture, subresourceIndex);
+    return CopyContext::ReadTextureTask::create(this, pTexture, subresourceIndex, std::move(pStagingBuffer));
 }
 
 std::vector<uint8_t> CopyContext::readTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex)
@@ -320,7 +324,8 @@ void CopyContext::updateTextureSubresources(
 CopyContext::ReadTextureTask::SharedPtr CopyContext::ReadTextureTask::create(
     CopyContext* pCtx,
     const Texture* pTexture,
-    uint32_t subresourceIndex
+    uint32_t subresourceIndex,
+    ref<Buffer> pStagingBuffer
 )
 {
     SharedPtr pThis = SharedPtr(new ReadTextureTask);
@@ -339,8 +344,11 @@ CopyContext::ReadTextureTask::SharedPtr CopyContext::ReadTextureTask::create(
     uint64_t rowCount = (pTexture->getHeight(mipLevel) + formatInfo.blockHeight - 1) / formatInfo.blockHeight;
     uint64_t size = pTexture->getDepth(mipLevel) * rowCount * pThis->mRowSize;
 
-    // Create buffer
-    pThis->mpBuffer = pCtx->getDevice()->createBuffer(size, ResourceBindFlags::None, MemoryType::ReadBack, nullptr);
+    // Reuse the staging buffer if it fits, otherwise create one
+    if (pStagingBuffer && pStagingBuffer->getMemoryType() == MemoryType::ReadBack && pStagingBuffer->getSize() >= size)
+        pThis->mpBuffer = std::move(pStagingBuffer);
+    else
+        pThis->mpBuffer = pCtx->getDevice()->createBuffer(size, ResourceBindFlags::None, MemoryType::ReadBack, nullptr);
 
     // Copy from texture to buffer
     pCtx->resourceBarrier(pTexture, Resource::State::CopySource);
@@ -400,6 +408,11 @@ void CopyContext::ReadTextureTask::getData(void* pData, size_t size) const
     mpBuffer->unmap();
 }
 
+bool CopyContext::ReadTextureTask::isReady() const
+{
+    return mpFence->getCurrentValue() >= mpFence->getSignaledValue();
+}
+
 std::vector<uint8_t> CopyContext::ReadTextureTask::getData() const
 {
     std::vector<uint8_t> result(size_t(mRowCount) * mActualRowSize * mDepth);
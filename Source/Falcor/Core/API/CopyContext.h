@@ -53,9 +53,13 @@ public:
     {
     public:
         using SharedPtr = std::shared_ptr<ReadTextureTask>;
-        static SharedPtr create(CopyContext* pCtx, const Texture* pTexture, uint32_t subresourceIndex);
+        static SharedPtr create(CopyContext* pCtx, const Texture* pTexture, uint32_t subresourceIndex, ref<Buffer> pStagingBuffer = nullptr);
         void getData(void* pData, size_t size) const;
         std::vector<uint8_t> getData() const;
+        /// Check if the readback has completed. getData() does not block once this returns true.
+        bool isReady() const;
+        /// Get the readback buffer. It can be passed to a later readback once getData() returned.
+        const ref<Buffer>& getBuffer() const { return mpBuffer; }
 
     private:
         ReadTextureTask() = default;
@@ -221,8 +225,13 @@ public:
 
     /**
      * Read texture data Asynchronously
+     * @param[in] pStagingBuffer Optional readback buffer to copy into. It is used if it is large enough, otherwise a new buffer is created.
      */
-    ReadTextureTask::SharedPtr asyncReadTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex);
+    ReadTextureTask::SharedPtr asyncReadTextureSubresource(
+        const Texture* pTexture,
+        uint32_t subresourceIndex,
+        ref<Buffer> pStagingBuffer = nullptr
+    );
 
     /**
      * Get the low-level context data
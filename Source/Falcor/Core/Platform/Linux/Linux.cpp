@@ -33,6 +33,7 @@
 
 #include <gtk/gtk.h>
 
+#include <cstdio>
 #include <iostream>
 #include <unistd.h>
 #include <signal.h>
@@ -579,8 +580,15 @@ void OSServices::stop() {}
 
 size_t getCurrentRSS()
 {
-    FALCOR_UNIMPLEMENTED();
-    return 0;
+    // The second field of /proc/self/statm is the resident set size in pages.
+    long pages = 0;
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (!file)
+        return 0;
+    if (fscanf(file, "%*s%ld", &pages) != 1)
+        pages = 0;
+    fclose(file);
+    return (size_t)pages * (size_t)sysconf(_SC_PAGESIZE);
 }
 
 size_t getPeakRSS()
@@ -27,6 +27,7 @@
  **************************************************************************/
 #include "MemoryMappedFile.h"
 
+#include <algorithm>
 #include <stdexcept>
 #include <cstdio>
 
@@ -183,6 +184,15 @@ size_t MemoryMappedFile::getPageSize()
 #endif
 }
 
+void MemoryMappedFile::touchPages(const void* data, size_t size)
+{
+    const volatile uint8_t* p = static_cast<const volatile uint8_t*>(data);
+    // getPageSize() returns the allocation granularity on Windows, which spans several pages.
+    const size_t stride = std::min<size_t>(getPageSize(), 4096);
+    for (size_t i = 0; i < size; i += stride)
+        (void)p[i];
+}
+
 bool MemoryMappedFile::remap(uint64_t offset, size_t mappedSize)
 {
     if (!mFile)
@@ -95,6 +95,9 @@ public:
     /// Get the OS page size (for remap).
     static size_t getPageSize();
 
+    /// Read one byte of every page in a range of mapped memory, which pages in the range if it is not resident yet.
+    static void touchPages(const void* data, size_t size);
+
 private:
     MemoryMappedFile(const MemoryMappedFile&) = delete;
     MemoryMappedFile(MemoryMappedFile&) = delete;
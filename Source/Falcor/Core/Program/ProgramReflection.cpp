@@ -34,6 +34,7 @@
 
 #include <slang.h>
 
+#include <algorithm>
 #include <map>
 
 using namespace slang;
@@ -1636,9 +1637,9 @@ int32_t ReflectionStructType::addMemberIgnoringNameConflicts(
 
 int32_t ReflectionStructType::addMember(const ref<const ReflectionVar>& pVar, ReflectionStructType::BuildState& ioBuildState)
 {
-    if (mNameToIndex.find(pVar->getName()) != mNameToIndex.end())
+    int32_t index = getMemberIndex(pVar->getName());
+    if (index != kInvalidMemberIndex)
     {
-        int32_t index = mNameToIndex[pVar->getName()];
         if (*pVar != *mMembers[index])
         {
             FALCOR_THROW(
@@ -1650,10 +1651,34 @@ int32_t ReflectionStructType::addMember(const ref<const ReflectionVar>& pVar, Re
         return -1;
     }
     auto memberIndex = addMemberIgnoringNameConflicts(pVar, ioBuildState);
-    mNameToIndex[pVar->getName()] = memberIndex;
+    insertMemberName(pVar->getName(), memberIndex);
     return memberIndex;
 }
 
+void ReflectionStructType::insertMemberName(std::string_view name, int32_t memberIndex)
+{
+    // Keep the table at most half full so that lookups stay short and always reach an empty slot.
+    if ((mNameCount + 1) * 2 > mNameTable.size())
+    {
+        std::vector<NameSlot> oldTable = std::move(mNameTable);
+        mNameTable.assign(std::max<size_t>(oldTable.size() * 2, 8), NameSlot{});
+        mNameCount = 0;
+        for (const NameSlot& slot : oldTable)
+        {
+            if (slot.memberIndex != kInvalidMemberIndex)
+                insertMemberName(mMembers[slot.memberIndex]->getName(), slot.memberIndex);
+        }
+    }
+
+    const size_t hash = std::hash<std::string_view>()(name);
+    const size_t mask = mNameTable.size() - 1;
+    size_t slot = hash & mask;
+    while (mNameTable[slot].memberIndex != kInvalidMemberIndex)
+        slot = (slot + 1) & mask;
+    mNameTable[slot] = NameSlot{hash, memberIndex};
+    mNameCount++;
+}
+
 ref<ReflectionVar> ReflectionVar::create(
     const std::string& name,
     const ref<const ReflectionType>& pType,
@@ -2095,10 +2120,19 @@ ref<const ReflectionVar> ReflectionType::findMember(std::string_view name) const
 
 int32_t ReflectionStructType::getMemberIndex(std::string_view name) const
 {
-    auto it = mNameToIndex.find(name);
-    if (it == mNameToIndex.end())
+    if (mNameTable.empty())
         return kInvalidMemberIndex;
-    return it->second;
+
+    const size_t hash = std::hash<std::string_view>()(name);
+    const size_t mask = mNameTable.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask)
+    {
+        const NameSlot& entry = mNameTable[slot];
+        if (entry.memberIndex == kInvalidMemberIndex)
+            return kInvalidMemberIndex;
+        if (entry.hash == hash && mMembers[entry.memberIndex]->getName() == name)
+            return entry.memberIndex;
+    }
 }
 
 const ref<const ReflectionVar>& ReflectionStructType::getMember(std::string_view name) const
@@ -912,8 +912,20 @@ public:
 
 private:
     ReflectionStructType(size_t size, const std::string& name, slang::TypeLayoutReflection* pSlangTypeLayout);
-    std::vector<ref<const ReflectionVar>> mMembers;           // Struct members
-    std::map<std::string, int32_t, std::less<>> mNameToIndex; // Translates from a name to an index in mMembers
+    void insertMemberName(std::string_view name, int32_t memberIndex);
+
+    /**
+     * Slot of the open addressing hash table that translates from a name to an index in mMembers.
+     */
+    struct NameSlot
+    {
+        size_t hash = 0;
+        int32_t memberIndex = kInvalidMemberIndex;
+    };
+
+    std::vector<ref<const ReflectionVar>> mMembers; // Struct members
+    std::vector<NameSlot> mNameTable;              // Power of two size, at most half full. Probed linearly.
+    size_t mNameCount = 0;                          // Names in mNameTable.
     std::string mName;
 };
 
@@ -28,6 +28,7 @@
 #include "ShaderVar.h"
 #include "Core/API/ParameterBlock.h"
 #include "Utils/Scripting/ScriptBindings.h"
+#include <charconv>
 
 namespace Falcor
 {
@@ -100,6 +101,11 @@ ShaderVar ShaderVar::operator[](size_t index) const
     FALCOR_THROW("No element or member found at index {}", index);
 }
 
+ShaderVar ShaderVar::operator[](const ShaderVarPath& path) const
+{
+    return path.resolve(*this);
+}
+
 ShaderVar ShaderVar::findMember(std::string_view name) const
 {
     if (!isValid())
@@ -396,6 +402,76 @@ void ShaderVar::setImpl(const ref<ParameterBlock>& pBlock) const
     mpBlock->setParameterBlock(mOffset, pBlock);
 }
 
+//
+// ShaderVarPath
+//
+
+ShaderVarPath::ShaderVarPath(std::string_view path) : mPath(path)
+{
+    size_t pos = 0;
+    while (pos < path.size())
+    {
+        Segment segment;
+        if (path[pos] == '[')
+        {
+            const size_t end = path.find(']', pos);
+            FALCOR_CHECK(end != std::string_view::npos, "Missing ']' in shader var path '{}'.", path);
+            const char* first = path.data() + pos + 1;
+            const char* last = path.data() + end;
+            auto [ptr, ec] = std::from_chars(first, last, segment.index);
+            FALCOR_CHECK(first != last && ec == std::errc() && ptr == last, "Invalid array index in shader var path '{}'.", path);
+            pos = end + 1;
+        }
+        else
+        {
+            if (path[pos] == '.' && !mSegments.empty())
+                pos++;
+            const size_t end = std::min(path.find_first_of(".[", pos), path.size());
+            FALCOR_CHECK(end > pos, "Empty member name in shader var path '{}'.", path);
+            segment.name = path.substr(pos, end - pos);
+            pos = end;
+        }
+        mSegments.push_back(std::move(segment));
+    }
+    FALCOR_CHECK(!mSegments.empty(), "Shader var path is empty.");
+}
+
+ShaderVar ShaderVarPath::resolve(const ShaderVar& root) const
+{
+    FALCOR_CHECK(root.isValid(), "Cannot resolve '{}' on invalid ShaderVar.", mPath);
+    if (root.getType() != mpRootType.get() || !(root.mOffset == mRootOffset))
+        build(root);
+
+    // Only the constant buffers/parameter blocks along the path are looked up, the offsets in them are cached.
+    ShaderVar var(root.mpBlock, mBlockOffsets[0]);
+    for (size_t i = 1; i < mBlockOffsets.size(); i++)
+        var = ShaderVar(var.getParameterBlock().get(), mBlockOffsets[i]);
+    return var;
+}
+
+void ShaderVarPath::build(const ShaderVar& root) const
+{
+    mpRootType = nullptr;
+    mBlockOffsets.clear();
+
+    // Same lookups as ShaderVar::operator[], but the implicit dereference of constant buffers is done here to record the offsets.
+    ShaderVar var = root;
+    for (const Segment& segment : mSegments)
+    {
+        const ReflectionResourceType* pResourceType = var.getType()->asResourceType();
+        if (pResourceType && pResourceType->getType() == ReflectionResourceType::Type::ConstantBuffer)
+        {
+            mBlockOffsets.push_back(var.mOffset);
+            var = var.getParameterBlock()->getRootVar();
+        }
+        var = segment.name.empty() ? var[segment.index] : var[segment.name];
+    }
+    mBlockOffsets.push_back(var.mOffset);
+
+    mpRootType = ref<const ReflectionType>(root.getType());
+    mRootOffset = root.mOffset;
+}
+
 FALCOR_SCRIPT_BINDING(ShaderVar)
 {
     FALCOR_SCRIPT_BINDING_DEPENDENCY(Buffer)
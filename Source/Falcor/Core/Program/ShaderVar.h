@@ -35,12 +35,15 @@
 #include "Core/API/RtAccelerationStructure.h"
 #include "Utils/Math/Vector.h"
 #include <memory>
+#include <string>
 #include <string_view>
+#include <vector>
 #include <cstddef>
 
 namespace Falcor
 {
 class ParameterBlock;
+class ShaderVarPath;
 
 /**
  * A "pointer" to a shader variable stored in some parameter block.
@@ -156,6 +159,16 @@ struct FALCOR_API ShaderVar
      */
     ShaderVar operator[](size_t index) const;
 
+    /**
+     * Get a shader variable pointer by a pre-parsed binding path.
+     *
+     * Same as applying `operator[]` for each part of the path, but the
+     * member lookups are cached in `path`, see `ShaderVarPath`.
+     *
+     * If a part of the path doesn't exist, an exception is thrown.
+     */
+    ShaderVar operator[](const ShaderVarPath& path) const;
+
     /**
      * Try to get a variable for a member/field.
      *
@@ -440,6 +453,8 @@ struct FALCOR_API ShaderVar
     void const* getRawData() const;
 
 private:
+    friend class ShaderVarPath;
+
     /**
      * The parameter block that is being pointed into.
      *
@@ -466,6 +481,65 @@ private:
     template<typename T>
     void setImpl(const T& val) const;
 };
+
+/**
+ * A binding path that is parsed once and resolves to cached offsets.
+ *
+ * A path consists of member names separated by '.' and array indices in brackets,
+ * e.g. "PerFrame.gFrameCount" or "gPhotonInfo[1]". Applying it to a `ShaderVar`
+ * gives the same result as the equivalent chain of `operator[]` calls:
+ *
+ * ShaderVarPath kFrameCount("PerFrame.gFrameCount");
+ * var[kFrameCount] = frameCount; // same as var["PerFrame"]["gFrameCount"] = frameCount
+ *
+ * The first time the path is applied, the members are looked up by name and the resulting
+ * offset in each parameter block along the path is cached for the type and offset of the root
+ * variable. Later applications only fetch the constant buffers/parameter blocks along the path.
+ * When the path is applied to a root variable of another type, e.g. the root variable of program
+ * vars created for a new program version, it is resolved by name again.
+ *
+ * The cache is not synchronized, a path must not be applied from several threads at the same time.
+ * Paths are meant to be kept next to the program vars they are applied to, e.g. as members of a render pass.
+ */
+class FALCOR_API ShaderVarPath
+{
+public:
+    /**
+     * Parse a binding path. Throws an exception if the path is malformed.
+     */
+    explicit ShaderVarPath(std::string_view path);
+
+    /**
+     * Get the path as passed to the constructor.
+     */
+    const std::string& getPath() const { return mPath; }
+
+    /**
+     * Resolve the path relative to `root`.
+     * Throws an exception if a part of the path doesn't exist.
+     */
+    ShaderVar resolve(const ShaderVar& root) const;
+
+private:
+    struct Segment
+    {
+        std::string name; ///< Member name, empty for an array index.
+        size_t index = 0; ///< Array element or member index if `name` is empty.
+    };
+
+    void build(const ShaderVar& root) const;
+
+    std::string mPath;
+    std::vector<Segment> mSegments;
+
+    // Cached resolution for the root type and offset below.
+    // The root type is referenced so that its address is not reused by another type while cached.
+    mutable ref<const ReflectionType> mpRootType;
+    mutable ShaderVarOffset mRootOffset;
+    /// Offset in each parameter block along the path. The first one is in the block of the root variable,
+    /// each following one is in the block bound to the constant buffer at the previous offset.
+    mutable std::vector<TypedShaderVarOffset> mBlockOffsets;
+};
 } // namespace Falcor
 
 #include "Core/API/ParameterBlock.h"
@@ -28,9 +28,12 @@
 #include "LightBVHBuilder.h"
 #include "Core/Error.h"
 #include "Utils/Logger.h"
+#include "Utils/Threading.h"
 #include "Utils/Timing/Profiler.h"
+#include "Utils/Math/Common.h"
 #include "Utils/Math/MathConstants.slangh"
 #include <algorithm>
+#include <utility>
 
 namespace
 {
@@ -44,6 +47,15 @@ namespace
     const uint32_t kMaxLeafTriangleCount = 1 << PackedNode::kTriangleCountBits;
     const uint32_t kMaxLeafTriangleOffset = 1 << PackedNode::kTriangleOffsetBits;
 
+    // Subtrees with at least this many triangles are built as separate tasks.
+    const uint32_t kParallelBuildThreshold = 4096;
+
+    // Nodes with at least this many triangles bin the split axes in parallel.
+    const uint32_t kParallelBinningThreshold = 65536;
+
+    // Number of triangles per chunk when binning a single axis in parallel.
+    const uint32_t kBinningChunkSize = 16384;
+
     inline float safeACos(float v)
     {
         return std::acos(std::clamp(v, -1.0f, 1.0f));
@@ -274,22 +286,26 @@ namespace Falcor
             FALCOR_THROW("Emissive triangle count exceeds the maximum supported ({})", kMaxLeafTriangleOffset + kMaxLeafTriangleCount);
         }
 
-        // Allocate temporary memory for the BVH build.
-        // To be grossly conservative, assume each triangle requires two nodes.
-        // This is only system RAM and shouldn't be that much, so it's not worth being more careful about it.
-        // TODO: Better estimate of how many nodes we will need.
-        data.nodes.clear();
-        data.nodes.reserve(2 * data.trianglesData.size());
-        data.triangleIndices.reserve(data.trianglesData.size());
-
         const uint64_t invalidBitmask = std::numeric_limits<uint64_t>::max();
         data.triangleBitmasks.resize(triangles.size(), invalidBitmask); // This is sized based on input triangle count, as it's indexed by global triangle index.
 
         // Build the tree.
         SplitHeuristicFunction splitFunc = getSplitFunction(mOptions.splitHeuristicSelection);
-        buildInternal(mOptions, splitFunc, 0ull, 0, Range(0, static_cast<uint32_t>(data.trianglesData.size())), data);
+        BuildScratch scratch = createScratch(mOptions, data);
+        const BuildNode* pRoot = buildInternal(mOptions, splitFunc, 0ull, 0, Range(0, static_cast<uint32_t>(data.trianglesData.size())), data, scratch);
+
+        // Convert the tree to BVH nodes in depth-first order.
+        data.nodes.clear();
+        data.nodes.resize(pRoot->nodeCount);
+        flattenInternal(mOptions, *pRoot, 0, data);
+        data.nodeArenas.clear();
         FALCOR_ASSERT(!data.nodes.empty());
 
+        // Leaf nodes cover consecutive triangle ranges in depth-first order, so the triangle indices are in sorted order.
+        data.triangleIndices.resize(data.trianglesData.size());
+        for (size_t i = 0; i < data.trianglesData.size(); i++)
+            data.triangleIndices[i] = data.trianglesData[i].triangleIndex;
+
         size_t numValid = 0;
         for (auto mask : data.triangleBitmasks)
             if (mask != invalidBitmask) numValid++;
@@ -321,6 +337,7 @@ namespace Falcor
         optionsChanged |= widget.checkbox("Allow refitting", options.allowRefitting);
         optionsChanged |= widget.var("Max triangle count per leaf", options.maxTriangleCountPerLeaf, 1u, kMaxLeafTriangleCount);
         optionsChanged |= widget.dropdown("Split heuristic", options.splitHeuristicSelection);
+        optionsChanged |= widget.checkbox("Parallel build", options.parallelBuild);
 
         if (auto splitGroup = widget.group("Split Options", true))
         {
@@ -349,7 +366,22 @@ namespace Falcor
         return optionsChanged;
     }
 
-    uint32_t LightBVHBuilder::buildInternal(const Options& options, const SplitHeuristicFunction& splitHeuristic, uint64_t bitmask, uint32_t depth, const Range& triangleRange, BuildingData& data)
+    LightBVHBuilder::BuildScratch LightBVHBuilder::createScratch(const Options& options, BuildingData& data)
+    {
+        BuildScratch scratch;
+        {
+            std::lock_guard<std::mutex> lock(data.nodeArenasMutex);
+            scratch.pNodeArena = data.nodeArenas.emplace_back(std::make_unique<std::deque<BuildNode>>()).get();
+        }
+        for (uint32_t dimension = 0; dimension < 3; ++dimension)
+        {
+            scratch.bins[dimension].resize(options.binCount);
+            scratch.costs[dimension].resize(options.binCount > 0 ? options.binCount - 1 : 0);
+        }
+        return scratch;
+    }
+
+    LightBVHBuilder::BuildNode* LightBVHBuilder::buildInternal(const Options& options, const SplitHeuristicFunction& splitHeuristic, uint64_t bitmask, uint32_t depth, const Range& triangleRange, BuildingData& data, BuildScratch& scratch)
     {
         FALCOR_ASSERT(triangleRange.begin < triangleRange.end);
 
@@ -363,10 +395,13 @@ namespace Falcor
         }
         FALCOR_ASSERT(nodeBounds.valid());
 
-        data.currentNodeFlux = nodeFlux;
+        BuildNode& node = scratch.pNodeArena->emplace_back();
+        node.bounds = nodeBounds;
+        node.flux = nodeFlux;
+        node.triangleRange = triangleRange;
 
         bool trySplitting = triangleRange.length() > (options.createLeavesASAP ? options.maxTriangleCountPerLeaf : 1);
-        const SplitResult splitResult = trySplitting ? splitHeuristic(data, triangleRange, nodeBounds, options) : SplitResult();
+        const SplitResult splitResult = trySplitting ? splitHeuristic(data, triangleRange, nodeBounds, nodeFlux, options, scratch) : SplitResult();
 
         // If we should split, then create an internal node and split.
         if (splitResult.isValid())
@@ -377,14 +412,6 @@ namespace Falcor
             auto comp = [dim = splitResult.axis](const TriangleSortData& d1, const TriangleSortData& d2) { return d1.bounds.center()[dim] < d2.bounds.center()[dim]; };
             std::nth_element(std::begin(data.trianglesData) + triangleRange.begin, std::begin(data.trianglesData) + splitResult.triangleIndex, std::begin(data.trianglesData) + triangleRange.end, comp);
 
-            // Allocate internal node.
-            FALCOR_ASSERT(data.nodes.size() < std::numeric_limits<uint32_t>::max());
-            const uint32_t nodeIndex = (uint32_t)data.nodes.size();
-            data.nodes.push_back({});
-
-            InternalNode node = {};
-            node.attribs.setAABB(nodeBounds.minPoint, nodeBounds.maxPoint);
-            node.attribs.flux = nodeFlux;
             // The lighting normal bounding cone will be computed later when all leaf nodes have been created.
 
             if (depth >= kMaxBVHDepth)
@@ -394,46 +421,101 @@ namespace Falcor
                 FALCOR_THROW("BVH depth of {} reached. Maximum of {} allowed.", depth + 1, kMaxBVHDepth);
             }
 
-            uint32_t leftIndex = buildInternal(options, splitHeuristic, bitmask | (0ull << depth), depth + 1, Range(triangleRange.begin, splitResult.triangleIndex), data);
-            uint32_t rightIndex = buildInternal(options, splitHeuristic, bitmask | (1ull << depth), depth + 1, Range(splitResult.triangleIndex, triangleRange.end), data);
+            const Range leftRange(triangleRange.begin, splitResult.triangleIndex);
+            const Range rightRange(splitResult.triangleIndex, triangleRange.end);
 
-            FALCOR_ASSERT(leftIndex == nodeIndex + 1); // The left node should always be placed immediately after the current node.
-            node.rightChildIdx = rightIndex;
+            // The children work on disjoint triangle ranges, so large subtrees can be built concurrently.
+            // The left subtree is built by a separate task with its own scratch memory.
+            if (options.parallelBuild && triangleRange.length() >= kParallelBuildThreshold)
+            {
+                Threading::Task leftTask = Threading::dispatchTask(
+                    [&]()
+                    {
+                        FALCOR_PROFILE_CPU("LightBVHBuilder::buildSubtree");
+                        BuildScratch leftScratch = createScratch(options, data);
+                        node.pLeft = buildInternal(options, splitHeuristic, bitmask | (0ull << depth), depth + 1, leftRange, data, leftScratch);
+                    }
+                );
+                try
+                {
+                    node.pRight = buildInternal(options, splitHeuristic, bitmask | (1ull << depth), depth + 1, rightRange, data, scratch);
+                }
+                catch (...)
+                {
+                    // Make sure the left task is done before unwinding, it references data on this stack frame.
+                    try { leftTask.finish(); } catch (...) {}
+                    throw;
+                }
+                leftTask.finish();
+            }
+            else
+            {
+                node.pLeft = buildInternal(options, splitHeuristic, bitmask | (0ull << depth), depth + 1, leftRange, data, scratch);
+                node.pRight = buildInternal(options, splitHeuristic, bitmask | (1ull << depth), depth + 1, rightRange, data, scratch);
+            }
 
-            data.nodes[nodeIndex].setInternalNode(node);
-            return nodeIndex;
+            node.nodeCount = 1 + node.pLeft->nodeCount + node.pRight->nodeCount;
         }
         else // No split => create leaf node
         {
             FALCOR_ASSERT(triangleRange.length() <= options.maxTriangleCountPerLeaf);
 
-            // Allocate leaf node.
-            FALCOR_ASSERT(data.nodes.size() < std::numeric_limits<uint32_t>::max());
-            const uint32_t nodeIndex = (uint32_t)data.nodes.size();
-            data.nodes.push_back({});
+            node.coneDirection = computeLightingCone(triangleRange, data, node.cosConeAngle);
 
-            LeafNode node = {};
-            node.attribs.setAABB(nodeBounds.minPoint, nodeBounds.maxPoint);
-            node.attribs.flux = nodeFlux;
-            float cosTheta;
-            node.attribs.coneDirection = computeLightingCone(triangleRange, data, cosTheta);
-            node.attribs.cosConeAngle = cosTheta;
-
-            node.triangleCount = triangleRange.length();
-            node.triangleOffset = (uint32_t)data.triangleIndices.size();
-            FALCOR_ASSERT(node.triangleCount < kMaxLeafTriangleCount);
-            FALCOR_ASSERT(node.triangleOffset < kMaxLeafTriangleOffset);
-
-            for (uint32_t triangleIdx = triangleRange.begin, index = 0; triangleIdx < triangleRange.end; ++triangleIdx, ++index)
+            // Each triangle is in exactly one leaf, so concurrent tasks write disjoint entries.
+            for (uint32_t triangleIdx = triangleRange.begin; triangleIdx < triangleRange.end; ++triangleIdx)
             {
                 uint32_t globalTriangleIndex = data.trianglesData[triangleIdx].triangleIndex;
-                data.triangleIndices.push_back(globalTriangleIndex);
                 data.triangleBitmasks[globalTriangleIndex] = bitmask;
             }
-            FALCOR_ASSERT(data.triangleIndices.size() == node.triangleOffset + node.triangleCount);
+        }
+
+        return &node;
+    }
+
+    void LightBVHBuilder::flattenInternal(const Options& options, const BuildNode& buildNode, uint32_t nodeIndex, BuildingData& data)
+    {
+        FALCOR_ASSERT(nodeIndex + buildNode.nodeCount <= data.nodes.size());
+
+        if (!buildNode.isLeaf())
+        {
+            InternalNode node = {};
+            node.attribs.setAABB(buildNode.bounds.minPoint, buildNode.bounds.maxPoint);
+            node.attribs.flux = buildNode.flux;
+
+            // The left node is always placed immediately after the current node, followed by the right node.
+            const uint32_t leftIndex = nodeIndex + 1;
+            const uint32_t rightIndex = leftIndex + buildNode.pLeft->nodeCount;
+            node.rightChildIdx = rightIndex;
+            data.nodes[nodeIndex].setInternalNode(node);
+
+            if (options.parallelBuild && buildNode.triangleRange.length() >= kParallelBuildThreshold)
+            {
+                Threading::Task leftTask = Threading::dispatchTask([&]() { flattenInternal(options, *buildNode.pLeft, leftIndex, data); });
+                flattenInternal(options, *buildNode.pRight, rightIndex, data);
+                leftTask.finish();
+            }
+            else
+            {
+                flattenInternal(options, *buildNode.pLeft, leftIndex, data);
+                flattenInternal(options, *buildNode.pRight, rightIndex, data);
+            }
+        }
+        else
+        {
+            LeafNode node = {};
+            node.attribs.setAABB(buildNode.bounds.minPoint, buildNode.bounds.maxPoint);
+            node.attribs.flux = buildNode.flux;
+            node.attribs.coneDirection = buildNode.coneDirection;
+            node.attribs.cosConeAngle = buildNode.cosConeAngle;
+
+            // Leaves are visited in depth-first order, so the triangle offset equals the start of the triangle range.
+            node.triangleCount = buildNode.triangleRange.length();
+            node.triangleOffset = buildNode.triangleRange.begin;
+            FALCOR_ASSERT(node.triangleCount < kMaxLeafTriangleCount);
+            FALCOR_ASSERT(node.triangleOffset < kMaxLeafTriangleOffset);
 
             data.nodes[nodeIndex].setLeafNode(node);
-            return nodeIndex;
         }
     }
 
@@ -497,7 +579,7 @@ namespace Falcor
         return coneDirection;
     }
 
-    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithEqual(const BuildingData& /*data*/, const Range& triangleRange, const AABB& nodeBounds, const Options& /*parameters*/)
+    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithEqual(const BuildingData& /*data*/, const Range& triangleRange, const AABB& nodeBounds, float /*nodeFlux*/, const Options& /*parameters*/, BuildScratch& /*scratch*/)
     {
         // Find the largest dimension.
         float3 dimensions = nodeBounds.extent();
@@ -524,36 +606,31 @@ namespace Falcor
         return cost;
     }
 
-    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters)
+    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, float nodeFlux, const Options& parameters, BuildScratch& scratch)
     {
         std::pair<float, SplitResult> overallBestSplit = std::make_pair(std::numeric_limits<float>::infinity(), SplitResult());
         FALCOR_ASSERT(!overallBestSplit.second.isValid());
 
-        struct Bin
+        // Only the bounds and triangle count of the bins are used.
+        auto mergeBin = [](Bin& bin, const Bin& rhs)
         {
-            AABB bounds;
-            uint32_t triangleCount = 0;
-
-            Bin() = default;
-            Bin(const TriangleSortData& tri) : bounds(tri.bounds), triangleCount(1) {}
-            Bin& operator|= (const Bin& rhs)
-            {
-                bounds |= rhs.bounds;
-                triangleCount += rhs.triangleCount;
-                return *this;
-            }
+            bin.bounds |= rhs.bounds;
+            bin.triangleCount += rhs.triangleCount;
         };
 
         FALCOR_ASSERT(parameters.binCount > 1);
-        std::vector<Bin> bins(parameters.binCount);
-        std::vector<float> costs(parameters.binCount - 1);
+        const bool parallel = parameters.parallelBuild && triangleRange.length() >= kParallelBinningThreshold;
 
         /** Helper function that computes the best split along the given dimension using the SAH metric.
             The triangles are binned to n bins, storing only the aggregate parameters (triangle count and bounds).
             Then the cost metric is evaluated for each of the n-1 potential splits.
+            Returns an infinite cost if all lights fall on either side of the best split.
         */
-        const auto binAlongDimension = [&bins, &costs, &triangleRange, &data, &parameters, &overallBestSplit, &nodeBounds](uint32_t dimension)
+        const auto binAlongDimension = [&](uint32_t dimension)
         {
+            std::vector<Bin>& bins = scratch.bins[dimension];
+            std::vector<float>& costs = scratch.costs[dimension];
+
             // Helper to compute the bin id for a given triangle.
             auto getBinId = [&](const TriangleSortData& td)
             {
@@ -565,14 +642,44 @@ namespace Falcor
                 return std::min((uint32_t)((p - bmin) * scale), parameters.binCount - 1);
             };
 
+            auto binTriangles = [&](uint32_t begin, uint32_t end, Bin* pBins)
+            {
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    const auto& td = data.trianglesData[i];
+                    Bin& bin = pBins[getBinId(td)];
+                    bin.bounds |= td.bounds;
+                    bin.triangleCount++;
+                }
+            };
+
             // Reset the bins.
             for (Bin& bin : bins) bin = Bin();
 
             // Fill the bins with all triangles.
-            for (uint32_t i = triangleRange.begin; i < triangleRange.end; ++i)
+            if (parallel)
             {
-                const auto& td = data.trianglesData[i];
-                bins[getBinId(td)] |= td;
+                // Bounds and triangle counts do not depend on the binning order, so chunks can be binned independently and merged.
+                const uint32_t chunkCount = div_round_up(triangleRange.length(), kBinningChunkSize);
+                std::vector<Bin> chunkBins(chunkCount * parameters.binCount);
+                Threading::parallelForEach(
+                    0,
+                    chunkCount,
+                    [&](size_t chunk)
+                    {
+                        const uint32_t begin = triangleRange.begin + (uint32_t)chunk * kBinningChunkSize;
+                        binTriangles(begin, std::min(begin + kBinningChunkSize, triangleRange.end), chunkBins.data() + chunk * parameters.binCount);
+                    },
+                    1
+                );
+                for (uint32_t chunk = 0; chunk < chunkCount; ++chunk)
+                {
+                    for (uint32_t i = 0; i < parameters.binCount; ++i) mergeBin(bins[i], chunkBins[chunk * parameters.binCount + i]);
+                }
+            }
+            else
+            {
+                binTriangles(triangleRange.begin, triangleRange.end, bins.data());
             }
 
             // First, compute A_j(L) * N_j(L) by sweeping over the bins from left to right.
@@ -580,7 +687,7 @@ namespace Falcor
             Bin total = Bin();
             for (std::size_t i = 0; i < costs.size(); ++i)
             {
-                total |= bins[i];
+                mergeBin(total, bins[i]);
                 costs[i] = evalSAH(total.bounds, total.triangleCount, parameters);
             }
 
@@ -588,7 +695,7 @@ namespace Falcor
             total = Bin();
             for (std::size_t i = costs.size(); i > 0; --i)
             {
-                total |= bins[i];
+                mergeBin(total, bins[i]);
                 costs[i - 1] += evalSAH(total.bounds, total.triangleCount, parameters);
             }
 
@@ -606,13 +713,9 @@ namespace Falcor
 
             // Early out if all lights fall on either side of the split.
             if (axisBestSplit.second.triangleIndex == triangleRange.begin ||
-                axisBestSplit.second.triangleIndex == triangleRange.end) return;
+                axisBestSplit.second.triangleIndex == triangleRange.end) return std::make_pair(std::numeric_limits<float>::infinity(), SplitResult());
 
-            if (axisBestSplit.first < overallBestSplit.first)
-            {
-                overallBestSplit = axisBestSplit;
-                FALCOR_ASSERT(triangleRange.begin < overallBestSplit.second.triangleIndex && overallBestSplit.second.triangleIndex < triangleRange.end);
-            }
+            return axisBestSplit;
         };
 
         if (parameters.splitAlongLargest)
@@ -622,13 +725,20 @@ namespace Falcor
             uint32_t largestDimension = dimensions[2] >= dimensions[0] && dimensions[2] >= dimensions[1] ?
                 2 : (dimensions[1] >= dimensions[0] && dimensions[1] >= dimensions[2] ? 1 : 0);
 
-            binAlongDimension(largestDimension);
+            overallBestSplit = binAlongDimension(largestDimension);
         }
         else
         {
+            std::pair<float, SplitResult> axisBestSplits[3];
+            if (parallel)
+                Threading::parallelForEach(0, 3, [&](size_t dimension) { axisBestSplits[dimension] = binAlongDimension((uint32_t)dimension); }, 1);
+            else
+                for (uint32_t dimension = 0; dimension < 3; ++dimension) axisBestSplits[dimension] = binAlongDimension(dimension);
+
+            // Pick the cheapest split. Ties are resolved in favor of the lowest dimension.
             for (uint32_t dimension = 0; dimension < 3; ++dimension)
             {
-                binAlongDimension(dimension);
+                if (axisBestSplits[dimension].first < overallBestSplit.first) overallBestSplit = axisBestSplits[dimension];
             }
         }
 
@@ -637,11 +747,12 @@ namespace Falcor
         {
             if (triangleRange.length() <= parameters.maxTriangleCountPerLeaf) return SplitResult();
             logWarning("LightBVHBuilder::computeSplitWithBinnedSAH() was not able to compute a proper split: reverting to LightBVHBuilder::computeSplitWithEqual()");
-            return computeSplitWithEqual(data, triangleRange, nodeBounds, parameters);
+            return computeSplitWithEqual(data, triangleRange, nodeBounds, nodeFlux, parameters, scratch);
         }
 
         // If the best split we found is more expensive than the cost of a leaf node (and we can create one), then create a leaf node.
         FALCOR_ASSERT(overallBestSplit.second.isValid());
+        FALCOR_ASSERT(triangleRange.begin < overallBestSplit.second.triangleIndex && overallBestSplit.second.triangleIndex < triangleRange.end);
         if (parameters.useLeafCreationCost && triangleRange.length() <= parameters.maxTriangleCountPerLeaf)
         {
             float leafCost = evalSAH(nodeBounds, triangleRange.length(), parameters);
@@ -679,7 +790,7 @@ namespace Falcor
         return cost;
     }
 
-    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAOH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters)
+    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAOH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, float nodeFlux, const Options& parameters, BuildScratch& scratch)
     {
         std::pair<float, SplitResult> overallBestSplit = std::make_pair(std::numeric_limits<float>::infinity(), SplitResult());
         FALCOR_ASSERT(!overallBestSplit.second.isValid());
@@ -689,30 +800,19 @@ namespace Falcor
         uint32_t largestDimension = dimensions[2] >= dimensions[0] && dimensions[2] >= dimensions[1] ?
             2 : (dimensions[1] >= dimensions[0] && dimensions[1] >= dimensions[2] ? 1 : 0);
 
-        struct Bin
+        auto mergeBin = [](Bin& bin, const Bin& rhs)
         {
-            AABB bounds;
-            uint32_t triangleCount = 0;
-            float flux = 0.0f;
-            float3 coneDirection = float3(0.0f);
-            float cosConeAngle = 1.0f;
-
-            Bin() = default;
-            Bin(const TriangleSortData& tri) : bounds(tri.bounds), triangleCount(1), flux(tri.flux), coneDirection(tri.coneDirection), cosConeAngle(tri.cosConeAngle) {}
-            Bin& operator|= (const Bin& rhs)
-            {
-                bounds |= rhs.bounds;
-                triangleCount += rhs.triangleCount;
-                flux += rhs.flux;
-                coneDirection += rhs.coneDirection;
-                // Note: cosConeAngle should be computed separately after the final cone direction is known
-                return *this;
-            }
+            bin.bounds |= rhs.bounds;
+            bin.triangleCount += rhs.triangleCount;
+            bin.flux += rhs.flux;
+            bin.coneDirection += rhs.coneDirection;
+            // Note: cosConeAngle should be computed separately after the final cone direction is known
         };
 
         FALCOR_ASSERT(parameters.binCount > 1);
-        std::vector<Bin> bins(parameters.binCount);
-        std::vector<float> costs(parameters.binCount - 1);
+        // The flux and cone direction sums depend on the binning order, so the dimensions are binned in parallel
+        // but each dimension is binned serially to get the same result as a serial build.
+        const bool parallel = parameters.parallelBuild && triangleRange.length() >= kParallelBinningThreshold;
 
         /** Helper function that computes the best split along the given dimension using the SAOH metric.
             The triangles are binned to n bins, storing only the aggregate parameters (triangle count, bounds, flux, and cone direction).
@@ -720,9 +820,13 @@ namespace Falcor
             Note that while the bounds and flux are accurately represented by the aggregated parameters,
             the bounding cones are approximates based on the bins' bounding cones. This is less expensive,
             but also less precise than computing them directly from the triangles.
+            Returns an infinite cost if all lights fall on either side of the best split.
         */
-        const auto binAlongDimension = [&bins, &costs, &triangleRange, &data, &parameters, &overallBestSplit, &nodeBounds, largestDimension, dimensions](uint32_t dimension)
+        const auto binAlongDimension = [&, largestDimension, dimensions](uint32_t dimension)
         {
+            std::vector<Bin>& bins = scratch.bins[dimension];
+            std::vector<float>& costs = scratch.costs[dimension];
+
             // Helper to compute the bin id for a given triangle.
             auto getBinId = [&](const TriangleSortData& td)
             {
@@ -742,7 +846,11 @@ namespace Falcor
             for (uint32_t i = triangleRange.begin; i < triangleRange.end; ++i)
             {
                 const auto& td = data.trianglesData[i];
-                bins[getBinId(td)] |= td;
+                Bin& bin = bins[getBinId(td)];
+                bin.bounds |= td.bounds;
+                bin.triangleCount++;
+                bin.flux += td.flux;
+                bin.coneDirection += td.coneDirection;
             }
 
             // Compute the lighting cones for each bin.
@@ -766,7 +874,7 @@ namespace Falcor
             Bin total = Bin();
             for (std::size_t i = 0; i < costs.size(); ++i)
             {
-                total |= bins[i];
+                mergeBin(total, bins[i]);
 
                 // Compute the bounding cone angle for the union of bins 0..i.
                 float cosTheta = kInvalidCosConeAngle;
@@ -787,7 +895,7 @@ namespace Falcor
             total = Bin();
             for (std::size_t i = costs.size(); i > 0; --i)
             {
-                total |= bins[i];
+                mergeBin(total, bins[i]);
 
                 // Compute the bounding cone angle for the union of bins i..n-1.
                 float cosTheta = kInvalidCosConeAngle;
@@ -821,25 +929,28 @@ namespace Falcor
 
             // Early out if all lights fall on either side of the split.
             if (axisBestSplit.second.triangleIndex == triangleRange.begin ||
-                axisBestSplit.second.triangleIndex == triangleRange.end) return;
+                axisBestSplit.second.triangleIndex == triangleRange.end) return std::make_pair(std::numeric_limits<float>::infinity(), SplitResult());
 
-            if (axisBestSplit.first < overallBestSplit.first)
-            {
-                overallBestSplit = axisBestSplit;
-                FALCOR_ASSERT(triangleRange.begin < overallBestSplit.second.triangleIndex && overallBestSplit.second.triangleIndex < triangleRange.end);
-            }
+            return axisBestSplit;
         };
 
         // Compute the best split.
         if (parameters.splitAlongLargest)
         {
-            binAlongDimension(largestDimension);
+            overallBestSplit = binAlongDimension(largestDimension);
         }
         else
         {
+            std::pair<float, SplitResult> axisBestSplits[3];
+            if (parallel)
+                Threading::parallelForEach(0, 3, [&](size_t dimension) { axisBestSplits[dimension] = binAlongDimension((uint32_t)dimension); }, 1);
+            else
+                for (uint32_t dimension = 0; dimension < 3; ++dimension) axisBestSplits[dimension] = binAlongDimension(dimension);
+
+            // Pick the cheapest split. Ties are resolved in favor of the lowest dimension.
             for (uint32_t dimension = 0; dimension < 3; ++dimension)
             {
-                binAlongDimension(dimension);
+                if (axisBestSplits[dimension].first < overallBestSplit.first) overallBestSplit = axisBestSplits[dimension];
             }
         }
 
@@ -848,17 +959,18 @@ namespace Falcor
         {
             if (triangleRange.length() <= parameters.maxTriangleCountPerLeaf) return SplitResult();
             logWarning("LightBVHBuilder::computeSplitWithBinnedSAOH() was not able to compute a proper split: reverting to LightBVHBuilder::computeSplitWithEqual()");
-            return computeSplitWithEqual(data, triangleRange, nodeBounds, parameters);
+            return computeSplitWithEqual(data, triangleRange, nodeBounds, nodeFlux, parameters, scratch);
         }
 
         // If the best split we found is more expensive than the cost of a leaf node (and we can create one), then create a leaf node.
         FALCOR_ASSERT(overallBestSplit.second.isValid());
+        FALCOR_ASSERT(triangleRange.begin < overallBestSplit.second.triangleIndex && overallBestSplit.second.triangleIndex < triangleRange.end);
         if (parameters.useLeafCreationCost && triangleRange.length() <= parameters.maxTriangleCountPerLeaf)
         {
             // Evaluate the cost metric for the node. This requires us to first compute the cone angle.
             float cosTheta = kInvalidCosConeAngle;
             computeLightingCone(triangleRange, data, cosTheta);
-            float leafCost = evalSAOH(nodeBounds, data.currentNodeFlux, cosTheta, parameters);
+            float leafCost = evalSAOH(nodeBounds, nodeFlux, cosTheta, parameters);
             if (leafCost <= overallBestSplit.first) return SplitResult();
         }
 
@@ -32,9 +32,11 @@
 #include "Utils/Math/AABB.h"
 #include "Utils/Math/Vector.h"
 #include "Utils/UI/Gui.h"
+#include <deque>
 #include <functional>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 namespace Falcor
@@ -44,6 +46,10 @@ namespace Falcor
         The building process can be customized via the |Options|,
         which are also available in the GUI via the |renderUI()| function.
 
+        Large subtrees are built as parallel tasks and the top levels bin the split axes in parallel.
+        The build first creates a temporary tree, which is then flattened into depth-first order.
+        The resulting nodes and triangle bitmasks are identical to a serial build.
+
         TODO: Rename all things triangle* to light* as the BVH class can be used for other types.
     */
     class FALCOR_API LightBVHBuilder
@@ -78,6 +84,7 @@ namespace Falcor
             bool           allowRefitting = true;                                ///< Rather than always rebuilding the BVH from scratch, keep the hierarchy but update the bounds and lighting cones.
             bool           usePreintegration = true;                             ///< Use pre-integration for culling out emissive triangles and use their flux when computing the splits. Only valid when using the BinnedSAOH split heuristic.
             bool           useLightingCones = true;                              ///< Use lighting cones when computing the splits. Only valid when using the BinnedSAOH split heuristic.
+            bool           parallelBuild = true;                                 ///< Build large subtrees and bin large nodes in parallel. The result is identical to a serial build.
 
             template<typename Archive>
             void serialize(Archive& ar)
@@ -93,6 +100,7 @@ namespace Falcor
                 ar("allowRefitting", allowRefitting);
                 ar("usePreintegration", usePreintegration);
                 ar("useLightingCones", useLightingCones);
+                ar("parallelBuild", parallelBuild);
             }
         };
 
@@ -143,38 +151,91 @@ namespace Falcor
             uint32_t triangleIndex = MeshLightData::kInvalidIndex; ///< Index into global triangle list.
         };
 
+        /** Aggregate data of the triangles falling into one bin when computing a binned split.
+        */
+        struct Bin
+        {
+            AABB bounds;
+            uint32_t triangleCount = 0;
+            float flux = 0.0f;                              ///< Only used by the SAOH split.
+            float3 coneDirection = float3(0.0f);            ///< Only used by the SAOH split.
+            float cosConeAngle = 1.0f;                      ///< Only used by the SAOH split.
+        };
+
+        /** Node of the temporary tree created during the build.
+        */
+        struct BuildNode
+        {
+            AABB bounds;
+            float flux = 0.f;
+            Range triangleRange = Range(0, 0);
+            float3 coneDirection = {};                      ///< Lighting cone direction. Only computed for leaf nodes.
+            float cosConeAngle = kInvalidCosConeAngle;      ///< Lighting cone angle. Only computed for leaf nodes.
+            uint32_t nodeCount = 1;                         ///< Number of nodes in the subtree rooted at this node.
+            BuildNode* pLeft = nullptr;
+            BuildNode* pRight = nullptr;
+
+            bool isLeaf() const { return pLeft == nullptr; }
+        };
+
+        /** Scratch memory of a build task. It is reused for all nodes built by the task to avoid per-node allocations.
+        */
+        struct BuildScratch
+        {
+            std::deque<BuildNode>* pNodeArena = nullptr;    ///< Storage for the build nodes created by the task. Owned by BuildingData.
+            std::vector<Bin> bins[3];                       ///< Bins for each split axis.
+            std::vector<float> costs[3];                    ///< Split costs for each split axis.
+        };
+
         struct BuildingData
         {
             std::vector<PackedNode>& nodes;                 ///< BVH nodes generated by the builder.
             std::vector<TriangleSortData> trianglesData;    ///< Compact list of triangles to include in build.
             std::vector<uint32_t> triangleIndices;          ///< Triangle indices sorted by leaf node. Each leaf node refers to a contiguous array of triangle indices.
             std::vector<uint64_t> triangleBitmasks;         ///< Array containing the per triangle bit pattern retracing the tree traversal to reach the triangle: 0=left child, 1=right child; this array gets filled in during the build process. Indexed by global triangle index.
-            float currentNodeFlux = 0.f;                    ///< Used by computeSAOHSplit() as the leaf creation cost.
+            std::vector<std::unique_ptr<std::deque<BuildNode>>> nodeArenas; ///< Build node storage of all build tasks.
+            std::mutex nodeArenasMutex;
 
             BuildingData(std::vector<PackedNode>& bvhNodes) : nodes(bvhNodes) {}
         };
 
         /** Compute the split according to a specified heuristic.
+            Must be thread safe as subtrees are built in parallel.
             \param[in] data Prepared light data.
             \param[in] triangleRange Range of triangles to process.
             \param[in] nodeBounds Bounds for the node to be splitted.
+            \param[in] nodeFlux Total flux of the node to be splitted. Used as the leaf creation cost.
             \param[in] parameters Various parameters defining how the building should occur.
+            \param[in,out] scratch Scratch memory of the calling build task.
         */
-        using SplitHeuristicFunction = std::function<SplitResult(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters)>;
+        using SplitHeuristicFunction = std::function<SplitResult(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, float nodeFlux, const Options& parameters, BuildScratch& scratch)>;
 
         /** Renders the UI with builder options.
         */
         bool renderOptions(Gui::Widgets& widget, Options& options) const;
 
-        /** Recursive BVH build.
+        /** Create the scratch memory for a build task.
+        */
+        static BuildScratch createScratch(const Options& options, BuildingData& data);
+
+        /** Recursive BVH build. Large subtrees are built in parallel.
             \param[in] splitHeuristic The splitting heuristic to be used.
             \param[in] bitmask Bit pattern retracing the tree traversal to reach the node to be built: 0=left child, 1=right child.
             \param[in] depth Depth of the node to be built
             \param[in] triangleRange Range of triangles to process.
             \param[in,out] data Prepared light data.
-            \return Index of the allocated node.
+            \param[in,out] scratch Scratch memory of the calling build task.
+            \return The allocated build node.
+        */
+        BuildNode* buildInternal(const Options& options, const SplitHeuristicFunction& splitHeuristic, uint64_t bitmask, uint32_t depth, const Range& triangleRange, BuildingData& data, BuildScratch& scratch);
+
+        /** Recursive conversion of the temporary build tree to BVH nodes in depth-first order.
+            \param[in] options The options to use for building the BVH.
+            \param[in] buildNode Root of the subtree to convert.
+            \param[in] nodeIndex Index of the BVH node for the root of the subtree.
+            \param[in,out] data Prepared light data.
         */
-        uint32_t buildInternal(const Options& options, const SplitHeuristicFunction& splitHeuristic, uint64_t bitmask, uint32_t depth, const Range& triangleRange, BuildingData& data);
+        void flattenInternal(const Options& options, const BuildNode& buildNode, uint32_t nodeIndex, BuildingData& data);
 
         /** Recursive computation of lighting cones for all internal nodes.
             \param[in] nodeIndex Index of the current node.
@@ -193,9 +254,9 @@ namespace Falcor
         static float3 computeLightingCone(const Range& triangleRange, const BuildingData& data, float& cosTheta);
 
         // See the documentation of SplitHeuristicFunction.
-        static SplitResult computeSplitWithEqual(const BuildingData& /*data*/, const Range& triangleRange, const AABB& nodeBounds, const Options& /*parameters*/);
-        static SplitResult computeSplitWithBinnedSAH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters);
-        static SplitResult computeSplitWithBinnedSAOH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters);
+        static SplitResult computeSplitWithEqual(const BuildingData& /*data*/, const Range& triangleRange, const AABB& nodeBounds, float /*nodeFlux*/, const Options& /*parameters*/, BuildScratch& /*scratch*/);
+        static SplitResult computeSplitWithBinnedSAH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, float nodeFlux, const Options& parameters, BuildScratch& scratch);
+        static SplitResult computeSplitWithBinnedSAOH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, float nodeFlux, const Options& parameters, BuildScratch& scratch);
 
         static SplitHeuristicFunction getSplitFunction(SplitHeuristic heuristic);
 
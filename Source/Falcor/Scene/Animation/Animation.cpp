@@ -31,6 +31,7 @@
 #include "Utils/Math/Common.h"
 #include "Utils/Scripting/ScriptBindings.h"
 #include "Scene/Transform.h"
+#include <algorithm>
 
 namespace Falcor
 {
@@ -111,7 +112,24 @@ namespace Falcor
         , mDuration(duration)
     {}
 
-    float4x4 Animation::animate(double currentTime)
+    float4x4 Animation::animate(double currentTime) const
+    {
+        size_t frameHint = 0;
+        return animate(currentTime, frameHint);
+    }
+
+    void Animation::evaluate(fstd::span<const double> times, fstd::span<float4x4> transforms) const
+    {
+        FALCOR_CHECK(times.size() == transforms.size(), "'times' and 'transforms' must have the same size.");
+
+        size_t frameHint = 0;
+        for (size_t i = 0; i < times.size(); i++)
+        {
+            transforms[i] = animate(times[i], frameHint);
+        }
+    }
+
+    float4x4 Animation::animate(double currentTime, size_t& frameHint) const
     {
         // Calculate the sample time.
         double time = currentTime;
@@ -129,7 +147,7 @@ namespace Falcor
         if (isLinearPreInfinity && mKeyframes.size() > 1)
         {
             const auto& k0 = mKeyframes.front();
-            auto k1 = interpolate(mInterpolationMode, k0.time + kEpsilonTime);
+            auto k1 = interpolate(mInterpolationMode, k0.time + kEpsilonTime, findKeyframe(k0.time + kEpsilonTime, 0));
             double segmentDuration = k1.time - k0.time;
             float t = (float)((time - k0.time) / segmentDuration);
             interpolated = interpolateLinear(k0, k1, t);
@@ -137,14 +155,15 @@ namespace Falcor
         else if (isLinearPostInfinity && mKeyframes.size() > 1)
         {
             const auto& k1 = mKeyframes.back();
-            auto k0 = interpolate(mInterpolationMode, k1.time - kEpsilonTime);
+            auto k0 = interpolate(mInterpolationMode, k1.time - kEpsilonTime, findKeyframe(k1.time - kEpsilonTime, 0));
             double segmentDuration = k1.time - k0.time;
             float t = (float)((time - k0.time) / segmentDuration);
             interpolated = interpolateLinear(k0, k1, t);
         }
         else
         {
-            interpolated = interpolate(mInterpolationMode, time);
+            frameHint = findKeyframe(time, frameHint);
+            interpolated = interpolate(mInterpolationMode, time, frameHint);
         }
 
         float4x4 T = math::matrixFromTranslation(interpolated.translation);
@@ -155,23 +174,21 @@ namespace Falcor
         return transform;
     }
 
-    Animation::Keyframe Animation::interpolate(InterpolationMode mode, double time) const
+    size_t Animation::findKeyframe(double time, size_t frameHint) const
     {
         FALCOR_ASSERT(!mKeyframes.empty());
 
-        // Validate cached frame index.
-        size_t frameIndex = std::clamp(mCachedFrameIndex, (size_t)0, mKeyframes.size() - 1);
-        if (time < mKeyframes[frameIndex].time) frameIndex = 0;
-
-        // Find frame index.
-        while (frameIndex < mKeyframes.size() - 1)
-        {
-            if (mKeyframes[frameIndex + 1].time > time) break;
-            frameIndex++;
-        }
+        // Find the last keyframe at or before the time, or the first keyframe if there is none.
+        // The search starts at the hint if it lies at or before the time.
+        auto first = mKeyframes.begin();
+        if (frameHint < mKeyframes.size() && mKeyframes[frameHint].time <= time) first += frameHint;
+        auto it = std::upper_bound(first, mKeyframes.end(), time, [](double t, const Keyframe& k) { return t < k.time; });
+        return it == mKeyframes.begin() ? 0 : (size_t)(it - mKeyframes.begin()) - 1;
+    }
 
-        // Cache frame index;
-        mCachedFrameIndex = frameIndex;
+    Animation::Keyframe Animation::interpolate(InterpolationMode mode, double time, size_t frameIndex) const
+    {
+        FALCOR_ASSERT(frameIndex < mKeyframes.size());
 
         // Compute index of adjacent frame including optional warping.
         auto adjacentFrame = [this] (size_t frame, int32_t offset = 1)
@@ -222,7 +239,7 @@ namespace Falcor
     // the animation does not behave linearly. If the animation behaves linearly, then the
     // current time is returned. This function should not be used if the current time lies
     // within the range of defined keyframe times.
-    double Animation::calcSampleTime(double currentTime)
+    double Animation::calcSampleTime(double currentTime) const
     {
         double modifiedTime = currentTime;
         double firstKeyframeTime = mKeyframes.front().time;
@@ -33,6 +33,7 @@
 #include "Utils/Math/Matrix.h"
 #include "Utils/Math/Quaternion.h"
 #include "Utils/UI/Gui.h"
+#include <fstd/span.h>
 #include <memory>
 #include <string>
 #include <vector>
@@ -144,18 +145,28 @@ namespace Falcor
         bool doesKeyframeExists(double time) const;
 
         /** Compute the animation.
+            The keyframe is found by binary search, the animation can be evaluated at arbitrary times and from several threads.
             \param time The current time in seconds. This can be larger then the animation time, in which case the animation will loop.
             \return Returns the animation's transform matrix for the specified time.
         */
-        float4x4 animate(double currentTime);
+        float4x4 animate(double currentTime) const;
+
+        /** Compute the animation at many times, e.g. the sub-frame times of motion blur.
+            Same result as calling animate() per time, the keyframe search continues from the previous time when the times are ascending.
+            \param[in] times Times in seconds.
+            \param[out] transforms Transform matrix for each time, must have the same size as 'times'.
+        */
+        void evaluate(fstd::span<const double> times, fstd::span<float4x4> transforms) const;
 
         /* Render the UI.
         */
         void renderUI(Gui::Widgets& widget);
 
     private:
-        Keyframe interpolate(InterpolationMode mode, double time) const;
-        double calcSampleTime(double currentTime);
+        float4x4 animate(double currentTime, size_t& frameHint) const;
+        size_t findKeyframe(double time, size_t frameHint) const;
+        Keyframe interpolate(InterpolationMode mode, double time, size_t frameIndex) const;
+        double calcSampleTime(double currentTime) const;
 
         std::string mName;
         NodeID mNodeID;
@@ -168,7 +179,6 @@ namespace Falcor
         bool mEnableWarping = false;
 
         std::vector<Keyframe> mKeyframes;
-        mutable size_t mCachedFrameIndex = 0;
 
         friend class SceneCache;
     };
@@ -27,8 +27,11 @@
  **************************************************************************/
 #include "AnimationController.h"
 #include "Core/API/RenderContext.h"
+#include "Utils/Threading.h"
+#include "Utils/Math/MatrixSIMD.h"
 #include "Utils/Timing/Profiler.h"
 #include "Scene/Scene.h"
+#include <algorithm>
 #include <fstream>
 
 namespace Falcor
@@ -39,9 +42,26 @@ namespace Falcor
         const std::string kInverseTransposeWorldMatrices = "inverseTransposeWorldMatrices";
         const std::string kPrevWorldMatrices = "prevWorldMatrices";
         const std::string kPrevInverseTransposeWorldMatrices = "prevInverseTransposeWorldMatrices";
+
+        const size_t kUpdateGrainSize = 256;    ///< Nodes per task of the parallel world matrix update.
+        const size_t kMaxUploadGap = 16;        ///< Unchanged matrices uploaded to merge two ranges into one upload.
+
+        /** Call func(offset, count) for ranges of matrices covering the sorted node indices.
+        */
+        template<typename F>
+        void forEachUploadRange(const std::vector<uint32_t>& sortedIndices, F func)
+        {
+            for (size_t i = 0; i < sortedIndices.size();)
+            {
+                const size_t first = sortedIndices[i];
+                size_t last = first;
+                while (++i < sortedIndices.size() && sortedIndices[i] <= last + 1 + kMaxUploadGap) last = sortedIndices[i];
+                func(first, last - first + 1);
+            }
+        }
     }
 
-    AnimationController::AnimationController(ref<Device> pDevice, Scene* pScene, const StaticVertexVector& staticVertexData, const SkinningVertexVector& skinningVertexData, uint32_t prevVertexCount, const std::vector<ref<Animation>>& animations)
+    AnimationController::AnimationController(ref<Device> pDevice, Scene* pScene, StaticVertexSpan staticVertexData, SkinningVertexSpan skinningVertexData, uint32_t prevVertexCount, const std::vector<ref<Animation>>& animations)
         : mpDevice(pDevice)
         , mAnimations(animations)
         , mNodesEdited(pScene->mSceneGraph.size())
@@ -83,6 +103,7 @@ namespace Falcor
             mpPrevVertexData->setName("AnimationController::mpPrevVertexData");
         }
 
+        initHierarchy();
         createSkinningPass(staticVertexData, skinningVertexData);
 
         // Determine length of global animation loop.
@@ -92,7 +113,7 @@ namespace Falcor
         }
     }
 
-    void AnimationController::addAnimatedVertexCaches(std::vector<CachedCurve>&& cachedCurves, std::vector<CachedMesh>&& cachedMeshes, const StaticVertexVector& staticVertexData)
+    void AnimationController::addAnimatedVertexCaches(std::vector<CachedCurve>&& cachedCurves, std::vector<CachedMesh>&& cachedMeshes, StaticVertexSpan staticVertexData)
     {
         size_t totalAnimatedMeshVertexCount = 0;
 
@@ -182,6 +203,59 @@ namespace Falcor
         }
     }
 
+    void AnimationController::setNodeEdited(size_t nodeID)
+    {
+        if (mNodesEdited[nodeID]) return;
+        mNodesEdited[nodeID] = true;
+        mEditedNodes.push_back((uint32_t)nodeID);
+    }
+
+    void AnimationController::initHierarchy()
+    {
+        const auto& sceneGraph = mpScene->mSceneGraph;
+        const uint32_t nodeCount = (uint32_t)sceneGraph.size();
+
+        // Store the children of each node contiguously.
+        mChildOffsets.assign(nodeCount + 1, 0);
+        for (const auto& node : sceneGraph)
+        {
+            if (node.parent != NodeID::Invalid()) mChildOffsets[node.parent.get() + 1]++;
+        }
+        for (uint32_t i = 0; i < nodeCount; i++) mChildOffsets[i + 1] += mChildOffsets[i];
+
+        mChildren.resize(mChildOffsets[nodeCount]);
+        std::vector<uint32_t> childCounts(nodeCount, 0);
+        for (uint32_t i = 0; i < nodeCount; i++)
+        {
+            NodeID parent = sceneGraph[i].parent;
+            if (parent != NodeID::Invalid()) mChildren[mChildOffsets[parent.get()] + childCounts[parent.get()]++] = i;
+        }
+
+        // A breadth-first traversal from the root nodes lists the nodes sorted by level.
+        mNodeLevels.assign(nodeCount, 0);
+        mNodesByLevel.clear();
+        mNodesByLevel.reserve(nodeCount);
+        for (uint32_t i = 0; i < nodeCount; i++)
+        {
+            if (sceneGraph[i].parent == NodeID::Invalid()) mNodesByLevel.push_back(i);
+        }
+        for (size_t i = 0; i < mNodesByLevel.size(); i++)
+        {
+            const uint32_t nodeIndex = mNodesByLevel[i];
+            for (uint32_t c = mChildOffsets[nodeIndex]; c < mChildOffsets[nodeIndex + 1]; c++)
+            {
+                mNodeLevels[mChildren[c]] = mNodeLevels[nodeIndex] + 1;
+                mNodesByLevel.push_back(mChildren[c]);
+            }
+        }
+        FALCOR_CHECK(mNodesByLevel.size() == nodeCount, "Scene graph contains nodes that are not reachable from a root node.");
+
+        const uint32_t levelCount = nodeCount > 0 ? mNodeLevels[mNodesByLevel.back()] + 1 : 0;
+        mLevelOffsets.assign(levelCount + 1, 0);
+        for (uint32_t nodeIndex : mNodesByLevel) mLevelOffsets[mNodeLevels[nodeIndex] + 1]++;
+        for (uint32_t level = 0; level < levelCount; level++) mLevelOffsets[level + 1] += mLevelOffsets[level];
+    }
+
     void AnimationController::initLocalMatrices()
     {
         for (size_t i = 0; i < mLocalMatrices.size(); i++)
@@ -194,21 +268,21 @@ namespace Falcor
     {
         FALCOR_PROFILE(pRenderContext, "animate");
 
-        std::fill(mMatricesChanged.begin(), mMatricesChanged.end(), false);
+        // Clear the change flags of the last update.
+        for (uint32_t nodeIndex : mDirtyNodes) mMatricesChanged[nodeIndex] = false;
+        mDirtyNodes.clear();
+        mChangedNodes.clear();
 
-        // Check for edited scene nodes and update local matrices.
+        // Update local matrices of edited scene nodes.
         const auto& sceneGraph = mpScene->mSceneGraph;
-        bool edited = false;
-        for (size_t i = 0; i < sceneGraph.size(); ++i)
+        bool edited = !mEditedNodes.empty();
+        for (uint32_t nodeIndex : mEditedNodes)
         {
-            if (mNodesEdited[i])
-            {
-                mLocalMatrices[i] = sceneGraph[i].transform;
-                mNodesEdited[i] = false;
-                mMatricesChanged[i] = true;
-                edited = true;
-            }
+            mLocalMatrices[nodeIndex] = sceneGraph[nodeIndex].transform;
+            mNodesEdited[nodeIndex] = false;
+            mChangedNodes.push_back(nodeIndex);
         }
+        mEditedNodes.clear();
 
         bool changed = false;
         double time = mLoopAnimations ? std::fmod(currentTime, mGlobalAnimationLength) : currentTime;
@@ -218,7 +292,6 @@ namespace Falcor
         // including transformation matrices, dynamic vertex data etc.
         if (mFirstUpdate || mEnabled != mPrevEnabled)
         {
-            std::fill(mMatricesChanged.begin(), mMatricesChanged.end(), true);
             initLocalMatrices();
             if (mEnabled)
             {
@@ -234,6 +307,7 @@ namespace Falcor
                 FALCOR_ASSERT(mpInvTransposeWorldMatricesBuffer && mpPrevInvTransposeWorldMatricesBuffer);
                 pRenderContext->copyResource(mpPrevWorldMatricesBuffer.get(), mpWorldMatricesBuffer.get());
                 pRenderContext->copyResource(mpPrevInvTransposeWorldMatricesBuffer.get(), mpInvTransposeWorldMatricesBuffer.get());
+                mPrevDirtyNodes.clear(); // Both buffers hold the current matrices.
                 bindBuffers();
                 executeSkinningPass(pRenderContext, true);
             }
@@ -294,38 +368,92 @@ namespace Falcor
             NodeID nodeID = pAnimation->getNodeID();
             FALCOR_ASSERT(nodeID.get() < mLocalMatrices.size());
             mLocalMatrices[nodeID.get()] = pAnimation->animate(time);
-            mMatricesChanged[nodeID.get()] = true;
+            mChangedNodes.push_back(nodeID.get());
         }
     }
 
-    void AnimationController::updateWorldMatrices(bool updateAll)
+    void AnimationController::collectDirtyNodes()
     {
-        const auto& sceneGraph = mpScene->mSceneGraph;
-
-        for (size_t i = 0; i < mGlobalMatrices.size(); i++)
+        // Mark the subtrees of the nodes with a new local matrix, breadth-first with mDirtyNodes as the queue.
+        // Nodes marked earlier in this update are skipped, their subtrees are marked already.
+        const size_t firstNew = mDirtyNodes.size();
+        for (uint32_t nodeIndex : mChangedNodes)
+        {
+            if (mMatricesChanged[nodeIndex]) continue;
+            mMatricesChanged[nodeIndex] = true;
+            mDirtyNodes.push_back(nodeIndex);
+        }
+        for (size_t i = firstNew; i < mDirtyNodes.size(); i++)
         {
-            // Propagate matrix change flag to children.
-            if (sceneGraph[i].parent != NodeID::Invalid())
+            const uint32_t nodeIndex = mDirtyNodes[i];
+            for (uint32_t c = mChildOffsets[nodeIndex]; c < mChildOffsets[nodeIndex + 1]; c++)
             {
-                mMatricesChanged[i] = mMatricesChanged[i] || mMatricesChanged[sceneGraph[i].parent.get()];
+                const uint32_t childIndex = mChildren[c];
+                if (mMatricesChanged[childIndex]) continue;
+                mMatricesChanged[childIndex] = true;
+                mDirtyNodes.push_back(childIndex);
             }
+        }
 
-            if (!mMatricesChanged[i] && !updateAll) continue;
+        // Sort the new dirty nodes by level so that parents are updated before their children.
+        const size_t levelCount = mLevelOffsets.size() - 1;
+        mUpdateLevelOffsets.assign(levelCount + 1, 0);
+        for (size_t i = firstNew; i < mDirtyNodes.size(); i++) mUpdateLevelOffsets[mNodeLevels[mDirtyNodes[i]] + 1]++;
+        for (size_t level = 0; level < levelCount; level++) mUpdateLevelOffsets[level + 1] += mUpdateLevelOffsets[level];
+
+        mUpdateNodes.resize(mDirtyNodes.size() - firstNew);
+        for (size_t i = firstNew; i < mDirtyNodes.size(); i++) mUpdateNodes[mUpdateLevelOffsets[mNodeLevels[mDirtyNodes[i]]]++] = mDirtyNodes[i];
+        // The scatter advanced each offset to the start of the next level, shift them back.
+        for (size_t level = levelCount; level > 0; level--) mUpdateLevelOffsets[level] = mUpdateLevelOffsets[level - 1];
+        mUpdateLevelOffsets[0] = 0;
+    }
 
-            mGlobalMatrices[i] = mLocalMatrices[i];
+    void AnimationController::updateWorldMatrices(bool updateAll)
+    {
+        if (updateAll)
+        {
+            std::fill(mMatricesChanged.begin(), mMatricesChanged.end(), true);
+            mDirtyNodes = mNodesByLevel;
+            mUpdateNodes = mNodesByLevel;
+            mUpdateLevelOffsets = mLevelOffsets;
+        }
+        else
+        {
+            collectDirtyNodes();
+        }
 
-            if (mpScene->mSceneGraph[i].parent != NodeID::Invalid())
-            {
-                mGlobalMatrices[i] = mul(mGlobalMatrices[sceneGraph[i].parent.get()], mGlobalMatrices[i]);
-            }
+        // Nodes on the same level only depend on the level above, update one level at a time in parallel.
+        for (size_t level = 0; level + 1 < mUpdateLevelOffsets.size(); level++)
+        {
+            Threading::parallelFor(
+                mUpdateLevelOffsets[level],
+                mUpdateLevelOffsets[level + 1],
+                [&](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; i++) updateWorldMatrix(mUpdateNodes[i]);
+                },
+                kUpdateGrainSize
+            );
+        }
+    }
 
-            mInvTransposeGlobalMatrices[i] = transpose(inverse(mGlobalMatrices[i]));
+    void AnimationController::updateWorldMatrix(uint32_t nodeIndex)
+    {
+        const auto& node = mpScene->mSceneGraph[nodeIndex];
 
-            if (mpSkinningPass)
-            {
-                mSkinningMatrices[i] = mul(mGlobalMatrices[i], sceneGraph[i].localToBindSpace);
-                mInvTransposeSkinningMatrices[i] = transpose(inverse(mSkinningMatrices[i]));
-            }
+        mGlobalMatrices[nodeIndex] = mLocalMatrices[nodeIndex];
+
+        if (node.parent != NodeID::Invalid())
+        {
+            mGlobalMatrices[nodeIndex] = math::mulSIMD(mGlobalMatrices[node.parent.get()], mGlobalMatrices[nodeIndex]);
+        }
+
+        mInvTransposeGlobalMatrices[nodeIndex] = math::inverseTransposeSIMD(mGlobalMatrices[nodeIndex]);
+
+        if (mpSkinningPass)
+        {
+            mSkinningMatrices[nodeIndex] = math::mulSIMD(mGlobalMatrices[nodeIndex], node.localToBindSpace);
+            mInvTransposeSkinningMatrices[nodeIndex] = math::inverseTransposeSIMD(mSkinningMatrices[nodeIndex]);
         }
     }
 
@@ -345,21 +473,19 @@ namespace Falcor
         else
         {
             // Upload changed matrices only.
-            for (size_t i = 0; i < mGlobalMatrices.size();)
+            // The current buffers were swapped in from the previous frame and were last written two updates ago,
+            // so they also miss the matrices that changed in the last update.
+            mUploadNodes = mDirtyNodes;
+            mUploadNodes.insert(mUploadNodes.end(), mPrevDirtyNodes.begin(), mPrevDirtyNodes.end());
+            std::sort(mUploadNodes.begin(), mUploadNodes.end());
+            mUploadNodes.erase(std::unique(mUploadNodes.begin(), mUploadNodes.end()), mUploadNodes.end());
+
+            forEachUploadRange(mUploadNodes, [&](size_t offset, size_t count)
             {
-                // Detect ranges of consecutive matrices that have all changed or not.
-                size_t offset = i;
-                bool changed = mMatricesChanged[i];
-                while (i < mGlobalMatrices.size() && mMatricesChanged[i] == changed) ++i;
-
-                // Upload range of changed matrices.
-                if (changed)
-                {
-                    size_t count = i - offset;
-                    mpWorldMatricesBuffer->setBlob(&mGlobalMatrices[offset], offset * sizeof(float4x4), count * sizeof(float4x4));
-                    mpInvTransposeWorldMatricesBuffer->setBlob(&mInvTransposeGlobalMatrices[offset], offset * sizeof(float4x4), count * sizeof(float4x4));
-                }
-            }
+                mpWorldMatricesBuffer->setBlob(&mGlobalMatrices[offset], offset * sizeof(float4x4), count * sizeof(float4x4));
+                mpInvTransposeWorldMatricesBuffer->setBlob(&mInvTransposeGlobalMatrices[offset], offset * sizeof(float4x4), count * sizeof(float4x4));
+            });
+            mPrevDirtyNodes = mDirtyNodes;
         }
     }
 
@@ -390,7 +516,7 @@ namespace Falcor
         return m;
     }
 
-    void AnimationController::createSkinningPass(const std::vector<PackedStaticVertexData>& staticVertexData, const std::vector<SkinningVertexData>& skinningVertexData)
+    void AnimationController::createSkinningPass(StaticVertexSpan staticVertexData, SkinningVertexSpan skinningVertexData)
     {
         if (staticVertexData.empty()) return;
 
@@ -454,10 +580,23 @@ namespace Falcor
     {
         if (!mpSkinningPass) return;
 
-        // Update matrices.
+        // Update matrices, the skinning matrices are not double buffered so only the ones changed in this update are uploaded.
         FALCOR_ASSERT(mpSkinningMatricesBuffer && mpInvTransposeSkinningMatricesBuffer);
-        mpSkinningMatricesBuffer->setBlob(mSkinningMatrices.data(), 0, mpSkinningMatricesBuffer->getSize());
-        mpInvTransposeSkinningMatricesBuffer->setBlob(mInvTransposeSkinningMatrices.data(), 0, mpInvTransposeSkinningMatricesBuffer->getSize());
+        if (initPrev)
+        {
+            mpSkinningMatricesBuffer->setBlob(mSkinningMatrices.data(), 0, mpSkinningMatricesBuffer->getSize());
+            mpInvTransposeSkinningMatricesBuffer->setBlob(mInvTransposeSkinningMatrices.data(), 0, mpInvTransposeSkinningMatricesBuffer->getSize());
+        }
+        else
+        {
+            mUploadNodes = mDirtyNodes;
+            std::sort(mUploadNodes.begin(), mUploadNodes.end());
+            forEachUploadRange(mUploadNodes, [&](size_t offset, size_t count)
+            {
+                mpSkinningMatricesBuffer->setBlob(&mSkinningMatrices[offset], offset * sizeof(float4x4), count * sizeof(float4x4));
+                mpInvTransposeSkinningMatricesBuffer->setBlob(&mInvTransposeSkinningMatrices[offset], offset * sizeof(float4x4), count * sizeof(float4x4));
+            });
+        }
 
         // Execute skinning pass.
         auto vars = mpSkinningPass->getRootVar()["gData"];
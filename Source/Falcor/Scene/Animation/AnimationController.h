@@ -33,6 +33,7 @@
 #include "Core/Pass/ComputePass.h"
 #include "Utils/Math/Matrix.h"
 #include "Scene/SceneTypes.slang"
+#include <fstd/span.h>
 #include <memory>
 #include <vector>
 
@@ -45,16 +46,16 @@ namespace Falcor
     public:
         ~AnimationController() = default;
 
-        using StaticVertexVector = std::vector<PackedStaticVertexData>;
-        using SkinningVertexVector = std::vector<SkinningVertexData>;
+        using StaticVertexSpan = fstd::span<const PackedStaticVertexData>;
+        using SkinningVertexSpan = fstd::span<const SkinningVertexData>;
 
         /** Constructor. Throws an exception if creation failed.
         */
-        AnimationController(ref<Device> pDevice, Scene* pScene, const StaticVertexVector& staticVertexData, const SkinningVertexVector& skinningVertexData, uint32_t prevVertexCount, const std::vector<ref<Animation>>& animations);
+        AnimationController(ref<Device> pDevice, Scene* pScene, StaticVertexSpan staticVertexData, SkinningVertexSpan skinningVertexData, uint32_t prevVertexCount, const std::vector<ref<Animation>>& animations);
 
         /** Add animated vertex caches (curves and meshes) to the controller.
         */
-        void addAnimatedVertexCaches(std::vector<CachedCurve>&& cachedCurves, std::vector<CachedMesh>&& cachedMeshes, const StaticVertexVector& staticVertexData);
+        void addAnimatedVertexCaches(std::vector<CachedCurve>&& cachedCurves, std::vector<CachedMesh>&& cachedMeshes, StaticVertexSpan staticVertexData);
 
         /** Returns true if controller contains animations.
         */
@@ -99,7 +100,7 @@ namespace Falcor
         /** Mark a scene node as being edited externally.
             Ensures that all global matrices depending on this scene node are updated.
         */
-        void setNodeEdited(size_t nodeID) { mNodesEdited[nodeID] = true; }
+        void setNodeEdited(size_t nodeID);
 
         /** Run the animation system.
             \return true if a change occurred, otherwise false.
@@ -146,14 +147,17 @@ namespace Falcor
         friend class SceneBuilder;
         friend class Scene;
 
+        void initHierarchy();
         void initLocalMatrices();
         void updateLocalMatrices(double time);
+        void collectDirtyNodes();
         void updateWorldMatrices(bool updateAll = false);
+        void updateWorldMatrix(uint32_t nodeIndex);
         void uploadWorldMatrices(bool uploadAll = false);
 
         void bindBuffers();
 
-        void createSkinningPass(const std::vector<PackedStaticVertexData>& staticVertexData, const SkinningVertexVector& skinningVertexData);
+        void createSkinningPass(StaticVertexSpan staticVertexData, SkinningVertexSpan skinningVertexData);
         void executeSkinningPass(RenderContext* pRenderContext, bool initPrev = false);
 
         ref<Device> mpDevice;
@@ -166,6 +170,22 @@ namespace Falcor
         std::vector<float4x4> mInvTransposeGlobalMatrices;
         std::vector<bool> mMatricesChanged;         ///< Flag per matrix, true if matrix changed since last frame.
 
+        // Scene graph hierarchy
+        std::vector<uint32_t> mChildOffsets;        ///< Offset of the children of each node in mChildren, plus one entry for the end.
+        std::vector<uint32_t> mChildren;            ///< Child node indices grouped by parent.
+        std::vector<uint32_t> mNodeLevels;          ///< Depth of each node in the scene graph, root nodes are at level 0.
+        std::vector<uint32_t> mNodesByLevel;        ///< All node indices sorted by level.
+        std::vector<uint32_t> mLevelOffsets;        ///< Offset of each level in mNodesByLevel, plus one entry for the end.
+
+        // Incremental update
+        std::vector<uint32_t> mEditedNodes;         ///< Nodes passed to setNodeEdited() since the last update.
+        std::vector<uint32_t> mChangedNodes;        ///< Nodes with a new local matrix in the current update.
+        std::vector<uint32_t> mDirtyNodes;          ///< Nodes with a new global matrix in the current update, mMatricesChanged is set for them.
+        std::vector<uint32_t> mPrevDirtyNodes;      ///< Nodes with a new global matrix in the last incremental update, stale in the buffers swapped in next.
+        std::vector<uint32_t> mUpdateNodes;         ///< Scratch: nodes to update sorted by level.
+        std::vector<uint32_t> mUpdateLevelOffsets;  ///< Scratch: offset of each level in mUpdateNodes.
+        std::vector<uint32_t> mUploadNodes;         ///< Scratch: sorted node indices to upload.
+
         bool mFirstUpdate = true;       ///< True if this is the first update.
         bool mEnabled = true;           ///< True if animations are enabled.
         bool mPrevEnabled = false;      ///< True if animations were enabled in previous frame.
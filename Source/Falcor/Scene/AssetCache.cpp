@@ -0,0 +1,194 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "AssetCache.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Logger.h"
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Specfies the current asset cache file version.
+            This needs to be incremented every time the file format or the processing of cached assets changes!
+        */
+        const uint32_t kVersion = 1;
+
+        /** Asset cache directory (subdirectory in the application data directory).
+        */
+        const std::string kDirectory = "NVIDIA/Falcor/AssetCache";
+
+        const char* kMagic = "FalcorA$";
+
+        enum class EntryType : uint32_t
+        {
+            Mesh,
+        };
+
+        struct Header
+        {
+            uint8_t magic[8]{};
+            uint32_t version{};
+            EntryType type{};
+
+            bool isValid(EntryType expectedType) const
+            {
+                return std::memcmp(magic, kMagic, sizeof(Header::magic)) == 0 && version == kVersion && type == expectedType;
+            }
+        };
+
+        template<typename T>
+        void writeVector(std::ostream& stream, const std::vector<T>& vec)
+        {
+            uint64_t len = vec.size();
+            stream.write(reinterpret_cast<const char*>(&len), sizeof(len));
+            stream.write(reinterpret_cast<const char*>(vec.data()), len * sizeof(T));
+        }
+
+        template<typename T>
+        bool readVector(std::istream& stream, std::vector<T>& vec)
+        {
+            uint64_t len = 0;
+            stream.read(reinterpret_cast<char*>(&len), sizeof(len));
+            if (!stream || len > std::numeric_limits<uint32_t>::max()) return false;
+            vec.resize(len);
+            stream.read(reinterpret_cast<char*>(vec.data()), len * sizeof(T));
+            return (bool)stream;
+        }
+
+        struct MeshInfo
+        {
+            uint64_t indexCount;
+            Vao::Topology topology;
+            uint8_t use16BitIndices;
+            uint8_t isFrontFaceCW;
+            uint8_t isAnimated;
+        };
+    }
+
+    bool AssetCache::readMesh(const Key& key, SceneBuilder::ProcessedMesh& mesh)
+    {
+        std::ifstream fs(getEntryPath(key), std::ios_base::binary);
+        if (!fs) return false;
+
+        Header header;
+        fs.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!fs || !header.isValid(EntryType::Mesh)) return false;
+
+        MeshInfo info;
+        fs.read(reinterpret_cast<char*>(&info), sizeof(info));
+        if (!fs) return false;
+
+        SceneBuilder::ProcessedMesh result;
+        if (!readVector(fs, result.indexData) || !readVector(fs, result.staticData) || !readVector(fs, result.skinningData)) return false;
+
+        result.name = std::move(mesh.name);
+        result.pMaterial = std::move(mesh.pMaterial);
+        result.skeletonNodeId = mesh.skeletonNodeId;
+        result.indexCount = info.indexCount;
+        result.topology = info.topology;
+        result.use16BitIndices = info.use16BitIndices != 0;
+        result.isFrontFaceCW = info.isFrontFaceCW != 0;
+        result.isAnimated = info.isAnimated != 0;
+        mesh = std::move(result);
+        return true;
+    }
+
+    void AssetCache::writeMesh(const Key& key, const SceneBuilder::ProcessedMesh& mesh)
+    {
+        auto path = getEntryPath(key);
+
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+
+        // Write to a temporary file first, so that concurrent readers never see a partially written entry.
+        // The cache directory may be shared by several processes, the temporary file gets a random name as thread IDs repeat across processes.
+        thread_local std::mt19937_64 rng = []()
+        {
+            std::random_device rd;
+            return std::mt19937_64((uint64_t(rd()) << 32) | rd());
+        }();
+        auto tmpPath = path;
+        tmpPath += fmt::format(".tmp{:016x}", rng());
+
+        {
+            std::ofstream fs(tmpPath, std::ios_base::binary);
+            if (!fs)
+            {
+                logWarning("Failed to create asset cache entry '{}'.", tmpPath);
+                return;
+            }
+
+            Header header;
+            std::memcpy(header.magic, kMagic, sizeof(Header::magic));
+            header.version = kVersion;
+            header.type = EntryType::Mesh;
+            fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            MeshInfo info = {};
+            info.indexCount = mesh.indexCount;
+            info.topology = mesh.topology;
+            info.use16BitIndices = mesh.use16BitIndices;
+            info.isFrontFaceCW = mesh.isFrontFaceCW;
+            info.isAnimated = mesh.isAnimated;
+            fs.write(reinterpret_cast<const char*>(&info), sizeof(info));
+
+            writeVector(fs, mesh.indexData);
+            writeVector(fs, mesh.staticData);
+            writeVector(fs, mesh.skinningData);
+
+            if (!fs)
+            {
+                logWarning("Failed to write asset cache entry '{}'.", tmpPath);
+                fs.close();
+                std::filesystem::remove(tmpPath, ec);
+                return;
+            }
+        }
+
+        // Another thread may have written the same entry in the meantime, in which case the rename may fail on some platforms.
+        std::filesystem::rename(tmpPath, path, ec);
+        if (ec) std::filesystem::remove(tmpPath, ec);
+    }
+
+    std::filesystem::path AssetCache::getCacheDirectory()
+    {
+        return getAppDataDirectory() / kDirectory;
+    }
+
+    std::filesystem::path AssetCache::getEntryPath(const Key& key)
+    {
+        // Spread entries over subdirectories to keep directory sizes manageable.
+        auto name = SHA1::toString(key);
+        return getCacheDirectory() / name.substr(0, 2) / name;
+    }
+}
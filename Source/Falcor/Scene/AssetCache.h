@@ -0,0 +1,69 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "SceneBuilder.h"
+#include "Core/Macros.h"
+#include "Utils/CryptoUtils.h"
+
+#include <filesystem>
+
+namespace Falcor
+{
+    /** Content-addressed on-disk cache for processed scene assets.
+        Entries are keyed by a hash of the asset's input data and the build options that affect processing,
+        so rebuilding a scene only reprocesses the assets that changed. Each entry is stored in its own file.
+        The cache is best effort: failing to read or write an entry is not an error.
+    */
+    class FALCOR_API AssetCache
+    {
+    public:
+        using Key = SHA1::MD;
+
+        /** Read a processed mesh from the cache.
+            Only the geometry is cached. The name, material and skeleton node of the mesh are left unchanged.
+            \param[in] key Cache key.
+            \param[out] mesh Processed mesh to fill in.
+            \return True if a valid entry was found.
+        */
+        static bool readMesh(const Key& key, SceneBuilder::ProcessedMesh& mesh);
+
+        /** Write a processed mesh to the cache.
+            \param[in] key Cache key.
+            \param[in] mesh Processed mesh.
+        */
+        static void writeMesh(const Key& key, const SceneBuilder::ProcessedMesh& mesh);
+
+        /** Get the directory holding the cache entries.
+        */
+        static std::filesystem::path getCacheDirectory();
+
+        /** Get the path of the file holding the entry of a key.
+        */
+        static std::filesystem::path getEntryPath(const Key& key);
+    };
+}
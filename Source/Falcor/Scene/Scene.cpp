@@ -39,21 +39,22 @@
 #include "Core/API/Device.h"
 #include "Core/API/RenderContext.h"
 #include "Core/API/IndirectCommands.h"
+#include "Core/Platform/MemoryMappedFile.h"
 #include "Utils/StringUtils.h"
 #include "Utils/ObjectIDPython.h"
 #include "Utils/Math/Common.h"
 #include "Utils/Math/MathHelpers.h"
 #include "Utils/Math/Vector.h"
+#include "Utils/Timing/CpuTimer.h"
 #include "Utils/Timing/Profiler.h"
 #include "Utils/UI/InputTypes.h"
 #include "Utils/Scripting/ScriptWriter.h"
-#include "Utils/NumericRange.h"
+#include "Utils/Threading.h"
 
 #include <fstream>
 #include <numeric>
 #include <sstream>
 #include <algorithm>
-#include <execution>
 
 namespace Falcor
 {
@@ -220,16 +221,41 @@ namespace Falcor
         // Setup volume grid -> id map.
         for (size_t i = 0; i < mGrids.size(); ++i) mGridIDs.emplace(mGrids[i], (uint32_t)i);
 
+        // Reserve a grid ID for each streamed grid sequence, later frames of the sequence replace the grid in that slot.
+        // Scenes loaded from the cache don't contain the initial grids, the streamers loaded them from file again.
+        // If the initial frame failed to load, a small placeholder grid keeps the slot until a frame is available.
+        for (const auto& pGridVolume : mGridVolumes)
+        {
+            for (const auto& pStreamer : pGridVolume->mStreamers)
+            {
+                if (!pStreamer || mStreamedGridIDs.count(pStreamer.get()) > 0) continue;
+                ref<Grid> pGrid = pStreamer->getGrid();
+                if (!pGrid)
+                {
+                    logWarning("GridVolume '{}' failed to load the initial frame of a streamed grid sequence, using a placeholder grid.", pGridVolume->getName());
+                    pGrid = Grid::createSphere(mpDevice, 0.5f, 1.f);
+                }
+                auto [it, inserted] = mGridIDs.emplace(pGrid, (uint32_t)mGrids.size());
+                if (inserted) mGrids.push_back(pGrid);
+                mStreamedGridIDs.emplace(pStreamer.get(), it->second);
+            }
+        }
+
         // Set default SDF grid config.
         setSDFGridConfig();
 
         // Create vertex array objects for meshes and curves.
-        createMeshVao(sceneData.meshDrawCount, sceneData.meshIndexData, sceneData.meshStaticData, sceneData.meshSkinningData);
+        // Mesh data may be mapped directly from a scene cache file, in which case it is uploaded without intermediate copies.
+        const auto meshIndexData = sceneData.getMeshIndexData();
+        const auto meshStaticData = sceneData.getMeshStaticData();
+        const auto meshSkinningData = sceneData.getMeshSkinningData();
+        if (sceneData.mappedMeshData) logMappedMeshDataTimes(*sceneData.mappedMeshData);
+        createMeshVao(sceneData.meshDrawCount, meshIndexData, meshStaticData, meshSkinningData);
         createCurveVao(mCurveIndexData, mCurveStaticData);
-        createMeshUVTiles(mMeshDesc, sceneData.meshIndexData, sceneData.meshStaticData);
+        createMeshUVTiles(mMeshDesc, meshIndexData, meshStaticData);
 
         // Create animation controller.
-        mpAnimationController = std::make_unique<AnimationController>(mpDevice, this, sceneData.meshStaticData, sceneData.meshSkinningData, sceneData.prevVertexCount, sceneData.animations);
+        mpAnimationController = std::make_unique<AnimationController>(mpDevice, this, meshStaticData, meshSkinningData, sceneData.prevVertexCount, sceneData.animations);
 
         // Some runtime mesh data validation. These are essentially asserts, but large scenes are mostly opened in Release
         for (const auto& mesh : mMeshDesc)
@@ -257,7 +283,7 @@ namespace Falcor
         }
 
         // Must be placed after curve data/AABB creation.
-        mpAnimationController->addAnimatedVertexCaches(std::move(sceneData.cachedCurves), std::move(sceneData.cachedMeshes), sceneData.meshStaticData);
+        mpAnimationController->addAnimatedVertexCaches(std::move(sceneData.cachedCurves), std::move(sceneData.cachedMeshes), meshStaticData);
 
         // Finalize scene.
         finalize();
@@ -424,7 +450,26 @@ namespace Falcor
         pRenderContext->raytrace(pProgram, pVars.get(), dispatchDims.x, dispatchDims.y, dispatchDims.z);
     }
 
-    void Scene::createMeshVao(uint32_t drawCount, const std::vector<uint32_t>& indexData, const std::vector<PackedStaticVertexData>& staticData, const std::vector<SkinningVertexData>& skinningData)
+    void Scene::logMappedMeshDataTimes(const SceneData::MappedMeshData& mappedMeshData)
+    {
+        // The mapped sections are paged in by this first access right before the upload, the scene cache doesn't touch them on load.
+        // Same as the scene cache log, cold is the first access and warm a second read of the now resident range.
+        auto logSection = [](const char* name, const void* data, size_t size)
+        {
+            if (size == 0) return;
+            auto startTime = CpuTimer::getCurrentTimePoint();
+            MemoryMappedFile::touchPages(data, size);
+            auto coldTime = CpuTimer::getCurrentTimePoint();
+            MemoryMappedFile::touchPages(data, size);
+            auto warmTime = CpuTimer::getCurrentTimePoint();
+            logInfo("Scene cache section '{}': {} bytes, cold {:.2f} ms (mapped), warm {:.2f} ms.", name, size, CpuTimer::calcDuration(startTime, coldTime), CpuTimer::calcDuration(coldTime, warmTime));
+        };
+        logSection("MeshIndexData", mappedMeshData.indexData.data(), mappedMeshData.indexData.size_bytes());
+        logSection("MeshStaticData", mappedMeshData.staticData.data(), mappedMeshData.staticData.size_bytes());
+        logSection("MeshSkinningData", mappedMeshData.skinningData.data(), mappedMeshData.skinningData.size_bytes());
+    }
+
+    void Scene::createMeshVao(uint32_t drawCount, fstd::span<const uint32_t> indexData, fstd::span<const PackedStaticVertexData> staticData, fstd::span<const SkinningVertexData> skinningData)
     {
         if (drawCount == 0) return;
 
@@ -556,7 +601,7 @@ namespace Falcor
         mpCurveVao = Vao::create(Vao::Topology::LineStrip, pLayout, pVBs, pIB, ResourceFormat::R32Uint);
     }
 
-    void Scene::createMeshUVTiles(const std::vector<MeshDesc>& meshDescs, const std::vector<uint32_t>& indexData, const std::vector<PackedStaticVertexData>& staticData)
+    void Scene::createMeshUVTiles(const std::vector<MeshDesc>& meshDescs, fstd::span<const uint32_t> indexData, fstd::span<const PackedStaticVertexData> staticData)
     {
         const uint8_t* indexData8 = reinterpret_cast<const uint8_t*>(indexData.data());
         mMeshUVTiles.resize(meshDescs.size());
@@ -638,8 +683,7 @@ namespace Falcor
                 result.push_back(largeTriangleTile);
         };
 
-        auto range = NumericRange<size_t>(0, meshDescs.size());
-        std::for_each(std::execution::par_unseq, range.begin(), range.end(), processMeshTile);
+        Threading::parallelForEach(0, meshDescs.size(), processMeshTile);
     }
 
     void Scene::setSDFGridConfig()
@@ -1707,8 +1751,8 @@ namespace Falcor
             {
                 // Fetch copy of volume data.
                 auto data = pGridVolume->getData();
-                data.densityGrid = (pGridVolume->getDensityGrid() ? mGridIDs.at(pGridVolume->getDensityGrid()) : SdfGridID::Invalid()).getSlang();
-                data.emissionGrid = (pGridVolume->getEmissionGrid() ? mGridIDs.at(pGridVolume->getEmissionGrid()) : SdfGridID::Invalid()).getSlang();
+                data.densityGrid = getGridID(*pGridVolume, GridVolume::GridSlot::Density).getSlang();
+                data.emissionGrid = getGridID(*pGridVolume, GridVolume::GridSlot::Emission).getSlang();
                 // Merge grid and volume transforms.
                 const auto& densityGrid = pGridVolume->getDensityGrid();
                 if (densityGrid)
@@ -1731,6 +1775,26 @@ namespace Falcor
         return flags;
     }
 
+    SdfGridID Scene::getGridID(const GridVolume& gridVolume, GridVolume::GridSlot slot)
+    {
+        const auto& pGrid = gridVolume.getGrid(slot);
+        if (!pGrid) return SdfGridID::Invalid();
+        if (auto it = mGridIDs.find(pGrid); it != mGridIDs.end()) return it->second;
+
+        // Grids of streamed sequences are loaded after the scene was created, they replace the grid in the reserved slot.
+        const auto& pStreamer = gridVolume.getGridSequenceStreamer(slot);
+        auto it = pStreamer ? mStreamedGridIDs.find(pStreamer.get()) : mStreamedGridIDs.end();
+        if (it == mStreamedGridIDs.end())
+            FALCOR_THROW("GridVolume '{}' uses a grid that was not part of the scene when it was created.", gridVolume.getName());
+
+        const SdfGridID gridID = it->second;
+        mGridIDs.erase(mGrids[gridID.get()]);
+        mGrids[gridID.get()] = pGrid;
+        mGridIDs.emplace(pGrid, gridID);
+        pGrid->bindShaderData(mpSceneBlock->getRootVar()["grids"][gridID.get()]);
+        return gridID;
+    }
+
     void Scene::bindGridVolumes()
     {
         auto var = mpSceneBlock->getRootVar();
@@ -54,6 +54,8 @@
 #include "Utils/UI/Gui.h"
 #include "Utils/Settings/Settings.h"
 
+#include <fstd/span.h>
+
 #include <functional>
 #include <memory>
 #include <type_traits>
@@ -70,6 +72,7 @@ namespace Falcor
     struct GamepadState;
 
     class RtProgramVars;
+    class MemoryMappedFile;
 
     /** This class is the main scene representation.
         It holds all scene resources such as geometry, cameras, lights, and materials.
@@ -339,6 +342,22 @@ namespace Falcor
             std::vector<PackedStaticVertexData> meshStaticData;     ///< Vertex attributes for all meshes in packed format.
             std::vector<SkinningVertexData> meshSkinningData;       ///< Additional vertex attributes for skinned meshes.
 
+            /** Mesh geometry referenced directly in a memory-mapped scene cache file.
+                The views are used in place of meshIndexData, meshStaticData and meshSkinningData when those are empty.
+            */
+            struct MappedMeshData
+            {
+                std::shared_ptr<const MemoryMappedFile> pFile;      ///< Mapped cache file. Keeps the views below valid.
+                fstd::span<const uint32_t> indexData;
+                fstd::span<const PackedStaticVertexData> staticData;
+                fstd::span<const SkinningVertexData> skinningData;
+            };
+            std::optional<MappedMeshData> mappedMeshData;
+
+            fstd::span<const uint32_t> getMeshIndexData() const { return meshIndexData.empty() && mappedMeshData ? mappedMeshData->indexData : fstd::span<const uint32_t>(meshIndexData); }
+            fstd::span<const PackedStaticVertexData> getMeshStaticData() const { return meshStaticData.empty() && mappedMeshData ? mappedMeshData->staticData : fstd::span<const PackedStaticVertexData>(meshStaticData); }
+            fstd::span<const SkinningVertexData> getMeshSkinningData() const { return meshSkinningData.empty() && mappedMeshData ? mappedMeshData->skinningData : fstd::span<const SkinningVertexData>(meshSkinningData); }
+
             // Curve data
             std::vector<CurveDesc> curveDesc;                       ///< List of curve descriptors.
             std::vector<AABB> curveBBs;                             ///< List of curve bounding boxes in object space. Each curve consists of many segments, each with its own AABB. The bounding boxes here are the unions of those.
@@ -1129,9 +1148,10 @@ namespace Falcor
         static constexpr uint32_t kDrawIdBufferIndex = kStaticDataBufferIndex + 1;
         static constexpr uint32_t kVertexBufferCount = kDrawIdBufferIndex + 1;
 
-        void createMeshVao(uint32_t drawCount, const std::vector<uint32_t>& indexData, const std::vector<PackedStaticVertexData>& staticData, const std::vector<SkinningVertexData>& skinningData);
+        void logMappedMeshDataTimes(const SceneData::MappedMeshData& mappedMeshData);
+        void createMeshVao(uint32_t drawCount, fstd::span<const uint32_t> indexData, fstd::span<const PackedStaticVertexData> staticData, fstd::span<const SkinningVertexData> skinningData);
         void createCurveVao(const std::vector<uint32_t>& indexData, const std::vector<StaticCurveVertexData>& staticData);
-        void createMeshUVTiles(const std::vector<MeshDesc>& meshDesc, const std::vector<uint32_t>& indexData, const std::vector<PackedStaticVertexData>& staticData);
+        void createMeshUVTiles(const std::vector<MeshDesc>& meshDesc, fstd::span<const uint32_t> indexData, fstd::span<const PackedStaticVertexData> staticData);
 
         void updateSceneDefines();
         DefineList getSceneSDFGridDefines() const;
@@ -1221,6 +1241,7 @@ namespace Falcor
         UpdateFlags updateSelectedCamera(bool forceUpdate);
         UpdateFlags updateLights(bool forceUpdate);
         UpdateFlags updateGridVolumes(bool forceUpdate);
+        SdfGridID getGridID(const GridVolume& gridVolume, GridVolume::GridSlot slot);
         UpdateFlags updateEnvMap(bool forceUpdate);
         UpdateFlags updateMaterials(bool forceUpdate);
         UpdateFlags updateGeometry(RenderContext* pRenderContext, bool forceUpdate);
@@ -1326,6 +1347,7 @@ namespace Falcor
         std::vector<ref<GridVolume>> mGridVolumes;                  ///< All loaded grid volumes.
         std::vector<ref<Grid>> mGrids;                              ///< All loaded grids.
         std::unordered_map<ref<Grid>, SdfGridID> mGridIDs;          ///< Lookup table for grid IDs.
+        std::unordered_map<const GridSequenceStreamer*, SdfGridID> mStreamedGridIDs; ///< Grid IDs reserved for streamed grid sequences, rebound to the current grid of the sequence.
         ref<LightCollection> mpLightCollection;                     ///< Class for managing emissive geometry. This is created lazily upon first use.
         ref<EnvMap> mpEnvMap;                                       ///< Environment map or nullptr if not loaded.
         bool mEnvMapChanged = false;                                ///< Flag indicating that the environment map has changed since last frame.
@@ -27,6 +27,7 @@
  **************************************************************************/
 #include "SceneBuilder.h"
 #include "SceneCache.h"
+#include "AssetCache.h"
 #include "Importer.h"
 #include "Curves/CurveConfig.h"
 #include "Material/StandardMaterial.h"
@@ -37,11 +38,19 @@
 #include "Utils/Scripting/ScriptBindings.h"
 #include "Utils/Math/MathHelpers.h"
 #include "Utils/ObjectIDPython.h"
-#include "Utils/NumericRange.h"
+#include "Utils/Threading.h"
+#include "Utils/Timing/CpuTimer.h"
 #include <mikktspace.h>
+#include <fstd/bit.h>
 #include <filesystem>
 #include <cmath>
-#include <execution>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FALCOR_VERTEX_KEY_SSE 1
+#else
+#define FALCOR_VERTEX_KEY_SSE 0
+#endif
 
 namespace Falcor
 {
@@ -164,7 +173,10 @@ namespace Falcor
             if (isZero(v.normal) || isZero(v.tangent.xyz())) zeroCount++;
         }
 
-        bool compareVertices(const SceneBuilder::Mesh::Vertex& lhs, const SceneBuilder::Mesh::Vertex& rhs, float threshold = 1e-6f)
+        // Threshold for comparing non-position vertex attributes when merging vertices.
+        const float kVertexCompareThreshold = 1e-6f;
+
+        bool compareVertices(const SceneBuilder::Mesh::Vertex& lhs, const SceneBuilder::Mesh::Vertex& rhs, float threshold = kVertexCompareThreshold)
         {
             if (any(lhs.position != rhs.position)) return false; // Position need to be exact to avoid cracks
             if (lhs.tangent.w != rhs.tangent.w) return false;
@@ -177,6 +189,131 @@ namespace Falcor
             return true;
         }
 
+        /** Vertex attributes laid out for vectorized comparison and hashing.
+            Attributes that compareVertices() requires to match exactly are stored as raw bits in 'exact',
+            attributes compared against a threshold are stored in 'approx'. Unused lanes are zero.
+        */
+        struct alignas(16) VertexKey
+        {
+            uint32_t exact[12] = {};
+            float approx[12] = {};
+
+            VertexKey(const SceneBuilder::Mesh::Vertex& v)
+            {
+                // Map -0 to +0 so that the bitwise comparison matches the float comparison in compareVertices().
+                auto bits = [](float f) { return fstd::bit_cast<uint32_t>(f == 0.f ? 0.f : f); };
+                exact[0] = bits(v.position.x);
+                exact[1] = bits(v.position.y);
+                exact[2] = bits(v.position.z);
+                exact[3] = bits(v.tangent.w);
+                exact[4] = bits(v.curveRadius);
+                exact[5] = v.boneIDs.x;
+                exact[6] = v.boneIDs.y;
+                exact[7] = v.boneIDs.z;
+                exact[8] = v.boneIDs.w;
+
+                approx[0] = v.normal.x;
+                approx[1] = v.normal.y;
+                approx[2] = v.normal.z;
+                approx[3] = v.tangent.x;
+                approx[4] = v.tangent.y;
+                approx[5] = v.tangent.z;
+                approx[6] = v.texCrd.x;
+                approx[7] = v.texCrd.y;
+                approx[8] = v.boneWeights.x;
+                approx[9] = v.boneWeights.y;
+                approx[10] = v.boneWeights.z;
+                approx[11] = v.boneWeights.w;
+            }
+
+            /** Hash of the attributes that must match exactly.
+                Vertices that only differ in the thresholded attributes (e.g. split normals) share a hash and are told apart by equals().
+            */
+            uint32_t hash() const
+            {
+                uint32_t h = 2166136261u; // FNV-1a
+                for (uint32_t i = 0; i < 9; i++)
+                {
+                    h ^= exact[i];
+                    h *= 16777619u;
+                }
+                return h;
+            }
+
+            /** Same result as compareVertices() on the original vertices.
+            */
+            bool equals(const VertexKey& other, float threshold) const
+            {
+#if FALCOR_VERTEX_KEY_SSE
+                __m128i eq = _mm_set1_epi32(-1);
+                __m128 differs = _mm_setzero_ps();
+                const __m128 thresholdVec = _mm_set1_ps(threshold);
+                const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+                for (uint32_t i = 0; i < 12; i += 4)
+                {
+                    const __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(exact + i));
+                    const __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(other.exact + i));
+                    eq = _mm_and_si128(eq, _mm_cmpeq_epi32(a, b));
+
+                    const __m128 d = _mm_and_ps(_mm_sub_ps(_mm_load_ps(approx + i), _mm_load_ps(other.approx + i)), absMask);
+                    differs = _mm_or_ps(differs, _mm_cmpgt_ps(d, thresholdVec));
+                }
+                return _mm_movemask_epi8(eq) == 0xffff && _mm_movemask_ps(differs) == 0;
+#else
+                for (uint32_t i = 0; i < 12; i++)
+                {
+                    if (exact[i] != other.exact[i]) return false;
+                    if (std::abs(approx[i] - other.approx[i]) > threshold) return false;
+                }
+                return true;
+#endif
+            }
+        };
+
+        /** Open-addressing hash table (linear probing) mapping vertex keys to vertex indices.
+            The keys themselves are stored by the caller, the table only stores hashes and indices.
+        */
+        class VertexHashTable
+        {
+        public:
+            VertexHashTable(size_t maxVertexCount)
+            {
+                // Keep the load factor at or below 0.5.
+                const size_t capacity = fstd::bit_ceil(std::max<size_t>(2 * maxVertexCount, 16));
+                FALCOR_CHECK(capacity <= std::numeric_limits<uint32_t>::max(), "Mesh is too large for vertex deduplication.");
+                mSlots.resize(capacity);
+                mMask = (uint32_t)(capacity - 1);
+            }
+
+            /** Find a vertex equal to 'key' or insert it with the given index.
+                \return Index of the equal vertex if found, otherwise 'newIndex'.
+            */
+            uint32_t findOrInsert(const VertexKey& key, uint32_t newIndex, const std::vector<VertexKey>& keys, float threshold)
+            {
+                const uint32_t hash = key.hash();
+                for (uint32_t slot = hash & mMask;; slot = (slot + 1) & mMask)
+                {
+                    Slot& s = mSlots[slot];
+                    if (s.index == kInvalidIndex)
+                    {
+                        s = { hash, newIndex };
+                        return newIndex;
+                    }
+                    if (s.hash == hash && keys[s.index].equals(key, threshold)) return s.index;
+                }
+            }
+
+        private:
+            static constexpr uint32_t kInvalidIndex = 0xffffffff;
+            struct Slot
+            {
+                uint32_t hash = 0;
+                uint32_t index = kInvalidIndex;
+            };
+            std::vector<Slot> mSlots;
+            uint32_t mMask = 0;
+        };
+
         std::vector<uint32_t> compact16BitIndices(const std::vector<uint32_t>& indices)
         {
             if (indices.empty()) return {};
@@ -193,7 +330,7 @@ namespace Falcor
 
         SceneCache::Key computeSceneCacheKey(const std::filesystem::path& path, SceneBuilder::Flags buildFlags)
         {
-            SceneBuilder::Flags cacheFlags = buildFlags & (~(SceneBuilder::Flags::UseCache | SceneBuilder::Flags::RebuildCache));
+            SceneBuilder::Flags cacheFlags = buildFlags & (~(SceneBuilder::Flags::UseCache | SceneBuilder::Flags::RebuildCache | SceneBuilder::Flags::CompressCache | SceneBuilder::Flags::UseAssetCache));
             SHA1 sha1;
             auto pathStr = path.string();
             sha1.update(pathStr.data(), pathStr.size());
@@ -201,6 +338,47 @@ namespace Falcor
             return sha1.finalize();
 
         }
+
+        /** Compute the asset cache key of a mesh from all inputs of processMesh().
+        */
+        AssetCache::Key computeMeshCacheKey(SceneBuilder::Mesh& mesh, SceneBuilder::Flags buildFlags)
+        {
+            const SceneBuilder::Flags processFlags = buildFlags & (SceneBuilder::Flags::UseOriginalTangentSpace | SceneBuilder::Flags::DeduplicateVerticesGlobally |
+                SceneBuilder::Flags::NonIndexedVertices | SceneBuilder::Flags::Force32BitIndices);
+
+            SHA1 sha1;
+            sha1.update(std::string_view("Mesh"));
+            sha1.update((uint32_t)processFlags);
+            sha1.update(mesh.faceCount);
+            sha1.update(mesh.vertexCount);
+            sha1.update(mesh.indexCount);
+            sha1.update((uint32_t)mesh.topology);
+            sha1.update(mesh.isFrontFaceCW);
+            sha1.update(mesh.isAnimated);
+            sha1.update(mesh.useOriginalTangentSpace);
+            sha1.update(mesh.mergeDuplicateVertices);
+            sha1.update(mesh.pIndices, mesh.indexCount * sizeof(uint32_t));
+
+            // Texture coordinates are pretransformed by the material's texture transform.
+            const float4x4 textureTransform = mesh.pMaterial->getTextureTransform().getMatrix();
+            sha1.update(&textureTransform, sizeof(textureTransform));
+
+            auto hashAttribute = [&](const auto& attribute)
+            {
+                sha1.update((uint32_t)attribute.frequency);
+                sha1.update(attribute.pData != nullptr);
+                if (attribute.pData) sha1.update(attribute.pData, mesh.getAttributeCount(attribute) * sizeof(attribute.pData[0]));
+            };
+            hashAttribute(mesh.positions);
+            hashAttribute(mesh.normals);
+            hashAttribute(mesh.tangents);
+            hashAttribute(mesh.texCrds);
+            hashAttribute(mesh.curveRadii);
+            hashAttribute(mesh.boneIDs);
+            hashAttribute(mesh.boneWeights);
+
+            return sha1.finalize();
+        }
     }
 
     SceneBuilder::SceneBuilder(ref<Device> pDevice, const Settings& settings, Flags flags)
@@ -340,6 +518,18 @@ namespace Falcor
             addMeshInstance(nodeID, meshID);
         }
 
+        if (uint64_t inputVertexCount = mVertexDedupStats.inputVertexCount)
+        {
+            uint64_t outputVertexCount = mVertexDedupStats.outputVertexCount;
+            logInfo("Global vertex deduplication: {} face vertices merged to {} vertices (ratio {:.3f}), {:.1f} ms total.",
+                inputVertexCount, outputVertexCount, (double)outputVertexCount / inputVertexCount, mVertexDedupStats.timeNs * 1e-6);
+        }
+
+        if (is_set(mFlags, Flags::UseAssetCache))
+        {
+            logInfo("Asset cache: {} meshes loaded from cache, {} meshes processed.", mAssetCacheStats.hitCount.load(), mAssetCacheStats.missCount.load());
+        }
+
         // Post-process the scene data.
         TimeReport timeReport;
 
@@ -390,7 +580,7 @@ namespace Falcor
         // Write scene cache if requested.
         if (mWriteSceneCache)
         {
-            SceneCache::writeCache(mSceneData, mSceneCacheKey);
+            SceneCache::writeCache(mSceneData, mSceneCacheKey, is_set(mFlags, Flags::CompressCache));
             timeReport.measure("Writing cache");
         }
 
@@ -412,6 +602,32 @@ namespace Falcor
     }
 
     MeshID SceneBuilder::addTriangleMesh(const ref<TriangleMesh>& pTriangleMesh, const ref<Material>& pMaterial, bool isAnimated)
+    {
+        TriangleMeshAttributes attributes;
+        return addMesh(createMeshFromTriangleMesh(pTriangleMesh, pMaterial, isAnimated, attributes));
+    }
+
+    std::vector<MeshID> SceneBuilder::addMeshes(fstd::span<const Mesh> meshes)
+    {
+        return addProcessedMeshes(processMeshes(meshes));
+    }
+
+    std::vector<MeshID> SceneBuilder::addTriangleMeshes(fstd::span<const ref<TriangleMesh>> triangleMeshes, fstd::span<const ref<Material>> materials, bool isAnimated)
+    {
+        FALCOR_CHECK(triangleMeshes.size() == materials.size(), "Expected one material per triangle mesh ({} meshes, {} materials).", triangleMeshes.size(), materials.size());
+
+        // Convert and pre-process in the same task so the temporary attribute arrays are released early.
+        std::vector<ProcessedMesh> processedMeshes(triangleMeshes.size());
+        parallelForEachMesh(triangleMeshes.size(), [&](size_t i)
+        {
+            TriangleMeshAttributes attributes;
+            processedMeshes[i] = processMesh(createMeshFromTriangleMesh(triangleMeshes[i], materials[i], isAnimated, attributes));
+        });
+
+        return addProcessedMeshes(processedMeshes);
+    }
+
+    SceneBuilder::Mesh SceneBuilder::createMeshFromTriangleMesh(const ref<TriangleMesh>& pTriangleMesh, const ref<Material>& pMaterial, bool isAnimated, TriangleMeshAttributes& attributes)
     {
         FALCOR_CHECK(pTriangleMesh != nullptr, "'pTriangleMesh' is missing");
         FALCOR_CHECK(pMaterial != nullptr, "'pMaterial' is missing");
@@ -431,9 +647,12 @@ namespace Falcor
         mesh.pMaterial = pMaterial;
         mesh.isAnimated = isAnimated;
 
-        std::vector<float3> positions(vertices.size());
-        std::vector<float3> normals(vertices.size());
-        std::vector<float2> texCoords(vertices.size());
+        auto& positions = attributes.positions;
+        auto& normals = attributes.normals;
+        auto& texCoords = attributes.texCoords;
+        positions.resize(vertices.size());
+        normals.resize(vertices.size());
+        texCoords.resize(vertices.size());
         std::transform(vertices.begin(), vertices.end(), positions.begin(), [] (const auto& v) { return v.position; });
         std::transform(vertices.begin(), vertices.end(), normals.begin(), [] (const auto& v) { return v.normal; });
         std::transform(vertices.begin(), vertices.end(), texCoords.begin(), [] (const auto& v) { return v.texCoord; });
@@ -442,7 +661,37 @@ namespace Falcor
         mesh.normals = { normals.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex };
         mesh.texCrds = { texCoords.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex };
 
-        return addMesh(mesh);
+        return mesh;
+    }
+
+    std::vector<SceneBuilder::ProcessedMesh> SceneBuilder::processMeshes(fstd::span<const Mesh> meshes) const
+    {
+        std::vector<ProcessedMesh> processedMeshes(meshes.size());
+        parallelForEachMesh(meshes.size(), [&](size_t i) { processedMeshes[i] = processMesh(meshes[i]); });
+        return processedMeshes;
+    }
+
+    void SceneBuilder::parallelForEachMesh(size_t count, const std::function<void(size_t)>& func)
+    {
+        // Store exceptions per mesh and rethrow the one with the lowest index.
+        // This makes the reported error independent of the scheduling.
+        std::vector<std::exception_ptr> exceptions(count);
+        Threading::parallelForEach(0, count, [&](size_t i)
+        {
+            try
+            {
+                func(i);
+            }
+            catch (...)
+            {
+                exceptions[i] = std::current_exception();
+            }
+        }, 1);
+
+        for (const auto& e : exceptions)
+        {
+            if (e) std::rethrow_exception(e);
+        }
     }
 
     SceneBuilder::ProcessedMesh SceneBuilder::processMesh(const Mesh& mesh_, MeshAttributeIndices* pAttributeIndices, std::vector<float4>* pTangents) const
@@ -495,6 +744,19 @@ namespace Falcor
             if (mesh.boneWeights.pData == nullptr) throw_on_missing_element("bone weights");
         }
 
+        // Look up the mesh in the asset cache. Requests for intermediate data always process the mesh.
+        AssetCache::Key assetCacheKey;
+        const bool useAssetCache = is_set(mFlags, Flags::UseAssetCache) && !pAttributeIndices && !pTangents;
+        if (useAssetCache)
+        {
+            assetCacheKey = computeMeshCacheKey(mesh, mFlags);
+            if (AssetCache::readMesh(assetCacheKey, processedMesh))
+            {
+                mAssetCacheStats.hitCount++;
+                return processedMesh;
+            }
+        }
+
         // Generate tangent space if that's required.
         std::vector<float4> localTangents;
         if (!pTangents)
@@ -549,7 +811,52 @@ namespace Falcor
             pAttributeIndices->reserve(mesh.vertexCount);
         }
 
-        if (mesh.mergeDuplicateVertices)
+        if (mesh.mergeDuplicateVertices && is_set(mFlags, Flags::DeduplicateVerticesGlobally))
+        {
+            // Merge identical vertices across the whole mesh, regardless of the original vertex index.
+            // This catches duplicates in meshes where faces reference positions via per-face attributes.
+            auto startTime = CpuTimer::getCurrentTimePoint();
+
+            vertices.reserve(mesh.vertexCount);
+            std::vector<VertexKey> keys;
+            keys.reserve(mesh.vertexCount);
+            VertexHashTable table(mesh.indexCount);
+
+            for (uint32_t face = 0; face < mesh.faceCount; face++)
+            {
+                for (uint32_t vert = 0; vert < 3; vert++)
+                {
+                    const Mesh::Vertex v = mesh.getVertex(face, vert);
+                    const VertexKey key(v);
+                    const uint32_t newIndex = (uint32_t)vertices.size();
+                    const uint32_t index = table.findOrInsert(key, newIndex, keys, kVertexCompareThreshold);
+
+                    if (index == newIndex)
+                    {
+                        FALCOR_ASSERT(vertices.size() < std::numeric_limits<uint32_t>::max());
+                        vertices.push_back({ v, invalidIndex });
+                        keys.push_back(key);
+
+                        if (pAttributeIndices)
+                        {
+                            pAttributeIndices->push_back(mesh.getAttributeIndices(face, vert));
+                            FALCOR_ASSERT(vertices.size() == pAttributeIndices->size());
+                        }
+                    }
+
+                    indices[face * 3 + vert] = index;
+                }
+            }
+
+            auto endTime = CpuTimer::getCurrentTimePoint();
+            const double timeMs = CpuTimer::calcDuration(startTime, endTime);
+            mVertexDedupStats.inputVertexCount += mesh.indexCount;
+            mVertexDedupStats.outputVertexCount += vertices.size();
+            mVertexDedupStats.timeNs += (uint64_t)(timeMs * 1e6);
+            logDebug("Mesh '{}': deduplicated {} face vertices to {} vertices (ratio {:.3f}) in {:.3f} ms.",
+                mesh.name, mesh.indexCount, vertices.size(), (double)vertices.size() / mesh.indexCount, timeMs);
+        }
+        else if (mesh.mergeDuplicateVertices)
         {
             vertices.reserve(mesh.vertexCount);
 
@@ -690,6 +997,12 @@ namespace Falcor
             }
         }
 
+        if (useAssetCache)
+        {
+            AssetCache::writeMesh(assetCacheKey, processedMesh);
+            mAssetCacheStats.missCount++;
+        }
+
         return processedMesh;
     }
 
@@ -708,13 +1021,12 @@ namespace Falcor
             if (mesh.tangents.pData)
             {
                 FALCOR_ASSERT(mesh.tangents.frequency == Mesh::AttributeFrequency::FaceVarying);
-                NumericRange<uint32_t> range(0, mesh.indexCount);
-                std::for_each(std::execution::par_unseq, range.begin(), range.end(), [&](uint32_t fvIndex)
+                Threading::parallelForEach(0, mesh.indexCount, [&](size_t fvIndex)
                 {
                     if (!any(isnan(mesh.tangents.pData[fvIndex])))
                         return;
-                    uint32_t faceIndex = fvIndex / 3;
-                    uint32_t vertexIndex = fvIndex % 3;
+                    uint32_t faceIndex = uint32_t(fvIndex / 3);
+                    uint32_t vertexIndex = uint32_t(fvIndex % 3);
                     float3 normal = mesh.getNormal(faceIndex, vertexIndex);
                     tangents[fvIndex] = float4(perp_stark(normal), 1.f);
                 });
@@ -772,6 +1084,16 @@ namespace Falcor
         return MeshID(mMeshes.size() - 1);
     }
 
+    std::vector<MeshID> SceneBuilder::addProcessedMeshes(fstd::span<const ProcessedMesh> meshes)
+    {
+        // Meshes are added sequentially to retain a deterministic order in the global scene buffers.
+        std::vector<MeshID> meshIDs;
+        meshIDs.reserve(meshes.size());
+        for (const auto& mesh : meshes)
+            meshIDs.push_back(addProcessedMesh(mesh));
+        return meshIDs;
+    }
+
     void SceneBuilder::addCachedMeshes(std::vector<CachedMesh>&& cachedMeshes)
     {
         mSceneData.cachedMeshes.reserve(mSceneData.cachedMeshes.size() + cachedMeshes.size());
@@ -2939,8 +3261,11 @@ namespace Falcor
         flags.value("DontUseDisplacement", SceneBuilder::Flags::DontUseDisplacement);
         flags.value("UseCompressedHitInfo", SceneBuilder::Flags::UseCompressedHitInfo);
         flags.value("TessellateCurvesIntoPolyTubes", SceneBuilder::Flags::TessellateCurvesIntoPolyTubes);
+        flags.value("DeduplicateVerticesGlobally", SceneBuilder::Flags::DeduplicateVerticesGlobally);
         flags.value("UseCache", SceneBuilder::Flags::UseCache);
         flags.value("RebuildCache", SceneBuilder::Flags::RebuildCache);
+        flags.value("UseAssetCache", SceneBuilder::Flags::UseAssetCache);
+        flags.value("CompressCache", SceneBuilder::Flags::CompressCache);
         ScriptBindings::addEnumBinaryOperators(flags);
 
         pybind11::class_<SceneBuilder> sceneBuilder(m, "SceneBuilder");
@@ -2957,6 +3282,13 @@ namespace Falcor
         sceneBuilder.def_property("cameraSpeed", &SceneBuilder::getCameraSpeed, &SceneBuilder::setCameraSpeed);
         sceneBuilder.def("importScene", &SceneBuilder::import, "path"_a, "dict"_a = pybind11::dict());
         sceneBuilder.def("addTriangleMesh", &SceneBuilder::addTriangleMesh, "triangleMesh"_a, "material"_a, "isAnimated"_a = false);
+        sceneBuilder.def("addTriangleMeshes",
+            [](SceneBuilder& self, const std::vector<ref<TriangleMesh>>& triangleMeshes, const std::vector<ref<Material>>& materials, bool isAnimated)
+            {
+                return self.addTriangleMeshes(triangleMeshes, materials, isAnimated);
+            },
+            "triangleMeshes"_a, "materials"_a, "isAnimated"_a = false
+        );
         sceneBuilder.def("addSDFGrid", &SceneBuilder::addSDFGrid, "sdfGrid"_a, "material"_a);
         sceneBuilder.def("addMaterial", &SceneBuilder::addMaterial, "material"_a);
         sceneBuilder.def("replaceMaterial", &SceneBuilder::replaceMaterial, "material"_a, "replacement"_a);
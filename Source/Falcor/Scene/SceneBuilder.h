@@ -44,7 +44,9 @@
 #include "Utils/Settings/Settings.h"
 
 #include <pybind11/pytypes.h>
+#include <fstd/span.h>
 
+#include <atomic>
 #include <filesystem>
 #include <memory>
 #include <string>
@@ -77,9 +79,12 @@ namespace Falcor
             DontUseDisplacement             = 0x4000,   ///< Don't use displacement mapping.
             UseCompressedHitInfo            = 0x8000,   ///< Use compressed hit info (on scenes with triangle meshes only).
             TessellateCurvesIntoPolyTubes   = 0x10000,  ///< Tessellate curves into poly-tubes (the default is linear swept spheres).
+            DeduplicateVerticesGlobally     = 0x20000,  ///< Merge identical vertices across the whole mesh using a hash table. By default, only vertices referenced through the same original index are merged.
 
+            UseAssetCache                   = 0x08000000, ///< Cache processed meshes individually on disk, keyed by their content and the build flags that affect processing. Only meshes that changed are reprocessed on rebuild.
             UseCache                        = 0x10000000, ///< Enable scene caching. This caches the runtime scene representation on disk to reduce load time.
             RebuildCache                    = 0x20000000, ///< Rebuild scene cache.
+            CompressCache                   = 0x40000000, ///< Compress geometry data when writing the scene cache. Reduces disk usage at the cost of decompression on load.
 
             Default = None
         };
@@ -422,6 +427,23 @@ namespace Falcor
         */
         MeshID addTriangleMesh(const ref<TriangleMesh>& pTriangleMesh, const ref<Material>& pMaterial, bool isAnimated = false);
 
+        /** Add a batch of meshes.
+            The meshes are pre-processed in parallel (validation, tangent generation, texture coordinate pretransform and vertex merging)
+            and then added in order, so the resulting mesh IDs are the same as when calling addMesh() for each mesh in turn.
+            Throws an exception if something went wrong. If several meshes fail, the error of the first failing mesh is reported.
+            \param meshes The meshes to add.
+            \return The IDs of the meshes in the scene, in the same order as the input.
+        */
+        std::vector<MeshID> addMeshes(fstd::span<const Mesh> meshes);
+
+        /** Add a batch of triangle meshes. See addMeshes().
+            \param triangleMeshes The triangle meshes to add.
+            \param materials The material to use for each mesh. The element count must match `triangleMeshes`.
+            \param isAnimated True if the mesh vertices can be modified during rendering (e.g., skinning or inverse rendering).
+            \return The IDs of the meshes in the scene, in the same order as the input.
+        */
+        std::vector<MeshID> addTriangleMeshes(fstd::span<const ref<TriangleMesh>> triangleMeshes, fstd::span<const ref<Material>> materials, bool isAnimated = false);
+
         /** Pre-process a mesh into the data format that is used in the global scene buffers.
             Throws an exception if something went wrong.
             \param mesh The mesh to pre-process.
@@ -437,12 +459,25 @@ namespace Falcor
         */
         static void generateTangents(Mesh& mesh, std::vector<float4>& tangents);
 
+        /** Pre-process a batch of meshes in parallel. See processMesh().
+            Throws an exception if something went wrong. If several meshes fail, the error of the first failing mesh is reported.
+            \param meshes The meshes to pre-process.
+            \return The pre-processed meshes, in the same order as the input.
+        */
+        std::vector<ProcessedMesh> processMeshes(fstd::span<const Mesh> meshes) const;
+
         /** Add a pre-processed mesh.
             \param mesh The pre-processed mesh.
             \return The ID of the mesh in the scene. Note that all of the instances share the same mesh ID.
         */
         MeshID addProcessedMesh(const ProcessedMesh& mesh);
 
+        /** Add a batch of pre-processed meshes in order.
+            \param meshes The pre-processed meshes.
+            \return The IDs of the meshes in the scene, in the same order as the input.
+        */
+        std::vector<MeshID> addProcessedMeshes(fstd::span<const ProcessedMesh> meshes);
+
         /** Add mesh vertex cache for animation.
             \param[in] cachedCurves The mesh vertex cache data (will be moved from).
         */
@@ -783,7 +818,38 @@ namespace Falcor
 
         std::unique_ptr<MaterialTextureLoader> mpMaterialTextureLoader;
 
+        /** Statistics for global vertex deduplication, accumulated over all processed meshes.
+            Updated from processMesh(), which may run concurrently.
+        */
+        struct VertexDedupStats
+        {
+            std::atomic<uint64_t> inputVertexCount{0};  ///< Number of face vertices before deduplication.
+            std::atomic<uint64_t> outputVertexCount{0}; ///< Number of unique vertices after deduplication.
+            std::atomic<uint64_t> timeNs{0};            ///< Total time spent deduplicating.
+        };
+        mutable VertexDedupStats mVertexDedupStats;
+
+        /** Statistics for the per-asset cache. Updated from processMesh(), which may run concurrently.
+        */
+        struct AssetCacheStats
+        {
+            std::atomic<uint64_t> hitCount{0};          ///< Number of meshes loaded from the asset cache.
+            std::atomic<uint64_t> missCount{0};         ///< Number of meshes processed and written to the asset cache.
+        };
+        mutable AssetCacheStats mAssetCacheStats;
+
+        /** Temporary attribute arrays referenced by a Mesh created from a TriangleMesh.
+        */
+        struct TriangleMeshAttributes
+        {
+            std::vector<float3> positions;
+            std::vector<float3> normals;
+            std::vector<float2> texCoords;
+        };
+
         // Helpers
+        static Mesh createMeshFromTriangleMesh(const ref<TriangleMesh>& pTriangleMesh, const ref<Material>& pMaterial, bool isAnimated, TriangleMeshAttributes& attributes);
+        static void parallelForEachMesh(size_t count, const std::function<void(size_t)>& func);
         bool doesNodeHaveAnimation(NodeID nodeID) const;
         void updateLinkedObjects(NodeID oldNodeID, NodeID newNodeID);
         bool collapseNodes(NodeID parentNodeID, NodeID childNodeID);
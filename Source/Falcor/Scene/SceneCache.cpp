@@ -31,10 +31,19 @@
 #include "Material/ClothMaterial.h"
 #include "Material/MaterialTextureLoader.h"
 #include "Utils/Logger.h"
+#include "Utils/Math/Common.h"
+#include "Utils/Timing/CpuTimer.h"
+#include "Utils/Threading.h"
+#include "Core/Platform/MemoryMappedFile.h"
 
 #include <lz4_stream/lz4_stream.h>
+#include <lz4.h>
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <set>
+#include <streambuf>
 
 namespace Falcor
 {
@@ -43,7 +52,13 @@ namespace Falcor
         /** Specfies the current cache file version.
             This needs to be incremented every time the file format changes!
         */
-        const uint32_t kVersion = 25;
+        const uint32_t kVersion = 28;
+
+        /** Oldest cache file version that can still be read.
+            Version 26 files have no section encoding table and store all bulk sections uncompressed.
+            Versions before 28 have no streamed grid sequences.
+        */
+        const uint32_t kMinVersion = 26;
 
         /** Scene cache directory (subdirectory in the application data directory).
         */
@@ -51,15 +66,266 @@ namespace Falcor
 
         const size_t kBlockSize = 1 * 1024 * 1024;
 
+        /** Alignment of section offsets in the cache file.
+            Sections start on a page boundary so they can be used directly from a memory mapping.
+        */
+        const uint64_t kSectionAlignment = 4096;
+
+        /** Uncompressed size of a chunk in compressed sections.
+            Chunks are compressed independently so they can be decoded in parallel.
+        */
+        const uint64_t kChunkSize = 1 * 1024 * 1024;
+
+        /** Sections of the cache file.
+            The scene data section holds the compressed serialized scene, the remaining sections hold
+            uncompressed bulk geometry data that is used in place from the memory-mapped file.
+        */
+        enum class Section : uint32_t
+        {
+            SceneData,
+            MeshIndexData,
+            MeshStaticData,
+            MeshSkinningData,
+            CurveIndexData,
+            CurveStaticData,
+            Count
+        };
+
+        const char* kSectionNames[] = { "SceneData", "MeshIndexData", "MeshStaticData", "MeshSkinningData", "CurveIndexData", "CurveStaticData" };
+        static_assert(std::size(kSectionNames) == (size_t)Section::Count);
+
+        struct SectionDesc
+        {
+            uint64_t offset{}; ///< Offset from the start of the file in bytes.
+            uint64_t size{};   ///< Size in bytes.
+        };
+
+        /** Codec used for a section.
+        */
+        enum class Codec : uint32_t
+        {
+            None, ///< Stored uncompressed, used in place from the mapped file.
+            LZ4,  ///< Independent LZ4 blocks per chunk. Chunks that do not compress are stored as is.
+        };
+
+        /** Lossless filter applied to each chunk before compression.
+        */
+        enum class Filter : uint32_t
+        {
+            None,
+            Delta32, ///< Difference between consecutive 32-bit words (indices).
+            Shuffle, ///< Byte transposition of fixed-size elements (vertex attributes), groups bytes of equal significance.
+        };
+
+        /** Encoding of a section. Compressed sections start with a table holding the end offset of each
+            compressed chunk (relative to the end of the table), followed by the chunk data.
+        */
+        struct SectionEncoding
+        {
+            Codec codec{};
+            Filter filter{};
+            uint32_t stride{};      ///< Element size for the shuffle filter.
+            uint32_t chunkCount{};
+            uint64_t chunkSize{};   ///< Uncompressed chunk size in bytes. The last chunk may be smaller.
+            uint64_t rawSize{};     ///< Uncompressed section size in bytes.
+        };
+
         const char* kMagic = "FalcorS$";
         struct Header
         {
             uint8_t magic[8]{};
             uint32_t version{};
+            uint32_t sectionCount{};
+            SectionDesc sections[(size_t)Section::Count]{};
+            SectionEncoding encodings[(size_t)Section::Count]{}; ///< Only present in version 27 and later.
 
             bool isValid() const
             {
-                return std::memcmp(magic, kMagic, sizeof(Header::magic)) == 0 && version == kVersion;
+                return std::memcmp(magic, kMagic, sizeof(Header::magic)) == 0 && version >= kMinVersion && version <= kVersion && sectionCount == (uint32_t)Section::Count;
+            }
+
+            size_t getSize() const { return version >= 27 ? sizeof(Header) : offsetof(Header, encodings); }
+        };
+
+        void applyFilter(Filter filter, uint32_t stride, const uint8_t* src, uint8_t* dst, size_t size)
+        {
+            switch (filter)
+            {
+            case Filter::None:
+                std::memcpy(dst, src, size);
+                break;
+            case Filter::Delta32:
+            {
+                FALCOR_ASSERT(size % 4 == 0);
+                uint32_t prev = 0;
+                for (size_t i = 0; i < size; i += 4)
+                {
+                    uint32_t value;
+                    std::memcpy(&value, src + i, 4);
+                    uint32_t delta = value - prev;
+                    std::memcpy(dst + i, &delta, 4);
+                    prev = value;
+                }
+                break;
+            }
+            case Filter::Shuffle:
+            {
+                FALCOR_ASSERT(size % stride == 0);
+                const size_t count = size / stride;
+                for (size_t e = 0; e < count; e++)
+                    for (size_t b = 0; b < stride; b++) dst[b * count + e] = src[e * stride + b];
+                break;
+            }
+            default:
+                FALCOR_UNREACHABLE();
+            }
+        }
+
+        void revertFilter(Filter filter, uint32_t stride, const uint8_t* src, uint8_t* dst, size_t size)
+        {
+            switch (filter)
+            {
+            case Filter::None:
+                std::memcpy(dst, src, size);
+                break;
+            case Filter::Delta32:
+            {
+                uint32_t prev = 0;
+                for (size_t i = 0; i < size; i += 4)
+                {
+                    uint32_t delta;
+                    std::memcpy(&delta, src + i, 4);
+                    prev += delta;
+                    std::memcpy(dst + i, &prev, 4);
+                }
+                break;
+            }
+            case Filter::Shuffle:
+            {
+                const size_t count = size / stride;
+                for (size_t e = 0; e < count; e++)
+                    for (size_t b = 0; b < stride; b++) dst[e * stride + b] = src[b * count + e];
+                break;
+            }
+            default:
+                FALCOR_UNREACHABLE();
+            }
+        }
+
+        struct EncodedSection
+        {
+            SectionEncoding encoding;
+            std::vector<uint8_t> data; ///< Chunk table followed by chunk data.
+        };
+
+        /** Compress a section. Chunks are filtered and compressed in parallel.
+        */
+        EncodedSection encodeSection(const void* data, size_t size, Filter filter, uint32_t stride)
+        {
+            EncodedSection result;
+            auto& encoding = result.encoding;
+            encoding.codec = Codec::LZ4;
+            encoding.filter = filter;
+            encoding.stride = stride;
+            encoding.chunkSize = std::max<uint64_t>(kChunkSize / stride, 1) * stride;
+            encoding.chunkCount = (uint32_t)div_round_up<uint64_t>(size, encoding.chunkSize);
+            encoding.rawSize = size;
+
+            std::vector<std::vector<uint8_t>> chunks(encoding.chunkCount);
+            Threading::parallelForEach(
+                0,
+                encoding.chunkCount,
+                [&](size_t i)
+                {
+                    const uint64_t offset = i * encoding.chunkSize;
+                    const int rawSize = (int)std::min(encoding.chunkSize, size - offset);
+                    std::vector<uint8_t> filtered(rawSize);
+                    applyFilter(filter, stride, static_cast<const uint8_t*>(data) + offset, filtered.data(), rawSize);
+
+                    auto& chunk = chunks[i];
+                    chunk.resize(LZ4_compressBound(rawSize));
+                    int compressedSize = LZ4_compress_default(
+                        reinterpret_cast<const char*>(filtered.data()), reinterpret_cast<char*>(chunk.data()), rawSize, (int)chunk.size()
+                    );
+                    // Store incompressible chunks as is. The decoder detects them by their size.
+                    if (compressedSize <= 0 || compressedSize >= rawSize) chunk = std::move(filtered);
+                    else chunk.resize(compressedSize);
+                },
+                1
+            );
+
+            // Assemble chunk table and chunk data.
+            const size_t tableSize = encoding.chunkCount * sizeof(uint64_t);
+            uint64_t end = 0;
+            result.data.resize(tableSize);
+            for (uint32_t i = 0; i < encoding.chunkCount; i++)
+            {
+                end += chunks[i].size();
+                std::memcpy(result.data.data() + i * sizeof(uint64_t), &end, sizeof(uint64_t));
+                result.data.insert(result.data.end(), chunks[i].begin(), chunks[i].end());
+            }
+            return result;
+        }
+
+        /** Decompress a single chunk of a section.
+            \return True if successful.
+        */
+        bool decodeChunk(const uint8_t* sectionData, const SectionEncoding& encoding, uint32_t chunk, uint8_t* dst)
+        {
+            const uint8_t* chunkTable = sectionData;
+            const uint8_t* chunkData = sectionData + encoding.chunkCount * sizeof(uint64_t);
+            uint64_t begin = 0, end = 0;
+            if (chunk > 0) std::memcpy(&begin, chunkTable + (chunk - 1) * sizeof(uint64_t), sizeof(uint64_t));
+            std::memcpy(&end, chunkTable + chunk * sizeof(uint64_t), sizeof(uint64_t));
+
+            const uint64_t offset = chunk * encoding.chunkSize;
+            const int rawSize = (int)std::min(encoding.chunkSize, encoding.rawSize - offset);
+            const int storedSize = (int)(end - begin);
+
+            std::vector<uint8_t> filtered;
+            const uint8_t* pFiltered = chunkData + begin;
+            if (storedSize != rawSize)
+            {
+                filtered.resize(rawSize);
+                int decodedSize = LZ4_decompress_safe(reinterpret_cast<const char*>(pFiltered), reinterpret_cast<char*>(filtered.data()), storedSize, rawSize);
+                if (decodedSize != rawSize) return false;
+                pFiltered = filtered.data();
+            }
+            revertFilter(encoding.filter, encoding.stride, pFiltered, dst + offset, rawSize);
+            return true;
+        }
+
+        /** Check that a compressed section is consistent with its size in the file.
+        */
+        bool validateEncoding(const SectionDesc& desc, const SectionEncoding& encoding, const uint8_t* sectionData)
+        {
+            if (encoding.codec != Codec::LZ4 || encoding.chunkSize == 0 || encoding.chunkSize > std::numeric_limits<int>::max()) return false;
+            if (encoding.filter == Filter::Delta32 && (encoding.chunkSize % 4 != 0 || encoding.rawSize % 4 != 0)) return false;
+            if (encoding.filter == Filter::Shuffle && (encoding.stride == 0 || encoding.chunkSize % encoding.stride != 0 || encoding.rawSize % encoding.stride != 0)) return false;
+            if (encoding.chunkCount != div_round_up(encoding.rawSize, encoding.chunkSize)) return false;
+
+            const uint64_t tableSize = encoding.chunkCount * sizeof(uint64_t);
+            if (tableSize > desc.size) return false;
+            uint64_t prev = 0;
+            for (uint32_t i = 0; i < encoding.chunkCount; i++)
+            {
+                uint64_t end;
+                std::memcpy(&end, sectionData + i * sizeof(uint64_t), sizeof(uint64_t));
+                if (end < prev || end > desc.size - tableSize) return false;
+                prev = end;
+            }
+            return true;
+        }
+
+        /** Read-only stream buffer over a block of memory.
+        */
+        class MemoryStreamBuffer : public std::streambuf
+        {
+        public:
+            MemoryStreamBuffer(const void* data, size_t size)
+            {
+                char* p = const_cast<char*>(static_cast<const char*>(data));
+                setg(p, p, p + size);
             }
         };
     }
@@ -126,7 +392,11 @@ namespace Falcor
     class SceneCache::InputStream
     {
     public:
-        InputStream(std::istream& stream) : mStream(stream) {}
+        InputStream(std::istream& stream, uint32_t version) : mStream(stream), mVersion(version) {}
+
+        /** Get the version of the cache file that is read.
+        */
+        uint32_t getVersion() const { return mVersion; }
 
         void read(void* data, size_t len)
         {
@@ -190,6 +460,7 @@ namespace Falcor
 
     private:
         std::istream& mStream;
+        uint32_t mVersion;
     };
 
     bool SceneCache::hasValidCache(const Key& key)
@@ -207,7 +478,7 @@ namespace Falcor
         return !fs.eof() && header.isValid();
     }
 
-    void SceneCache::writeCache(const Scene::SceneData& sceneData, const Key& key)
+    void SceneCache::writeCache(const Scene::SceneData& sceneData, const Key& key, bool compress)
     {
         auto cachePath = getCachePath(key);
 
@@ -220,16 +491,75 @@ namespace Falcor
         std::ofstream fs(cachePath.c_str(), std::ios_base::binary);
         if (fs.bad()) FALCOR_THROW("Failed to create scene cache file '{}'.", cachePath);
 
-        // Write header (uncompressed).
+        // Write placeholder header. It is rewritten with the final section table at the end.
         Header header;
         std::memcpy(header.magic, kMagic, sizeof(Header::magic));
         header.version = kVersion;
+        header.sectionCount = (uint32_t)Section::Count;
         fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
 
-        // Write cache (compressed).
-        lz4_stream::basic_ostream<kBlockSize> zs(fs);
-        OutputStream stream(zs);
-        writeSceneData(stream, sceneData);
+        auto beginSection = [&](Section section)
+        {
+            uint64_t offset = (uint64_t)fs.tellp();
+            uint64_t alignedOffset = align_to(kSectionAlignment, offset);
+            static const char kPadding[kSectionAlignment] = {};
+            fs.write(kPadding, alignedOffset - offset);
+            header.sections[(size_t)section].offset = alignedOffset;
+        };
+        auto endSection = [&](Section section)
+        {
+            auto& desc = header.sections[(size_t)section];
+            desc.size = (uint64_t)fs.tellp() - desc.offset;
+        };
+        auto writeSection = [&](Section section, const auto& vec, Filter filter)
+        {
+            using T = typename std::decay_t<decltype(vec)>::value_type;
+            beginSection(section);
+            if (compress && !vec.empty())
+            {
+                uint32_t stride = filter == Filter::Shuffle ? (uint32_t)sizeof(T) : 4;
+                auto encoded = encodeSection(vec.data(), vec.size() * sizeof(T), filter, stride);
+                fs.write(reinterpret_cast<const char*>(encoded.data.data()), encoded.data.size());
+                header.encodings[(size_t)section] = encoded.encoding;
+            }
+            else
+            {
+                fs.write(reinterpret_cast<const char*>(vec.data()), vec.size() * sizeof(T));
+            }
+            endSection(section);
+        };
+
+        // Write scene data (compressed).
+        beginSection(Section::SceneData);
+        {
+            lz4_stream::basic_ostream<kBlockSize> zs(fs);
+            OutputStream stream(zs);
+            writeSceneData(stream, sceneData);
+        }
+        endSection(Section::SceneData);
+
+        // Write bulk geometry data (optionally compressed).
+        auto startTime = CpuTimer::getCurrentTimePoint();
+        writeSection(Section::MeshIndexData, sceneData.meshIndexData, Filter::Delta32);
+        writeSection(Section::MeshStaticData, sceneData.meshStaticData, Filter::Shuffle);
+        writeSection(Section::MeshSkinningData, sceneData.meshSkinningData, Filter::Shuffle);
+        writeSection(Section::CurveIndexData, sceneData.curveIndexData, Filter::Delta32);
+        writeSection(Section::CurveStaticData, sceneData.curveStaticData, Filter::Shuffle);
+        if (compress)
+        {
+            uint64_t rawSize = 0, storedSize = 0;
+            for (size_t i = 0; i < (size_t)Section::Count; i++)
+            {
+                if (header.encodings[i].codec == Codec::None) continue;
+                rawSize += header.encodings[i].rawSize;
+                storedSize += header.sections[i].size;
+            }
+            logInfo("Compressed scene cache geometry from {} to {} bytes in {:.2f} ms.", rawSize, storedSize, CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint()));
+        }
+
+        // Write final header.
+        fs.seekp(0);
+        fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
         if (fs.bad()) FALCOR_THROW("Failed to write scene cache file to '{}'.", cachePath);
     }
 
@@ -239,20 +569,126 @@ namespace Falcor
 
         logInfo("Loading scene cache from '{}'.", cachePath);
 
-        // Open file.
-        std::ifstream fs(cachePath.c_str(), std::ios_base::binary);
-        if (fs.bad()) FALCOR_THROW("Failed to open scene cache file '{}'.", cachePath);
+        // Map file.
+        auto pFile = std::make_shared<MemoryMappedFile>(cachePath, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::SequentialScan);
+        if (!pFile->isOpen()) FALCOR_THROW("Failed to open scene cache file '{}'.", cachePath);
 
-        // Read header (uncompressed).
+        // Validate header and section table.
         Header header;
-        fs.read(reinterpret_cast<char*>(&header), sizeof(header));
-        if (!header.isValid()) FALCOR_THROW("Invalid header in scene cache file '{}'.", cachePath);
+        std::memcpy(&header, pFile->getData(), std::min(sizeof(header), pFile->getMappedSize()));
+        if (!header.isValid() || pFile->getMappedSize() < header.getSize()) FALCOR_THROW("Invalid header in scene cache file '{}'.", cachePath);
+        if (header.version < 27) std::fill(std::begin(header.encodings), std::end(header.encodings), SectionEncoding{});
 
-        // Read cache (compressed).
+        const uint8_t* pData = static_cast<const uint8_t*>(pFile->getData());
+        for (uint32_t i = 0; i < header.sectionCount; i++)
+        {
+            const auto& desc = header.sections[i];
+            if (desc.offset % kSectionAlignment != 0 || desc.offset > pFile->getMappedSize() || desc.size > pFile->getMappedSize() - desc.offset)
+                FALCOR_THROW("Invalid section '{}' in scene cache file '{}'.", kSectionNames[i], cachePath);
+        }
+
+        // Read scene data (compressed).
+        auto startTime = CpuTimer::getCurrentTimePoint();
+        const auto& sceneDataDesc = header.sections[(size_t)Section::SceneData];
+        MemoryStreamBuffer buffer(pData + sceneDataDesc.offset, sceneDataDesc.size);
+        std::istream fs(&buffer);
         lz4_stream::basic_istream<kBlockSize, kBlockSize> zs(fs);
-        InputStream stream(zs);
+        InputStream stream(zs, header.version);
         auto sceneData = readSceneData(stream, pDevice);
         if (fs.bad()) FALCOR_THROW("Failed to read scene cache file from '{}'.", cachePath);
+
+        // Sections are paged in lazily by their first access. The cold time of a section is the time of that access
+        // (decode, copy or GPU upload), the warm time is a second read of the same, now resident, range.
+        auto logSectionTimes = [&](Section section, const char* access, double coldMs)
+        {
+            const auto& desc = header.sections[(size_t)section];
+            auto warmStart = CpuTimer::getCurrentTimePoint();
+            MemoryMappedFile::touchPages(pData + desc.offset, desc.size);
+            double warmMs = CpuTimer::calcDuration(warmStart, CpuTimer::getCurrentTimePoint());
+            logInfo("Scene cache section '{}': {} bytes, cold {:.2f} ms ({}), warm {:.2f} ms.", kSectionNames[(size_t)section], desc.size, coldMs, access, warmMs);
+        };
+        logSectionTimes(Section::SceneData, "decoded", CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint()));
+
+        // Uncompressed mesh data is used in place from the mapped file, the scene uploads it directly to the GPU.
+        // Curve data is kept on the CPU by the scene, so it is always copied out of the mapping.
+        // Compressed sections are decoded into the scene data vectors, with all chunks of all sections decoded in parallel.
+        struct DecodeJob
+        {
+            Section section;
+            uint32_t chunk;
+            uint8_t* dst;
+        };
+        std::vector<DecodeJob> decodeJobs;
+
+        auto loadSection = [&](Section section, auto& vec, auto* pView)
+        {
+            using T = typename std::decay_t<decltype(vec)>::value_type;
+            const auto& desc = header.sections[(size_t)section];
+            const auto& encoding = header.encodings[(size_t)section];
+            const uint8_t* sectionData = pData + desc.offset;
+
+            if (encoding.codec == Codec::None)
+            {
+                if (desc.size % sizeof(T) != 0) FALCOR_THROW("Invalid section '{}' in scene cache file '{}'.", kSectionNames[(size_t)section], cachePath);
+                fstd::span<const T> view(reinterpret_cast<const T*>(sectionData), desc.size / sizeof(T));
+                if (pView)
+                {
+                    // Mapped sections are first accessed by the scene when it uploads them, which logs their times.
+                    *pView = view;
+                    return;
+                }
+                auto copyStart = CpuTimer::getCurrentTimePoint();
+                vec.assign(view.begin(), view.end());
+                if (desc.size > 0) logSectionTimes(section, "copied", CpuTimer::calcDuration(copyStart, CpuTimer::getCurrentTimePoint()));
+                return;
+            }
+
+            if (!validateEncoding(desc, encoding, sectionData) || encoding.rawSize % sizeof(T) != 0)
+                FALCOR_THROW("Invalid encoding of section '{}' in scene cache file '{}'.", kSectionNames[(size_t)section], cachePath);
+            vec.resize(encoding.rawSize / sizeof(T));
+            for (uint32_t i = 0; i < encoding.chunkCount; i++) decodeJobs.push_back({section, i, reinterpret_cast<uint8_t*>(vec.data())});
+        };
+
+        Scene::SceneData::MappedMeshData mappedMeshData;
+        loadSection(Section::MeshIndexData, sceneData.meshIndexData, &mappedMeshData.indexData);
+        loadSection(Section::MeshStaticData, sceneData.meshStaticData, &mappedMeshData.staticData);
+        loadSection(Section::MeshSkinningData, sceneData.meshSkinningData, &mappedMeshData.skinningData);
+        loadSection(Section::CurveIndexData, sceneData.curveIndexData, (fstd::span<const uint32_t>*)nullptr);
+        loadSection(Section::CurveStaticData, sceneData.curveStaticData, (fstd::span<const StaticCurveVertexData>*)nullptr);
+
+        if (!decodeJobs.empty())
+        {
+            startTime = CpuTimer::getCurrentTimePoint();
+            std::atomic<bool> failed = false;
+            std::vector<double> jobTimes(decodeJobs.size());
+            Threading::parallelForEach(
+                0,
+                decodeJobs.size(),
+                [&](size_t jobIndex)
+                {
+                    const DecodeJob& job = decodeJobs[jobIndex];
+                    const size_t i = (size_t)job.section;
+                    auto jobStart = CpuTimer::getCurrentTimePoint();
+                    if (!decodeChunk(pData + header.sections[i].offset, header.encodings[i], job.chunk, job.dst)) failed = true;
+                    jobTimes[jobIndex] = CpuTimer::calcDuration(jobStart, CpuTimer::getCurrentTimePoint());
+                },
+                1
+            );
+            if (failed) FALCOR_THROW("Failed to decompress scene cache file '{}'.", cachePath);
+            logInfo("Decompressed {} scene cache chunks in {:.2f} ms.", decodeJobs.size(), CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint()));
+
+            // The chunks of a section are decoded in parallel, its cold time is the summed decode time of its chunks.
+            double sectionTimes[(size_t)Section::Count] = {};
+            for (size_t i = 0; i < decodeJobs.size(); i++) sectionTimes[(size_t)decodeJobs[i].section] += jobTimes[i];
+            for (size_t i = 0; i < (size_t)Section::Count; i++)
+            {
+                if (header.encodings[i].codec != Codec::None) logSectionTimes((Section)i, "decoded", sectionTimes[i]);
+            }
+        }
+
+        mappedMeshData.pFile = std::move(pFile);
+        sceneData.mappedMeshData = std::move(mappedMeshData);
+
         return sceneData;
     }
 
@@ -281,13 +717,25 @@ namespace Falcor
         stream.write((uint32_t)sceneData.lights.size());
         for (const auto& pLight : sceneData.lights) writeLight(stream, pLight);
 
+        // The current grids of streamed grid sequences are not stored, the streamers load them from file again.
+        std::set<ref<Grid>> streamedGrids;
+        for (const auto& pGridVolume : sceneData.gridVolumes)
+        {
+            for (const auto& pStreamer : pGridVolume->mStreamers)
+            {
+                if (pStreamer && pStreamer->getGrid()) streamedGrids.insert(pStreamer->getGrid());
+            }
+        }
+        std::vector<ref<Grid>> grids;
+        std::copy_if(sceneData.grids.begin(), sceneData.grids.end(), std::back_inserter(grids), [&](const ref<Grid>& pGrid) { return streamedGrids.count(pGrid) == 0; });
+
         writeMarker(stream, "Grids");
-        stream.write((uint32_t)sceneData.grids.size());
-        for (const auto& pGrid : sceneData.grids) writeGrid(stream, pGrid);
+        stream.write((uint32_t)grids.size());
+        for (const auto& pGrid : grids) writeGrid(stream, pGrid);
 
         writeMarker(stream, "GridVolumes");
         stream.write((uint32_t)sceneData.gridVolumes.size());
-        for (const auto& pGridVolume : sceneData.gridVolumes) writeGridVolume(stream, pGridVolume, sceneData.grids);
+        for (const auto& pGridVolume : sceneData.gridVolumes) writeGridVolume(stream, pGridVolume, grids);
 
         writeMarker(stream, "EnvMap");
         bool hasEnvMap = sceneData.pEnvMap != nullptr;
@@ -347,16 +795,11 @@ namespace Falcor
         stream.write(sceneData.has16BitIndices);
         stream.write(sceneData.has32BitIndices);
         stream.write(sceneData.meshDrawCount);
-        stream.write(sceneData.meshIndexData);
-        stream.write(sceneData.meshStaticData);
-        stream.write(sceneData.meshSkinningData);
 
         writeMarker(stream, "Curves");
         stream.write(sceneData.curveDesc);
         stream.write(sceneData.curveBBs);
         stream.write(sceneData.curveInstanceData);
-        stream.write(sceneData.curveIndexData);
-        stream.write(sceneData.curveStaticData);
 
         stream.write((uint32_t)sceneData.cachedCurves.size());
         for (const auto& cachedCurve : sceneData.cachedCurves)
@@ -468,16 +911,11 @@ namespace Falcor
         stream.read(sceneData.has16BitIndices);
         stream.read(sceneData.has32BitIndices);
         stream.read(sceneData.meshDrawCount);
-        stream.read(sceneData.meshIndexData);
-        stream.read(sceneData.meshStaticData);
-        stream.read(sceneData.meshSkinningData);
 
         readMarker(stream, "Curves");
         stream.read(sceneData.curveDesc);
         stream.read(sceneData.curveBBs);
         stream.read(sceneData.curveInstanceData);
-        stream.read(sceneData.curveIndexData);
-        stream.read(sceneData.curveStaticData);
 
         sceneData.cachedCurves.resize(stream.read<uint32_t>());
         for (auto& cachedCurve : sceneData.cachedCurves)
@@ -820,6 +1258,11 @@ namespace Falcor
                 stream.write(id);
             }
         }
+        for (const auto& pStreamer : pGridVolume->mStreamers)
+        {
+            stream.write(pStreamer != nullptr);
+            if (pStreamer) writeGridSequenceStreamer(stream, pStreamer);
+        }
         stream.write(pGridVolume->mGridFrame);
         stream.write(pGridVolume->mGridFrameCount);
         stream.write(pGridVolume->mBounds);
@@ -844,14 +1287,41 @@ namespace Falcor
                 pGrid = id == uint32_t(-1) ? nullptr : grids[id];
             }
         }
+        if (stream.getVersion() >= 28)
+        {
+            for (auto& pStreamer : pGridVolume->mStreamers)
+            {
+                if (stream.read<bool>()) pStreamer = readGridSequenceStreamer(stream, pDevice);
+            }
+        }
         stream.read(pGridVolume->mGridFrame);
         stream.read(pGridVolume->mGridFrameCount);
         stream.read(pGridVolume->mBounds);
         stream.read(pGridVolume->mData);
 
+        // Load the current frame of the streamed grid sequences.
+        pGridVolume->updateStreamers();
+
         return pGridVolume;
     }
 
+    // GridSequenceStreamer
+
+    void SceneCache::writeGridSequenceStreamer(OutputStream& stream, const ref<GridSequenceStreamer>& pStreamer)
+    {
+        stream.write(pStreamer->getPaths());
+        stream.write(pStreamer->getGridname());
+        stream.write(pStreamer->getOptions());
+    }
+
+    ref<GridSequenceStreamer> SceneCache::readGridSequenceStreamer(InputStream& stream, ref<Device> pDevice)
+    {
+        auto paths = stream.read<std::vector<std::filesystem::path>>();
+        auto gridname = stream.read<std::string>();
+        auto options = stream.read<GridSequenceStreamer::Options>();
+        return GridSequenceStreamer::create(pDevice, paths, gridname, options);
+    }
+
     // Grid
 
     void SceneCache::writeGrid(OutputStream& stream, const ref<Grid>& pGrid)
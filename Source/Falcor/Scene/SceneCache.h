@@ -50,6 +50,9 @@ namespace Falcor
     /** Helper class for reading and writing scene cache files.
         The scene cache is used to heavily reduce load times of more complex assets.
         The cache stores a binary representation of `Scene::SceneData` which contains everything to re-create a `Scene`.
+        The file is split into page-aligned sections addressed by a table in the header. The serialized scene data is
+        stored compressed, bulk geometry data is either stored uncompressed and used in place from a memory-mapped file,
+        or split into independently LZ4 compressed chunks that are decoded in parallel.
     */
     class FALCOR_API SceneCache
     {
@@ -65,8 +68,9 @@ namespace Falcor
         /** Write a scene cache.
             \param[in] sceneData Scene data.
             \param[in] key Cache key.
+            \param[in] compress Compress bulk geometry data. Compressed sections are decoded into memory on load instead of being used in place.
         */
-        static void writeCache(const Scene::SceneData& sceneData, const Key& key);
+        static void writeCache(const Scene::SceneData& sceneData, const Key& key, bool compress = false);
 
         /** Read a scene cache.
             \param[in] pDevice GPU device.
@@ -106,6 +110,9 @@ namespace Falcor
         static void writeGridVolume(OutputStream& stream, const ref<GridVolume>& pVolume, const std::vector<ref<Grid>>& grids);
         static ref<GridVolume> readGridVolume(InputStream& stream, const std::vector<ref<Grid>>& grids, ref<Device> pDevice);
 
+        static void writeGridSequenceStreamer(OutputStream& stream, const ref<GridSequenceStreamer>& pStreamer);
+        static ref<GridSequenceStreamer> readGridSequenceStreamer(InputStream& stream, ref<Device> pDevice);
+
         static void writeGrid(OutputStream& stream, const ref<Grid>& pGrid);
         static ref<Grid> readGrid(InputStream& stream, ref<Device> pDevice);
 
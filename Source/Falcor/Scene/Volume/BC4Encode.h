@@ -30,8 +30,17 @@
 #include <cstdint>
 #include <climits>
 
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define BC4_ENCODE_SSE2 1
+#else
+#define BC4_ENCODE_SSE2 0
+#endif
+
 // this file exposes a single function, CompressAlphaDxt5, which encodes a 4x4 set of uint8 alpha values into a single 64 bit BC4 encoded block
+// CompressAlphaDxt5Scalar is the reference implementation, the SSE2 version produces identical blocks
 static void CompressAlphaDxt5(uint8_t* tile, void* block);
+static inline void CompressAlphaDxt5Scalar(uint8_t* tile, void* block);
 
 // derived from libsquish, alpha.cpp
 /* -----------------------------------------------------------------------------
@@ -184,27 +193,9 @@ static void WriteAlphaBlock7(int alpha0, int alpha1, uint8_t const* indices, voi
 }
 
 
-static void CompressAlphaDxt5(uint8_t* tile, void* block)
+template<typename FitFunc>
+static void EncodeAlphaBlock(int min5, int max5, int min7, int max7, FitFunc fit, void* block)
 {
-    // get the range for 5-alpha and 7-alpha interpolation
-    int min5 = 255;
-    int max5 = 0;
-    int min7 = 255;
-    int max7 = 0;
-    for (int i = 0; i < 16; ++i)
-    {
-        // incorporate into the min/max
-        int value = (int)(tile[i]);
-        if (value < min7)
-            min7 = value;
-        if (value > max7)
-            max7 = value;
-        if (value != 0 && value < min5)
-            min5 = value;
-        if (value != 255 && value > max5)
-            max5 = value;
-    }
-
     // handle the case that no valid range was found
     if (min5 > max5)
         min5 = max5;
@@ -234,8 +225,8 @@ static void CompressAlphaDxt5(uint8_t* tile, void* block)
     // fit the data to both code books
     uint8_t indices5[16];
     uint8_t indices7[16];
-    int err5 = FitCodes(tile, codes5, indices5);
-    int err7 = FitCodes(tile, codes7, indices7);
+    int err5 = fit(codes5, indices5);
+    int err7 = fit(codes7, indices7);
 
     // save the block with least error
     if (err5 <= err7)
@@ -244,3 +235,97 @@ static void CompressAlphaDxt5(uint8_t* tile, void* block)
         WriteAlphaBlock7(min7, max7, indices7, block);
 }
 
+static inline void CompressAlphaDxt5Scalar(uint8_t* tile, void* block)
+{
+    // get the range for 5-alpha and 7-alpha interpolation
+    int min5 = 255;
+    int max5 = 0;
+    int min7 = 255;
+    int max7 = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        // incorporate into the min/max
+        int value = (int)(tile[i]);
+        if (value < min7)
+            min7 = value;
+        if (value > max7)
+            max7 = value;
+        if (value != 0 && value < min5)
+            min5 = value;
+        if (value != 255 && value > max5)
+            max5 = value;
+    }
+
+    EncodeAlphaBlock(min5, max5, min7, max7, [tile](uint8_t const* codes, uint8_t* indices) { return FitCodes(tile, codes, indices); }, block);
+}
+
+#if BC4_ENCODE_SSE2
+static inline int HorizontalMinU8(__m128i v)
+{
+    v = _mm_min_epu8(v, _mm_srli_si128(v, 8));
+    v = _mm_min_epu8(v, _mm_srli_si128(v, 4));
+    v = _mm_min_epu8(v, _mm_srli_si128(v, 2));
+    v = _mm_min_epu8(v, _mm_srli_si128(v, 1));
+    return _mm_cvtsi128_si32(v) & 0xff;
+}
+
+static inline int HorizontalMaxU8(__m128i v)
+{
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 8));
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 4));
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 2));
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 1));
+    return _mm_cvtsi128_si32(v) & 0xff;
+}
+
+// fits all 16 values at once, the absolute distance orders the codes the same as the squared distance
+static int FitCodesSSE2(__m128i values, uint8_t const* codes, uint8_t* indices)
+{
+    __m128i least = _mm_set1_epi8((char)0xff);
+    __m128i index = _mm_setzero_si128();
+    for (int j = 0; j < 8; ++j)
+    {
+        const __m128i code = _mm_set1_epi8((char)codes[j]);
+        const __m128i dist = _mm_or_si128(_mm_subs_epu8(values, code), _mm_subs_epu8(code, values));
+
+        // keep the first code on ties, like the scalar version
+        const __m128i notCloser = _mm_cmpeq_epi8(_mm_min_epu8(dist, least), least);
+        index = _mm_or_si128(_mm_and_si128(notCloser, index), _mm_andnot_si128(notCloser, _mm_set1_epi8((char)j)));
+        least = _mm_min_epu8(dist, least);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), index);
+
+    // sum of the squared distances
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lo = _mm_unpacklo_epi8(least, zero);
+    const __m128i hi = _mm_unpackhi_epi8(least, zero);
+    __m128i sum = _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+
+static void CompressAlphaDxt5SSE2(uint8_t* tile, void* block)
+{
+    const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tile));
+    const __m128i isZero = _mm_cmpeq_epi8(values, _mm_setzero_si128());
+    const __m128i isMax = _mm_cmpeq_epi8(values, _mm_set1_epi8((char)0xff));
+
+    // the 5-alpha range ignores 0 and 255, which have their own codes
+    int min5 = HorizontalMinU8(_mm_or_si128(values, isZero));
+    int max5 = HorizontalMaxU8(_mm_andnot_si128(isMax, values));
+    int min7 = HorizontalMinU8(values);
+    int max7 = HorizontalMaxU8(values);
+
+    EncodeAlphaBlock(min5, max5, min7, max7, [values](uint8_t const* codes, uint8_t* indices) { return FitCodesSSE2(values, codes, indices); }, block);
+}
+#endif
+
+static void CompressAlphaDxt5(uint8_t* tile, void* block)
+{
+#if BC4_ENCODE_SSE2
+    CompressAlphaDxt5SSE2(tile, block);
+#else
+    CompressAlphaDxt5Scalar(tile, block);
+#endif
+}
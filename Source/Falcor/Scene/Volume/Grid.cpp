@@ -91,25 +91,66 @@ namespace Falcor
 
     ref<Grid> Grid::createFromFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname)
     {
+        auto hostData = loadHostData(path, gridname);
+        return hostData ? createFromHostData(pDevice, *hostData) : nullptr;
+    }
+
+    std::optional<Grid::HostData> Grid::loadHostData(const std::filesystem::path& path, const std::string& gridname)
+    {
+        HostData hostData;
+        if (!loadHostData(path, gridname, hostData)) return {};
+        return hostData;
+    }
+
+    bool Grid::loadHostData(const std::filesystem::path& path, const std::string& gridname, HostData& hostData)
+    {
+        hostData.gridHandle = {};
         if (!std::filesystem::exists(path))
         {
             logWarning("Error when loading grid. Can't open grid file '{}'.", path);
-            return nullptr;
+            return false;
         }
 
         if (hasExtension(path, "nvdb"))
         {
-            return createFromNanoVDBFile(pDevice, path, gridname);
+            hostData.gridHandle = readNanoVDBFile(path, gridname);
         }
         else if (hasExtension(path, "vdb"))
         {
-            return createFromOpenVDBFile(pDevice, path, gridname);
+            hostData.gridHandle = readOpenVDBFile(path, gridname);
         }
         else
         {
             logWarning("Error when loading grid. Unsupported grid file '{}'.", path);
-            return nullptr;
+            return false;
+        }
+        if (!hostData.gridHandle) return false;
+
+        auto floatGrid = hostData.gridHandle.grid<float>();
+        if (!floatGrid->hasMinMax())
+        {
+            nanovdb::gridStats(*floatGrid);
         }
+        if (hostData.pBricks) hostData.pBricks->reset(floatGrid);
+        else hostData.pBricks = std::make_unique<NanoVDBConverterBC4>(floatGrid);
+        hostData.pBricks->convertBricks();
+        return true;
+    }
+
+    ref<Grid> Grid::createFromHostData(ref<Device> pDevice, HostData& hostData)
+    {
+        FALCOR_CHECK(hostData.gridHandle && hostData.pBricks, "Grid host data is empty.");
+        return ref<Grid>(new Grid(pDevice, hostData));
+    }
+
+    Grid::HostData::HostData() = default;
+    Grid::HostData::~HostData() = default;
+    Grid::HostData::HostData(HostData&&) = default;
+    Grid::HostData& Grid::HostData::operator=(HostData&&) = default;
+
+    uint64_t Grid::HostData::getSizeInBytes() const
+    {
+        return gridHandle.size() + (pBricks ? pBricks->getBrickDataSizeInBytes() : (uint64_t)0);
     }
 
     void Grid::renderUI(Gui::Widgets& widget)
@@ -213,6 +254,23 @@ namespace Falcor
             nanovdb::gridStats(*mpFloatGrid);
         }
 
+        NanoVDBConverterBC4 bricks(mpFloatGrid);
+        bricks.convertBricks();
+        createBuffers(bricks);
+    }
+
+    Grid::Grid(ref<Device> pDevice, HostData& hostData)
+        : mpDevice(pDevice)
+        , mGridHandle(std::move(hostData.gridHandle))
+        , mpFloatGrid(mGridHandle.grid<float>())
+        , mAccessor(mpFloatGrid->getAccessor())
+    {
+        // The bricks reference the NanoVDB grid, which stays at the same address when the handle is moved.
+        createBuffers(*hostData.pBricks);
+    }
+
+    void Grid::createBuffers(NanoVDBConverterBC4& bricks)
+    {
         // Keep both NanoVDB and brick textures resident in GPU memory for simplicity for now (~15% increased footprint).
         mpBuffer = mpDevice->createStructuredBuffer(
             sizeof(uint32_t),
@@ -221,42 +279,41 @@ namespace Falcor
             MemoryType::DeviceLocal,
             mGridHandle.data()
         );
-        using NanoVDBGridConverter = NanoVDBConverterBC4;
-        mBrickedGrid = NanoVDBGridConverter(mpFloatGrid).convert(mpDevice);
+        mBrickedGrid = bricks.createTextures(mpDevice);
     }
 
-    ref<Grid> Grid::createFromNanoVDBFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname)
+    nanovdb::GridHandle<nanovdb::HostBuffer> Grid::readNanoVDBFile(const std::filesystem::path& path, const std::string& gridname)
     {
         if (!nanovdb::io::hasGrid(path.string(), gridname))
         {
             logWarning("Error when loading grid. Can't find grid '{}' in '{}'.", gridname, path);
-            return nullptr;
+            return {};
         }
 
         auto handle = nanovdb::io::readGrid(path.string(), gridname);
         if (!handle)
         {
             logWarning("Error when loading grid.");
-            return nullptr;
+            return {};
         }
 
         auto floatGrid = handle.grid<float>();
         if (!floatGrid || floatGrid->gridType() != nanovdb::GridType::Float)
         {
             logWarning("Error when loading grid. Grid '{}' in '{}' is not of type float.", gridname, path);
-            return nullptr;
+            return {};
         }
 
         if (floatGrid->isEmpty())
         {
             logWarning("Grid '{}' in '{}' is empty.", gridname, path);
-            return nullptr;
+            return {};
         }
 
-        return ref<Grid>(new Grid(pDevice, std::move(handle)));
+        return handle;
     }
 
-    ref<Grid> Grid::createFromOpenVDBFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname)
+    nanovdb::GridHandle<nanovdb::HostBuffer> Grid::readOpenVDBFile(const std::filesystem::path& path, const std::string& gridname)
     {
         openvdb::initialize();
 
@@ -278,25 +335,23 @@ namespace Falcor
         if (!baseGrid)
         {
             logWarning("Error when loading grid. Can't find grid '{}' in '{}'.", gridname, path);
-            return nullptr;
+            return {};
         }
 
         if (!baseGrid->isType<openvdb::FloatGrid>())
         {
             logWarning("Error when loading grid. Grid '{}' in '{}' is not of type float.", gridname, path);
-            return nullptr;
+            return {};
         }
 
         if (baseGrid->empty())
         {
             logWarning("Grid '{}' in '{}' is empty.", gridname, path);
-            return nullptr;
+            return {};
         }
 
         openvdb::FloatGrid::Ptr floatGrid = openvdb::gridPtrCast<openvdb::FloatGrid>(baseGrid);
-        auto handle = nanovdb::openToNanoVDB(floatGrid);
-
-        return ref<Grid>(new Grid(pDevice, std::move(handle)));
+        return nanovdb::openToNanoVDB(floatGrid);
     }
 
 
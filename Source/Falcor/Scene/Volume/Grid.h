@@ -48,11 +48,13 @@
 
 #include <filesystem>
 #include <memory>
+#include <optional>
 #include <string>
 
 namespace Falcor
 {
     struct ShaderVar;
+    template <typename TexelType, unsigned int kBitsPerTexel> struct NanoVDBToBricksConverter;
 
     /** Voxel grid based on NanoVDB.
     */
@@ -60,6 +62,24 @@ namespace Falcor
     {
         FALCOR_OBJECT(Grid)
     public:
+        /** Grid loaded from a file and converted to bricks on the CPU, but not yet uploaded to the GPU.
+            Created by loadHostData(), which does not touch the device and can run on a worker thread.
+        */
+        struct FALCOR_API HostData
+        {
+            HostData();
+            ~HostData();
+            HostData(HostData&&);
+            HostData& operator=(HostData&&);
+
+            nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle;
+            std::unique_ptr<NanoVDBToBricksConverter<uint64_t, 4>> pBricks;
+
+            /** Get the size of the host data in bytes.
+            */
+            uint64_t getSizeInBytes() const;
+        };
+
         /** Create a sphere voxel grid.
             \param[in] pDevice GPU device.
             \param[in] radius Radius of the sphere in world units.
@@ -89,6 +109,31 @@ namespace Falcor
         */
         static ref<Grid> createFromFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname);
 
+        /** Load a grid from a file and convert it to bricks without creating any GPU resources.
+            This function is thread-safe, the result is uploaded with createFromHostData().
+            \param[in] path File path of the grid (absolute or relative to working directory).
+            \param[in] gridname Name of the grid to load.
+            \return The grid data, or an empty optional if the grid failed to load.
+        */
+        static std::optional<HostData> loadHostData(const std::filesystem::path& path, const std::string& gridname);
+
+        /** Load a grid from a file into existing host data, reusing its brick buffers.
+            This avoids reallocating the brick buffers for every frame of a grid sequence. This function is thread-safe.
+            \param[in] path File path of the grid (absolute or relative to working directory).
+            \param[in] gridname Name of the grid to load.
+            \param[in,out] hostData Host data to load into.
+            \return True if the grid was loaded.
+        */
+        static bool loadHostData(const std::filesystem::path& path, const std::string& gridname, HostData& hostData);
+
+        /** Create a grid from host data returned by loadHostData().
+            The NanoVDB grid is moved to the new grid, the brick buffers stay in the host data and can be reused by the next load.
+            \param[in] pDevice GPU device.
+            \param[in] hostData Grid data.
+            \return A new grid.
+        */
+        static ref<Grid> createFromHostData(ref<Device> pDevice, HostData& hostData);
+
         /** Render the UI.
         */
         void renderUI(Gui::Widgets& widget);
@@ -146,9 +191,12 @@ namespace Falcor
 
     private:
         Grid(ref<Device> pDevice, nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle);
+        Grid(ref<Device> pDevice, HostData& hostData);
+
+        void createBuffers(NanoVDBToBricksConverter<uint64_t, 4>& bricks);
 
-        static ref<Grid> createFromNanoVDBFile(ref<Device>, const std::filesystem::path& path, const std::string& gridname);
-        static ref<Grid> createFromOpenVDBFile(ref<Device>, const std::filesystem::path& path, const std::string& gridname);
+        static nanovdb::GridHandle<nanovdb::HostBuffer> readNanoVDBFile(const std::filesystem::path& path, const std::string& gridname);
+        static nanovdb::GridHandle<nanovdb::HostBuffer> readOpenVDBFile(const std::filesystem::path& path, const std::string& gridname);
 
         ref<Device> mpDevice;
 
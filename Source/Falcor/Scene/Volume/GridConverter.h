@@ -31,7 +31,7 @@
 #include "Core/API/Formats.h"
 #include "Utils/Logger.h"
 #include "Utils/HostDeviceShared.slangh"
-#include "Utils/NumericRange.h"
+#include "Utils/Threading.h"
 #include "Utils/Math/Vector.h"
 #include "Utils/Timing/CpuTimer.h"
 
@@ -46,7 +46,6 @@
 
 #include <algorithm>
 #include <atomic>
-#include <execution>
 #include <vector>
 
 namespace Falcor
@@ -56,6 +55,10 @@ namespace Falcor
     using NanoVDBConverterUNORM8 = NanoVDBToBricksConverter<uint8_t, 8>;
     using NanoVDBConverterUNORM16 = NanoVDBToBricksConverter<uint16_t, 16>;
 
+    /** Converts a NanoVDB float grid to the bricked representation (range, indirection and atlas textures).
+        The conversion runs on the CPU in parallel over rows of bricks. The converter can be reset to another grid,
+        which reuses its CPU buffers, e.g. when converting the frames of a grid sequence.
+    */
     template <typename TexelType, unsigned int kBitsPerTexel>
     struct NanoVDBToBricksConverter
     {
@@ -63,14 +66,45 @@ namespace Falcor
         NanoVDBToBricksConverter(const nanovdb::FloatGrid* grid);
         NanoVDBToBricksConverter(const NanoVDBToBricksConverter& rhs) = delete;
 
+        /** Prepare the conversion of another grid, keeping the allocated CPU buffers.
+        */
+        void reset(const nanovdb::FloatGrid* grid);
+
+        /** Convert the grid to bricks and create the brick textures.
+        */
         BrickedGrid convert(ref<Device> pDevice);
 
+        /** Convert the grid to bricks on the CPU only. Does not touch the device, so it can run on a worker thread.
+        */
+        void convertBricks();
+
+        /** Create the brick textures from the bricks computed by convertBricks(). Must be called on the thread owning the device.
+        */
+        BrickedGrid createTextures(ref<Device> pDevice);
+
+        /** Get the range data (fp16 majorant and minorant per brick) of all mips, valid after convertBricks().
+        */
+        const std::vector<uint32_t>& getRangeData() const { return mRangeData; }
+
+        /** Get the dimensions in bricks of a mip of the range data.
+        */
+        int3 getLeafDim(int mip) const { return mLeafDim[mip]; }
+
+        /** Get the index of the first voxel of the first brick.
+        */
+        int3 getIndexMin() const { return mBBMin; }
+
+        /** Get the size of the brick data held on the CPU in bytes.
+        */
+        uint64_t getBrickDataSizeInBytes() const { return mRangeData.size() * sizeof(uint32_t) + mPtrData.size() * sizeof(uint32_t) + mAtlasData.size() * sizeof(TexelType); }
+
     private:
         const static uint32_t kBrickSize = 8; // Must be 8, to match both NanoVDB leaf size.
         const static int32_t kBC4Compress = kBitsPerTexel == 4;
 
-        void convertSlice(int z);
-        void computeMip(int mip);
+        void convertRow(int y, int z);
+        void computeMipSlice(int mip, int z);
+        void expandHalo(const nanovdb::FloatGrid::AccessorType& a, const nanovdb::Coord& ijk, float& min_inout, float& maj_inout) const;
 
         inline uint3 getAtlasSizeBricks() const { return mAtlasSizeBricks; }
         inline uint3 getAtlasSizePixels() const { return mAtlasSizeBricks * kBrickSize; }
@@ -96,7 +130,7 @@ namespace Falcor
             return float2(f16tof32(data16[0]), f16tof32(data16[1]));
         }
 
-        inline void expandMinorantMajorant(float value, float& min_inout, float& maj_inout)
+        inline void expandMinorantMajorant(float value, float& min_inout, float& maj_inout) const
         {
             if (value < min_inout) min_inout = value;
             if (value > maj_inout) maj_inout = value;
@@ -115,6 +149,12 @@ namespace Falcor
 
     template <typename TexelType, unsigned int kBitsPerTexel>
     NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::NanoVDBToBricksConverter(const nanovdb::FloatGrid* grid)
+    {
+        reset(grid);
+    }
+
+    template <typename TexelType, unsigned int kBitsPerTexel>
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::reset(const nanovdb::FloatGrid* grid)
     {
         mNonEmptyCount.store(0);
         mpFloatGrid = grid;
@@ -134,124 +174,152 @@ namespace Falcor
         mAtlasSizeBricks = uint3(approxdim, approxdim, lastdim);
         uint3 atlasSizePixels = getAtlasSizePixels();
         uint leafTexelCount = atlasSizePixels.x * atlasSizePixels.y * atlasSizePixels.z;
-        mRangeData.resize(mLeafCount[3]);
-        mPtrData.resize(mLeafCount[0]);
-        mAtlasData.resize(kBC4Compress ? (leafTexelCount / 16) : leafTexelCount);
+        // Every range and indirection entry and every used atlas brick is overwritten by the conversion.
+        // Growing buffers are cleared first to avoid copying their old content.
+        auto resizeForOverwrite = [](auto& buffer, size_t size)
+        {
+            if (size > buffer.capacity()) buffer.clear();
+            buffer.resize(size);
+        };
+        resizeForOverwrite(mRangeData, mLeafCount[3]);
+        resizeForOverwrite(mPtrData, mLeafCount[0]);
+        resizeForOverwrite(mAtlasData, kBC4Compress ? (leafTexelCount / 16) : leafTexelCount);
     }
 
     template <typename TexelType, unsigned int kBitsPerTexel>
-    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::convertSlice(int z)
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::expandHalo(const nanovdb::FloatGrid::AccessorType& a, const nanovdb::Coord& ijk, float& min_inout, float& maj_inout) const
+    {
+        // The 1-voxel halo around the brick is read from the 26 neighbouring leaves directly, only the leaves are looked up.
+        // Where there is no leaf, the whole 8x8x8 region holds the value of a tile.
+        const int n = (int)kBrickSize;
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                for (int dz = -1; dz <= 1; ++dz)
+                {
+                    if (dx == 0 && dy == 0 && dz == 0) continue;
+                    const nanovdb::Coord origin = ijk + nanovdb::Coord(dx * n, dy * n, dz * n);
+                    const auto* leaf = a.probeLeaf(origin);
+                    if (!leaf)
+                    {
+                        expandMinorantMajorant(a.getValue(origin), min_inout, maj_inout);
+                        continue;
+                    }
+
+                    // Voxels of the neighbour next to the brick: its last layer on the negative side, its first layer on the positive side.
+                    const int x0 = dx < 0 ? n - 1 : 0, x1 = dx > 0 ? 1 : n;
+                    const int y0 = dy < 0 ? n - 1 : 0, y1 = dy > 0 ? 1 : n;
+                    const int z0 = dz < 0 ? n - 1 : 0, z1 = dz > 0 ? 1 : n;
+                    const float* data = leaf->data()->mValues;
+                    for (int x = x0; x < x1; ++x)
+                        for (int y = y0; y < y1; ++y)
+                            for (int z = z0; z < z1; ++z)
+                                expandMinorantMajorant(data[x * n * n + y * n + z], min_inout, maj_inout);
+                }
+            }
+        }
+    }
+
+    template <typename TexelType, unsigned int kBitsPerTexel>
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::convertRow(int y, int z)
     {
         uint3 atlasSizePixels = getAtlasSizePixels();
         uint brickMax = getAtlasMaxBrick();
         uint bricksPerSlice = mAtlasSizeBricks.x * mAtlasSizeBricks.y;
         uint pixelsPerSlice = atlasSizePixels.x * atlasSizePixels.y;
 
-        size_t offset = z * mLeafDim[0].x * mLeafDim[0].y;
+        size_t offset = ((size_t)z * mLeafDim[0].y + y) * mLeafDim[0].x;
         uint32_t* rangedst = mRangeData.data() + offset;
         uint32_t* ptrdst = mPtrData.data() + offset;
         auto a = mpFloatGrid->getAccessor();
-        for (int y = 0; y < mLeafDim[0].y; ++y)
+        for (int x = 0; x < mLeafDim[0].x; ++x)
         {
-            for (int x = 0; x < mLeafDim[0].x; ++x)
+            nanovdb::Coord ijk = { x * 8 + mBBMin.x, y * 8 + mBBMin.y, z * 8 + mBBMin.z };
+            auto val = a.getValue(ijk);
+            auto leaf = a.probeLeaf(ijk);
+            float minorant = val, majorant = val;
+            uint myleaf = 0;
+            if (leaf)
             {
-                nanovdb::Coord ijk = { x * 8 + mBBMin.x, y * 8 + mBBMin.y, z * 8 + mBBMin.z };
-                auto val = a.getValue(ijk);
-                auto leaf = a.probeLeaf(ijk);
-                float minorant = val, majorant = val;
-                uint myleaf = 0;
-                if (leaf)
-                {
-                    // Nanovdb only stores minorant/majorant for active voxels, but we need all of them... Grab the central 8x8x8 first the quick way.
-                    const float* data = leaf->data()->mValues;
-                    for (int i = 0; i < kBrickSize * kBrickSize * kBrickSize; ++i) expandMinorantMajorant(data[i], minorant, majorant);
-                    // We also need the 1-halo from neighbouring bricks. Fetch them in an order that maximises nanovdb's internal cache reuse.
-                    for (int j = -1; j <= kBrickSize; ++j) for (int i = 0; i < kBrickSize; ++i) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(i, j, -1)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) for (int i = 0; i < kBrickSize; ++i) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(i, j, kBrickSize)), minorant, majorant);
-                    for (int j = 0; j < kBrickSize; ++j) for (int i = 0; i < kBrickSize; ++i) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(i, -1, j)), minorant, majorant);
-                    for (int j = 0; j < kBrickSize; ++j) for (int i = 0; i < kBrickSize; ++i) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(i, kBrickSize, j)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) for (int i = 0; i < kBrickSize; ++i) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(-1, j, i)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) for (int i = 0; i < kBrickSize; ++i) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(kBrickSize, j, i)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(-1, j, -1)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(kBrickSize, j, -1)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(-1, j, kBrickSize)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(kBrickSize, j, kBrickSize)), minorant, majorant);
-
-                    if (minorant != majorant) myleaf = mNonEmptyCount.fetch_add(1);
-                }
-                if (majorant == minorant || myleaf >= brickMax || leaf == nullptr)
-                {
-                    *rangedst++ = f32tof16(majorant) + (f32tof16(majorant) << 16); // force identical major and minor
-                    *ptrdst++ = 0;
-                }
-                else
-                {
-                    const float* data = leaf->data()->mValues;
-                    majorant = f16tof32(f32tof16(majorant) + 1);
-                    minorant = f16tof32(f32tof16(minorant));
-                    *rangedst++ = f32tof16(majorant) + (f32tof16(minorant) << 16);
-                    uint32_t atlasx = myleaf % mAtlasSizeBricks.x;
-                    uint32_t atlasy = (myleaf / mAtlasSizeBricks.x) % mAtlasSizeBricks.y;
-                    uint32_t atlasz = myleaf / bricksPerSlice;
-                    *ptrdst++ = (atlasx + (atlasy << 8) + (atlasz << 16));
-
-                    if (!kBC4Compress) {
-                        float invRange = ((1 << kBitsPerTexel) - 1.f) / (majorant - minorant);
-                        TexelType* atlasdst = (TexelType*)mAtlasData.data() + atlasx * kBrickSize + atlasy * (atlasSizePixels.x * kBrickSize) + atlasz * (pixelsPerSlice * kBrickSize);
-                        for (int pixz = 0; pixz < kBrickSize; ++pixz)
+                // Nanovdb only stores minorant/majorant for active voxels, but we need all of them... Grab the central 8x8x8 first the quick way.
+                const float* data = leaf->data()->mValues;
+                for (int i = 0; i < kBrickSize * kBrickSize * kBrickSize; ++i) expandMinorantMajorant(data[i], minorant, majorant);
+                // We also need the 1-halo from neighbouring bricks.
+                expandHalo(a, ijk, minorant, majorant);
+
+                if (minorant != majorant) myleaf = mNonEmptyCount.fetch_add(1);
+            }
+            if (majorant == minorant || myleaf >= brickMax || leaf == nullptr)
+            {
+                *rangedst++ = f32tof16(majorant) + (f32tof16(majorant) << 16); // force identical major and minor
+                *ptrdst++ = 0;
+            }
+            else
+            {
+                const float* data = leaf->data()->mValues;
+                majorant = f16tof32(f32tof16(majorant) + 1);
+                minorant = f16tof32(f32tof16(minorant));
+                *rangedst++ = f32tof16(majorant) + (f32tof16(minorant) << 16);
+                uint32_t atlasx = myleaf % mAtlasSizeBricks.x;
+                uint32_t atlasy = (myleaf / mAtlasSizeBricks.x) % mAtlasSizeBricks.y;
+                uint32_t atlasz = myleaf / bricksPerSlice;
+                *ptrdst++ = (atlasx + (atlasy << 8) + (atlasz << 16));
+
+                if (!kBC4Compress) {
+                    float invRange = ((1 << kBitsPerTexel) - 1.f) / (majorant - minorant);
+                    TexelType* atlasdst = (TexelType*)mAtlasData.data() + atlasx * kBrickSize + atlasy * (atlasSizePixels.x * kBrickSize) + atlasz * (pixelsPerSlice * kBrickSize);
+                    for (int pixz = 0; pixz < kBrickSize; ++pixz)
+                    {
+                        for (int pixy = 0; pixy < kBrickSize; ++pixy)
                         {
-                            for (int pixy = 0; pixy < kBrickSize; ++pixy)
+                            for (int pixx = 0; pixx < kBrickSize; ++pixx)
                             {
-                                for (int pixx = 0; pixx < kBrickSize; ++pixx)
-                                {
-                                    float f = data[pixx * kBrickSize * kBrickSize + pixy * kBrickSize + pixz];
-                                    *atlasdst++ = TexelType((f - minorant) * invRange);
-                                }
-                                atlasdst += (atlasSizePixels.x - kBrickSize); // next scanline
+                                float f = data[pixx * kBrickSize * kBrickSize + pixy * kBrickSize + pixz];
+                                *atlasdst++ = TexelType((f - minorant) * invRange);
                             }
-                            atlasdst += (pixelsPerSlice - (atlasSizePixels.x * kBrickSize)); // next slice
+                            atlasdst += (atlasSizePixels.x - kBrickSize); // next scanline
                         }
+                        atlasdst += (pixelsPerSlice - (atlasSizePixels.x * kBrickSize)); // next slice
                     }
-                    else {
-                        // BC4 compression:
-                        float invRange = (255.f) / (majorant - minorant);
-                        uint64_t* atlasdst = ((uint64_t*)mAtlasData.data() + atlasx * (kBrickSize / 4) + atlasy * ((atlasSizePixels.x / 4) * kBrickSize / 4) + atlasz * (pixelsPerSlice / 16 * kBrickSize));
-                        for (int pixz = 0; pixz < kBrickSize; ++pixz)
+                }
+                else {
+                    // BC4 compression:
+                    float invRange = (255.f) / (majorant - minorant);
+                    uint64_t* atlasdst = ((uint64_t*)mAtlasData.data() + atlasx * (kBrickSize / 4) + atlasy * ((atlasSizePixels.x / 4) * kBrickSize / 4) + atlasz * (pixelsPerSlice / 16 * kBrickSize));
+                    for (int pixz = 0; pixz < kBrickSize; ++pixz)
+                    {
+                        for (int tiley = 0; tiley < kBrickSize; tiley += 4)
                         {
-                            for (int tiley = 0; tiley < kBrickSize; tiley += 4)
-                            {
-                                for (int tilex = 0; tilex < kBrickSize; tilex += 4) {
-                                    uint8_t tilevals[4][4];
-                                    uint8_t tileminorant = 255, tilemajorant = 0;
-                                    for (int pixy = 0; pixy < 4; ++pixy)
+                            for (int tilex = 0; tilex < kBrickSize; tilex += 4) {
+                                uint8_t tilevals[4][4];
+                                uint8_t tileminorant = 255, tilemajorant = 0;
+                                for (int pixy = 0; pixy < 4; ++pixy)
+                                {
+                                    for (int pixx = 0; pixx < 4; ++pixx)
                                     {
-                                        for (int pixx = 0; pixx < 4; ++pixx)
-                                        {
-                                            float f = data[(pixx + tilex) * (kBrickSize * kBrickSize) + (pixy + tiley) * kBrickSize + pixz];
-                                            uint8_t voxel = uint8_t((f - minorant) * invRange);
-                                            tileminorant = std::min(tileminorant, voxel);
-                                            tilemajorant = std::max(tilemajorant, voxel);
-                                            tilevals[pixy][pixx] = voxel;
-                                        }
+                                        float f = data[(pixx + tilex) * (kBrickSize * kBrickSize) + (pixy + tiley) * kBrickSize + pixz];
+                                        uint8_t voxel = uint8_t((f - minorant) * invRange);
+                                        tileminorant = std::min(tileminorant, voxel);
+                                        tilemajorant = std::max(tilemajorant, voxel);
+                                        tilevals[pixy][pixx] = voxel;
                                     }
-                                    CompressAlphaDxt5((uint8_t*)&tilevals[0][0], atlasdst);
-                                    atlasdst++;
                                 }
-                                atlasdst += (atlasSizePixels.x / 4 - kBrickSize / 4); // next scanline
+                                CompressAlphaDxt5((uint8_t*)&tilevals[0][0], atlasdst);
+                                atlasdst++;
                             }
-                            atlasdst += (pixelsPerSlice / 16 - (atlasSizePixels.x / 4 * kBrickSize / 4)); // next slice
-                        } // z slice loop
-                    } // bc4 compress?
-                } // non empty brick?
-            } // x brick loop
-        } // y brick loop
+                            atlasdst += (atlasSizePixels.x / 4 - kBrickSize / 4); // next scanline
+                        }
+                        atlasdst += (pixelsPerSlice / 16 - (atlasSizePixels.x / 4 * kBrickSize / 4)); // next slice
+                    } // z slice loop
+                } // bc4 compress?
+            } // non empty brick?
+        } // x brick loop
     }
 
     template <typename TexelType, unsigned int kBitsPerTexel>
-    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::computeMip(int mip)
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::computeMipSlice(int mip, int z)
     {
-        uint32_t* rangedst = mRangeData.data() + mLeafCount[mip - 1];
-        uint32_t* rangesrc = mRangeData.data() + ((mip > 1) ? mLeafCount[mip - 2] : 0);
         int3 leafdim_src = mLeafDim[mip - 1];
         uint32_t rowstride_src = leafdim_src.x;
         uint32_t slicestride_src = leafdim_src.y * rowstride_src;
@@ -260,43 +328,58 @@ namespace Falcor
         uint32_t rowstride_tgt = leafdim_tgt.x;
         uint32_t slicestride_tgt = leafdim_tgt.y * rowstride_tgt;
 
-        for (int z = 0; z < leafdim_tgt.z; ++z, rangesrc += slicestride_src)
+        // Each target slice reads two source slices.
+        uint32_t* rangedst = mRangeData.data() + mLeafCount[mip - 1] + (size_t)z * slicestride_tgt;
+        uint32_t* rangesrc = mRangeData.data() + ((mip > 1) ? mLeafCount[mip - 2] : 0) + (size_t)z * 2 * slicestride_src;
+
+        for (int y = 0; y < leafdim_tgt.y; ++y, rangesrc += rowstride_src)
         {
-            for (int y = 0; y < leafdim_tgt.y; ++y, rangesrc += rowstride_src)
+            for (int x = 0; x < leafdim_tgt.x; ++x, rangesrc += 2)
             {
-                for (int x = 0; x < leafdim_tgt.x; ++x, rangesrc += 2)
-                {
-                    float2 majmin_dst = combineMajMin(
-                        combineMajMin(
-                            combineMajMin(unpackMajMin(rangesrc), unpackMajMin(rangesrc + 1)),
-                            combineMajMin(unpackMajMin(rangesrc + rowstride_src), unpackMajMin(rangesrc + 1 + rowstride_src))
-                        ),
-                        combineMajMin(
-                            combineMajMin(unpackMajMin(rangesrc + slicestride_src), unpackMajMin(rangesrc + slicestride_src + 1)),
-                            combineMajMin(unpackMajMin(rangesrc + slicestride_src + rowstride_src), unpackMajMin(rangesrc + slicestride_src + 1 + rowstride_src))
-                        )
-                    );
-                    *rangedst++ = f32tof16(majmin_dst.x) + (f32tof16(majmin_dst.y) << 16);
-                } // x
-            } // y
-        } // z
+                float2 majmin_dst = combineMajMin(
+                    combineMajMin(
+                        combineMajMin(unpackMajMin(rangesrc), unpackMajMin(rangesrc + 1)),
+                        combineMajMin(unpackMajMin(rangesrc + rowstride_src), unpackMajMin(rangesrc + 1 + rowstride_src))
+                    ),
+                    combineMajMin(
+                        combineMajMin(unpackMajMin(rangesrc + slicestride_src), unpackMajMin(rangesrc + slicestride_src + 1)),
+                        combineMajMin(unpackMajMin(rangesrc + slicestride_src + rowstride_src), unpackMajMin(rangesrc + slicestride_src + 1 + rowstride_src))
+                    )
+                );
+                *rangedst++ = f32tof16(majmin_dst.x) + (f32tof16(majmin_dst.y) << 16);
+            } // x
+        } // y
     }
 
     template <typename TexelType, unsigned int kBitsPerTexel>
     BrickedGrid NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::convert(ref<Device> pDevice)
+    {
+        convertBricks();
+        return createTextures(pDevice);
+    }
+
+    template <typename TexelType, unsigned int kBitsPerTexel>
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::convertBricks()
     {
         auto t0 = CpuTimer::getCurrentTimePoint();
-        auto range = NumericRange<int>(0, mLeafDim[0].z);
-        std::for_each(std::execution::par, range.begin(), range.end(), [&](int z) { convertSlice(z); });
-        for (int mip = 1; mip < 4; ++mip) computeMip(mip);
+        const int3 leafDim = mLeafDim[0];
+        Threading::parallelForEach(0, (size_t)leafDim.y * leafDim.z, [&](size_t row) { convertRow(int(row % leafDim.y), int(row / leafDim.y)); });
+        for (int mip = 1; mip < 4; ++mip)
+        {
+            Threading::parallelForEach(0, (size_t)mLeafDim[mip].z, [&](size_t z) { computeMipSlice(mip, (int)z); });
+        }
 
+        double dt = CpuTimer::calcDuration(t0, CpuTimer::getCurrentTimePoint());
+        logDebug("Converted '{}' in {:.4}ms: mNonEmptyCount {} vs max {}", mpFloatGrid->gridName(), dt, mNonEmptyCount.load(), getAtlasMaxBrick());
+    }
+
+    template <typename TexelType, unsigned int kBitsPerTexel>
+    BrickedGrid NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::createTextures(ref<Device> pDevice)
+    {
         BrickedGrid bricks;
         bricks.range = pDevice->createTexture3D(mLeafDim[0].x, mLeafDim[0].y, mLeafDim[0].z, ResourceFormat::RG16Float, 4, mRangeData.data(), ResourceBindFlags::ShaderResource);
         bricks.indirection = pDevice->createTexture3D(mLeafDim[0].x, mLeafDim[0].y, mLeafDim[0].z, ResourceFormat::RGBA8Uint, 1, mPtrData.data(), ResourceBindFlags::ShaderResource);
         bricks.atlas = pDevice->createTexture3D(getAtlasSizePixels().x, getAtlasSizePixels().y, getAtlasSizePixels().z, getAtlasFormat(), 1, mAtlasData.data(), ResourceBindFlags::ShaderResource);
-
-        double dt = CpuTimer::calcDuration(t0, CpuTimer::getCurrentTimePoint());
-        logDebug("Converted '{}' in {:.4}ms: mNonEmptyCount {} vs max {}", mpFloatGrid->gridName(), dt, mNonEmptyCount.load(), getAtlasMaxBrick());
         return bricks;
     }
 }
@@ -0,0 +1,318 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "GridSequenceStreamer.h"
+#include "Utils/Logger.h"
+#include "Utils/StringUtils.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <algorithm>
+#include <limits>
+
+namespace Falcor
+{
+    namespace
+    {
+        const ref<Grid> kNullGrid;
+    }
+
+    GridSequenceStreamer::GridSequenceStreamer(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname, const Options& options)
+        : mpDevice(pDevice)
+        , mGridname(gridname)
+        , mOptions(options)
+    {
+        mFrames.resize(paths.size());
+        for (size_t i = 0; i < paths.size(); ++i) mFrames[i].path = paths[i];
+    }
+
+    std::vector<std::filesystem::path> GridSequenceStreamer::getPaths() const
+    {
+        std::vector<std::filesystem::path> paths(mFrames.size());
+        for (size_t i = 0; i < mFrames.size(); ++i) paths[i] = mFrames[i].path;
+        return paths;
+    }
+
+    const ref<Grid>& GridSequenceStreamer::setFrame(uint32_t frame)
+    {
+        if (mFrames.empty()) return kNullGrid;
+
+        // Setting the same frame again is not counted as a hit.
+        const uint32_t prevFrame = mCurrentFrame;
+        mCurrentFrame = std::min(frame, (uint32_t)mFrames.size() - 1);
+        collectLoads();
+        makeResident(mCurrentFrame, mCurrentFrame != prevFrame);
+        evict();
+        prefetch();
+        updateResidentStats();
+
+        return mFrames[mCurrentFrame].pGrid;
+    }
+
+    const ref<Grid>& GridSequenceStreamer::getGrid() const
+    {
+        return mFrames.empty() ? kNullGrid : mFrames[mCurrentFrame].pGrid;
+    }
+
+    void GridSequenceStreamer::finishLoads()
+    {
+        for (uint32_t frameIndex : mLoadingFrames) finishLoad(mFrames[frameIndex]);
+        mLoadingFrames.clear();
+        updateResidentStats();
+    }
+
+    void GridSequenceStreamer::resetStats()
+    {
+        mStats = Stats();
+        updateResidentStats();
+    }
+
+    void GridSequenceStreamer::renderUI(Gui::Widgets& widget)
+    {
+        const uint64_t requestCount = mStats.hitCount + mStats.missCount;
+        widget.text(fmt::format(
+            "Streamed frames: {}\n"
+            "Resident frames: {} ({}, {} reusable buffers)\n"
+            "Hits: {}, misses: {} ({:.1f}% hit rate)\n"
+            "Prefetched: {}, discarded: {}, evicted: {}\n"
+            "Stall time: {:.1f} ms",
+            mFrames.size(),
+            mStats.residentFrameCount, formatByteSize(mStats.residentBytes), formatByteSize(mStats.spareBytes),
+            mStats.hitCount, mStats.missCount, requestCount > 0 ? 100.0 * mStats.hitCount / requestCount : 0.0,
+            mStats.prefetchCount, mStats.discardCount, mStats.evictionCount,
+            mStats.stallTimeMs
+        ));
+
+        widget.var("Frames ahead", mOptions.framesAhead, 0u, 256u, 1u);
+        widget.var("Frames behind", mOptions.framesBehind, 0u, 256u, 1u);
+        widget.var("Concurrent loads", mOptions.maxConcurrentLoads, 1u, 16u, 1u);
+        uint32_t memoryLimitMB = (uint32_t)(mOptions.memoryLimit >> 20);
+        if (widget.var("Memory limit (MB)", memoryLimitMB, 1u, std::numeric_limits<uint32_t>::max(), 64u)) mOptions.memoryLimit = (uint64_t)memoryLimitMB << 20;
+
+        if (widget.button("Reset stats")) resetStats();
+    }
+
+    void GridSequenceStreamer::collectLoads()
+    {
+        for (auto it = mLoadingFrames.begin(); it != mLoadingFrames.end();)
+        {
+            Frame& f = mFrames[*it];
+            if (f.task.isRunning())
+            {
+                ++it;
+                continue;
+            }
+            finishLoad(f);
+            it = mLoadingFrames.erase(it);
+        }
+    }
+
+    void GridSequenceStreamer::prefetch()
+    {
+        const uint32_t frameCount = (uint32_t)mFrames.size();
+        const uint32_t framesAhead = std::min(mOptions.framesAhead, frameCount - 1);
+
+        // Size of a frame is not known before it is loaded, estimate it from the frames loaded so far.
+        const uint64_t estimatedBytes = mLoadedCount > 0 ? mLoadedBytes / mLoadedCount : 0;
+        uint64_t projectedBytes = getResidentBytes() + mLoadingFrames.size() * estimatedBytes;
+
+        for (uint32_t distance = 1; distance <= framesAhead && mLoadingFrames.size() < mOptions.maxConcurrentLoads; ++distance)
+        {
+            const uint32_t frameIndex = (mCurrentFrame + distance) % frameCount;
+            Frame& f = mFrames[frameIndex];
+            if (f.isLoaded() || f.failed || f.task.isValid()) continue;
+
+            projectedBytes += estimatedBytes;
+            if (projectedBytes > mOptions.memoryLimit) break;
+
+            // The task only captures copies, so it can outlive the streamer.
+            auto pResult = createLoadResult();
+            f.pResult = pResult;
+            f.task = Threading::dispatchTask([pResult, path = f.path, gridname = mGridname]() { pResult->loaded = Grid::loadHostData(path, gridname, pResult->hostData); });
+            mLoadingFrames.push_back(frameIndex);
+            mStats.prefetchCount++;
+        }
+    }
+
+    void GridSequenceStreamer::evict()
+    {
+        const uint32_t frameCount = (uint32_t)mFrames.size();
+
+        // Frames that left the window.
+        for (uint32_t i = 0; i < frameCount; ++i)
+        {
+            if (mFrames[i].isLoaded() && !isInWindow(i)) release(mFrames[i]);
+        }
+
+        // Memory limit. Frames with the largest distance ahead of the current frame go first,
+        // which are the frames behind it followed by the frames furthest ahead. The current frame is always kept.
+        uint64_t residentBytes = getResidentBytes();
+        if (residentBytes <= mOptions.memoryLimit) return;
+
+        std::vector<uint32_t> candidates;
+        for (uint32_t i = 0; i < frameCount; ++i)
+        {
+            if (mFrames[i].isLoaded() && i != mCurrentFrame) candidates.push_back(i);
+        }
+        std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b) { return getDistanceAhead(a) > getDistanceAhead(b); });
+
+        for (uint32_t i : candidates)
+        {
+            if (residentBytes <= mOptions.memoryLimit) break;
+            residentBytes -= mFrames[i].sizeInBytes;
+            release(mFrames[i]);
+        }
+    }
+
+    void GridSequenceStreamer::makeResident(uint32_t frameIndex, bool countHit)
+    {
+        Frame& f = mFrames[frameIndex];
+        if (f.failed) return;
+        if (f.isLoaded())
+        {
+            if (countHit) mStats.hitCount++;
+        }
+        else
+        {
+            mStats.missCount++;
+            auto t0 = CpuTimer::getCurrentTimePoint();
+            if (f.task.isValid())
+            {
+                finishLoad(f);
+                mLoadingFrames.erase(std::find(mLoadingFrames.begin(), mLoadingFrames.end(), frameIndex));
+            }
+            else
+            {
+                f.pResult = createLoadResult();
+                f.pResult->loaded = Grid::loadHostData(f.path, mGridname, f.pResult->hostData);
+                finishLoad(f);
+            }
+            mStats.stallTimeMs += CpuTimer::calcDuration(t0, CpuTimer::getCurrentTimePoint());
+        }
+
+        f.used = true;
+
+        // Upload to the GPU. The grid keeps the NanoVDB data on the CPU, the brick buffers are reused by the next loads.
+        // Without a device the host data stays resident instead.
+        if (f.hostData && mpDevice)
+        {
+            f.pGrid = Grid::createFromHostData(mpDevice, *f.hostData);
+            recycle(*f.hostData);
+            f.hostData.reset();
+            f.sizeInBytes = f.pGrid->getGridSizeInBytes() + f.pGrid->getGridHandle().size();
+        }
+    }
+
+    void GridSequenceStreamer::finishLoad(Frame& f)
+    {
+        try
+        {
+            f.task.finish();
+        }
+        catch (const std::exception& e)
+        {
+            logWarning("Error when loading grid '{}' from '{}': {}", mGridname, f.path, e.what());
+        }
+        f.task = {};
+
+        if (f.pResult && f.pResult->loaded)
+        {
+            f.hostData = std::move(f.pResult->hostData);
+            f.sizeInBytes = f.hostData->getSizeInBytes();
+            mLoadedBytes += f.sizeInBytes;
+            mLoadedCount++;
+        }
+        else
+        {
+            if (f.pResult) recycle(f.pResult->hostData);
+            f.failed = true;
+        }
+        f.pResult.reset();
+    }
+
+    std::shared_ptr<GridSequenceStreamer::LoadResult> GridSequenceStreamer::createLoadResult()
+    {
+        auto pResult = std::make_shared<LoadResult>();
+        if (!mSpareHostData.empty())
+        {
+            pResult->hostData = std::move(mSpareHostData.back());
+            mSpareHostData.pop_back();
+        }
+        return pResult;
+    }
+
+    void GridSequenceStreamer::recycle(Grid::HostData& hostData)
+    {
+        // One set of brick buffers per concurrent load is enough.
+        if (!hostData.pBricks || mSpareHostData.size() >= mOptions.maxConcurrentLoads) return;
+        hostData.gridHandle = {};
+        mSpareHostData.push_back(std::move(hostData));
+    }
+
+    void GridSequenceStreamer::release(Frame& f)
+    {
+        if (!f.used) mStats.discardCount++;
+        mStats.evictionCount++;
+        f.used = false;
+        f.pGrid = nullptr;
+        if (f.hostData) recycle(*f.hostData);
+        f.hostData.reset();
+        f.sizeInBytes = 0;
+    }
+
+    void GridSequenceStreamer::updateResidentStats()
+    {
+        mStats.residentFrameCount = 0;
+        mStats.residentBytes = 0;
+        for (const auto& f : mFrames)
+        {
+            if (!f.isLoaded()) continue;
+            mStats.residentFrameCount++;
+            mStats.residentBytes += f.sizeInBytes;
+        }
+        mStats.spareBytes = 0;
+        for (const auto& hostData : mSpareHostData) mStats.spareBytes += hostData.getSizeInBytes();
+    }
+
+    uint64_t GridSequenceStreamer::getResidentBytes() const
+    {
+        uint64_t residentBytes = 0;
+        for (const auto& f : mFrames) residentBytes += f.sizeInBytes;
+        for (const auto& hostData : mSpareHostData) residentBytes += hostData.getSizeInBytes();
+        return residentBytes;
+    }
+
+    uint32_t GridSequenceStreamer::getDistanceAhead(uint32_t frameIndex) const
+    {
+        const uint32_t frameCount = (uint32_t)mFrames.size();
+        return (frameIndex + frameCount - mCurrentFrame) % frameCount;
+    }
+
+    bool GridSequenceStreamer::isInWindow(uint32_t frameIndex) const
+    {
+        const uint32_t distance = getDistanceAhead(frameIndex);
+        return distance <= mOptions.framesAhead || (uint32_t)mFrames.size() - distance <= mOptions.framesBehind;
+    }
+}
@@ -0,0 +1,188 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Grid.h"
+#include "Core/Macros.h"
+#include "Core/Object.h"
+#include "Utils/Threading.h"
+#include "Utils/UI/Gui.h"
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Falcor
+{
+    /** Grid sequence that is streamed from files instead of being loaded up front.
+        Only a window of frames around the current frame is kept in memory. Frames ahead of the current frame are
+        loaded from file and converted to bricks on worker threads, and uploaded to the GPU when they become current.
+        Frames outside the window are evicted, and frames furthest ahead of the current frame are evicted first to stay below the memory limit.
+        The window wraps around the end of the sequence, as grid playback loops.
+        All functions must be called from the thread owning the device.
+    */
+    class FALCOR_API GridSequenceStreamer : public Object
+    {
+        FALCOR_OBJECT(GridSequenceStreamer)
+    public:
+        struct Options
+        {
+            uint32_t framesAhead = 8;                   ///< Frames after the current frame that are prefetched.
+            uint32_t framesBehind = 1;                  ///< Frames before the current frame that are kept resident.
+            uint32_t maxConcurrentLoads = 2;            ///< Maximum number of frames loaded on worker threads at a time.
+            uint64_t memoryLimit = 4ull << 30;          ///< Memory limit in bytes for resident frames (GPU and CPU) and prefetched frames.
+        };
+
+        struct Stats
+        {
+            uint64_t hitCount = 0;                      ///< Frames that were resident or prefetched when they became current.
+            uint64_t missCount = 0;                     ///< Frames that had to be loaded (or waited for) when they became current.
+            uint64_t prefetchCount = 0;                 ///< Frames loaded on worker threads.
+            uint64_t discardCount = 0;                  ///< Prefetched frames that left the window before being used.
+            uint64_t evictionCount = 0;                 ///< Frames evicted from memory.
+            double stallTimeMs = 0.0;                   ///< Total time spent loading or waiting for frames on misses.
+            uint32_t residentFrameCount = 0;            ///< Frames currently held in memory.
+            uint64_t residentBytes = 0;                 ///< Memory used by the frames currently held in memory.
+            uint64_t spareBytes = 0;                    ///< Memory of the brick buffers kept for reuse by the next loads.
+        };
+
+        /** Create a streamer for a grid sequence. No grid is loaded until the first call to setFrame().
+            \param[in] pDevice GPU device. If null, frames are only loaded on the CPU and getGrid() returns nullptr.
+            \param[in] paths File paths of the grids, one per frame.
+            \param[in] gridname Name of the grid to load.
+            \param[in] options Streaming options.
+        */
+        static ref<GridSequenceStreamer> create(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname, const Options& options = Options())
+        {
+            return make_ref<GridSequenceStreamer>(pDevice, paths, gridname, options);
+        }
+
+        GridSequenceStreamer(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname, const Options& options);
+
+        /** Set the current frame. Loads the frame if it is not resident, then schedules prefetches and evicts frames.
+            \param[in] frame Frame index, clamped to the sequence length.
+            \return The grid of the frame, or nullptr if it failed to load.
+        */
+        const ref<Grid>& setFrame(uint32_t frame);
+
+        /** Get the grid of the current frame.
+        */
+        const ref<Grid>& getGrid() const;
+
+        /** Check if a frame is held in memory, either uploaded to the GPU or prefetched.
+        */
+        bool isFrameResident(uint32_t frame) const { return frame < mFrames.size() && mFrames[frame].isLoaded(); }
+
+        /** Wait for all pending prefetches.
+            Frames that finished loading are hits when they become current, so this makes playback independent of the load times.
+        */
+        void finishLoads();
+
+        /** Get the current frame.
+        */
+        uint32_t getFrame() const { return mCurrentFrame; }
+
+        /** Get the number of frames in the sequence.
+        */
+        uint32_t getFrameCount() const { return (uint32_t)mFrames.size(); }
+
+        /** Get the file paths of the grids, one per frame.
+        */
+        std::vector<std::filesystem::path> getPaths() const;
+
+        /** Get the name of the grid loaded from each file.
+        */
+        const std::string& getGridname() const { return mGridname; }
+
+        /** Set the streaming options. Takes effect at the next call to setFrame().
+        */
+        void setOptions(const Options& options) { mOptions = options; }
+
+        /** Get the streaming options.
+        */
+        const Options& getOptions() const { return mOptions; }
+
+        /** Get the streaming statistics.
+        */
+        const Stats& getStats() const { return mStats; }
+
+        /** Reset the hit/miss counters.
+        */
+        void resetStats();
+
+        /** Render the UI.
+        */
+        void renderUI(Gui::Widgets& widget);
+
+    private:
+        struct LoadResult
+        {
+            Grid::HostData hostData;
+            bool loaded = false;
+        };
+
+        struct Frame
+        {
+            std::filesystem::path path;
+            ref<Grid> pGrid;                                            ///< Grid uploaded to the GPU.
+            std::optional<Grid::HostData> hostData;                     ///< Prefetched grid waiting to be uploaded.
+            Threading::Task task;                                       ///< Pending load on a worker thread.
+            std::shared_ptr<LoadResult> pResult;                        ///< Written by the pending load.
+            uint64_t sizeInBytes = 0;
+            bool used = false;                                          ///< Frame was current since it was loaded.
+            bool failed = false;
+
+            bool isLoaded() const { return pGrid || hostData; }
+        };
+
+        void collectLoads();
+        void prefetch();
+        void evict();
+        void makeResident(uint32_t frameIndex, bool countHit);
+        void finishLoad(Frame& f);
+        void release(Frame& f);
+        std::shared_ptr<LoadResult> createLoadResult();
+        void recycle(Grid::HostData& hostData);
+        void updateResidentStats();
+
+        uint64_t getResidentBytes() const;
+        uint32_t getDistanceAhead(uint32_t frameIndex) const;
+        bool isInWindow(uint32_t frameIndex) const;
+
+        ref<Device> mpDevice;
+        std::string mGridname;
+        Options mOptions;
+        std::vector<Frame> mFrames;
+        uint32_t mCurrentFrame = 0;
+        std::vector<uint32_t> mLoadingFrames;                           ///< Frames with a pending load.
+        std::vector<Grid::HostData> mSpareHostData;                     ///< Host data of uploaded or evicted frames, its brick buffers are reused by the next loads.
+        uint64_t mLoadedBytes = 0;                                      ///< Total size of the frames loaded so far, used to estimate the size of pending loads.
+        uint32_t mLoadedCount = 0;
+        Stats mStats;
+    };
+}
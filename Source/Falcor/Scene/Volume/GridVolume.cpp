@@ -49,6 +49,36 @@ namespace Falcor
         const float kMaxAnisotropy = 0.99f;
         const double kMinFrameRate = 1.0;
         const double kMaxFrameRate = 1000.0;
+
+        bool findGridFiles(const std::filesystem::path& path, std::vector<std::filesystem::path>& paths)
+        {
+            if (!std::filesystem::exists(path))
+            {
+                logWarning("'{}' does not exist.", path);
+                return false;
+            }
+            if (!std::filesystem::is_directory(path))
+            {
+                logWarning("'{}' is not a directory.", path);
+                return false;
+            }
+
+            // Enumerate grid files.
+            paths.clear();
+            for (auto it : std::filesystem::directory_iterator(path))
+            {
+                if (hasExtension(it.path(), "nvdb") || hasExtension(it.path(), "vdb")) paths.push_back(it.path());
+            }
+
+            // Sort by length first, then alpha-numerically.
+            auto cmp = [](const std::filesystem::path& a, const std::filesystem::path& b) {
+                auto sa = a.string();
+                auto sb = b.string();
+                return sa.length() != sb.length() ? sa.length() < sb.length() : sa < sb;
+            };
+            std::sort(paths.begin(), paths.end(), cmp);
+            return true;
+        }
     }
 
     static_assert(sizeof(GridVolumeData) % 16 == 0, "GridVolumeData size should be a multiple of 16");
@@ -80,6 +110,16 @@ namespace Falcor
             if (widget.checkbox("Playback", playback)) setPlaybackEnabled(playback);
         }
 
+        if (const auto& pStreamer = getGridSequenceStreamer(GridSlot::Density))
+        {
+            if (auto group = widget.group("Density Streaming")) pStreamer->renderUI(group);
+        }
+
+        if (const auto& pStreamer = getGridSequenceStreamer(GridSlot::Emission))
+        {
+            if (auto group = widget.group("Emission Streaming")) pStreamer->renderUI(group);
+        }
+
         if (const auto& densityGrid = getDensityGrid())
         {
             if (auto group = widget.group("Density Grid")) densityGrid->renderUI(group);
@@ -127,10 +167,12 @@ namespace Falcor
 
     GridVolume::GridSequence GridVolume::createGridSequence(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname, bool keepEmpty)
     {
+        // The brick buffers are reused for all grids of the sequence.
         GridSequence grids;
+        Grid::HostData hostData;
         for (const auto& path : paths)
         {
-            auto grid = Grid::createFromFile(pDevice, path, gridname);
+            auto grid = Grid::loadHostData(path, gridname, hostData) ? Grid::createFromHostData(pDevice, hostData) : nullptr;
             if (keepEmpty || grid) grids.push_back(grid);
         }
 
@@ -146,33 +188,47 @@ namespace Falcor
 
     uint32_t GridVolume::loadGridSequence(GridSlot slot, const std::filesystem::path& path, const std::string& gridname, bool keepEmpty)
     {
-        if (!std::filesystem::exists(path))
-        {
-            logWarning("'{}' does not exist.", path);
-            return 0;
-        }
-        if (!std::filesystem::is_directory(path))
-        {
-            logWarning("'{}' is not a directory.", path);
-            return 0;
-        }
+        std::vector<std::filesystem::path> paths;
+        if (!findGridFiles(path, paths)) return 0;
+        return loadGridSequence(slot, paths, gridname, keepEmpty);
+    }
+
+    uint32_t GridVolume::streamGridSequence(GridSlot slot, const std::vector<std::filesystem::path>& paths, const std::string& gridname, const GridSequenceStreamer::Options& options)
+    {
+        auto pStreamer = GridSequenceStreamer::create(mpDevice, paths, gridname, options);
+        setGridSequenceStreamer(slot, pStreamer);
+        return pStreamer->getFrameCount();
+    }
 
-        // Enumerate grid files.
+    uint32_t GridVolume::streamGridSequence(GridSlot slot, const std::filesystem::path& path, const std::string& gridname, const GridSequenceStreamer::Options& options)
+    {
         std::vector<std::filesystem::path> paths;
-        for (auto it : std::filesystem::directory_iterator(path))
+        if (!findGridFiles(path, paths)) return 0;
+        return streamGridSequence(slot, paths, gridname, options);
+    }
+
+    void GridVolume::setGridSequenceStreamer(GridSlot slot, const ref<GridSequenceStreamer>& pStreamer)
+    {
+        uint32_t slotIndex = (uint32_t)slot;
+        FALCOR_ASSERT(slotIndex >= 0 && slotIndex < (uint32_t)GridSlot::Count);
+
+        if (mStreamers[slotIndex] != pStreamer)
         {
-            if (hasExtension(it.path(), "nvdb") || hasExtension(it.path(), "vdb")) paths.push_back(it.path());
+            mGrids[slotIndex].clear();
+            mStreamers[slotIndex] = pStreamer;
+            updateSequence();
+            updateStreamers();
+            updateBounds();
+            markUpdates(UpdateFlags::GridsChanged);
         }
+    }
 
-        // Sort by length first, then alpha-numerically.
-        auto cmp = [](const std::filesystem::path& a, const std::filesystem::path& b) {
-            auto sa = a.string();
-            auto sb = b.string();
-            return sa.length() != sb.length() ? sa.length() < sb.length() : sa < sb;
-        };
-        std::sort(paths.begin(), paths.end(), cmp);
+    const ref<GridSequenceStreamer>& GridVolume::getGridSequenceStreamer(GridSlot slot) const
+    {
+        uint32_t slotIndex = (uint32_t)slot;
+        FALCOR_ASSERT(slotIndex >= 0 && slotIndex < (uint32_t)GridSlot::Count);
 
-        return loadGridSequence(slot, paths, gridname, keepEmpty);
+        return mStreamers[slotIndex];
     }
 
     void GridVolume::setGridSequence(GridSlot slot, const GridSequence& grids)
@@ -180,9 +236,10 @@ namespace Falcor
         uint32_t slotIndex = (uint32_t)slot;
         FALCOR_ASSERT(slotIndex >= 0 && slotIndex < (uint32_t)GridSlot::Count);
 
-        if (mGrids[slotIndex] != grids)
+        if (mGrids[slotIndex] != grids || mStreamers[slotIndex])
         {
             mGrids[slotIndex] = grids;
+            mStreamers[slotIndex] = nullptr;
             updateSequence();
             updateBounds();
             markUpdates(UpdateFlags::GridsChanged);
@@ -209,6 +266,8 @@ namespace Falcor
         uint32_t slotIndex = (uint32_t)slot;
         FALCOR_ASSERT(slotIndex >= 0 && slotIndex < (uint32_t)GridSlot::Count);
 
+        if (mStreamers[slotIndex]) return mStreamers[slotIndex]->getGrid();
+
         const auto& gridSequence = mGrids[slotIndex];
         uint32_t gridIndex = std::min(mGridFrame, (uint32_t)gridSequence.size() - 1);
         return gridSequence.empty() ? kNullGrid : gridSequence[gridIndex];
@@ -221,6 +280,10 @@ namespace Falcor
         {
             std::copy_if(grids.begin(), grids.end(), std::inserter(uniqueGrids, uniqueGrids.begin()), [] (const auto& grid) { return grid != nullptr; });
         }
+        for (const auto& pStreamer : mStreamers)
+        {
+            if (pStreamer && pStreamer->getGrid()) uniqueGrids.insert(pStreamer->getGrid());
+        }
         return std::vector<ref<Grid>>(uniqueGrids.begin(), uniqueGrids.end());
     }
 
@@ -229,6 +292,7 @@ namespace Falcor
         if (mGridFrame != gridFrame)
         {
             mGridFrame = gridFrame;
+            updateStreamers();
             markUpdates(UpdateFlags::GridsChanged);
             updateBounds();
         }
@@ -329,9 +393,21 @@ namespace Falcor
     {
         mGridFrameCount = 1;
         for (const auto& grids : mGrids) mGridFrameCount = std::max(mGridFrameCount, (uint32_t)grids.size());
+        for (const auto& pStreamer : mStreamers)
+        {
+            if (pStreamer) mGridFrameCount = std::max(mGridFrameCount, pStreamer->getFrameCount());
+        }
         setGridFrame(std::min(mGridFrame, mGridFrameCount - 1));
     }
 
+    void GridVolume::updateStreamers()
+    {
+        for (const auto& pStreamer : mStreamers)
+        {
+            if (pStreamer && pStreamer->getFrameCount() > 0) pStreamer->setFrame(std::min(mGridFrame, pStreamer->getFrameCount() - 1));
+        }
+    }
+
     void GridVolume::updateBounds()
     {
         AABB bounds;
@@ -422,6 +498,32 @@ namespace Falcor
             "slot"_a, "path"_a, "gridnames"_a, "keepEmpty"_a = true
         ); // PYTHONDEPRECATED
 
+        auto makeStreamerOptions = [](uint32_t framesAhead, uint32_t framesBehind, uint32_t memoryLimitMB)
+        {
+            GridSequenceStreamer::Options options;
+            options.framesAhead = framesAhead;
+            options.framesBehind = framesBehind;
+            options.memoryLimit = (uint64_t)memoryLimitMB << 20;
+            return options;
+        };
+        const GridSequenceStreamer::Options kDefaultStreamerOptions;
+        const uint32_t kDefaultMemoryLimitMB = (uint32_t)(kDefaultStreamerOptions.memoryLimit >> 20);
+        volume.def("streamGridSequence",
+            [makeStreamerOptions](GridVolume& self, GridVolume::GridSlot slot, const std::vector<std::filesystem::path>& paths, const std::string& gridname, uint32_t framesAhead, uint32_t framesBehind, uint32_t memoryLimitMB)
+            {
+                std::vector<std::filesystem::path> resolvedPaths;
+                for (const auto& path : paths)
+                    resolvedPaths.push_back(getActiveAssetResolver().resolvePath(path));
+                return self.streamGridSequence(slot, resolvedPaths, gridname, makeStreamerOptions(framesAhead, framesBehind, memoryLimitMB));
+            },
+            "slot"_a, "paths"_a, "gridname"_a, "framesAhead"_a = kDefaultStreamerOptions.framesAhead, "framesBehind"_a = kDefaultStreamerOptions.framesBehind, "memoryLimitMB"_a = kDefaultMemoryLimitMB
+        );
+        volume.def("streamGridSequence",
+            [makeStreamerOptions](GridVolume& self, GridVolume::GridSlot slot, const std::filesystem::path& path, const std::string& gridname, uint32_t framesAhead, uint32_t framesBehind, uint32_t memoryLimitMB)
+            { return self.streamGridSequence(slot, getActiveAssetResolver().resolvePath(path), gridname, makeStreamerOptions(framesAhead, framesBehind, memoryLimitMB)); },
+            "slot"_a, "path"_a, "gridname"_a, "framesAhead"_a = kDefaultStreamerOptions.framesAhead, "framesBehind"_a = kDefaultStreamerOptions.framesBehind, "memoryLimitMB"_a = kDefaultMemoryLimitMB
+        );
+
         m.attr("Volume") = m.attr("GridVolume"); // PYTHONDEPRECATED
     }
 }
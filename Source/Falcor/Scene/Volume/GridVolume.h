@@ -27,6 +27,7 @@
  **************************************************************************/
 #pragma once
 #include "Grid.h"
+#include "GridSequenceStreamer.h"
 #include "GridVolumeData.slang"
 #include "Core/Macros.h"
 #include "Utils/Math/AABB.h"
@@ -46,7 +47,8 @@ namespace Falcor
         The absorbing/scattering medium is defined by a density voxel grid and additional parameters.
         The emission is defined by an emission voxel grid and additional parameters.
         Grids are stored in grid slots (density, emission) and can either be static, using one grid per slot,
-        or dynamic, using a sequence of grids per slot.
+        or dynamic, using a sequence of grids per slot. Long sequences can be streamed from files instead,
+        keeping only a window of frames around the current grid frame in memory.
     */
     class FALCOR_API GridVolume : public Animatable
     {
@@ -146,6 +148,36 @@ namespace Falcor
         */
         uint32_t loadGridSequence(GridSlot slot, const std::filesystem::path& path, const std::string& gridname, bool keepEmpty = true);
 
+        /** Stream a sequence of grids from files to a grid slot.
+            Only a window of frames around the current grid frame is loaded, see GridSequenceStreamer.
+            Note: This will replace any existing grid sequence for that slot.
+            \param[in] slot Grid slot.
+            \param[in] paths File paths of the grids. Can also include a full path or relative path from a data directory.
+            \param[in] gridname Name of the grid to load.
+            \param[in] options Streaming options.
+            \return Returns the length of the streamed sequence.
+        */
+        uint32_t streamGridSequence(GridSlot slot, const std::vector<std::filesystem::path>& paths, const std::string& gridname, const GridSequenceStreamer::Options& options = GridSequenceStreamer::Options());
+
+        /** Stream a sequence of grids from a directory to a grid slot.
+            Note: This will replace any existing grid sequence for that slot.
+            \param[in] slot Grid slot.
+            \param[in] path Directory containing grid files. Can also include a full path or relative path from a data directory.
+            \param[in] gridname Name of the grid to load.
+            \param[in] options Streaming options.
+            \return Returns the length of the streamed sequence.
+        */
+        uint32_t streamGridSequence(GridSlot slot, const std::filesystem::path& path, const std::string& gridname, const GridSequenceStreamer::Options& options = GridSequenceStreamer::Options());
+
+        /** Set a streamed grid sequence for the specified slot.
+            Note: This will replace any existing grid sequence for that slot.
+        */
+        void setGridSequenceStreamer(GridSlot slot, const ref<GridSequenceStreamer>& pStreamer);
+
+        /** Get the streamed grid sequence for the specified slot, or nullptr if the slot is not streamed.
+        */
+        const ref<GridSequenceStreamer>& getGridSequenceStreamer(GridSlot slot) const;
+
         /** Set the grid sequence for the specified slot.
         */
         void setGridSequence(GridSlot slot, const GridSequence& grids);
@@ -164,6 +196,7 @@ namespace Falcor
         const ref<Grid>& getGrid(GridSlot slot) const;
 
         /** Get a list of all grids used for this volume.
+            Streamed slots only contribute the grid of the current frame.
         */
         std::vector<ref<Grid>> getAllGrids() const;
 
@@ -284,6 +317,7 @@ namespace Falcor
 
     private:
         void updateSequence();
+        void updateStreamers();
         void updateBounds();
 
         void markUpdates(UpdateFlags updates);
@@ -292,6 +326,7 @@ namespace Falcor
         ref<Device> mpDevice;
         std::string mName;
         std::array<GridSequence, (size_t)GridSlot::Count> mGrids;
+        std::array<ref<GridSequenceStreamer>, (size_t)GridSlot::Count> mStreamers;
         uint32_t mGridFrame = 0;
         uint32_t mGridFrameCount = 1;
         double mFrameRate = 30.f;
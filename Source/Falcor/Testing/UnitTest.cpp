@@ -33,6 +33,7 @@
 #include "Core/Program/ProgramManager.h"
 #include "Utils/Scripting/Scripting.h"
 #include "Utils/Threading.h"
+#include "Utils/Timing/Profiler.h"
 #include "Utils/StringUtils.h"
 #include "Utils/TermColor.h"
 #include "Utils/Logger.h"
@@ -42,11 +43,14 @@
 #include <fmt/format.h>
 #include <fmt/color.h>
 #include <pugixml.hpp>
-#include <BS_thread_pool_light.hpp>
+#include <nlohmann/json.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <optional>
 #include <regex>
+#include <thread>
 #include <cstdint>
 
 namespace Falcor
@@ -211,7 +215,13 @@ inline void writeXmlReport(const std::filesystem::path& path, const std::vector<
     doc.save_file(path.native().c_str());
 }
 
-inline TestResult runTest(const Test& test, DevicePool& devicePool)
+/// Name of the profiler event wrapping a GPU test in a --trace capture. The profiler rejects names containing '/'.
+inline std::string getTraceEventName(const Test& test)
+{
+    return replaceCharacters(test.suiteName + "." + test.name, "/", '_');
+}
+
+inline TestResult runTest(const Test& test, DevicePool& devicePool, const std::filesystem::path& traceDir)
 {
     if (!test.skipMessage.empty())
         return {TestResult::Status::Skipped, {test.skipMessage}};
@@ -225,6 +235,15 @@ inline TestResult runTest(const Test& test, DevicePool& devicePool)
     CPUUnitTestContext cpuCtx;
     GPUUnitTestContext gpuCtx(pDevice);
 
+    // Capture the test as a single profiler frame.
+    Profiler* pProfiler = pDevice && !traceDir.empty() ? pDevice->getProfiler() : nullptr;
+    bool wasProfilerEnabled = false;
+    if (pProfiler)
+    {
+        wasProfilerEnabled = pProfiler->isEnabled();
+        pProfiler->startCapture();
+    }
+
     auto startTime = std::chrono::steady_clock::now();
 
     try
@@ -232,7 +251,12 @@ inline TestResult runTest(const Test& test, DevicePool& devicePool)
         if (test.cpuFunc)
             test.cpuFunc(cpuCtx);
         else
+        {
+            std::optional<ScopedProfilerEvent> testEvent;
+            if (pProfiler)
+                testEvent.emplace(pDevice->getRenderContext(), getTraceEventName(test));
             test.gpuFunc(gpuCtx);
+        }
     }
     catch (const SkippingTestException& e)
     {
@@ -271,6 +295,23 @@ inline TestResult runTest(const Test& test, DevicePool& devicePool)
     auto endTime = std::chrono::steady_clock::now();
     result.elapsedMS = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
 
+    if (pProfiler)
+    {
+        // Tests that capture themselves replace the capture started above, no trace is written for them.
+        if (pProfiler->isCapturing())
+        {
+            pProfiler->endFrame(pDevice->getRenderContext());
+            auto pCapture = pProfiler->endCapture();
+            const std::string eventPath = "/" + getTraceEventName(test) + "/";
+            const auto& lanes = pCapture->getLanes();
+            if (std::none_of(lanes.begin(), lanes.end(), [&](const auto& lane) { return lane.name.rfind(eventPath, 0) == 0; }))
+                logWarning("Trace of test '{}' is missing the test event.", getTraceEventName(test));
+            auto path = traceDir / (replaceCharacters(test.suiteName + "." + test.name, "/\\: ", '_') + ".json");
+            pCapture->writeTraceToFile(path);
+        }
+        pProfiler->setEnabled(wasProfilerEnabled);
+    }
+
     // Release GPU resources.
     if (pDevice)
     {
@@ -304,47 +345,51 @@ inline int32_t runTestsParallel(const RunOptions& options)
 
     std::vector<TestResult> results(tests.size());
 
-    BS::thread_pool_light threadPool(options.parallel);
-
     reportLine("[==========] Running {} test{}.", tests.size(), plural(tests.size(), "s"));
 
-    for (size_t testIndex = 0; testIndex < tests.size(); ++testIndex)
+    // Each runner thread picks the next test until all tests are done, which limits the number of concurrently running tests
+    // to the requested parallelism. The runners are dedicated threads, so tests using the global task scheduler keep all its workers.
+    std::atomic<size_t> nextTestIndex{0};
+    auto runTests = [&options, &abort, &tests, &results, &devicePool, &nextTestIndex]()
     {
-        threadPool.push_task(
-            [&abort, &tests, &results, &devicePool, testIndex]()
-            {
-                if (abort)
-                    return;
+        while (true)
+        {
+            size_t testIndex = nextTestIndex++;
+            if (testIndex >= tests.size() || abort)
+                break;
 
-                const Test& test = tests[testIndex];
-                TestResult& result = results[testIndex];
-                std::string repeats;
+            const Test& test = tests[testIndex];
+            TestResult& result = results[testIndex];
+            std::string repeats;
 
-                reportLine("[ RUN      ] {}:{}{}", test.suiteName, test.name, repeats);
+            reportLine("[ RUN      ] {}:{}{}", test.suiteName, test.name, repeats);
 
-                result = runTest(test, devicePool);
+            result = runTest(test, devicePool, options.traceDir);
 
-                std::string statusTag;
-                switch (result.status)
-                {
-                case TestResult::Status::Passed:
-                    statusTag = "[       OK ]";
-                    break;
-                case TestResult::Status::Failed:
-                    statusTag = "[  FAILED  ]";
-                    break;
-                case TestResult::Status::Skipped:
-                    statusTag = "[  SKIPPED ]";
-                    break;
-                }
-                if (!result.extraMessage.empty())
-                    reportLine("{}", result.extraMessage);
-                reportLine("{} {}:{}{} ({} ms)", statusTag, test.suiteName, test.name, repeats, result.elapsedMS);
+            std::string statusTag;
+            switch (result.status)
+            {
+            case TestResult::Status::Passed:
+                statusTag = "[       OK ]";
+                break;
+            case TestResult::Status::Failed:
+                statusTag = "[  FAILED  ]";
+                break;
+            case TestResult::Status::Skipped:
+                statusTag = "[  SKIPPED ]";
+                break;
             }
-        );
-    }
+            if (!result.extraMessage.empty())
+                reportLine("{}", result.extraMessage);
+            reportLine("{} {}:{}{} ({} ms)", statusTag, test.suiteName, test.name, repeats, result.elapsedMS);
+        }
+    };
 
-    threadPool.wait_for_tasks();
+    std::vector<std::thread> runners;
+    for (uint32_t i = 0; i < std::min<size_t>(options.parallel, tests.size()); ++i)
+        runners.emplace_back(runTests);
+    for (auto& runner : runners)
+        runner.join();
 
     if (abort)
     {
@@ -430,7 +475,7 @@ inline int32_t runTestsSerial(const RunOptions& options)
                 if (options.repeat > 1)
                     repeats = fmt::format("[{}/{}]", repeatIndex + 1, options.repeat);
                 reportLine("[ RUN      ] {}:{}{}", suiteName, test.name, repeats);
-                TestResult result = runTest(test, devicePool);
+                TestResult result = runTest(test, devicePool, options.traceDir);
                 report.emplace_back(test, result);
 
                 std::string statusTag;
@@ -507,6 +552,9 @@ int32_t runTests(const RunOptions& options)
     Threading::start();
     Scripting::start();
 
+    if (!options.traceDir.empty())
+        std::filesystem::create_directories(options.traceDir);
+
     int32_t failureCount = options.parallel > 1 ? runTestsParallel(options) : runTestsSerial(options);
 
     Scripting::shutdown();
@@ -783,6 +831,36 @@ GPU_TEST(TestGPUTest)
     EXPECT_GE(s[6], 11);
 }
 
+GPU_TEST(TestTraceEvent)
+{
+    // The event wrapping a test in a --trace capture must be accepted by the profiler and show up in the trace.
+    unittest::Test test;
+    test.suiteName = "UnitTest.cpp";
+    test.name = "TestTraceEvent (Vulkan)";
+    const std::string eventName = unittest::getTraceEventName(test);
+
+    Profiler* pProfiler = ctx.getDevice()->getProfiler();
+    bool wasEnabled = pProfiler->isEnabled();
+    pProfiler->setEnabled(true);
+    pProfiler->startCapture();
+    {
+        ScopedProfilerEvent testEvent(ctx.getRenderContext(), eventName);
+    }
+    pProfiler->endFrame(ctx.getRenderContext());
+    auto pCapture = pProfiler->endCapture();
+    pProfiler->setEnabled(wasEnabled);
+    ASSERT(pCapture != nullptr);
+
+    size_t count = 0;
+    auto trace = nlohmann::json::parse(pCapture->toTraceJsonString());
+    for (const auto& event : trace["traceEvents"])
+    {
+        if (event["ph"] == "X" && event["name"] == eventName && event["tid"] == 0)
+            count++;
+    }
+    EXPECT_EQ(count, 1u) << "Missing trace event '" << eventName << "'";
+}
+
 CPU_TEST(TestSkip1, "skipped")
 {
     EXPECT(false);
@@ -91,6 +91,7 @@ struct RunOptions
     std::string testCaseFilter;
     std::string tagFilter;
     std::filesystem::path xmlReportPath;
+    std::filesystem::path traceDir; ///< If set, a profiler trace of each GPU test is written to this directory.
     uint32_t parallel = 1;
     uint32_t repeat = 1;
 };
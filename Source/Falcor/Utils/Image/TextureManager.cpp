@@ -29,9 +29,8 @@
 #include "Core/AssetResolver.h"
 #include "Core/API/Device.h"
 #include "Utils/Logger.h"
-#include "Utils/NumericRange.h"
+#include "Utils/Threading.h"
 
-#include <execution>
 
 // Temporarily disable asynchronous texture loader until Falcor supports parallel GPU work submission.
 // Until then `TextureManager` should only called from the main thread.
@@ -409,11 +408,9 @@ void TextureManager::endDeferredLoading()
 
     // Load textures in parallel.
     std::atomic<size_t> texturesLoaded;
-    NumericRange<size_t> jobRange(0, jobs.size());
-    std::for_each(
-        std::execution::par_unseq,
-        jobRange.begin(),
-        jobRange.end(),
+    Threading::parallelForEach(
+        0,
+        jobs.size(),
         [&](size_t i)
         {
             const auto& job = jobs[i];
@@ -437,7 +434,8 @@ void TextureManager::endDeferredLoading()
                 std::lock_guard<std::mutex> lock(mpDevice->getGlobalGfxMutex());
                 mpDevice->wait();
             }
-        }
+        },
+        1
     );
     mpDevice->wait();
 
@@ -0,0 +1,148 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+
+#include "MatrixTypes.h"
+#include "MatrixMath.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define FALCOR_MATRIX_SSE 1
+#include <emmintrin.h>
+#else
+#define FALCOR_MATRIX_SSE 0
+#endif
+
+/**
+ * SSE versions of the 4x4 float matrix operations used by the per-frame scene graph update.
+ * The scalar versions in MatrixMath.h are used when SSE is not available.
+ */
+
+namespace Falcor
+{
+namespace math
+{
+
+#if FALCOR_MATRIX_SSE
+namespace detail
+{
+/// Cross product of the xyz components, the w component of the result is 0.
+inline __m128 cross3SSE(__m128 a, __m128 b)
+{
+    const __m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    const __m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+    const __m128 c = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+    return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+/// Broadcast of the sum of all components.
+inline __m128 horizontalSumSSE(__m128 v)
+{
+    v = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+template<int I>
+inline __m128 broadcastSSE(__m128 v)
+{
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(I, I, I, I));
+}
+} // namespace detail
+#endif
+
+/// Multiply two 4x4 float matrices, same result as mul().
+[[nodiscard]] inline float4x4 mulSIMD(const float4x4& lhs, const float4x4& rhs)
+{
+#if FALCOR_MATRIX_SSE
+    const float* b = rhs.data();
+    const __m128 b0 = _mm_loadu_ps(b + 0);
+    const __m128 b1 = _mm_loadu_ps(b + 4);
+    const __m128 b2 = _mm_loadu_ps(b + 8);
+    const __m128 b3 = _mm_loadu_ps(b + 12);
+
+    float4x4 result;
+    const float* a = lhs.data();
+    float* out = result.data();
+    for (int r = 0; r < 4; ++r)
+    {
+        const float* row = a + 4 * r;
+        __m128 v = _mm_mul_ps(_mm_set1_ps(row[0]), b0);
+        v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(row[1]), b1));
+        v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(row[2]), b2));
+        v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(row[3]), b3));
+        _mm_storeu_ps(out + 4 * r, v);
+    }
+    return result;
+#else
+    return mul(lhs, rhs);
+#endif
+}
+
+/**
+ * Compute the transposed inverse of a 4x4 float matrix, same result as transpose(inverse(m)) up to rounding.
+ * Affine matrices (last row 0,0,0,1) take a fast path that inverts the upper 3x3 part by cofactors,
+ * all other matrices use the general inverse().
+ */
+[[nodiscard]] inline float4x4 inverseTransposeSIMD(const float4x4& m)
+{
+    if (any(m[3] != float4(0.f, 0.f, 0.f, 1.f)))
+        return transpose(inverse(m));
+
+#if FALCOR_MATRIX_SSE
+    // Rows hold the 3x3 part in xyz and the translation in w.
+    const float* p = m.data();
+    const __m128 r0 = _mm_loadu_ps(p + 0);
+    const __m128 r1 = _mm_loadu_ps(p + 4);
+    const __m128 r2 = _mm_loadu_ps(p + 8);
+
+    // The cofactor rows are the rows of the transposed inverse of the 3x3 part scaled by the determinant.
+    const __m128 c0 = detail::cross3SSE(r1, r2);
+    const __m128 c1 = detail::cross3SSE(r2, r0);
+    const __m128 c2 = detail::cross3SSE(r0, r1);
+    const __m128 det = detail::horizontalSumSSE(_mm_mul_ps(r0, c0));
+    const __m128 invDet = _mm_div_ps(_mm_set1_ps(1.f), det);
+
+    // The last row is the inverse translation -(A^-1 t) transposed.
+    __m128 t = _mm_mul_ps(detail::broadcastSSE<3>(r0), c0);
+    t = _mm_add_ps(t, _mm_mul_ps(detail::broadcastSSE<3>(r1), c1));
+    t = _mm_add_ps(t, _mm_mul_ps(detail::broadcastSSE<3>(r2), c2));
+
+    float4x4 result;
+    float* out = result.data();
+    _mm_storeu_ps(out + 0, _mm_mul_ps(c0, invDet));
+    _mm_storeu_ps(out + 4, _mm_mul_ps(c1, invDet));
+    _mm_storeu_ps(out + 8, _mm_mul_ps(c2, invDet));
+    _mm_storeu_ps(out + 12, _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(t, invDet)));
+    out[15] = 1.f;
+    return result;
+#else
+    return transpose(inverse(m));
+#endif
+}
+
+} // namespace math
+} // namespace Falcor
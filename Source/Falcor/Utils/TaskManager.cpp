@@ -30,17 +30,22 @@
 namespace Falcor
 {
 
-TaskManager::TaskManager(bool startPaused)
-{
-    if (startPaused)
-        mThreadPool.pause();
-}
+TaskManager::TaskManager(bool startPaused) : mPaused(startPaused) {}
 
 void TaskManager::addTask(CpuTask&& task)
 {
     std::lock_guard<std::mutex> l(mTaskMutex);
     ++mCurrentlyScheduled;
-    mThreadPool.push_task(
+    if (mPaused)
+        mPausedCpuTasks.push_back(std::move(task));
+    else
+        dispatchCpuTask(std::move(task));
+}
+
+void TaskManager::dispatchCpuTask(CpuTask&& task)
+{
+    // Called with mTaskMutex held.
+    mCpuTasks.push_back(Threading::dispatchTask(
         [task = std::move(task), this]() mutable
         {
             ++mCurrentlyRunning;
@@ -49,9 +54,12 @@ void TaskManager::addTask(CpuTask&& task)
             size_t running = --mCurrentlyRunning;
             // If nothing is running, lets wake up and try to exit.
             if (running == 0)
+            {
+                std::lock_guard<std::mutex> l(mTaskMutex);
                 mGpuTaskCond.notify_all();
+            }
         }
-    );
+    ));
 }
 
 void TaskManager::addTask(GpuTask&& task)
@@ -64,7 +72,14 @@ void TaskManager::addTask(GpuTask&& task)
 
 void TaskManager::finish(RenderContext* renderContext)
 {
-    mThreadPool.unpause();
+    {
+        std::lock_guard<std::mutex> l(mTaskMutex);
+        mPaused = false;
+        for (auto& task : mPausedCpuTasks)
+            dispatchCpuTask(std::move(task));
+        mPausedCpuTasks.clear();
+    }
+
     while (true)
     {
         while (true)
@@ -97,6 +112,15 @@ void TaskManager::finish(RenderContext* renderContext)
         if (mCurrentlyRunning == 0 && mCurrentlyScheduled == 0)
             break;
     }
+
+    // Wait for the CPU tasks to fully return. They catch all exceptions, which are reported by rethrowException().
+    std::vector<Threading::Task> cpuTasks;
+    {
+        std::lock_guard<std::mutex> l(mTaskMutex);
+        cpuTasks.swap(mCpuTasks);
+    }
+    for (auto& task : cpuTasks)
+        task.finish();
     rethrowException();
 }
 
@@ -28,8 +28,7 @@
 #pragma once
 
 #include "Core/Macros.h"
-
-#include <BS_thread_pool.hpp>
+#include "Utils/Threading.h"
 
 #include <functional>
 #include <mutex>
@@ -67,9 +66,13 @@ private:
     void rethrowException();
     /// CPU task execution wrapped so it stores exception if the task throws
     void executeCpuTask(CpuTask&& task);
+    /// Dispatch a CPU task to the global task scheduler
+    void dispatchCpuTask(CpuTask&& task);
 
 private:
-    BS::thread_pool mThreadPool;
+    bool mPaused = false;
+    std::vector<CpuTask> mPausedCpuTasks; ///< CPU tasks added while paused, dispatched in finish().
+    std::vector<Threading::Task> mCpuTasks;
     std::atomic_size_t mCurrentlyRunning{0};
     std::atomic_size_t mCurrentlyScheduled{0};
 
@@ -27,78 +27,449 @@
  **************************************************************************/
 #include "Threading.h"
 #include "Core/Error.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Logger.h"
+
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <vector>
 
 namespace Falcor
 {
+struct Threading::Task::State
+{
+    std::function<void()> func;
+    std::atomic<uint32_t> pendingDependencies{1}; ///< Starts at one to guard against scheduling while dependencies are registered.
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool done = false;                                 ///< Protected by mutex.
+    std::vector<std::shared_ptr<State>> dependents;    ///< Protected by mutex.
+    std::exception_ptr exception;                      ///< Written before done is set.
+};
+
 namespace
 {
-struct ThreadingData
+using TaskState = Threading::Task::State;
+
+class Scheduler
 {
-    bool initialized = false;
-    std::vector<std::thread> threads;
-    uint32_t current;
-} gData; // TODO: REMOVEGLOBAL
-} // namespace
+public:
+    Scheduler(uint32_t workerCount)
+    {
+        mWorkers.resize(workerCount);
+        for (auto& pWorker : mWorkers)
+            pWorker = std::make_unique<Worker>();
+        mThreads.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; ++i)
+            mThreads.emplace_back(&Scheduler::runWorker, this, i);
+    }
+
+    ~Scheduler()
+    {
+        waitIdle();
+        {
+            std::lock_guard<std::mutex> lock(mWakeMutex);
+            mStop = true;
+        }
+        mWakeCond.notify_all();
+        for (auto& t : mThreads)
+            t.join();
+    }
+
+    uint32_t getWorkerCount() const { return (uint32_t)mWorkers.size(); }
+
+    /// Returns the index of the calling worker thread, or -1 if not called from a worker of this scheduler.
+    int getCurrentWorker() const { return sCurrentScheduler == this ? sCurrentWorker : -1; }
+
+    void dispatch(const std::shared_ptr<TaskState>& pState, fstd::span<TaskState* const> dependencies)
+    {
+        ++mActiveTaskCount;
+
+        for (TaskState* pDependency : dependencies)
+        {
+            auto& dep = *pDependency;
+            std::lock_guard<std::mutex> lock(dep.mutex);
+            if (!dep.done)
+            {
+                dep.dependents.push_back(pState);
+                ++pState->pendingDependencies;
+            }
+        }
+
+        if (--pState->pendingDependencies == 0)
+            schedule(pState);
+    }
+
+    /// Run a single queued task on the calling thread. Returns false if no task was available.
+    bool runOne(int workerIndex)
+    {
+        std::shared_ptr<TaskState> pState = pop(workerIndex);
+        if (!pState)
+            return false;
+        execute(pState);
+        return true;
+    }
+
+    void waitIdle()
+    {
+        std::unique_lock<std::mutex> lock(mIdleMutex);
+        mIdleCond.wait(lock, [this] { return mActiveTaskCount == 0; });
+    }
+
+    void wait(TaskState& state)
+    {
+        int workerIndex = getCurrentWorker();
+        if (workerIndex < 0)
+        {
+            std::unique_lock<std::mutex> lock(state.mutex);
+            state.cond.wait(lock, [&state] { return state.done; });
+            return;
+        }
+
+        // Execute other tasks while waiting to avoid blocking the worker.
+        while (true)
+        {
+            {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                if (state.done)
+                    return;
+            }
+            if (!runOne(workerIndex))
+                std::this_thread::yield();
+        }
+    }
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<TaskState>> tasks;
+    };
+
+    void schedule(const std::shared_ptr<TaskState>& pState)
+    {
+        int workerIndex = getCurrentWorker();
+        if (workerIndex >= 0)
+        {
+            auto& worker = *mWorkers[workerIndex];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.tasks.push_back(pState);
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(mGlobalMutex);
+            mGlobalTasks.push_back(pState);
+        }
+
+        // Update the queued count under the wake mutex so that sleeping workers do not miss the notification.
+        {
+            std::lock_guard<std::mutex> lock(mWakeMutex);
+            ++mQueuedTaskCount;
+        }
+        mWakeCond.notify_one();
+    }
+
+    std::shared_ptr<TaskState> pop(int workerIndex)
+    {
+        std::shared_ptr<TaskState> pState;
+
+        // Own queue first (most recently pushed, cache friendly), then the shared queue, then steal the oldest task from another worker.
+        if (workerIndex >= 0)
+        {
+            auto& worker = *mWorkers[workerIndex];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (!worker.tasks.empty())
+            {
+                pState = std::move(worker.tasks.back());
+                worker.tasks.pop_back();
+            }
+        }
+        if (!pState)
+        {
+            std::lock_guard<std::mutex> lock(mGlobalMutex);
+            if (!mGlobalTasks.empty())
+            {
+                pState = std::move(mGlobalTasks.front());
+                mGlobalTasks.pop_front();
+            }
+        }
+        if (!pState)
+        {
+            const size_t workerCount = mWorkers.size();
+            const size_t start = workerIndex >= 0 ? workerIndex + 1 : 0;
+            for (size_t i = 0; i < workerCount && !pState; ++i)
+            {
+                auto& victim = *mWorkers[(start + i) % workerCount];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (!victim.tasks.empty())
+                {
+                    pState = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                }
+            }
+        }
+
+        if (pState)
+        {
+            std::lock_guard<std::mutex> lock(mWakeMutex);
+            --mQueuedTaskCount;
+        }
+        return pState;
+    }
+
+    void execute(const std::shared_ptr<TaskState>& pState)
+    {
+        try
+        {
+            pState->func();
+        }
+        catch (...)
+        {
+            pState->exception = std::current_exception();
+        }
+        pState->func = nullptr;
+
+        std::vector<std::shared_ptr<TaskState>> dependents;
+        {
+            std::lock_guard<std::mutex> lock(pState->mutex);
+            pState->done = true;
+            dependents.swap(pState->dependents);
+        }
+        pState->cond.notify_all();
+
+        for (const auto& pDependent : dependents)
+        {
+            if (--pDependent->pendingDependencies == 0)
+                schedule(pDependent);
+        }
+
+        if (--mActiveTaskCount == 0)
+        {
+            std::lock_guard<std::mutex> lock(mIdleMutex);
+            mIdleCond.notify_all();
+        }
+    }
 
-static std::mutex sThreadingInitMutex;
-static uint32_t sThreadingInitCount = 0;
+    void runWorker(uint32_t workerIndex)
+    {
+        sCurrentScheduler = this;
+        sCurrentWorker = (int)workerIndex;
+
+        while (true)
+        {
+            if (runOne((int)workerIndex))
+                continue;
+
+            std::unique_lock<std::mutex> lock(mWakeMutex);
+            mWakeCond.wait(lock, [this] { return mStop || mQueuedTaskCount > 0; });
+            if (mStop && mQueuedTaskCount == 0)
+                break;
+        }
+
+        sCurrentScheduler = nullptr;
+        sCurrentWorker = -1;
+    }
+
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    std::vector<std::thread> mThreads;
+
+    std::mutex mGlobalMutex;
+    std::deque<std::shared_ptr<TaskState>> mGlobalTasks; ///< Tasks dispatched from non-worker threads.
+
+    std::mutex mWakeMutex;
+    std::condition_variable mWakeCond;
+    size_t mQueuedTaskCount = 0; ///< Protected by mWakeMutex.
+    bool mStop = false;          ///< Protected by mWakeMutex.
+
+    std::atomic<size_t> mActiveTaskCount{0}; ///< Dispatched but not yet finished tasks.
+    std::mutex mIdleMutex;
+    std::condition_variable mIdleCond;
+
+    static thread_local Scheduler* sCurrentScheduler;
+    static thread_local int sCurrentWorker;
+};
+
+thread_local Scheduler* Scheduler::sCurrentScheduler = nullptr;
+thread_local int Scheduler::sCurrentWorker = -1;
+
+std::mutex sThreadingInitMutex;
+uint32_t sThreadingInitCount = 0;
+std::unique_ptr<Scheduler> spScheduler; // TODO: REMOVEGLOBAL
+
+uint32_t resolveThreadCount(uint32_t threadCount)
+{
+    if (threadCount == Threading::kDefaultThreadCount)
+    {
+        if (auto value = getEnvironmentVariable("FALCOR_THREAD_COUNT"))
+        {
+            try
+            {
+                threadCount = (uint32_t)std::stoul(*value);
+            }
+            catch (const std::exception&)
+            {
+                logWarning("Ignoring invalid FALCOR_THREAD_COUNT value '{}'.", *value);
+            }
+        }
+    }
+    if (threadCount == 0)
+        threadCount = Threading::getLogicalThreadCount();
+    return std::max(threadCount, 1u);
+}
+
+/// Get the scheduler, starting it with the default worker count if needed. This allows using the scheduler in tools that never call Threading::start().
+Scheduler& getScheduler()
+{
+    std::lock_guard<std::mutex> lock(sThreadingInitMutex);
+    if (!spScheduler)
+        spScheduler = std::make_unique<Scheduler>(resolveThreadCount(Threading::kDefaultThreadCount));
+    return *spScheduler;
+}
+} // namespace
 
 void Threading::start(uint32_t threadCount)
 {
     std::lock_guard<std::mutex> lock(sThreadingInitMutex);
-    if (sThreadingInitCount++ == 0)
+    if (sThreadingInitCount++ > 0)
+        return;
+
+    const uint32_t workerCount = resolveThreadCount(threadCount);
+    if (!spScheduler)
+        spScheduler = std::make_unique<Scheduler>(workerCount);
+    else if (spScheduler->getWorkerCount() != workerCount)
+        logWarning(
+            "Threading::start({}) called after the task scheduler was already created on first use with {} workers, keeping {} workers.",
+            threadCount, spScheduler->getWorkerCount(), spScheduler->getWorkerCount()
+        );
+}
+
+void Threading::shutdown()
+{
+    std::unique_ptr<Scheduler> pScheduler;
     {
-        gData.threads.resize(threadCount);
-        gData.initialized = true;
+        std::lock_guard<std::mutex> lock(sThreadingInitMutex);
+        if (sThreadingInitCount == 0)
+            FALCOR_THROW("Threading::shutdown() called more times than Threading::start().");
+        if (--sThreadingInitCount == 0)
+            pScheduler = std::move(spScheduler);
     }
+    // Destroy outside the lock, pending tasks may still dispatch new tasks.
+    pScheduler.reset();
 }
 
-void Threading::shutdown()
+uint32_t Threading::getWorkerCount()
 {
-    std::lock_guard<std::mutex> lock(sThreadingInitMutex);
-    uint32_t count = sThreadingInitCount--;
-    if (count == 1)
+    return getScheduler().getWorkerCount();
+}
+
+Threading::Task Threading::dispatchTask(std::function<void(void)> func, fstd::span<const Task> dependencies)
+{
+    auto pState = std::make_shared<Task::State>();
+    pState->func = std::move(func);
+
+    std::vector<Task::State*> dependencyStates;
+    dependencyStates.reserve(dependencies.size());
+    for (const auto& dependency : dependencies)
     {
-        for (auto& t : gData.threads)
-            if (t.joinable())
-                t.join();
-        gData.initialized = false;
+        if (dependency.mpState)
+            dependencyStates.push_back(dependency.mpState.get());
     }
-    else if (count == 0)
-        FALCOR_THROW("Threading::stop() called more times than Threading::start().");
+
+    getScheduler().dispatch(pState, dependencyStates);
+    return Task(pState);
 }
 
-Threading::Task Threading::dispatchTask(const std::function<void(void)>& func)
+void Threading::parallelFor(size_t begin, size_t end, const std::function<void(size_t, size_t)>& func, size_t grainSize)
 {
-    FALCOR_ASSERT(gData.initialized);
+    if (end <= begin)
+        return;
 
-    std::thread& t = gData.threads[gData.current];
-    if (t.joinable())
-        t.join();
-    t = std::thread(func);
-    gData.current = (gData.current + 1) % gData.threads.size();
+    Scheduler& scheduler = getScheduler();
+    const size_t count = end - begin;
+    const size_t workerCount = scheduler.getWorkerCount();
+    if (grainSize == 0)
+        grainSize = std::max<size_t>(1, count / (workerCount * 4));
+    const size_t chunkCount = (count + grainSize - 1) / grainSize;
 
-    return Task();
+    if (chunkCount == 1 || workerCount == 1)
+    {
+        func(begin, end);
+        return;
+    }
+
+    // Chunks are claimed dynamically by the calling thread and by helper tasks, which balances uneven work.
+    std::atomic<size_t> nextChunk{0};
+    std::atomic<bool> failed{false};
+    std::mutex exceptionMutex;
+    std::exception_ptr exception;
+
+    auto runChunks = [&]()
+    {
+        while (!failed)
+        {
+            size_t chunk = nextChunk++;
+            if (chunk >= chunkCount)
+                break;
+            size_t chunkBegin = begin + chunk * grainSize;
+            size_t chunkEnd = std::min(end, chunkBegin + grainSize);
+            try
+            {
+                func(chunkBegin, chunkEnd);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(exceptionMutex);
+                if (!exception)
+                    exception = std::current_exception();
+                failed = true;
+            }
+        }
+    };
+
+    const size_t helperCount = std::min(chunkCount, workerCount) - 1;
+    std::vector<Task> helpers;
+    helpers.reserve(helperCount);
+    for (size_t i = 0; i < helperCount; ++i)
+        helpers.push_back(dispatchTask(runChunks));
+
+    runChunks();
+    for (auto& helper : helpers)
+        helper.finish();
+
+    if (exception)
+        std::rethrow_exception(exception);
 }
 
 void Threading::finish()
 {
-    for (auto& t : gData.threads)
+    Scheduler* pScheduler = nullptr;
     {
-        if (t.joinable())
-            t.join();
+        std::lock_guard<std::mutex> lock(sThreadingInitMutex);
+        pScheduler = spScheduler.get();
+    }
+    if (pScheduler)
+    {
+        FALCOR_CHECK(pScheduler->getCurrentWorker() < 0, "Threading::finish() must not be called from a task.");
+        pScheduler->waitIdle();
     }
 }
 
-Threading::Task::Task() {}
-
-bool Threading::Task::isRunning()
+bool Threading::Task::isRunning() const
 {
-    FALCOR_UNIMPLEMENTED();
+    if (!mpState)
+        return false;
+    std::lock_guard<std::mutex> lock(mpState->mutex);
+    return !mpState->done;
 }
 
 void Threading::Task::finish()
 {
-    FALCOR_UNIMPLEMENTED();
+    if (!mpState)
+        return;
+    getScheduler().wait(*mpState);
+    if (mpState->exception)
+        std::rethrow_exception(mpState->exception);
 }
 } // namespace Falcor
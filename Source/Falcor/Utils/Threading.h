@@ -27,51 +27,72 @@
  **************************************************************************/
 #pragma once
 #include "Core/Macros.h"
+#include <fstd/span.h>
 #include <condition_variable>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <cstdint>
 
 namespace Falcor
 {
+/**
+ * Global work-stealing task scheduler.
+ *
+ * A fixed set of persistent worker threads executes tasks. Each worker has its own task queue and steals from other
+ * workers when it runs out of work. Tasks dispatched from outside the workers go to a shared queue. Waiting on a task
+ * from a worker thread executes other tasks in the meantime, so nested parallelism does not deadlock.
+ */
 class FALCOR_API Threading
 {
 public:
-    const static uint32_t kDefaultThreadCount = 16;
+    /// Default worker count. Zero uses the FALCOR_THREAD_COUNT environment variable if set, or one worker per logical thread.
+    const static uint32_t kDefaultThreadCount = 0;
 
     /**
-     * Handle to a dispatched task
-     *
-     * TODO: Implementation
+     * Handle to a dispatched task.
+     * Handles are cheap to copy. A default constructed handle does not refer to a task and is considered finished.
      */
-    class Task
+    class FALCOR_API Task
     {
     public:
-        ///  Check if task is still executing
-        bool isRunning();
+        Task() = default;
+
+        /// Check if task is still pending or executing.
+        bool isRunning() const;
 
-        /// Wait for task to finish executing
+        /// Wait for task to finish executing. Rethrows any exception thrown by the task.
         void finish();
 
+        /// Check if the handle refers to a task.
+        bool isValid() const { return mpState != nullptr; }
+
+        struct State;
+
     private:
-        Task();
+        Task(std::shared_ptr<State> pState) : mpState(std::move(pState)) {}
+
+        std::shared_ptr<State> mpState;
         friend class Threading;
     };
 
     /**
      * Initializes the global thread pool
+     * Calls are reference counted, only the first one creates the pool. If the pool was already created on first use,
+     * it keeps its worker count and a warning is logged when a different count is requested.
      * @param[in] threadCount Number of threads in the pool
      */
     static void start(uint32_t threadCount = kDefaultThreadCount);
 
     /**
-     * Waits for all currently executing threads to finish
+     * Waits for all dispatched tasks to finish
      */
     static void finish();
 
     /**
-     * Waits for all currently executing threads to finish and shuts down the thread pool
+     * Waits for all dispatched tasks to finish and shuts down the thread pool
+     * The pool is destroyed by the call matching the first start(). Throws if called more often than start().
      */
     static void shutdown();
 
@@ -80,11 +101,47 @@ public:
      */
     static uint32_t getLogicalThreadCount() { return std::thread::hardware_concurrency(); }
 
+    /**
+     * Returns the number of worker threads. Starts the thread pool with the default worker count if not running.
+     */
+    static uint32_t getWorkerCount();
+
     /**
      * Starts a task on an available thread.
+     * @param[in] func Function to execute.
+     * @param[in] dependencies Tasks that must finish before this task starts. Dependencies only order execution,
+     *            exceptions thrown by a dependency are reported by that dependency's finish().
      * @return Handle to the task
      */
-    static Task dispatchTask(const std::function<void(void)>& func);
+    static Task dispatchTask(std::function<void(void)> func, fstd::span<const Task> dependencies = {});
+
+    /**
+     * Execute func(begin, end) over sub-ranges of [begin, end) in parallel and wait for completion.
+     * The calling thread participates in the work. The first exception thrown by func is rethrown.
+     * @param[in] begin Start of the range.
+     * @param[in] end End of the range (exclusive).
+     * @param[in] func Function called for each sub-range.
+     * @param[in] grainSize Minimum sub-range size, or zero to choose automatically.
+     */
+    static void parallelFor(size_t begin, size_t end, const std::function<void(size_t, size_t)>& func, size_t grainSize = 0);
+
+    /**
+     * Execute func(i) for all i in [begin, end) in parallel and wait for completion.
+     */
+    template<typename F>
+    static void parallelForEach(size_t begin, size_t end, F&& func, size_t grainSize = 0)
+    {
+        parallelFor(
+            begin,
+            end,
+            [&func](size_t rangeBegin, size_t rangeEnd)
+            {
+                for (size_t i = rangeBegin; i < rangeEnd; ++i)
+                    func(i);
+            },
+            grainSize
+        );
+    }
 };
 
 /**
@@ -28,10 +28,19 @@
 #include "Profiler.h"
 #include "Core/API/Device.h"
 #include "Core/API/GpuTimer.h"
+#include "Core/Error.h"
+#include "Core/Platform/OS.h"
 #include "Utils/Logger.h"
 #include "Utils/Scripting/ScriptBindings.h"
 
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
 #include <fstream>
+#include <mutex>
 
 namespace Falcor
 {
@@ -46,6 +55,144 @@ const float kSigma = 0.98f;
 // for computing statistics (min, max, mean, stddev) over the recent history.
 const size_t kMaxHistorySize = 512;
 
+// Number of records in the ring buffer of a CPU lane. Records are dropped when the ring buffer is full.
+const uint32_t kCpuLaneRecordCount = 4096;
+
+// Maximum number of distinct event nestings per CPU lane. Further events are ignored.
+const uint32_t kCpuLaneMaxNodes = 1024;
+
+// Maximum nesting depth of events on a CPU lane. Deeper events are ignored.
+const uint32_t kCpuLaneMaxDepth = 64;
+
+const uint32_t kInvalidNode = uint32_t(-1);
+
+/**
+ * Interned event names. Names are stored in a deque so references stay valid when new names are added.
+ */
+struct NameTable
+{
+    std::mutex mutex;
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, Profiler::NameId> ids;
+};
+
+NameTable& getNameTable()
+{
+    static NameTable table;
+    return table;
+}
+
+/**
+ * Per-thread lane of CPU event records.
+ * Each distinct nesting of events on the lane is a node, node 0 is the root of the lane.
+ * The owning thread is the only producer and Profiler::endFrame() the only consumer of the record ring buffer.
+ * Nodes are written by the owning thread before publishing the first record referring to them and are immutable afterwards.
+ */
+struct CpuLane
+{
+    struct Node
+    {
+        Profiler::NameId nameId;
+        uint32_t parent;
+        uint32_t firstChild; ///< Only accessed by the owning thread.
+        uint32_t nextSibling; ///< Only accessed by the owning thread.
+    };
+
+    struct Record
+    {
+        uint32_t node;
+        CpuTimer::TimePoint startTime;
+        CpuTimer::TimePoint endTime;
+    };
+
+    struct OpenEvent
+    {
+        uint32_t node;
+        CpuTimer::TimePoint startTime;
+    };
+
+    CpuLane(uint32_t index) : name(fmt::format("CPU thread {}", index))
+    {
+        nodes[0] = {Profiler::kInvalidNameId, kInvalidNode, kInvalidNode, kInvalidNode};
+    }
+
+    uint32_t getChild(uint32_t parent, Profiler::NameId nameId)
+    {
+        if (parent == kInvalidNode)
+            return kInvalidNode;
+        uint32_t node = nodes[parent].firstChild;
+        for (; node != kInvalidNode; node = nodes[node].nextSibling)
+        {
+            if (nodes[node].nameId == nameId)
+                return node;
+        }
+        if (nodeCount == kCpuLaneMaxNodes)
+            return kInvalidNode;
+        node = nodeCount++;
+        nodes[node] = {nameId, parent, kInvalidNode, nodes[parent].firstChild};
+        nodes[parent].firstChild = node;
+        return node;
+    }
+
+    void push(const Record& record)
+    {
+        uint64_t head = writeIndex.load(std::memory_order_relaxed);
+        if (head - readIndex.load(std::memory_order_acquire) >= kCpuLaneRecordCount)
+        {
+            droppedRecords.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        records[head % kCpuLaneRecordCount] = record;
+        writeIndex.store(head + 1, std::memory_order_release);
+    }
+
+    std::string name;
+
+    // Owning thread state.
+    std::array<Node, kCpuLaneMaxNodes> nodes;
+    uint32_t nodeCount = 1;
+    std::array<OpenEvent, kCpuLaneMaxDepth> stack;
+    uint32_t depth = 0;
+
+    // Single producer single consumer ring buffer.
+    std::array<Record, kCpuLaneRecordCount> records;
+    std::atomic<uint64_t> writeIndex{0};
+    std::atomic<uint64_t> readIndex{0};
+    std::atomic<uint64_t> droppedRecords{0};
+};
+
+/**
+ * Registry of CPU lanes. Lanes are created on first use by each thread and are never destroyed.
+ * The lanes are process-global because CPU events are recorded without a profiler, they belong to the first
+ * enabled profiler (the owner) until it is disabled or destroyed. Other profilers don't collect them.
+ */
+struct CpuLaneRegistry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<CpuLane>> lanes;
+    const Profiler* pOwner = nullptr;
+    std::atomic<bool> enabled{false};
+};
+
+CpuLaneRegistry& getCpuLaneRegistry()
+{
+    static CpuLaneRegistry registry;
+    return registry;
+}
+
+CpuLane& getCpuLane()
+{
+    thread_local CpuLane* pLane = nullptr;
+    if (!pLane)
+    {
+        auto& registry = getCpuLaneRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.lanes.push_back(std::make_unique<CpuLane>((uint32_t)registry.lanes.size()));
+        pLane = registry.lanes.back().get();
+    }
+    return *pLane;
+}
+
 pybind11::dict toPython(const Profiler::Stats& stats)
 {
     pybind11::dict d;
@@ -131,7 +278,8 @@ Profiler::Stats Profiler::Stats::compute(const float* data, size_t len)
 
 // Profiler::Event
 
-Profiler::Event::Event(const std::string& name) : mName(name), mCpuTimeHistory(kMaxHistorySize, 0.f), mGpuTimeHistory(kMaxHistorySize, 0.f)
+Profiler::Event::Event(const std::string& name, NameId nameId, Event* pParent)
+    : mName(name), mNameId(nameId), mpParent(pParent), mCpuTimeHistory(kMaxHistorySize, 0.f), mGpuTimeHistory(kMaxHistorySize, 0.f)
 {}
 
 Profiler::Stats Profiler::Event::computeCpuTimeStats() const
@@ -192,6 +340,14 @@ void Profiler::Event::end(uint32_t frameIndex)
     frameData.valid = true;
 }
 
+void Profiler::Event::addCpuTime(uint32_t frameIndex, float time)
+{
+    // CPU lane timings are complete when they are collected, so add them to the frame data read back in this frame's endFrame().
+    auto& frameData = mFrameData[(frameIndex + 1) % 2];
+    frameData.cpuTotalTime += time;
+    frameData.valid = true;
+}
+
 void Profiler::Event::endFrame(uint32_t frameIndex)
 {
     // Resolve GPU timers for the current frame measurements.
@@ -212,6 +368,8 @@ void Profiler::Event::endFrame(uint32_t frameIndex)
         return;
 
     mCpuTime = frameData.cpuTotalTime;
+    mLastCpuStartTime = frameData.cpuStartTime;
+    mLastHasGpuTime = frameData.currentTimer > 0;
     mGpuTime = 0.f;
     for (size_t i = 0; i < frameData.currentTimer; ++i)
         mGpuTime += (float)frameData.pTimers[i]->getElapsedTime();
@@ -250,8 +408,70 @@ void Profiler::Capture::writeToFile(const std::filesystem::path& path) const
     ofs.write(json.data(), json.size());
 }
 
-Profiler::Capture::Capture(size_t reservedEvents, size_t reservedFrames) : mReservedFrames(reservedFrames)
+std::string Profiler::Capture::toTraceJsonString() const
+{
+    using json = nlohmann::json;
+
+    // See https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU for the format.
+    json events = json::array();
+    events.push_back({{"name", "process_name"}, {"ph", "M"}, {"pid", 0}, {"args", {{"name", "Falcor"}}}});
+
+    auto addTrack = [&](uint32_t track, const std::string& name)
+    {
+        events.push_back({{"name", "thread_name"}, {"ph", "M"}, {"pid", 0}, {"tid", track}, {"args", {{"name", name}}}});
+        events.push_back({{"name", "thread_sort_index"}, {"ph", "M"}, {"pid", 0}, {"tid", track}, {"args", {{"sort_index", track}}}});
+    };
+    addTrack(kMainTrack, "Main thread");
+    addTrack(kGpuTrack, "GPU");
+    for (uint32_t i = 0; i < mCpuLaneCount; ++i)
+        addTrack(kCpuLaneTrackOffset + i, fmt::format("CPU thread {}", i));
+
+    for (const auto& record : mTraceRecords)
+    {
+        const std::string& path = mTraceNames[record.nameIndex];
+        events.push_back(
+            {{"name", path.substr(path.find_last_of('/') + 1)},
+             {"cat", record.track == kGpuTrack ? "gpu" : "cpu"},
+             {"ph", "X"},
+             {"pid", 0},
+             {"tid", record.track},
+             {"ts", record.startTime},
+             {"dur", record.duration},
+             {"args", {{"path", path}}}}
+        );
+    }
+
+    for (size_t i = 0; i < mFrameMarkers.size(); ++i)
+    {
+        events.push_back(
+            {{"name", fmt::format("Frame {}", i)}, {"ph", "i"}, {"s", "g"}, {"pid", 0}, {"tid", kMainTrack}, {"ts", mFrameMarkers[i]}}
+        );
+    }
+
+    for (const auto& record : mCounterRecords)
+    {
+        events.push_back(
+            {{"name", mCounterNames[record.nameIndex]}, {"ph", "C"}, {"pid", 0}, {"ts", record.time}, {"args", {{"value", record.value}}}}
+        );
+    }
+
+    json trace = {{"traceEvents", std::move(events)}, {"displayTimeUnit", "ms"}};
+    return trace.dump();
+}
+
+void Profiler::Capture::writeTraceToFile(const std::filesystem::path& path) const
 {
+    auto json = toTraceJsonString();
+    std::ofstream ofs(path);
+    ofs.write(json.data(), json.size());
+}
+
+Profiler::Capture::Capture(size_t reservedEvents, size_t reservedFrames)
+    : mReservedFrames(reservedFrames), mStartTime(CpuTimer::getCurrentTimePoint())
+{
+    mTraceRecords.reserve(std::min<size_t>(reservedEvents * reservedFrames * 2, 1 << 20));
+    mFrameMarkers.reserve(reservedFrames);
+
     // Speculativly allocate event record storage.
     mLanes.resize(reservedEvents * 2);
     for (auto& lane : mLanes)
@@ -266,19 +486,19 @@ void Profiler::Capture::captureEvents(const std::vector<Event*>& events)
     // Initialize on first capture.
     if (mEvents.empty())
     {
-        mEvents = events;
+        for (Event* pEvent : events)
+            addLanes(pEvent);
         mLanes.resize(mEvents.size() * 2);
-        for (size_t i = 0; i < mEvents.size(); ++i)
-        {
-            auto& pEvent = mEvents[i];
-            mLanes[i * 2].name = pEvent->getName() + "/cpu_time";
-            mLanes[i * 2].records.reserve(mReservedFrames);
-            mLanes[i * 2 + 1].name = pEvent->getName() + "/gpu_time";
-            mLanes[i * 2 + 1].records.reserve(mReservedFrames);
-        }
         return; // Exit as no data is available on first capture.
     }
 
+    // Add lanes for events that were not seen before (e.g. events recorded on CPU lanes).
+    for (Event* pEvent : events)
+    {
+        if (mEventIndices.find(pEvent) == mEventIndices.end())
+            addLanes(pEvent);
+    }
+
     // Record CPU/GPU timing on subsequent captures.
     for (size_t i = 0; i < mEvents.size(); ++i)
     {
@@ -290,6 +510,94 @@ void Profiler::Capture::captureEvents(const std::vector<Event*>& events)
     ++mFrameCount;
 }
 
+void Profiler::Capture::addLanes(Event* pEvent)
+{
+    // Reuse the speculatively allocated lanes if available.
+    size_t laneIndex = mEvents.size() * 2;
+    if (mLanes.size() < laneIndex + 2)
+        mLanes.resize(laneIndex + 2);
+
+    mEventIndices[pEvent] = mEvents.size();
+    mEvents.push_back(pEvent);
+    mLanes[laneIndex].name = pEvent->getName() + "/cpu_time";
+    mLanes[laneIndex + 1].name = pEvent->getName() + "/gpu_time";
+    for (size_t i = laneIndex; i < laneIndex + 2; ++i)
+    {
+        mLanes[i].records.reserve(mReservedFrames);
+        // Events seen for the first time did not run in earlier frames.
+        mLanes[i].records.resize(mFrameCount, 0.f);
+    }
+}
+
+double Profiler::Capture::getTraceTime(CpuTimer::TimePoint time) const
+{
+    return std::chrono::duration<double, std::micro>(time - mStartTime).count();
+}
+
+void Profiler::Capture::recordEvent(const Event* pEvent, uint32_t track, CpuTimer::TimePoint startTime, CpuTimer::TimePoint endTime)
+{
+    // Clip events that started before the capture.
+    double start = std::max(getTraceTime(startTime), 0.0);
+    double end = getTraceTime(endTime);
+    if (end < start)
+        return;
+
+    auto [it, inserted] = mTraceNameIndices.try_emplace(pEvent, (uint32_t)mTraceNames.size());
+    if (inserted)
+        mTraceNames.push_back(pEvent->getName());
+    if (track >= kCpuLaneTrackOffset)
+        mCpuLaneCount = std::max(mCpuLaneCount, track - kCpuLaneTrackOffset + 1);
+    mTraceRecords.push_back({it->second, track, start, end - start});
+}
+
+void Profiler::Capture::recordGpuEvents(const std::vector<Event*>& events)
+{
+    // GPU times are available one frame late, together with the CPU start time of the event in that frame.
+    // Top-level events are laid out one after the other on the GPU track, children one after the other inside their parent.
+    // The events are in hierarchical order, so parents are placed before their children.
+    std::unordered_map<const Event*, double> childStartTimes;
+    for (const Event* pEvent : events)
+    {
+        if (!pEvent->mLastHasGpuTime)
+            continue;
+
+        double duration = pEvent->getGpuTime() * 1000.0;
+        double start;
+        auto parent = pEvent->mpParent ? childStartTimes.find(pEvent->mpParent) : childStartTimes.end();
+        if (parent != childStartTimes.end())
+        {
+            start = parent->second;
+            parent->second += duration;
+        }
+        else
+        {
+            start = std::max(getTraceTime(pEvent->mLastCpuStartTime), mGpuTime);
+            mGpuTime = start + duration;
+        }
+        childStartTimes[pEvent] = start;
+
+        if (start < 0.0)
+            continue;
+        auto [it, inserted] = mTraceNameIndices.try_emplace(pEvent, (uint32_t)mTraceNames.size());
+        if (inserted)
+            mTraceNames.push_back(pEvent->getName());
+        mTraceRecords.push_back({it->second, kGpuTrack, start, duration});
+    }
+}
+
+void Profiler::Capture::recordFrameMarker(CpuTimer::TimePoint time)
+{
+    mFrameMarkers.push_back(getTraceTime(time));
+}
+
+void Profiler::Capture::recordCounter(std::string_view name, double value, CpuTimer::TimePoint time)
+{
+    auto it = std::find(mCounterNames.begin(), mCounterNames.end(), name);
+    if (it == mCounterNames.end())
+        it = mCounterNames.emplace(mCounterNames.end(), name);
+    mCounterRecords.push_back({(uint32_t)(it - mCounterNames.begin()), getTraceTime(time), value});
+}
+
 void Profiler::Capture::finalize()
 {
     FALCOR_ASSERT(!mFinalized);
@@ -310,50 +618,93 @@ Profiler::Profiler(ref<Device> pDevice) : mpDevice(pDevice)
     mpFence->breakStrongReferenceToDevice();
 }
 
-void Profiler::startEvent(RenderContext* pRenderContext, const std::string& name, Flags flags)
+Profiler::~Profiler()
+{
+    setCpuLaneOwner(false);
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+    // Events started before a change of state are never finished.
+    if (enabled != mEnabled)
+        mEventStack.clear();
+    mEnabled = enabled;
+    setCpuLaneOwner(enabled);
+}
+
+bool Profiler::isCollectingCpuEvents() const
+{
+    auto& registry = getCpuLaneRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.pOwner == this;
+}
+
+void Profiler::setCpuLaneOwner(bool owner)
+{
+    auto& registry = getCpuLaneRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (owner && !registry.pOwner)
+    {
+        registry.pOwner = this;
+        // Drop the records of a previous owner that were never collected.
+        for (auto& pLane : registry.lanes)
+            pLane->readIndex.store(pLane->writeIndex.load(std::memory_order_acquire), std::memory_order_release);
+    }
+    else if (owner && registry.pOwner != this)
+    {
+        logWarning("Profiler: CPU events are already collected by the profiler of another device and won't show up in this profiler.");
+    }
+    else if (!owner && registry.pOwner == this)
+    {
+        registry.pOwner = nullptr;
+    }
+    registry.enabled.store(registry.pOwner != nullptr, std::memory_order_relaxed);
+}
+
+void Profiler::startEvent(RenderContext* pRenderContext, std::string_view name, Flags flags)
+{
+    startEvent(pRenderContext, internName(name), flags);
+}
+
+void Profiler::startEvent(RenderContext* pRenderContext, NameId nameId, Flags flags)
 {
     if (mEnabled && is_set(flags, Flags::Internal))
     {
-        // '/' is used as a "path delimiter", so it cannot be used in the event name.
-        if (name.find('/') != std::string::npos)
+        // Invalid events are kept on the stack with their parent event so that endEvent() stays balanced.
+        Event* pParent = mEventStack.empty() ? nullptr : mEventStack.back().pEvent;
+        if (nameId != kInvalidNameId)
         {
-            logWarning("Profiler event names must not contain '/'. Ignoring this profiler event.");
-            return;
+            Event* pEvent = getChildEvent(pParent, nameId);
+            if (!mPaused)
+                pEvent->start(*this, mFrameIndex);
+            registerEvent(pEvent);
+            mEventStack.push_back({pEvent, true, mpCapture ? CpuTimer::getCurrentTimePoint() : CpuTimer::TimePoint()});
         }
-
-        mCurrentEventName = mCurrentEventName + "/" + name;
-
-        Event* pEvent = getEvent(mCurrentEventName);
-        FALCOR_ASSERT(pEvent != nullptr);
-        if (!mPaused)
-            pEvent->start(*this, mFrameIndex);
-
-        if (std::find(mCurrentFrameEvents.begin(), mCurrentFrameEvents.end(), pEvent) == mCurrentFrameEvents.end())
+        else
         {
-            mCurrentFrameEvents.push_back(pEvent);
+            mEventStack.push_back({pParent, false});
         }
     }
     if (is_set(flags, Flags::Pix))
     {
         FALCOR_ASSERT(pRenderContext);
-        pRenderContext->getLowLevelData()->beginDebugEvent(name.c_str());
+        const char* name = nameId != kInvalidNameId ? getInternedName(nameId).c_str() : "<invalid profiler event>";
+        pRenderContext->getLowLevelData()->beginDebugEvent(name);
     }
 }
 
-void Profiler::endEvent(RenderContext* pRenderContext, const std::string& name, Flags flags)
+void Profiler::endEvent(RenderContext* pRenderContext, std::string_view name, Flags flags)
 {
-    if (mEnabled && is_set(flags, Flags::Internal))
+    if (mEnabled && is_set(flags, Flags::Internal) && !mEventStack.empty())
     {
-        // '/' is used as a "path delimiter", so it cannot be used in the event name.
-        if (name.find('/') != std::string::npos)
-            return;
-
-        Event* pEvent = getEvent(mCurrentEventName);
-        FALCOR_ASSERT(pEvent != nullptr);
-        if (!mPaused)
+        auto [pEvent, started, startTime] = mEventStack.back();
+        mEventStack.pop_back();
+        if (started && !mPaused)
+        {
             pEvent->end(mFrameIndex);
-
-        mCurrentEventName.erase(mCurrentEventName.find_last_of("/"));
+            if (mpCapture)
+                mpCapture->recordEvent(pEvent, Capture::kMainTrack, startTime, CpuTimer::getCurrentTimePoint());
+        }
     }
 
     if (is_set(flags, Flags::Pix))
@@ -369,6 +720,153 @@ Profiler::Event* Profiler::getEvent(const std::string& name)
     return event ? event : createEvent(name);
 }
 
+Profiler::NameId Profiler::internName(std::string_view name)
+{
+    auto& table = getNameTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    auto it = table.ids.find(name);
+    if (it != table.ids.end())
+        return it->second;
+
+    // '/' is used as a "path delimiter", so it cannot be used in the event name.
+    // Invalid names are remembered as well so the warning is only issued once.
+    NameId nameId = (NameId)table.names.size();
+    if (name.find('/') != std::string_view::npos)
+    {
+        logWarning("Profiler event names must not contain '/'. Ignoring profiler event '{}'.", name);
+        nameId = kInvalidNameId;
+    }
+
+    const std::string& storedName = table.names.emplace_back(name);
+    table.ids.emplace(storedName, nameId);
+    return nameId;
+}
+
+const std::string& Profiler::getInternedName(NameId nameId)
+{
+    auto& table = getNameTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    FALCOR_CHECK(nameId < table.names.size(), "Invalid profiler event name id {}.", nameId);
+    return table.names[nameId];
+}
+
+bool Profiler::startCpuEvent(NameId nameId)
+{
+    if (!getCpuLaneRegistry().enabled.load(std::memory_order_relaxed) || nameId == kInvalidNameId)
+        return false;
+
+    CpuLane& lane = getCpuLane();
+    if (lane.depth < kCpuLaneMaxDepth)
+    {
+        uint32_t parent = lane.depth == 0 ? 0 : lane.stack[lane.depth - 1].node;
+        lane.stack[lane.depth] = {lane.getChild(parent, nameId), CpuTimer::getCurrentTimePoint()};
+    }
+    ++lane.depth;
+    return true;
+}
+
+void Profiler::endCpuEvent()
+{
+    CpuLane& lane = getCpuLane();
+    FALCOR_ASSERT(lane.depth > 0);
+    if (--lane.depth < kCpuLaneMaxDepth)
+    {
+        const auto& event = lane.stack[lane.depth];
+        if (event.node != kInvalidNode)
+            lane.push({event.node, event.startTime, CpuTimer::getCurrentTimePoint()});
+    }
+}
+
+Profiler::Event* Profiler::getChildEvent(Event* pParent, NameId nameId)
+{
+    auto& children = pParent ? pParent->mChildren : mRootEvents;
+    for (Event* pChild : children)
+    {
+        if (pChild->mNameId == nameId)
+            return pChild;
+    }
+
+    // Create the event, this is the only place where the event path is built.
+    // The event may already exist if it was created through getEvent().
+    std::string name = (pParent ? pParent->mName : std::string()) + "/" + getInternedName(nameId);
+    Event* pEvent = getEvent(name);
+    pEvent->mNameId = nameId;
+    pEvent->mpParent = pParent;
+    children.push_back(pEvent);
+    return pEvent;
+}
+
+void Profiler::registerEvent(Event* pEvent)
+{
+    if (pEvent->mRegisteredFrame == mFrameIndex)
+        return;
+    if (pEvent->mpParent)
+        registerEvent(pEvent->mpParent);
+    pEvent->mRegisteredFrame = mFrameIndex;
+    mCurrentFrameEvents.push_back(pEvent);
+}
+
+void Profiler::collectCpuLanes()
+{
+    auto& registry = getCpuLaneRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (registry.pOwner != this)
+        return;
+
+    if (mCpuLaneEvents.size() < registry.lanes.size())
+        mCpuLaneEvents.resize(registry.lanes.size());
+
+    for (size_t laneIndex = 0; laneIndex < registry.lanes.size(); ++laneIndex)
+    {
+        CpuLane& lane = *registry.lanes[laneIndex];
+        auto& laneEvents = mCpuLaneEvents[laneIndex];
+
+        // Get the event of a lane node, creating the events of the node and its parents on first use.
+        auto getLaneEvent = [&](uint32_t node)
+        {
+            if (laneEvents.empty())
+            {
+                laneEvents.resize(kCpuLaneMaxNodes, nullptr);
+                laneEvents[0] = getChildEvent(nullptr, internName(lane.name));
+            }
+            // Create the missing events top-down, starting below the deepest ancestor that has an event.
+            while (!laneEvents[node])
+            {
+                uint32_t child = node;
+                while (!laneEvents[lane.nodes[child].parent])
+                    child = lane.nodes[child].parent;
+                laneEvents[child] = getChildEvent(laneEvents[lane.nodes[child].parent], lane.nodes[child].nameId);
+            }
+            return laneEvents[node];
+        };
+
+        uint64_t head = lane.writeIndex.load(std::memory_order_acquire);
+        uint64_t tail = lane.readIndex.load(std::memory_order_relaxed);
+        for (; tail != head; ++tail)
+        {
+            if (mPaused)
+                continue;
+
+            const CpuLane::Record& record = lane.records[tail % kCpuLaneRecordCount];
+            float time = (float)CpuTimer::calcDuration(record.startTime, record.endTime);
+            Event* pEvent = getLaneEvent(record.node);
+            pEvent->addCpuTime(mFrameIndex, time);
+            registerEvent(pEvent);
+            if (mpCapture)
+                mpCapture->recordEvent(pEvent, Capture::kCpuLaneTrackOffset + (uint32_t)laneIndex, record.startTime, record.endTime);
+
+            // The lane root accumulates the time of the top-level events of the lane.
+            if (lane.nodes[record.node].parent == 0)
+                laneEvents[0]->addCpuTime(mFrameIndex, time);
+        }
+        lane.readIndex.store(head, std::memory_order_release);
+
+        if (uint64_t dropped = lane.droppedRecords.exchange(0, std::memory_order_relaxed))
+            logWarning("Profiler dropped {} events on '{}'. Call endFrame() more often or record fewer events.", dropped, lane.name);
+    }
+}
+
 void Profiler::endFrame(RenderContext* pRenderContext)
 {
     if (mPaused)
@@ -380,11 +878,21 @@ void Profiler::endFrame(RenderContext* pRenderContext)
     if (mFenceValue != uint64_t(-1))
         mpFence->wait();
 
+    collectCpuLanes();
+
     for (Event* pEvent : mCurrentFrameEvents)
     {
         pEvent->endFrame(mFrameIndex);
     }
 
+    if (mpCapture)
+    {
+        auto time = CpuTimer::getCurrentTimePoint();
+        mpCapture->recordGpuEvents(mCurrentFrameEvents);
+        mpCapture->recordFrameMarker(time);
+        mpCapture->recordCounter("Process memory (MB)", (double)getCurrentRSS() / (1024.0 * 1024.0), time);
+    }
+
     // Flush and insert signal for synchronization of GPU timings.
     pRenderContext->submit(false);
     mFenceValue = pRenderContext->signal(mpFence.get());
@@ -392,7 +900,9 @@ void Profiler::endFrame(RenderContext* pRenderContext)
     if (mpCapture)
         mpCapture->captureEvents(mCurrentFrameEvents);
 
-    mLastFrameEvents = std::move(mCurrentFrameEvents);
+    // Swap instead of move to keep the capacity of both vectors.
+    std::swap(mLastFrameEvents, mCurrentFrameEvents);
+    mCurrentFrameEvents.clear();
     ++mFrameIndex;
 }
 
@@ -416,6 +926,12 @@ bool Profiler::isCapturing() const
     return mpCapture != nullptr;
 }
 
+void Profiler::recordCounter(std::string_view name, double value)
+{
+    if (mpCapture && !mPaused)
+        mpCapture->recordCounter(name, value, CpuTimer::getCurrentTimePoint());
+}
+
 Profiler::Event* Profiler::createEvent(const std::string& name)
 {
     auto pEvent = std::shared_ptr<Event>(new Event(name));
@@ -434,16 +950,20 @@ void Profiler::breakStrongReferenceToDevice()
     mpDevice.breakStrongReference();
 }
 
-ScopedProfilerEvent::ScopedProfilerEvent(RenderContext* pRenderContext, const std::string& name, Profiler::Flags flags)
-    : mpRenderContext(pRenderContext), mName(name), mFlags(flags)
+ScopedProfilerEvent::ScopedProfilerEvent(RenderContext* pRenderContext, std::string_view name, Profiler::Flags flags)
+    : ScopedProfilerEvent(pRenderContext, Profiler::internName(name), flags)
+{}
+
+ScopedProfilerEvent::ScopedProfilerEvent(RenderContext* pRenderContext, Profiler::NameId nameId, Profiler::Flags flags)
+    : mpRenderContext(pRenderContext), mFlags(flags)
 {
     FALCOR_ASSERT(mpRenderContext);
-    mpRenderContext->getProfiler()->startEvent(mpRenderContext, mName, mFlags);
+    mpRenderContext->getProfiler()->startEvent(mpRenderContext, nameId, mFlags);
 }
 
 ScopedProfilerEvent::~ScopedProfilerEvent()
 {
-    mpRenderContext->getProfiler()->endEvent(mpRenderContext, mName, mFlags);
+    mpRenderContext->getProfiler()->endEvent(mpRenderContext, {}, mFlags);
 }
 
 /// Implements a Python context manager for profiling events.
@@ -465,12 +985,16 @@ FALCOR_SCRIPT_BINDING(Profiler)
 
     using namespace pybind11::literals;
 
-    auto endCapture = [](Profiler* pProfiler)
+    auto endCapture = [](Profiler* pProfiler, std::optional<std::filesystem::path> tracePath)
     {
         std::optional<pybind11::dict> result;
         auto pCapture = pProfiler->endCapture();
         if (pCapture)
+        {
             result = toPython(*pCapture);
+            if (tracePath)
+                pCapture->writeTraceToFile(*tracePath);
+        }
         return result;
     };
 
@@ -480,7 +1004,8 @@ FALCOR_SCRIPT_BINDING(Profiler)
     profiler.def_property_readonly("is_capturing", &Profiler::isCapturing);
     profiler.def_property_readonly("events", [](const Profiler& profiler) { return toPython(profiler.getEvents()); });
     profiler.def("start_capture", &Profiler::startCapture, "reserved_frames"_a = 1000);
-    profiler.def("end_capture", endCapture);
+    profiler.def("end_capture", endCapture, "trace_path"_a = std::optional<std::filesystem::path>());
+    profiler.def("record_counter", &Profiler::recordCounter, "name"_a, "value"_a);
 
     pybind11::class_<PythonProfilerEvent>(m, "ProfilerEvent")
         .def(pybind11::init<RenderContext*, std::string_view>())
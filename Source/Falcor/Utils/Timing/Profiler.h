@@ -30,9 +30,11 @@
 #include "Core/Macros.h"
 #include "Core/API/GpuTimer.h"
 #include "Core/API/Fence.h"
+#include <atomic>
 #include <filesystem>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -46,6 +48,13 @@ class RenderContext;
  * It automatically creates event hierarchies based on the order and nesting of the calls made.
  * This class uses a double-buffering scheme for GPU profiling to avoid GPU stalls.
  * ProfilerEvent is a wrapper class which together with scoping can simplify event profiling.
+ *
+ * Event names are interned into integer ids and events are looked up by id in the event hierarchy,
+ * so profiling an event does not allocate memory once the event exists.
+ * CPU-only events can be recorded from any thread (see startCpuEvent()). They are written to lock-free
+ * per-thread lanes and show up as events under a "CPU thread <index>" root event.
+ * The CPU lanes are shared by all profilers in the process and are only collected by the first profiler that is
+ * enabled, until it is disabled again. With multiple devices, only one of their profilers records CPU-only events.
  */
 class FALCOR_API Profiler
 {
@@ -59,6 +68,10 @@ public:
         Default = Internal | Pix
     };
 
+    /// Interned event name.
+    using NameId = uint32_t;
+    static constexpr NameId kInvalidNameId = NameId(-1);
+
     struct Stats
     {
         float min;
@@ -69,6 +82,8 @@ public:
         static Stats compute(const float* data, size_t len);
     };
 
+    class Capture;
+
     class Event
     {
     public:
@@ -84,13 +99,22 @@ public:
         Stats computeGpuTimeStats() const;
 
     private:
-        Event(const std::string& name);
+        Event(const std::string& name, NameId nameId = kInvalidNameId, Event* pParent = nullptr);
 
         void start(Profiler& profiler, uint32_t frameIndex);
         void end(uint32_t frameIndex);
+        void addCpuTime(uint32_t frameIndex, float time);
         void endFrame(uint32_t frameIndex);
 
         std::string mName; ///< Nested event name.
+        NameId mNameId;    ///< Interned name of the last path component.
+        Event* mpParent;   ///< Parent event in the hierarchy.
+
+        std::vector<Event*> mChildren;            ///< Child events in the hierarchy.
+        uint32_t mRegisteredFrame = uint32_t(-1); ///< Frame index this event was last registered for.
+
+        CpuTimer::TimePoint mLastCpuStartTime; ///< CPU start time of the last measurement (previous frame).
+        bool mLastHasGpuTime = false;          ///< True if the last measurement included GPU time.
 
         float mCpuTime = 0.0; ///< CPU time (previous frame).
         float mGpuTime = 0.0; ///< GPU time (previous frame).
@@ -119,6 +143,7 @@ public:
         FrameData mFrameData[2]; ///< Double-buffered frame data to avoid GPU flushes.
 
         friend class Profiler;
+        friend class Capture;
     };
 
     class Capture
@@ -139,16 +164,63 @@ public:
         std::string toJsonString() const;
         void writeToFile(const std::filesystem::path& path) const;
 
+        /**
+         * Get the capture as a trace in the Chrome trace event format, which can be opened in Perfetto or chrome://tracing.
+         * The trace has a track for the main thread events, one for the GPU events and one for each CPU lane,
+         * as well as frame markers and counters (see Profiler::recordCounter()).
+         * GPU timestamps are not calibrated against the CPU clock. GPU events are laid out in submission order,
+         * starting no earlier than the CPU start of the event.
+         */
+        std::string toTraceJsonString() const;
+        void writeTraceToFile(const std::filesystem::path& path) const;
+
     private:
+        static constexpr uint32_t kMainTrack = 0;
+        static constexpr uint32_t kGpuTrack = 1;
+        static constexpr uint32_t kCpuLaneTrackOffset = 2;
+
+        struct TraceRecord
+        {
+            uint32_t nameIndex; ///< Index into mTraceNames.
+            uint32_t track;     ///< Track (kMainTrack, kGpuTrack or kCpuLaneTrackOffset + CPU lane index).
+            double startTime;   ///< Start time in microseconds since the start of the capture.
+            double duration;    ///< Duration in microseconds.
+        };
+
+        struct CounterRecord
+        {
+            uint32_t nameIndex; ///< Index into mCounterNames.
+            double time;        ///< Time in microseconds since the start of the capture.
+            double value;
+        };
+
         void captureEvents(const std::vector<Event*>& events);
+        void addLanes(Event* pEvent);
         void finalize();
 
+        double getTraceTime(CpuTimer::TimePoint time) const;
+        void recordEvent(const Event* pEvent, uint32_t track, CpuTimer::TimePoint startTime, CpuTimer::TimePoint endTime);
+        void recordGpuEvents(const std::vector<Event*>& events);
+        void recordFrameMarker(CpuTimer::TimePoint time);
+        void recordCounter(std::string_view name, double value, CpuTimer::TimePoint time);
+
         size_t mReservedFrames = 0;
         size_t mFrameCount = 0;
         std::vector<Event*> mEvents;
+        std::unordered_map<const Event*, size_t> mEventIndices; ///< Index into mEvents for each captured event.
         std::vector<Lane> mLanes;
         bool mFinalized = false;
 
+        CpuTimer::TimePoint mStartTime;                               ///< Start time of the capture.
+        std::vector<std::string> mTraceNames;                         ///< Names of the traced events.
+        std::unordered_map<const Event*, uint32_t> mTraceNameIndices; ///< Index into mTraceNames for each traced event.
+        std::vector<std::string> mCounterNames;                       ///< Names of the counters.
+        std::vector<TraceRecord> mTraceRecords;
+        std::vector<CounterRecord> mCounterRecords;
+        std::vector<double> mFrameMarkers;                            ///< Frame end times in microseconds since the start of the capture.
+        double mGpuTime = 0.0;                                        ///< End of the last top-level event on the GPU track.
+        uint32_t mCpuLaneCount = 0;                                   ///< Number of CPU lanes with recorded events.
+
         friend class Profiler;
     };
 
@@ -156,6 +228,7 @@ public:
      * Constructor.
      */
     Profiler(ref<Device> pDevice);
+    ~Profiler();
 
     const Device* getDevice() const { return mpDevice.get(); }
 
@@ -169,7 +242,13 @@ public:
      * Enable/disable the profiler.
      * @param[in] enabled True to enable the profiler.
      */
-    void setEnabled(bool enabled) { mEnabled = enabled; }
+    void setEnabled(bool enabled);
+
+    /**
+     * Check if the profiler collects the CPU-only events recorded with startCpuEvent().
+     * @return Returns true if this profiler owns the process-global CPU lanes.
+     */
+    bool isCollectingCpuEvents() const;
 
     /**
      * Check if the profiler is paused.
@@ -201,6 +280,14 @@ public:
      */
     bool isCapturing() const;
 
+    /**
+     * Record a counter value (e.g. number of photons) in the active capture.
+     * Counters show up as counter tracks in traces (see Capture::toTraceJsonString()). Does nothing if not capturing.
+     * @param[in] name The counter name.
+     * @param[in] value The counter value.
+     */
+    void recordCounter(std::string_view name, double value);
+
     /**
      * Finish profiling for the entire frame.
      * Note: Must be called once at the end of each frame.
@@ -213,15 +300,52 @@ public:
      * @param[in] name The event name.
      * @param[in] flags The event flags.
      */
-    void startEvent(RenderContext* pRenderContext, const std::string& name, Flags flags = Flags::Default);
+    void startEvent(RenderContext* pRenderContext, std::string_view name, Flags flags = Flags::Default);
 
     /**
-     * Finish profiling a new event and update the events hierarchies.
+     * Start profiling a new event and update the events hierarchies.
      * @param[in] pRenderContext Render context for measuring GPU time.
-     * @param[in] name The event name.
+     * @param[in] nameId The interned event name.
      * @param[in] flags The event flags.
      */
-    void endEvent(RenderContext* pRenderContext, const std::string& name, Flags flags = Flags::Default);
+    void startEvent(RenderContext* pRenderContext, NameId nameId, Flags flags = Flags::Default);
+
+    /**
+     * Finish profiling the innermost event and update the events hierarchies.
+     * @param[in] pRenderContext Render context for measuring GPU time.
+     * @param[in] name The event name. Only kept for readability, the innermost started event is finished.
+     * @param[in] flags The event flags.
+     */
+    void endEvent(RenderContext* pRenderContext, std::string_view name = {}, Flags flags = Flags::Default);
+
+    /**
+     * Intern an event name. Thread-safe.
+     * @param[in] name The event name. Must not contain '/'.
+     * @return Returns the interned name or kInvalidNameId if the name is invalid.
+     */
+    static NameId internName(std::string_view name);
+
+    /**
+     * Get an interned event name. Thread-safe.
+     * @param[in] nameId The interned name.
+     * @return Returns the event name.
+     */
+    static const std::string& getInternedName(NameId nameId);
+
+    /**
+     * Start a CPU-only event on the calling thread.
+     * This can be called from any thread. Events are nested per thread and written to a lock-free per-thread lane,
+     * which is collected by the next call to endFrame() of the profiler owning the CPU lanes. No memory is allocated after the first time a given nesting
+     * of events is recorded on a thread.
+     * @param[in] nameId The interned event name.
+     * @return Returns true if the event was started, in which case endCpuEvent() must be called on the same thread.
+     */
+    static bool startCpuEvent(NameId nameId);
+
+    /**
+     * Finish the innermost CPU-only event on the calling thread.
+     */
+    static void endCpuEvent();
 
     /**
      * Get the event, or create a new one if the event does not yet exist.
@@ -240,6 +364,30 @@ public:
     void breakStrongReferenceToDevice();
 
 private:
+    /**
+     * Get a child event, or create a new one if the event does not yet exist.
+     * @param[in] pParent The parent event or nullptr for a top-level event.
+     * @param[in] nameId The interned event name.
+     * @return Returns the event.
+     */
+    Event* getChildEvent(Event* pParent, NameId nameId);
+
+    /**
+     * Add an event and its parents to the events of the current frame.
+     */
+    void registerEvent(Event* pEvent);
+
+    /**
+     * Take or release ownership of the process-global CPU lanes.
+     * @param[in] owner True to collect the CPU lanes in this profiler if no other profiler does.
+     */
+    void setCpuLaneOwner(bool owner);
+
+    /**
+     * Collect the events recorded on the per-thread CPU lanes. Does nothing if this profiler doesn't own the lanes.
+     */
+    void collectCpuLanes();
+
     /**
      * Create a new event.
      * @param[in] name The event name.
@@ -254,16 +402,24 @@ private:
      */
     Event* findEvent(const std::string& name);
 
+    struct StackEntry
+    {
+        Event* pEvent;                 ///< Started event, or the parent event for ignored events.
+        bool started;                  ///< False for ignored events.
+        CpuTimer::TimePoint startTime; ///< CPU start time, only used when capturing.
+    };
+
     BreakableReference<Device> mpDevice;
 
     bool mEnabled = false;
     bool mPaused = false;
 
     std::unordered_map<std::string, std::shared_ptr<Event>> mEvents; ///< Events by name.
+    std::vector<Event*> mRootEvents;                                 ///< Top-level events of the hierarchy.
     std::vector<Event*> mCurrentFrameEvents;                         ///< Events registered for current frame.
     std::vector<Event*> mLastFrameEvents;                            ///< Events from last frame.
-    std::string mCurrentEventName;                                   ///< Current nested event name.
-    uint32_t mCurrentLevel = 0;                                      ///< Current nesting level.
+    std::vector<StackEntry> mEventStack;                             ///< Currently started events.
+    std::vector<std::vector<Event*>> mCpuLaneEvents;                 ///< Events for the nodes of each CPU lane.
     uint32_t mFrameIndex = 0;                                        ///< Current frame index.
 
     std::shared_ptr<Capture> mpCapture; ///< Currently active capture.
@@ -283,22 +439,80 @@ FALCOR_ENUM_CLASS_OPERATORS(Profiler::Flags);
 class FALCOR_API ScopedProfilerEvent
 {
 public:
-    ScopedProfilerEvent(RenderContext* pRenderContext, const std::string& name, Profiler::Flags flags = Profiler::Flags::Default);
+    ScopedProfilerEvent(RenderContext* pRenderContext, std::string_view name, Profiler::Flags flags = Profiler::Flags::Default);
+    ScopedProfilerEvent(RenderContext* pRenderContext, Profiler::NameId nameId, Profiler::Flags flags = Profiler::Flags::Default);
     ~ScopedProfilerEvent();
 
 private:
     RenderContext* mpRenderContext;
-    const std::string mName;
     Profiler::Flags mFlags;
 };
+
+/**
+ * Per call site cache of an interned profiler event name, used by the FALCOR_PROFILE macros.
+ * String literals and other constant character arrays are interned on the first call only,
+ * other names (e.g. std::string or const char*) may change between calls and are interned on every call.
+ */
+class ProfilerNameCache
+{
+public:
+    template<size_t N>
+    Profiler::NameId get(const char (&name)[N])
+    {
+        Profiler::NameId nameId = mNameId.load(std::memory_order_relaxed);
+        if (nameId == Profiler::kInvalidNameId)
+        {
+            nameId = Profiler::internName(std::string_view(name));
+            mNameId.store(nameId, std::memory_order_relaxed);
+        }
+        return nameId;
+    }
+
+    Profiler::NameId get(std::string_view name) const { return Profiler::internName(name); }
+
+private:
+    std::atomic<Profiler::NameId> mNameId{Profiler::kInvalidNameId};
+};
+
+/**
+ * Helper class for starting and ending CPU-only profiling events using RAII.
+ * Can be used on any thread, see Profiler::startCpuEvent().
+ * The FALCOR_PROFILE_CPU macro wraps creation of local ScopedCpuProfilerEvent objects.
+ */
+class FALCOR_API ScopedCpuProfilerEvent
+{
+public:
+    ScopedCpuProfilerEvent(Profiler::NameId nameId) : mStarted(Profiler::startCpuEvent(nameId)) {}
+    ~ScopedCpuProfilerEvent()
+    {
+        if (mStarted)
+            Profiler::endCpuEvent();
+    }
+
+private:
+    bool mStarted;
+};
 } // namespace Falcor
 
 #if FALCOR_ENABLE_PROFILER
-#define FALCOR_PROFILE(_pRenderContext, _name) \
-    Falcor::ScopedProfilerEvent FALCOR_CONCAT_STRINGS(_profileEvent, __LINE__)(_pRenderContext, _name)
-#define FALCOR_PROFILE_CUSTOM(_pRenderContext, _name, _flags) \
-    Falcor::ScopedProfilerEvent FALCOR_CONCAT_STRINGS(_profileEvent, __LINE__)(_pRenderContext, _name, _flags)
+/// Profile a scope. Constant names are interned once per call site, see ProfilerNameCache.
+#define FALCOR_PROFILE(_pRenderContext, _name)                                            \
+    static Falcor::ProfilerNameCache FALCOR_CONCAT_STRINGS(_profileName, __LINE__);       \
+    Falcor::ScopedProfilerEvent FALCOR_CONCAT_STRINGS(_profileEvent, __LINE__)(           \
+        _pRenderContext, FALCOR_CONCAT_STRINGS(_profileName, __LINE__).get(_name)         \
+    )
+#define FALCOR_PROFILE_CUSTOM(_pRenderContext, _name, _flags)                             \
+    static Falcor::ProfilerNameCache FALCOR_CONCAT_STRINGS(_profileName, __LINE__);       \
+    Falcor::ScopedProfilerEvent FALCOR_CONCAT_STRINGS(_profileEvent, __LINE__)(           \
+        _pRenderContext, FALCOR_CONCAT_STRINGS(_profileName, __LINE__).get(_name), _flags \
+    )
+/// Profile a CPU-only scope on any thread. The name is interned once per call site, so it must not change between calls.
+#define FALCOR_PROFILE_CPU(_name)                                                         \
+    static const Falcor::Profiler::NameId FALCOR_CONCAT_STRINGS(_profileName, __LINE__) = \
+        Falcor::Profiler::internName(_name);                                              \
+    Falcor::ScopedCpuProfilerEvent FALCOR_CONCAT_STRINGS(_profileEvent, __LINE__)(FALCOR_CONCAT_STRINGS(_profileName, __LINE__))
 #else
 #define FALCOR_PROFILE(_pRenderContext, _name)
 #define FALCOR_PROFILE_CUSTOM(_pRenderContext, _name, _flags)
+#define FALCOR_PROFILE_CPU(_name)
 #endif
@@ -120,6 +120,7 @@ namespace Mogwai
 
     void CaptureTrigger::endFrame(RenderContext* pRenderContext, const ref<Fbo>& pTargetFbo)
     {
+        update(pRenderContext);
         if (!mCurrent.pGraph) return;
         uint64_t frameId = mpRenderer->getGlobalClock().getFrame();
         const auto& ranges = mGraphRanges.at(mCurrent.pGraph);
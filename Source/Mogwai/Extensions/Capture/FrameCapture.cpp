@@ -41,6 +41,7 @@ namespace Mogwai
         const std::string kUI = "ui";
         const std::string kOutputs = "outputs";
         const std::string kCapture = "capture";
+        const std::string kFlush = "flush";
 
         template<typename T>
         std::vector<typename T::value_type::first_type> getFirstOfPair(const T& pair)
@@ -65,6 +66,11 @@ namespace Mogwai
         mpImageProcessing = std::make_unique<ImageProcessing>(pRenderer->getDevice());
     }
 
+    FrameCapture::~FrameCapture()
+    {
+        flush();
+    }
+
     void FrameCapture::renderUI(Gui* pGui)
     {
         if (mShowUI)
@@ -77,6 +83,11 @@ namespace Mogwai
             w.tooltip("Capture all available outputs instead of the marked ones only.");
 
             if (w.button("Capture Current Frame")) capture();
+
+            w.text(fmt::format("Images in flight: {} readbacks, {} encodes", mPendingReadbacks.size(), mEncodeTasks.size()));
+            w.text(fmt::format("Images captured: {} (max in flight {})", mStats.imageCount, mStats.maxInFlight));
+            w.text(fmt::format("Render thread stalls: {} readback, {} encode, {:.2f} ms", mStats.readbackStallCount, mStats.encodeStallCount, mStats.stallTime));
+            w.tooltip("Images are read back and written asynchronously. The render thread only waits when too many images are in flight.");
         }
     }
 
@@ -95,6 +106,7 @@ namespace Mogwai
         auto printGraph = [](FrameCapture* pFC, RenderGraph* pGraph) { pybind11::print(pFC->graphFramesStr(pGraph)); };
         frameCapture.def(kPrintFrames.c_str(), printGraph, "graph"_a);
         frameCapture.def(kCapture.c_str(), &FrameCapture::capture);
+        frameCapture.def(kFlush.c_str(), &FrameCapture::flush);
         auto printAllGraphs = [](FrameCapture* pFC)
         {
             std::string s;
@@ -248,8 +260,116 @@ namespace Mogwai
             Bitmap::ExportFlags flags = Bitmap::ExportFlags::None;
             if (mask == TextureChannelFlags::RGBA) flags |= Bitmap::ExportFlags::ExportAlpha;
 
-            pTex->captureToFile(0, 0, filename, fileformat, flags);
+            queueImage(pRenderContext, pTex, filename, fileformat, flags);
+        }
+    }
+
+    void FrameCapture::update(RenderContext* pCtx)
+    {
+        processReadbacks(0);
+    }
+
+    void FrameCapture::queueImage(RenderContext* pRenderContext, const ref<Texture>& pTex, const std::filesystem::path& path, Bitmap::FileFormat fileFormat, Bitmap::ExportFlags exportFlags)
+    {
+        if (fileFormat == Bitmap::FileFormat::DdsFile) FALCOR_THROW("FrameCapture does not support saving to DDS.");
+
+        // Block on the oldest readback if too many are in flight.
+        processReadbacks(mPendingReadbacks.size() >= kMaxPendingReadbacks ? 1 : 0);
+
+        PendingImage image;
+        image.path = path;
+        image.width = pTex->getWidth();
+        image.height = pTex->getHeight();
+        image.resourceFormat = pTex->getFormat();
+        image.fileFormat = fileFormat;
+        image.exportFlags = exportFlags;
+
+        // Same as Texture::captureToFile(), HDR textures with less than 3 channels are expanded to RGBA32Float.
+        ref<Texture> pReadbackTex = pTex;
+        if (getFormatType(image.resourceFormat) == FormatType::Float && getFormatChannelCount(image.resourceFormat) < 3)
+        {
+            pReadbackTex = mpRenderer->getDevice()->createTexture2D(image.width, image.height, ResourceFormat::RGBA32Float, 1, 1, nullptr, ResourceBindFlags::RenderTarget | ResourceBindFlags::ShaderResource);
+            pRenderContext->blit(pTex->getSRV(0, 1, 0, 1), pReadbackTex->getRTV(0, 0, 1));
+            image.resourceFormat = ResourceFormat::RGBA32Float;
+        }
+
+        // The copy into the readback buffer is submitted and fenced right away, so the texture can be reused next frame.
+        // Take a staging buffer from the pool, the readback replaces it with a larger one if it doesn't fit.
+        ref<Buffer> pStagingBuffer;
+        if (!mStagingBuffers.empty())
+        {
+            pStagingBuffer = std::move(mStagingBuffers.back());
+            mStagingBuffers.pop_back();
+        }
+        image.pReadback = pRenderContext->asyncReadTextureSubresource(pReadbackTex.get(), 0, std::move(pStagingBuffer));
+        mPendingReadbacks.push_back(std::move(image));
+        mStats.imageCount++;
+        mStats.maxInFlight = std::max(mStats.maxInFlight, mPendingReadbacks.size() + mEncodeTasks.size());
+    }
+
+    void FrameCapture::processReadbacks(size_t waitCount)
+    {
+        while (!mPendingReadbacks.empty())
+        {
+            PendingImage& image = mPendingReadbacks.front();
+            const bool ready = image.pReadback->isReady();
+            if (!ready && waitCount == 0) break;
+            if (waitCount > 0) waitCount--;
+
+            auto start = CpuTimer::getCurrentTimePoint();
+            auto pData = std::make_shared<std::vector<uint8_t>>(image.pReadback->getData());
+            if (!ready)
+            {
+                mStats.readbackStallCount++;
+                mStats.stallTime += CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+            }
+
+            // The encode task owns the pixels, the readback buffer goes back to the pool.
+            // There are never more than kMaxPendingReadbacks buffers in use, so the pool doesn't need a bound of its own.
+            mStagingBuffers.push_back(image.pReadback->getBuffer());
+            image.pReadback.reset();
+            queueEncode([image = std::move(image), pData]()
+            {
+                FALCOR_PROFILE_CPU("FrameCapture::encode");
+                Bitmap::saveImage(image.path, image.width, image.height, image.fileFormat, image.exportFlags, image.resourceFormat, true, pData->data());
+            });
+            mPendingReadbacks.pop_front();
+        }
+    }
+
+    void FrameCapture::queueEncode(std::function<void()> encode)
+    {
+        while (!mEncodeTasks.empty() && !mEncodeTasks.front().isRunning()) retireEncode();
+
+        // Block on the oldest encode if the queue is full, this bounds the memory held by captured images.
+        if (mEncodeTasks.size() >= kMaxEncodeTasks)
+        {
+            auto start = CpuTimer::getCurrentTimePoint();
+            mStats.encodeStallCount++;
+            retireEncode();
+            mStats.stallTime += CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        }
+
+        mEncodeTasks.push_back(Threading::dispatchTask(std::move(encode)));
+    }
+
+    void FrameCapture::flush()
+    {
+        processReadbacks(mPendingReadbacks.size());
+        while (!mEncodeTasks.empty()) retireEncode();
+    }
+
+    void FrameCapture::retireEncode()
+    {
+        try
+        {
+            mEncodeTasks.front().finish();
+        }
+        catch (const std::exception& e)
+        {
+            logError("FrameCapture failed to write image: {}", e.what());
         }
+        mEncodeTasks.pop_front();
     }
 
     void FrameCapture::addFrames(const RenderGraph* pGraph, const uint64_vec& frames)
@@ -29,12 +29,14 @@
 #include "../../Mogwai.h"
 #include "CaptureTrigger.h"
 #include "Utils/Image/ImageProcessing.h"
+#include <deque>
 
 namespace Mogwai
 {
     class FrameCapture : public CaptureTrigger
     {
     public:
+        virtual ~FrameCapture();
         static UniquePtr create(Renderer* pRenderer);
         virtual void renderUI(Gui* pGui) override;
         virtual void registerScriptBindings(pybind11::module& m) override;
@@ -43,6 +45,10 @@ namespace Mogwai
         virtual void triggerFrame(RenderContext* pRenderContext, RenderGraph* pGraph, uint64_t frameID) override;
         void capture();
 
+        /** Block until all queued images are written to disk.
+        */
+        void flush();
+
     private:
         FrameCapture(Renderer* pRenderer);
 
@@ -52,7 +58,47 @@ namespace Mogwai
         std::string graphFramesStr(const RenderGraph* pGraph);
         void captureOutput(RenderContext* pRenderContext, RenderGraph* pGraph, const uint32_t outputIndex);
 
+        virtual void update(RenderContext* pCtx) override;
+
+        /** Queue the readback of a texture. The image is written by a worker once the readback completed.
+        */
+        void queueImage(RenderContext* pRenderContext, const ref<Texture>& pTex, const std::filesystem::path& path, Bitmap::FileFormat fileFormat, Bitmap::ExportFlags exportFlags);
+
+        /** Hand completed readbacks to the encode queue, waiting for at least the oldest waitCount readbacks.
+        */
+        void processReadbacks(size_t waitCount);
+        void queueEncode(std::function<void()> encode);
+        void retireEncode();
+
+        /** Bounds on the captures in flight, the render thread blocks when they are exceeded.
+        */
+        static constexpr size_t kMaxPendingReadbacks = 8;
+        static constexpr size_t kMaxEncodeTasks = 4;
+
+        struct PendingImage
+        {
+            CopyContext::ReadTextureTask::SharedPtr pReadback;
+            std::filesystem::path path;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            ResourceFormat resourceFormat = ResourceFormat::Unknown;
+            Bitmap::FileFormat fileFormat = Bitmap::FileFormat::PngFile;
+            Bitmap::ExportFlags exportFlags = Bitmap::ExportFlags::None;
+        };
+
+        struct
+        {
+            uint64_t imageCount = 0;         ///< Images queued.
+            uint64_t readbackStallCount = 0; ///< Times the render thread waited for a readback.
+            uint64_t encodeStallCount = 0;   ///< Times the render thread waited for an encode task.
+            double stallTime = 0.0;          ///< Total time the render thread waited in ms.
+            size_t maxInFlight = 0;          ///< Max number of images in flight.
+        } mStats;
+
         bool mCaptureAllOutputs = false;
         std::unique_ptr<ImageProcessing> mpImageProcessing;
+        std::deque<PendingImage> mPendingReadbacks; ///< Readbacks in submission order.
+        std::vector<ref<Buffer>> mStagingBuffers;   ///< Readback buffers of retired readbacks, reused by the next ones.
+        std::deque<Threading::Task> mEncodeTasks;   ///< Encode tasks in submission order.
     };
 }
@@ -34,6 +34,7 @@ namespace Mogwai
     {
         const std::string kScriptVar = "timingCapture";
         const std::string kCaptureFrameTime = "captureFrameTime";
+        const std::string kCaptureTrace = "captureTrace";
     }
 
     MOGWAI_EXTENSION(TimingCapture);
@@ -51,6 +52,7 @@ namespace Mogwai
 
         // Members
         timingCapture.def(kCaptureFrameTime.c_str(), &TimingCapture::captureFrameTime, "path"_a);
+        timingCapture.def(kCaptureTrace.c_str(), &TimingCapture::captureTrace, "path"_a);
     }
 
     std::string TimingCapture::getScriptVar() const
@@ -83,6 +85,45 @@ namespace Mogwai
         }
     }
 
+    void TimingCapture::captureTrace(std::filesystem::path path)
+    {
+        Profiler* pProfiler = mpRenderer->getDevice()->getProfiler();
+
+        // Only end captures started here, a capture started elsewhere (e.g. from the profiler UI) is left alone.
+        if (!mTracePath.empty())
+        {
+            if (pProfiler->isCapturing())
+            {
+                auto pCapture = pProfiler->endCapture();
+                pCapture->writeTraceToFile(mTracePath);
+                logInfo("Wrote profiler trace of {} frames to '{}'.", pCapture->getFrameCount(), mTracePath);
+            }
+            else
+            {
+                logWarning("Profiler capture for trace '{}' was ended elsewhere. No trace was written.", mTracePath);
+            }
+            mTracePath.clear();
+        }
+        else if (pProfiler->isCapturing())
+        {
+            if (!path.empty()) logWarning("Profiler is already capturing. Ignoring request to capture trace to '{}'.", path);
+            return;
+        }
+
+        mTracePath = path;
+
+        if (!path.empty())
+        {
+            if (std::filesystem::exists(path))
+            {
+                logWarning("Trace in file '{}' will be overwritten.", path);
+            }
+
+            pProfiler->setEnabled(true);
+            pProfiler->startCapture();
+        }
+    }
+
     void TimingCapture::recordPreviousFrameTime()
     {
         if (!mFrameTimeFile.is_open()) return;
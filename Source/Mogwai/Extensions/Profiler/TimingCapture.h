@@ -49,6 +49,12 @@ namespace Mogwai
         void captureFrameTime(std::filesystem::path path);
         void recordPreviousFrameTime();
 
+        /** Start a profiler capture, or end the capture and write it as a Chrome trace (chrome://tracing, ui.perfetto.dev) if path is empty.
+            Captures that were not started by this function are never ended, the call is ignored while one is running.
+        */
+        void captureTrace(std::filesystem::path path);
+
         std::ofstream   mFrameTimeFile;     ///< Frame times are appended to this file when it's open.
+        std::filesystem::path mTracePath;   ///< Trace is written to this file when the capture ends.
     };
 }
@@ -537,6 +537,7 @@ namespace Mogwai
     {
         if (mOptions.useSceneCache) buildFlags |= SceneBuilder::Flags::UseCache;
         if (mOptions.rebuildSceneCache) buildFlags |= SceneBuilder::Flags::RebuildCache;
+        if (mOptions.compressSceneCache) buildFlags |= SceneBuilder::Flags::CompressCache;
 
         while (true)
         {
@@ -844,6 +845,7 @@ int runMain(int argc, char** argv)
     args::ValueFlag<uint32_t> heightFlag(parser, "pixels", "Initial window height.", {"height"});
     args::Flag useSceneCacheFlag(parser, "", "Use scene cache to improve scene load times.", {'c', "use-cache"});
     args::Flag rebuildSceneCacheFlag(parser, "", "Rebuild the scene cache.", {"rebuild-cache"});
+    args::Flag compressSceneCacheFlag(parser, "", "Compress geometry data when writing the scene cache.", {"compress-cache"});
     args::Flag generateShaderDebugInfoFlag(parser, "", "Generate shader debug info.", {"debug-shaders"});
     args::Flag enableDebugLayerFlag(parser, "", "Enable debug layer (enabled by default in Debug build).", {"enable-debug-layer"});
     args::Flag preciseProgramFlag(parser, "", "Force all slang programs to run in precise mode", { "precise" });
@@ -946,6 +948,7 @@ int runMain(int argc, char** argv)
     if (silentFlag) options.silentMode = true;
     if (useSceneCacheFlag) options.useSceneCache = true;
     if (rebuildSceneCacheFlag) options.rebuildSceneCache = true;
+    if (compressSceneCacheFlag) options.compressSceneCache = true;
 
     Mogwai::Renderer renderer(config, options);
     return renderer.run();
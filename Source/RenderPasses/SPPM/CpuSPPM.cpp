@@ -0,0 +1,593 @@
+#include "CpuSPPM.h"
+#include "Scene/Material/StandardMaterial.h"
+#include "Utils/Image/Bitmap.h"
+#include "Utils/Timing/CpuTimer.h"
+#include "Utils/Threading.h"
+
+namespace
+{
+const uint32_t kPhotonBlockSize = 4096; // photons traced per task, blocks are merged in order so results do not depend on the thread count
+const uint32_t kMaxLeafSize = 4;
+const uint32_t kMaxStackSize = 64;
+const uint32_t kInvalidIndex = 0xffffffff;
+
+/** PCG32 random number generator. Each photon path gets its own stream so tracing is deterministic.
+*/
+struct Rng
+{
+    uint64_t state;
+
+    Rng(uint64_t seed, uint64_t sequence)
+    {
+        // SplitMix64 to decorrelate nearby seeds.
+        uint64_t z = seed * 0x9E3779B97F4A7C15ull + sequence;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        state = z ^ (z >> 31);
+    }
+
+    uint32_t nextUint()
+    {
+        uint64_t old = state;
+        state = old * 6364136223846793005ull + 1442695040888963407ull;
+        uint32_t xorShifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+        uint32_t rot = (uint32_t)(old >> 59u);
+        return (xorShifted >> rot) | (xorShifted << ((~rot + 1u) & 31u));
+    }
+
+    float next() { return (nextUint() >> 8) * (1.f / 16777216.f); }
+};
+
+float luminance(const float3& rgb)
+{
+    return dot(rgb, float3(0.2126f, 0.7152f, 0.0722f));
+}
+
+float3 sampleCosineHemisphere(const float3& n, float u0, float u1)
+{
+    const float r = std::sqrt(u0);
+    const float phi = 2.f * (float)M_PI * u1;
+    const float3 b = perp_stark(n);
+    const float3 t = cross(b, n);
+    return normalize(b * (r * std::cos(phi)) + t * (r * std::sin(phi)) + n * std::sqrt(std::max(0.f, 1.f - u0)));
+}
+
+float3 reflect(const float3& dir, const float3& n)
+{
+    return dir - 2.f * dot(dir, n) * n;
+}
+}
+
+uint32_t CpuSPPM::SceneDesc::addMaterial(const MaterialDesc& desc)
+{
+    materials.push_back(desc);
+    return (uint32_t)materials.size() - 1;
+}
+
+uint32_t CpuSPPM::SceneDesc::addMaterial(const ref<Material>& pMaterial, float specRoughCutoff)
+{
+    MaterialDesc desc;
+    desc.ior = pMaterial->getIndexOfRefraction();
+    if (auto pStandard = dynamic_ref_cast<StandardMaterial>(pMaterial))
+    {
+        desc.albedo = pStandard->getBaseColor3();
+        desc.emission = pStandard->getEmissiveColor() * pStandard->getEmissiveFactor();
+        if (pStandard->getSpecularTransmission() > 0.5f)
+        {
+            desc.type = MaterialType::Dielectric;
+            desc.albedo = pStandard->getTransmissionColor();
+        }
+        else if (pStandard->getMetallic() > 0.5f && pStandard->getRoughness() <= specRoughCutoff)
+        {
+            desc.type = MaterialType::Conductor;
+        }
+    }
+    return addMaterial(desc);
+}
+
+void CpuSPPM::SceneDesc::addMesh(const TriangleMesh& mesh, const float4x4& transform, uint32_t materialID)
+{
+    FALCOR_CHECK(materialID < materials.size(), "Invalid material ID {}.", materialID);
+    const auto& vertices = mesh.getVertices();
+    const auto& indices = mesh.getIndices();
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        Triangle tri;
+        tri.p0 = transformPoint(transform, vertices[indices[i + 0]].position);
+        tri.p1 = transformPoint(transform, vertices[indices[i + 1]].position);
+        tri.p2 = transformPoint(transform, vertices[indices[i + 2]].position);
+        tri.materialID = materialID;
+        triangles.push_back(tri);
+    }
+}
+
+void CpuSPPM::SceneDesc::addScene(Scene& scene, uint2 frameDim, float specRoughCutoff)
+{
+    ref<Device> pDevice = scene.getDevice();
+    const auto& globalMatrices = scene.getAnimationController()->getGlobalMatrices();
+
+    // Materials are converted on first use, meshes are read back once and shared by all their instances.
+    std::vector<uint32_t> materialIDs(scene.getMaterialCount(), kInvalidIndex);
+    std::vector<std::vector<float3>> meshPositions(scene.getMeshCount());
+    std::vector<std::vector<uint3>> meshIndices(scene.getMeshCount());
+
+    for (uint32_t instanceID = 0; instanceID < scene.getGeometryInstanceCount(); instanceID++)
+    {
+        const GeometryInstanceData& instance = scene.getGeometryInstance(instanceID);
+        if (instance.getType() != GeometryType::TriangleMesh) continue;
+
+        const MeshID meshID{instance.geometryID};
+        auto& positions = meshPositions[meshID.get()];
+        auto& indices = meshIndices[meshID.get()];
+        if (positions.empty())
+        {
+            const auto& meshDesc = scene.getMesh(meshID);
+            std::map<std::string, ref<Buffer>> buffers = {
+                {"triangleIndices", pDevice->createStructuredBuffer(sizeof(uint3), meshDesc.getTriangleCount())},
+                {"positions", pDevice->createStructuredBuffer(sizeof(float3), meshDesc.vertexCount)},
+                {"texcrds", pDevice->createStructuredBuffer(sizeof(float3), meshDesc.vertexCount)},
+            };
+            scene.getMeshVerticesAndIndices(meshID, buffers);
+            positions = buffers["positions"]->getElements<float3>();
+            indices = buffers["triangleIndices"]->getElements<uint3>();
+        }
+
+        uint32_t& materialID = materialIDs[instance.materialID];
+        if (materialID == kInvalidIndex) materialID = addMaterial(scene.getMaterial(MaterialID{instance.materialID}), specRoughCutoff);
+
+        const float4x4& transform = globalMatrices[instance.globalMatrixID];
+        for (const uint3& index : indices)
+        {
+            Triangle tri;
+            tri.p0 = transformPoint(transform, positions[index.x]);
+            tri.p1 = transformPoint(transform, positions[index.y]);
+            tri.p2 = transformPoint(transform, positions[index.z]);
+            tri.materialID = materialID;
+            triangles.push_back(tri);
+        }
+    }
+
+    const ref<Camera>& pCamera = scene.getCamera();
+    camera.position = pCamera->getPosition();
+    camera.target = pCamera->getTarget();
+    camera.up = pCamera->getUpVector();
+    camera.fovY = focalLengthToFovY(pCamera->getFocalLength(), pCamera->getFrameHeight());
+    camera.frameDim = frameDim;
+}
+
+CpuSPPM::CpuSPPM(SceneDesc scene, const Options& options)
+    : mScene(std::move(scene)), mOptions(options)
+{
+    FALCOR_CHECK(!mScene.triangles.empty(), "CPU SPPM requires a non-empty scene.");
+    FALCOR_CHECK(all(mScene.camera.frameDim > uint2(0)), "Invalid frame dimensions.");
+
+    buildBVH();
+    buildLightDistribution();
+    reset();
+}
+
+void CpuSPPM::reset()
+{
+    mIteration = 0;
+    mCausticRadius = mOptions.causticInitRadius;
+    mGlobalRadius = mOptions.globalInitRadius;
+    const size_t pixelCount = mScene.camera.frameDim.x * mScene.camera.frameDim.y;
+    mCausticPixelStats.assign(pixelCount, PixelStats{float3(0.f), 0.f, mOptions.causticInitRadius});
+    mGlobalPixelStats.assign(pixelCount, PixelStats{float3(0.f), 0.f, mOptions.globalInitRadius});
+    mImage.assign(pixelCount, float3(0.f));
+    mStats.clear();
+}
+
+const CpuSPPM::IterationStats& CpuSPPM::runIteration()
+{
+    IterationStats stats;
+    stats.iteration = mIteration;
+    stats.causticRadius = mCausticRadius;
+    stats.globalRadius = mGlobalRadius;
+
+    auto startTime = CpuTimer::getCurrentTimePoint();
+
+    // Trace photons.
+    const uint32_t blockCount = div_round_up(mOptions.photonsPerIteration, kPhotonBlockSize);
+    mBlocks.resize(blockCount);
+    Threading::parallelForEach(0, blockCount, [&](size_t i)
+    {
+        const uint32_t b = (uint32_t)i;
+        const uint32_t first = b * kPhotonBlockSize;
+        tracePhotons(b, first, std::min(first + kPhotonBlockSize, mOptions.photonsPerIteration), mBlocks[b]);
+    }, 1);
+
+    mCausticPhotons.clear();
+    mGlobalPhotons.clear();
+    for (const auto& block : mBlocks)
+    {
+        mCausticPhotons.insert(mCausticPhotons.end(), block.caustic.begin(), block.caustic.end());
+        mGlobalPhotons.insert(mGlobalPhotons.end(), block.global.begin(), block.global.end());
+    }
+    stats.causticPhotons = (uint32_t)mCausticPhotons.size();
+    stats.globalPhotons = (uint32_t)mGlobalPhotons.size();
+
+    auto traceTime = CpuTimer::getCurrentTimePoint();
+    stats.traceMs = CpuTimer::calcDuration(startTime, traceTime);
+
+    // Build the photon maps.
+    mCausticGrid.build(mCausticPhotons, mCausticRadius);
+    mGlobalGrid.build(mGlobalPhotons, mGlobalRadius);
+
+    auto buildTime = CpuTimer::getCurrentTimePoint();
+    stats.buildMs = CpuTimer::calcDuration(traceTime, buildTime);
+
+    // Gather at the primary hits and accumulate.
+    const CameraDesc& camera = mScene.camera;
+    const float3 forward = normalize(camera.target - camera.position);
+    const float3 right = normalize(cross(forward, camera.up));
+    const float3 up = cross(right, forward);
+    const float tanHalfFov = std::tan(0.5f * camera.fovY);
+    const float aspect = (float)camera.frameDim.x / camera.frameDim.y;
+    // Max radius of the pixels with a hit per row, the photon maps of the next iteration are built for it.
+    std::vector<float2> rowMaxRadius(camera.frameDim.y, float2(0.f));
+
+    Threading::parallelFor(0, camera.frameDim.y, [&](size_t start, size_t end)
+    {
+        for (uint32_t y = (uint32_t)start; y < end; y++)
+        {
+            for (uint32_t x = 0; x < camera.frameDim.x; x++)
+            {
+                const float sx = (2.f * (x + 0.5f) / camera.frameDim.x - 1.f) * aspect * tanHalfFov;
+                const float sy = (1.f - 2.f * (y + 0.5f) / camera.frameDim.y) * tanHalfFov;
+                const float3 dir = normalize(forward + sx * right + sy * up);
+
+                const uint32_t pixel = y * camera.frameDim.x + x;
+                PixelStats& caustic = mCausticPixelStats[pixel];
+                PixelStats& global = mGlobalPixelStats[pixel];
+                Hit hit;
+                if (intersect(camera.position, dir, hit))
+                {
+                    const MaterialDesc& material = mScene.materials[mScene.triangles[hit.triangle].materialID];
+                    // Pixels that had no hit yet may be larger than the radius the photon maps are built for.
+                    caustic.radius = std::min(caustic.radius, mCausticRadius);
+                    global.radius = std::min(global.radius, mGlobalRadius);
+                    if (mOptions.collectCaustic)
+                    {
+                        uint32_t photonCount = 0;
+                        const float3 phi = gather(hit.pos, hit.normal, material, mCausticGrid, caustic.radius, photonCount);
+                        caustic.update(phi, photonCount, mOptions.alpha, mOptions.minRadius);
+                    }
+                    if (mOptions.collectGlobal)
+                    {
+                        uint32_t photonCount = 0;
+                        const float3 phi = gather(hit.pos, hit.normal, material, mGlobalGrid, global.radius, photonCount);
+                        global.update(phi, photonCount, mOptions.alpha, mOptions.minRadius);
+                    }
+                    rowMaxRadius[y] = max(rowMaxRadius[y], float2(caustic.radius, global.radius));
+                }
+
+                mImage[pixel] = caustic.getRadiance(mIteration + 1) + global.getRadiance(mIteration + 1);
+            }
+        }
+    });
+
+    auto endTime = CpuTimer::getCurrentTimePoint();
+    stats.gatherMs = CpuTimer::calcDuration(buildTime, endTime);
+    stats.totalMs = CpuTimer::calcDuration(startTime, endTime);
+    stats.photonsPerSecond = stats.totalMs > 0.0 ? mOptions.photonsPerIteration / (stats.totalMs * 1e-3) : 0.0;
+
+    // Size the photon maps for the largest radius, keep the previous size if no pixel had a hit.
+    mIteration++;
+    float2 maxRadius(0.f);
+    for (const float2& radius : rowMaxRadius)
+        maxRadius = max(maxRadius, radius);
+    if (maxRadius.x > 0.f) mCausticRadius = std::max(maxRadius.x, mOptions.minRadius);
+    if (maxRadius.y > 0.f) mGlobalRadius = std::max(maxRadius.y, mOptions.minRadius);
+
+    mStats.push_back(stats);
+    return mStats.back();
+}
+
+void CpuSPPM::run(uint32_t iterations)
+{
+    double totalMs = 0.0;
+    uint64_t storedPhotons = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        const auto& stats = runIteration();
+        totalMs += stats.totalMs;
+        storedPhotons += stats.causticPhotons + stats.globalPhotons;
+    }
+
+    if (iterations > 0 && totalMs > 0.0)
+    {
+        logInfo(
+            "CpuSPPM: {} iterations, {:.2f} ms/iteration, {:.2f} Mphotons/s emitted, {:.2f} Mphotons/s stored ({} threads).",
+            iterations, totalMs / iterations, (double)mOptions.photonsPerIteration * iterations / (totalMs * 1e3),
+            storedPhotons / (totalMs * 1e3), Threading::getWorkerCount()
+        );
+    }
+}
+
+void CpuSPPM::saveImage(const std::filesystem::path& path) const
+{
+    const uint2 frameDim = mScene.camera.frameDim;
+    std::vector<float4> data(mImage.size());
+    for (size_t i = 0; i < mImage.size(); i++)
+        data[i] = float4(mImage[i], 1.f);
+    auto format = Bitmap::getFormatFromFileExtension(getExtensionFromPath(path));
+    Bitmap::saveImage(path, frameDim.x, frameDim.y, format, Bitmap::ExportFlags::None, ResourceFormat::RGBA32Float, true, data.data());
+}
+
+void CpuSPPM::buildBVH()
+{
+    const uint32_t triangleCount = (uint32_t)mScene.triangles.size();
+    std::vector<AABB> triBounds(triangleCount);
+    std::vector<float3> centroids(triangleCount);
+    mNormals.resize(triangleCount);
+    for (uint32_t i = 0; i < triangleCount; i++)
+    {
+        const Triangle& tri = mScene.triangles[i];
+        triBounds[i] = AABB(tri.p0).include(tri.p1).include(tri.p2);
+        centroids[i] = triBounds[i].center();
+        const float3 n = cross(tri.p1 - tri.p0, tri.p2 - tri.p0);
+        const float len = length(n);
+        mNormals[i] = len > 0.f ? n / len : float3(0.f, 0.f, 1.f);
+    }
+
+    mTriangleIndices.resize(triangleCount);
+    std::iota(mTriangleIndices.begin(), mTriangleIndices.end(), 0u);
+    mNodes.clear();
+    mNodes.reserve(2 * triangleCount);
+
+    // Split at the middle of the longest centroid axis, falling back to a median split.
+    std::function<void(uint32_t, uint32_t)> buildNode = [&](uint32_t start, uint32_t end)
+    {
+        AABB bounds, centroidBounds;
+        for (uint32_t i = start; i < end; i++)
+        {
+            bounds.include(triBounds[mTriangleIndices[i]]);
+            centroidBounds.include(centroids[mTriangleIndices[i]]);
+        }
+
+        const uint32_t nodeIndex = (uint32_t)mNodes.size();
+        mNodes.push_back({bounds, start, (uint16_t)(end - start), 0});
+        if (end - start <= kMaxLeafSize) return;
+
+        const float3 extent = centroidBounds.extent();
+        const uint32_t axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        if (extent[axis] <= 0.f) return; // all centroids coincide, keep as a (large) leaf
+        const float splitPos = centroidBounds.center()[axis];
+
+        auto first = mTriangleIndices.begin() + start;
+        auto last = mTriangleIndices.begin() + end;
+        uint32_t mid = (uint32_t)(std::partition(first, last, [&](uint32_t i) { return centroids[i][axis] < splitPos; }) - mTriangleIndices.begin());
+        if (mid == start || mid == end)
+        {
+            mid = (start + end) / 2;
+            std::nth_element(first, mTriangleIndices.begin() + mid, last, [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+        }
+
+        buildNode(start, mid);
+        mNodes[nodeIndex].count = 0;
+        mNodes[nodeIndex].axis = (uint16_t)axis;
+        mNodes[nodeIndex].offset = (uint32_t)mNodes.size();
+        buildNode(mid, end);
+    };
+    buildNode(0, triangleCount);
+}
+
+bool CpuSPPM::intersect(const float3& origin, const float3& dir, Hit& hit) const
+{
+    const float3 invDir = 1.f / dir;
+    hit.t = std::numeric_limits<float>::infinity();
+    float2 bary;
+
+    auto intersectBox = [&](const AABB& box)
+    {
+        const float3 t0 = (box.minPoint - origin) * invDir;
+        const float3 t1 = (box.maxPoint - origin) * invDir;
+        const float3 tmin = min(t0, t1);
+        const float3 tmax = max(t0, t1);
+        const float tNear = std::max(std::max(tmin.x, tmin.y), std::max(tmin.z, 0.f));
+        const float tFar = std::min(std::min(tmax.x, tmax.y), std::min(tmax.z, hit.t));
+        return tNear <= tFar;
+    };
+
+    uint32_t stack[kMaxStackSize];
+    uint32_t stackSize = 0;
+    uint32_t nodeIndex = 0;
+    while (true)
+    {
+        const BVHNode& node = mNodes[nodeIndex];
+        if (intersectBox(node.bounds))
+        {
+            if (node.count > 0)
+            {
+                for (uint32_t i = node.offset; i < node.offset + node.count; i++)
+                {
+                    // Moeller-Trumbore.
+                    const uint32_t triIndex = mTriangleIndices[i];
+                    const Triangle& tri = mScene.triangles[triIndex];
+                    const float3 e1 = tri.p1 - tri.p0;
+                    const float3 e2 = tri.p2 - tri.p0;
+                    const float3 p = cross(dir, e2);
+                    const float det = dot(e1, p);
+                    if (std::abs(det) < 1e-12f) continue;
+                    const float invDet = 1.f / det;
+                    const float3 s = origin - tri.p0;
+                    const float u = dot(s, p) * invDet;
+                    if (u < 0.f || u > 1.f) continue;
+                    const float3 q = cross(s, e1);
+                    const float v = dot(dir, q) * invDet;
+                    if (v < 0.f || u + v > 1.f) continue;
+                    const float t = dot(e2, q) * invDet;
+                    if (t > 0.f && t < hit.t)
+                    {
+                        hit.t = t;
+                        hit.triangle = triIndex;
+                        bary = float2(u, v);
+                    }
+                }
+            }
+            else
+            {
+                // Visit the near child first.
+                const bool dirNeg = dir[node.axis] < 0.f;
+                FALCOR_ASSERT(stackSize < kMaxStackSize);
+                stack[stackSize++] = dirNeg ? nodeIndex + 1 : node.offset;
+                nodeIndex = dirNeg ? node.offset : nodeIndex + 1;
+                continue;
+            }
+        }
+        if (stackSize == 0) break;
+        nodeIndex = stack[--stackSize];
+    }
+
+    if (hit.t == std::numeric_limits<float>::infinity()) return false;
+
+    const Triangle& tri = mScene.triangles[hit.triangle];
+    hit.pos = tri.p0 * (1.f - bary.x - bary.y) + tri.p1 * bary.x + tri.p2 * bary.y;
+    hit.normal = mNormals[hit.triangle];
+    hit.backface = dot(hit.normal, dir) > 0.f;
+    if (hit.backface) hit.normal = -hit.normal;
+    return true;
+}
+
+void CpuSPPM::buildLightDistribution()
+{
+    mEmissiveTriangles.clear();
+    mEmissiveCdf.clear();
+    mEmissivePower = 0.f;
+
+    for (uint32_t i = 0; i < (uint32_t)mScene.triangles.size(); i++)
+    {
+        const Triangle& tri = mScene.triangles[i];
+        const float3 Le = mScene.materials[tri.materialID].emission;
+        const float area = 0.5f * length(cross(tri.p1 - tri.p0, tri.p2 - tri.p0));
+        const float power = luminance(Le) * area * (float)M_PI;
+        if (power <= 0.f) continue;
+        mEmissivePower += power;
+        mEmissiveTriangles.push_back(i);
+        mEmissiveCdf.push_back(mEmissivePower);
+    }
+
+    if (mEmissiveTriangles.empty()) logWarning("CpuSPPM: Scene has no emissive triangles, the output will be black.");
+}
+
+void CpuSPPM::tracePhotons(uint32_t blockIndex, uint32_t start, uint32_t end, PhotonBlock& block) const
+{
+    block.caustic.clear();
+    block.global.clear();
+    if (mEmissiveTriangles.empty()) return;
+
+    const float rayEpsilon = 1e-4f * std::max(1.f, length(mNodes[0].bounds.extent()) * 1e-2f);
+    const float invPhotonCount = 1.f / mOptions.photonsPerIteration;
+
+    for (uint32_t photonIndex = start; photonIndex < end; photonIndex++)
+    {
+        Rng rng((uint64_t)mOptions.seed << 32 | mIteration, photonIndex);
+
+        // Sample an emissive triangle proportional to its power.
+        const float uLight = rng.next() * mEmissivePower;
+        const size_t lightIndex = std::min(
+            (size_t)(std::upper_bound(mEmissiveCdf.begin(), mEmissiveCdf.end(), uLight) - mEmissiveCdf.begin()), mEmissiveCdf.size() - 1
+        );
+        const uint32_t triIndex = mEmissiveTriangles[lightIndex];
+        const Triangle& tri = mScene.triangles[triIndex];
+        const float lightPower = mEmissiveCdf[lightIndex] - (lightIndex > 0 ? mEmissiveCdf[lightIndex - 1] : 0.f);
+
+        // Uniform position on the triangle and cosine weighted direction.
+        const float su = std::sqrt(rng.next());
+        const float b1 = 1.f - su;
+        const float b2 = rng.next() * su;
+        float3 origin = tri.p0 * (1.f - b1 - b2) + tri.p1 * b1 + tri.p2 * b2;
+        const float3 normal = mNormals[triIndex];
+        const float u0 = rng.next();
+        float3 dir = sampleCosineHemisphere(normal, u0, rng.next());
+        origin += normal * rayEpsilon;
+
+        // Le * cos / (pdfLight * pdfPos * pdfDir) with pdfDir = cos / pi.
+        const float area = 0.5f * length(cross(tri.p1 - tri.p0, tri.p2 - tri.p0));
+        float3 thp = mScene.materials[tri.materialID].emission * (area * (float)M_PI * mEmissivePower / lightPower) * invPhotonCount;
+
+        bool allSpecular = true;
+        for (uint32_t depth = 0; depth < mOptions.maxBounces; depth++)
+        {
+            Hit hit;
+            if (!intersect(origin, dir, hit)) break;
+
+            const MaterialDesc& material = mScene.materials[mScene.triangles[hit.triangle].materialID];
+            if (material.type == MaterialType::Diffuse)
+            {
+                // Photons that only went through specular bounces after leaving the light are caustic photons.
+                auto& photons = (depth > 0 && allSpecular) ? block.caustic : block.global;
+                photons.push_back({hit.pos, thp, dir});
+
+                allSpecular = false;
+                dir = sampleCosineHemisphere(hit.normal, rng.next(), rng.next());
+                thp *= material.albedo;
+                origin = hit.pos + hit.normal * rayEpsilon;
+            }
+            else if (material.type == MaterialType::Conductor)
+            {
+                dir = reflect(dir, hit.normal);
+                thp *= material.albedo;
+                origin = hit.pos + hit.normal * rayEpsilon;
+            }
+            else
+            {
+                const float eta = hit.backface ? material.ior : 1.f / material.ior;
+                const float cosI = -dot(dir, hit.normal);
+                const float sin2T = eta * eta * (1.f - cosI * cosI);
+                float fresnel = 1.f;
+                float cosT = 0.f;
+                if (sin2T < 1.f)
+                {
+                    cosT = std::sqrt(1.f - sin2T);
+                    const float rs = (eta * cosI - cosT) / (eta * cosI + cosT);
+                    const float rp = (cosI - eta * cosT) / (cosI + eta * cosT);
+                    fresnel = 0.5f * (rs * rs + rp * rp);
+                }
+
+                if (rng.next() < fresnel)
+                {
+                    dir = reflect(dir, hit.normal);
+                    origin = hit.pos + hit.normal * rayEpsilon;
+                }
+                else
+                {
+                    dir = normalize(eta * dir + (eta * cosI - cosT) * hit.normal);
+                    origin = hit.pos - hit.normal * rayEpsilon;
+                }
+                thp *= material.albedo;
+            }
+
+            if (!any(thp > float3(0.f))) break;
+        }
+    }
+}
+
+void CpuSPPM::PixelStats::update(const float3& phi, uint32_t m, float alpha, float minRadius)
+{
+    // Same update as PixelPhotonStats.slang, only a fraction alpha of the new photons is kept.
+    if (m == 0) return;
+    const float newN = n + alpha * m;
+    const float newRadius = std::max(radius * std::sqrt(newN / (n + m)), minRadius);
+    tau = (tau + phi) * (newRadius * newRadius) / (radius * radius);
+    n = newN;
+    radius = newRadius;
+}
+
+float3 CpuSPPM::gather(const float3& pos, const float3& normal, const MaterialDesc& material, const PhotonHashGrid& grid, float radius, uint32_t& photonCount) const
+{
+    // Only diffuse surfaces have a non-zero BSDF for arbitrary photon directions.
+    if (material.type != MaterialType::Diffuse) return float3(0.f);
+
+    // Photons on the back side count towards N like on the GPU, where the BSDF evaluates to zero for them.
+    float3 flux(0.f);
+    grid.query(pos, radius, [&](const CpuPhoton& photon)
+    {
+        const float cosTheta = -dot(photon.dir, normal);
+        if (cosTheta > 0.f) flux += photon.flux * cosTheta;
+        photonCount++;
+    });
+
+    return flux * material.albedo * (float)M_1_PI;
+}
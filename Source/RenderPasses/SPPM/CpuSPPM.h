@@ -0,0 +1,188 @@
+#pragma once
+#include "Falcor.h"
+#include "Scene/TriangleMesh.h"
+#include "PhotonHashGrid.h"
+
+using namespace Falcor;
+
+/** Multi-threaded CPU reference implementation of the SPPM pass.
+    It keeps the same per-pixel progressive statistics (N, tau, radius) as the GPU pass and separate caustic and global photon maps,
+    but runs without any GPU resources so it can be used on headless machines and as ground truth for the GPU pass.
+    The scene is a flat list of world space triangles with a simplified material model (diffuse, mirror, smooth dielectric).
+*/
+class CpuSPPM
+{
+public:
+    enum class MaterialType
+    {
+        Diffuse,    // Lambertian, photons are stored on these surfaces
+        Conductor,  // Perfect mirror
+        Dielectric, // Smooth glass
+    };
+
+    struct MaterialDesc
+    {
+        MaterialType type = MaterialType::Diffuse;
+        float3 albedo = float3(0.5f);
+        float3 emission = float3(0.f);
+        float ior = 1.5f;
+    };
+
+    struct Triangle
+    {
+        float3 p0, p1, p2;
+        uint32_t materialID = 0;
+    };
+
+    struct CameraDesc
+    {
+        float3 position = float3(0.f, 0.f, 1.f);
+        float3 target = float3(0.f);
+        float3 up = float3(0.f, 1.f, 0.f);
+        float fovY = 0.7854f; // radians
+        uint2 frameDim = uint2(512, 512);
+    };
+
+    struct SceneDesc
+    {
+        std::vector<MaterialDesc> materials;
+        std::vector<Triangle> triangles;
+        CameraDesc camera;
+
+        /** Add a material. Standard materials are mapped to the closest simplified material.
+            \param[in] pMaterial Material to convert.
+            \param[in] specRoughCutoff Metals with roughness below this value are treated as mirrors (same as gSpecRoughCutoff on the GPU).
+            \return Material ID.
+        */
+        uint32_t addMaterial(const ref<Material>& pMaterial, float specRoughCutoff = 0.55f);
+        uint32_t addMaterial(const MaterialDesc& desc);
+
+        /** Add all triangles of a mesh.
+        */
+        void addMesh(const TriangleMesh& mesh, const float4x4& transform, uint32_t materialID);
+
+        /** Add all triangle mesh instances of a scene and take over its camera.
+            The mesh data is read back from the GPU, curves, SDF grids and custom primitives are skipped.
+            \param[in] scene Scene to convert.
+            \param[in] frameDim Resolution of the rendered image.
+            \param[in] specRoughCutoff See addMaterial().
+        */
+        void addScene(Scene& scene, uint2 frameDim, float specRoughCutoff = 0.55f);
+    };
+
+    struct Options
+    {
+        uint32_t photonsPerIteration = 512 * 512;
+        uint32_t maxBounces = 4;
+        float causticInitRadius = 0.01f;
+        float globalInitRadius = 0.05f;
+        float alpha = 0.7f;
+        float minRadius = 0.00001f;
+        bool collectCaustic = true;
+        bool collectGlobal = true;
+        uint32_t seed = 0;
+    };
+
+    struct IterationStats
+    {
+        uint32_t iteration = 0;
+        uint32_t causticPhotons = 0;
+        uint32_t globalPhotons = 0;
+        float causticRadius = 0.f; // max per-pixel radius, the photon maps are built for it
+        float globalRadius = 0.f;
+        double traceMs = 0.0;
+        double buildMs = 0.0;
+        double gatherMs = 0.0;
+        double totalMs = 0.0;
+        double photonsPerSecond = 0.0; // emitted photon paths per second of total iteration time
+    };
+
+    CpuSPPM(SceneDesc scene, const Options& options);
+
+    /** Restart progressive rendering.
+    */
+    void reset();
+
+    /** Run one SPPM iteration (photon trace, photon map build, gather).
+    */
+    const IterationStats& runIteration();
+
+    /** Run a number of iterations and log the accumulated throughput.
+    */
+    void run(uint32_t iterations);
+
+    const std::vector<float3>& getImage() const { return mImage; }
+    const std::vector<IterationStats>& getStats() const { return mStats; }
+    uint32_t getIteration() const { return mIteration; }
+
+    /** Save the current estimate as an EXR/PFM image.
+    */
+    void saveImage(const std::filesystem::path& path) const;
+
+private:
+    struct BVHNode
+    {
+        AABB bounds;
+        uint32_t offset; // first triangle for leaves, second child for interior nodes
+        uint16_t count;  // triangle count, 0 for interior nodes
+        uint16_t axis;
+    };
+
+    struct Hit
+    {
+        float t;
+        uint32_t triangle;
+        float3 pos;
+        float3 normal; // geometric normal facing against the ray
+        bool backface;
+    };
+
+    /** Per-pixel statistics of one photon map, see PixelPhotonStats.slang.
+    */
+    struct PixelStats
+    {
+        float3 tau = float3(0.f); // accumulated flux * bsdf * cos, rescaled to the current radius
+        float n = 0.f;            // accumulated photon count
+        float radius = 0.f;
+
+        void update(const float3& phi, uint32_t m, float alpha, float minRadius);
+        float3 getRadiance(uint32_t iterationCount) const { return tau / ((float)M_PI * radius * radius * iterationCount); }
+    };
+
+    struct PhotonBlock
+    {
+        std::vector<CpuPhoton> caustic;
+        std::vector<CpuPhoton> global;
+    };
+
+    void buildBVH();
+    bool intersect(const float3& origin, const float3& dir, Hit& hit) const;
+    void buildLightDistribution();
+    void tracePhotons(uint32_t blockIndex, uint32_t start, uint32_t end, PhotonBlock& block) const;
+    float3 gather(const float3& pos, const float3& normal, const MaterialDesc& material, const PhotonHashGrid& grid, float radius, uint32_t& photonCount) const;
+
+    SceneDesc mScene;
+    Options mOptions;
+
+    std::vector<BVHNode> mNodes;
+    std::vector<uint32_t> mTriangleIndices;
+    std::vector<float3> mNormals;
+
+    std::vector<uint32_t> mEmissiveTriangles;
+    std::vector<float> mEmissiveCdf;
+    float mEmissivePower = 0.f;
+
+    std::vector<CpuPhoton> mCausticPhotons;
+    std::vector<CpuPhoton> mGlobalPhotons;
+    PhotonHashGrid mCausticGrid;
+    PhotonHashGrid mGlobalGrid;
+    std::vector<PhotonBlock> mBlocks;
+
+    uint32_t mIteration = 0;
+    float mCausticRadius = 0.f; // max per-pixel radius of the pixels with a hit
+    float mGlobalRadius = 0.f;
+    std::vector<PixelStats> mCausticPixelStats;
+    std::vector<PixelStats> mGlobalPixelStats;
+    std::vector<float3> mImage;
+    std::vector<IterationStats> mStats;
+};
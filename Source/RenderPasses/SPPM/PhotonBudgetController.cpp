@@ -0,0 +1,126 @@
+#include "PhotonBudgetController.h"
+
+namespace
+{
+const uint32_t kMinPathCount = 32 * 32;
+const float kMinGlobalStoreProbability = 1.f / 64.f;
+const double kCapacityHeadroom = 1.25; // capacity allocated on top of the stored photons when growing or shrinking
+const double kMaxStepScale = 2.0;      // TargetFrameTime: max change of the photon paths per step
+const double kMaxClimbStep = 1.25;     // MaxThroughput: max change of the photon paths per step
+const double kMinClimbStep = 1.02;
+}
+
+void PhotonBudgetController::reset(uint32_t pathCount, uint32_t maxPathCount, uint32_t maxCapacity)
+{
+    mMaxPathCount = std::max(maxPathCount, kMinPathCount);
+    mMaxCapacity = std::max(maxCapacity, 1u);
+    mPathCount = clampPathCount(pathCount);
+    mGlobalStoreProbability = 1.f;
+    mCapacity = mMaxCapacity;
+    mSettleCount = 0;
+    mTimeSum = 0.0;
+    mStoredSum[0] = mStoredSum[1] = 0.0;
+    mLastThroughput = 0.f;
+    mDirection = 1;
+    mClimbStep = kMaxClimbStep;
+    mClimbStreak = 0;
+    mShrinkCount = 0;
+}
+
+void PhotonBudgetController::setSettings(const Settings& settings)
+{
+    mSettings = settings;
+}
+
+void PhotonBudgetController::update(const Measurement& m)
+{
+    if (mSettings.mode == PhotonBudgetMode::Fixed)
+        return;
+    // The readback lags behind, skip frames that were traced with older settings.
+    if (m.pathCount != mPathCount || m.globalStoreProbability != mGlobalStoreProbability || m.timeMs <= 0.f)
+        return;
+
+    mTimeSum += m.timeMs;
+    mStoredSum[0] += m.storedPhotons[0];
+    mStoredSum[1] += m.storedPhotons[1];
+    if (++mSettleCount < kSettleFrames)
+        return;
+
+    const double timeMs = mTimeSum / mSettleCount;
+    const double caustic = mStoredSum[0] / mSettleCount;
+    const double global = mStoredSum[1] / mSettleCount;
+    const double globalUnscaled = global / mGlobalStoreProbability; // global photons that reached a diffuse surface
+    mSettleCount = 0;
+    mTimeSum = 0.0;
+    mStoredSum[0] = mStoredSum[1] = 0.0;
+
+    // Photon paths.
+    const float throughput = float((caustic + global) / (timeMs * 1e-3));
+    double pathCount = mPathCount;
+    if (mSettings.mode == PhotonBudgetMode::TargetFrameTime)
+    {
+        // The time is roughly linear in the photon paths, a damped multiplicative step converges without overshooting.
+        const double scale = std::sqrt(mSettings.targetTimeMs / timeMs);
+        pathCount *= std::clamp(scale, 1.0 / kMaxStepScale, kMaxStepScale);
+    }
+    else
+    {
+        // Keep climbing while the photons per second improve, turn around with a smaller step when they drop.
+        // The step grows again after a few improvements in a row, so the controller follows changes of the scene or view.
+        if (throughput < mLastThroughput)
+        {
+            mDirection = -mDirection;
+            mClimbStep = std::max(std::sqrt(mClimbStep), kMinClimbStep);
+            mClimbStreak = 0;
+        }
+        else if (++mClimbStreak >= 3)
+        {
+            mClimbStep = std::min(mClimbStep * mClimbStep, kMaxClimbStep);
+            mClimbStreak = 0;
+        }
+        pathCount *= mDirection > 0 ? mClimbStep : 1.0 / mClimbStep;
+    }
+    mLastThroughput = throughput;
+
+    // Caustic/global ratio, store fewer global photons when they dominate the stored photons.
+    const double f = mSettings.targetCausticFraction;
+    float globalStoreProbability = 1.f;
+    if (caustic > 0.0 && globalUnscaled > 0.0 && f > 0.0 && f < 1.0)
+        globalStoreProbability = (float)std::clamp(caustic * (1.0 - f) / (f * globalUnscaled), (double)kMinGlobalStoreProbability, 1.0);
+
+    // Stored photons of the new settings, the paths must not produce more photons than the largest buffers hold.
+    const double storedPerPath = std::max(caustic, globalUnscaled * globalStoreProbability) / mPathCount;
+    if (storedPerPath > 0.0)
+        pathCount = std::min(pathCount, mMaxCapacity / (storedPerPath * kCapacityHeadroom));
+
+    mPathCount = clampPathCount(pathCount);
+    mGlobalStoreProbability = globalStoreProbability;
+
+    // Capacity with hysteresis.
+    const double required = storedPerPath * mPathCount;
+    if (required > mCapacity)
+    {
+        mCapacity = (uint32_t)std::min(required * kCapacityHeadroom, (double)mMaxCapacity);
+        mShrinkCount = 0;
+    }
+    else if (required * 4.0 < mCapacity)
+    {
+        if (++mShrinkCount >= kShrinkFrames / kSettleFrames)
+        {
+            mCapacity = std::max((uint32_t)(required * kCapacityHeadroom), 1u);
+            mShrinkCount = 0;
+        }
+    }
+    else
+    {
+        mShrinkCount = 0;
+    }
+}
+
+uint32_t PhotonBudgetController::clampPathCount(double pathCount) const
+{
+    // The trace pass is dispatched over a square of photon paths.
+    const double clamped = std::clamp(pathCount, (double)kMinPathCount, (double)mMaxPathCount);
+    const uint32_t dim = std::max((uint32_t)std::floor(std::sqrt(clamped) + 0.5), 1u);
+    return dim * dim <= mMaxPathCount ? dim * dim : (dim - 1) * (dim - 1);
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "Falcor.h"
+
+using namespace Falcor;
+
+// How the number of photons per iteration is chosen
+enum class PhotonBudgetMode : uint32_t
+{
+    Fixed,           // photon paths set in the UI, buffers sized for the max photon count
+    TargetFrameTime, // scale the photon paths until the SPPM stages take the target time per iteration
+    MaxThroughput,   // hill-climb the photon paths to the highest stored photons per second
+};
+FALCOR_ENUM_INFO(
+    PhotonBudgetMode,
+    {
+        {PhotonBudgetMode::Fixed, "Fixed"},
+        {PhotonBudgetMode::TargetFrameTime, "TargetFrameTime"},
+        {PhotonBudgetMode::MaxThroughput, "MaxThroughput"},
+    }
+);
+FALCOR_ENUM_REGISTER(PhotonBudgetMode);
+
+/** Chooses the photon paths traced per iteration, the fraction of global photons that is stored and the photon buffer capacity.
+    Works on measurements read back from the GPU a few frames late. Measurements of frames traced with other settings
+    than the current ones are ignored, and the settings only change after kSettleFrames measurements of the current ones.
+    The capacity only grows when the stored photons do not fit and only shrinks when they use less than a quarter of it
+    for kShrinkFrames measurements, so the photon buffers and AS are not reallocated on every change of the photon paths.
+*/
+class PhotonBudgetController
+{
+public:
+    struct Settings
+    {
+        PhotonBudgetMode mode = PhotonBudgetMode::Fixed;
+        float targetTimeMs = 16.f;          ///< TargetFrameTime: GPU time of the SPPM stages per iteration.
+        float targetCausticFraction = 0.25f; ///< Fraction of the stored photons that should be caustic photons, global photons are stored with a lower probability to reach it.
+    };
+
+    /** Measurement of one iteration.
+    */
+    struct Measurement
+    {
+        float timeMs = 0.f;           ///< GPU time of the SPPM stages.
+        uint32_t pathCount = 0;       ///< Photon paths traced.
+        float globalStoreProbability = 1.f;
+        uint32_t storedPhotons[2] = {}; ///< Caustic and global photons stored, including photons dropped by the buffer capacity.
+    };
+
+    static constexpr uint32_t kSettleFrames = 4;
+    static constexpr uint32_t kShrinkFrames = 60;
+
+    /** Restart the controller, also needed after changing the mode.
+        \param[in] pathCount Photon paths to start with, the UI value.
+        \param[in] maxPathCount Upper bound of the photon paths.
+        \param[in] maxCapacity Upper bound of the photons stored per photon map.
+    */
+    void reset(uint32_t pathCount, uint32_t maxPathCount, uint32_t maxCapacity);
+
+    void update(const Measurement& measurement);
+
+    void setSettings(const Settings& settings);
+    const Settings& getSettings() const { return mSettings; }
+
+    uint32_t getPathCount() const { return mPathCount; } ///< Always a square, the trace pass is dispatched over sqrt(pathCount)^2 paths.
+    float getGlobalStoreProbability() const { return mGlobalStoreProbability; }
+    uint32_t getCapacity() const { return mCapacity; }
+    float getThroughput() const { return mLastThroughput; } ///< Stored photons per second of the last settled measurement.
+
+private:
+    uint32_t clampPathCount(double pathCount) const;
+
+    Settings mSettings;
+    uint32_t mMaxPathCount = 1;
+    uint32_t mMaxCapacity = 1;
+
+    uint32_t mPathCount = 1;
+    float mGlobalStoreProbability = 1.f;
+    uint32_t mCapacity = 1;
+
+    // Measurements of the current settings
+    uint32_t mSettleCount = 0;
+    double mTimeSum = 0.0;
+    double mStoredSum[2] = {};
+
+    // MaxThroughput hill climbing
+    float mLastThroughput = 0.f;
+    int mDirection = 1;
+    double mClimbStep = 1.0;
+    uint32_t mClimbStreak = 0;
+
+    uint32_t mShrinkCount = 0;
+};
@@ -0,0 +1,40 @@
+#include "PhotonHashGrid.h"
+#include "Utils/Threading.h"
+
+void PhotonHashGrid::build(const std::vector<CpuPhoton>& photons, float radius, bool parallel)
+{
+    FALCOR_CHECK(radius > 0.f, "Photon gather radius must be positive.");
+
+    mpPhotons = &photons;
+    mRadius = radius;
+    mCellSize = 2.f * radius;
+    mInvCellSize = 1.f / mCellSize;
+
+    // Use twice as many buckets as photons to keep the number of collisions low.
+    const uint32_t photonCount = (uint32_t)photons.size();
+    const uint32_t bucketCount = std::max(1u, fstd::bit_ceil(2u * photonCount));
+    mBucketStart.assign(bucketCount + 1, 0);
+    mPhotonIndices.resize(photonCount);
+    mPhotonBuckets.resize(photonCount);
+
+    // Hash photons.
+    auto hashRange = [&](size_t start, size_t end)
+    {
+        for (size_t i = start; i < end; i++)
+            mPhotonBuckets[i] = hashCell(getCell(photons[i].pos));
+    };
+    if (parallel)
+        Threading::parallelFor(0, photonCount, hashRange);
+    else
+        hashRange(0, photonCount);
+
+    // Counting sort. The scatter is done serially in photon order to keep the layout deterministic.
+    for (uint32_t i = 0; i < photonCount; i++)
+        mBucketStart[mPhotonBuckets[i] + 1]++;
+    for (uint32_t i = 0; i < bucketCount; i++)
+        mBucketStart[i + 1] += mBucketStart[i];
+
+    std::vector<uint32_t> offsets(mBucketStart.begin(), mBucketStart.end() - 1);
+    for (uint32_t i = 0; i < photonCount; i++)
+        mPhotonIndices[offsets[mPhotonBuckets[i]]++] = i;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "Falcor.h"
+
+using namespace Falcor;
+
+/** Photon record used by the CPU photon maps.
+*/
+struct CpuPhoton
+{
+    float3 pos;
+    float3 flux;
+    float3 dir; // direction of travel when the photon hit the surface
+};
+
+/** Spatial hash grid over a list of photons.
+    The cell size is twice the gather radius, so a radius query touches at most 2x2x2 cells.
+    The grid is rebuilt every iteration with a counting sort over the hashed cell indices,
+    so the cell size follows the shrinking max SPPM radius.
+*/
+class PhotonHashGrid
+{
+public:
+    /** Build the grid.
+        \param[in] photons Photons to insert. The grid keeps a pointer to this list, it must outlive the grid.
+        \param[in] radius Max gather radius of the following queries.
+        \param[in] parallel Hash the photons on the global task scheduler.
+    */
+    void build(const std::vector<CpuPhoton>& photons, float radius, bool parallel = true);
+
+    /** Call func(const CpuPhoton&) for every photon within the build radius of p.
+    */
+    template<typename F>
+    void query(const float3& p, F&& func) const
+    {
+        query(p, mRadius, std::forward<F>(func));
+    }
+
+    /** Call func(const CpuPhoton&) for every photon within radius of p. The radius must not be larger than the build radius.
+    */
+    template<typename F>
+    void query(const float3& p, float radius, F&& func) const
+    {
+        if (!mpPhotons || mpPhotons->empty()) return;
+        FALCOR_ASSERT(radius <= mRadius);
+
+        const float radius2 = radius * radius;
+        const int3 cellMin = getCell(p - radius);
+        // The cells are 2 * radius wide, so the query spans at most two cells per axis.
+        // Clamp like the GPU gather so rounding at cell borders can't add a third one.
+        const int3 cellMax = min(getCell(p + radius), cellMin + 1);
+
+        // Different cells may hash to the same bucket, make sure each bucket is visited once.
+        uint32_t visited[8];
+        uint32_t visitedCount = 0;
+
+        for (int z = cellMin.z; z <= cellMax.z; z++)
+        for (int y = cellMin.y; y <= cellMax.y; y++)
+        for (int x = cellMin.x; x <= cellMax.x; x++)
+        {
+            const uint32_t bucket = hashCell(int3(x, y, z));
+            if (std::find(visited, visited + visitedCount, bucket) != visited + visitedCount) continue;
+            FALCOR_ASSERT(visitedCount < 8);
+            visited[visitedCount++] = bucket;
+
+            for (uint32_t i = mBucketStart[bucket]; i < mBucketStart[bucket + 1]; i++)
+            {
+                const CpuPhoton& photon = (*mpPhotons)[mPhotonIndices[i]];
+                const float3 d = photon.pos - p;
+                if (dot(d, d) < radius2) func(photon);
+            }
+        }
+    }
+
+    float getRadius() const { return mRadius; }
+    float getCellSize() const { return mCellSize; }
+    uint32_t getBucketCount() const { return (uint32_t)mBucketStart.size() - 1; }
+    uint32_t getPhotonCount() const { return (uint32_t)mPhotonIndices.size(); }
+
+private:
+    int3 getCell(const float3& p) const
+    {
+        return int3(std::floor(p.x * mInvCellSize), std::floor(p.y * mInvCellSize), std::floor(p.z * mInvCellSize));
+    }
+
+    uint32_t hashCell(const int3& cell) const
+    {
+        // Teschner et al. 2003, "Optimized Spatial Hashing for Collision Detection of Deformable Objects".
+        const uint32_t h = ((uint32_t)cell.x * 73856093u) ^ ((uint32_t)cell.y * 19349663u) ^ ((uint32_t)cell.z * 83492791u);
+        return h & (getBucketCount() - 1);
+    }
+
+    const std::vector<CpuPhoton>* mpPhotons = nullptr;
+    float mRadius = 0.f;
+    float mCellSize = 0.f;
+    float mInvCellSize = 0.f;
+    std::vector<uint32_t> mBucketStart = { 0, 0 }; // Start offset of each bucket in mPhotonIndices, with one extra entry at the end.
+    std::vector<uint32_t> mPhotonIndices;          // Photon indices sorted by bucket.
+    std::vector<uint32_t> mPhotonBuckets;          // Scratch: bucket of each photon.
+};
@@ -1,11 +1,12 @@
 #include "SPPM.h"
+#include "CpuSPPM.h"
 #include "RenderGraph/RenderPassHelpers.h"
 #include "RenderGraph/RenderPassStandardFlags.h"
 
 extern "C" FALCOR_API_EXPORT void registerPlugin(Falcor::PluginRegistry & registry)
 {
     registry.registerClass<RenderPass, SPPM>();
-    //ScriptBindings::registerBinding(MyPathTracer::registerBindings);
+    ScriptBindings::registerBinding(SPPM::registerBindings);
 }
 
 namespace
@@ -13,8 +14,14 @@ namespace
 const char kTracePhoton[] = "RenderPasses/SPPM/TracePhoton.rt.slang";
 const char kCollectPhoton[] = "RenderPasses/SPPM/CollectPhoton.rt.slang";
 const char kShowAS[] = "RenderPasses/SPPM/ShowAS.rt.slang";
+const char kCollectPhotonGrid[] = "RenderPasses/SPPM/CollectPhotonGrid.cs.slang";
+const char kPrepareVisiblePoints[] = "RenderPasses/SPPM/PrepareVisiblePoints.cs.slang";
+const char kPhotonAABBs[] = "RenderPasses/SPPM/PhotonAABBs.cs.slang";
+const char kPhotonHashGridBuild[] = "RenderPasses/SPPM/PhotonHashGridBuild.cs.slang";
 const uint32_t kMaxPayloadSize = 128u;
 const uint32_t kMaxAttributeSize = 8u;
+const uint32_t kSeedTextureSize = 1024u; // photon paths per dimension are limited by the seed texture
+const uint32_t kPackedVisiblePointSize = 64u; // sizeof(PackedVisiblePoint) in VisiblePoint.slang
 const uint32_t kMaxRecursionDepth = 5u;
 
 const ChannelList kInputChannels =
@@ -34,6 +41,7 @@ SPPM::SPPM(ref<Device> pDevice, const Properties& props) : RenderPass(pDevice)
     mpSampleGenerator = SampleGenerator::create(mpDevice, SAMPLE_GENERATOR_UNIFORM);
     mpPixelStats = std::make_unique<PixelStats>(mpDevice);
     mpPixelDebug = std::make_unique<PixelDebug>(mpDevice);
+    mPhotonBudget.reset(photonNumX * photonNumX, kSeedTextureSize * kSeedTextureSize, mMaxPhotonCount * mMaxPhotonCount);
     // don't need values in the script
     // control the parameters using ImGUI
 }
@@ -55,10 +63,148 @@ void SPPM::resetPhotonCounter(RenderContext* pRenderContext)
         uint64_t zero = 0;
         mPhotonCounter.reset = mpDevice->createBuffer(sizeof(uint64_t), ResourceBindFlags::None, MemoryType::DeviceLocal, &zero);
         //uint32_t oneInit[2] = { 1,1 };
-        mPhotonCounter.cpuReadback = mpDevice->createBuffer(sizeof(uint64_t), ResourceBindFlags::None, MemoryType::ReadBack, nullptr);
+        mPhotonCounter.radiusRange = mpDevice->createBuffer(2 * sizeof(float4));
+        mPhotonCounter.cpuReadback = mpDevice->createBuffer(PhotonCounter::kSlotSize * PhotonCounter::kReadbackCount, ResourceBindFlags::None, MemoryType::ReadBack, nullptr);
+        if (!mPhotonCounter.fence)
+            mPhotonCounter.fence = mpDevice->createFence();
+        for (auto& slot : mPhotonCounter.slots)
+            slot = {};
+        mPhotonCounter.stageMask = 0;
+        mPhotonCounter.nextSlot = 0;
+    }
+    // prepare stage timers
+    {
+        for (auto& timers : mPhotonCounter.stageTimers)
+            for (auto& timer : timers)
+                if (!timer)
+                    timer = GpuTimer::create(mpDevice);
+        for (auto& time : mStageTimes)
+            time = -1.f;
+    }
+}
+
+void SPPM::readbackPhotonCounter(RenderContext* pRenderContext)
+{
+    FALCOR_PROFILE(pRenderContext, "readbackPhotonCounter");
+    auto& counter = mPhotonCounter;
+    auto& slot = counter.slots[counter.nextSlot];
+
+    // The slot we are about to overwrite must have landed. This only blocks if the GPU is more than kReadbackCount frames behind.
+    if (slot.pending && counter.fence->getCurrentValue() < slot.fenceValue)
+    {
+        counter.stallCount++;
+        counter.fence->wait(slot.fenceValue);
+    }
+    resolvePhotonCounterReadbacks();
+    pRenderContext->getProfiler()->recordCounter("SPPM caustic photons", mPhotonCounts[0]);
+    pRenderContext->getProfiler()->recordCounter("SPPM global photons", mPhotonCounts[1]);
+
+    // Queue the copy for this frame and signal the fence without waiting.
+    for (uint32_t i = 0; i < (uint32_t)PhotonStage::Count; i++)
+        if (counter.stageMask & (1u << i))
+            counter.stageTimers[counter.nextSlot][i]->resolve();
+    const uint64_t slotOffset = counter.nextSlot * PhotonCounter::kSlotSize;
+    pRenderContext->copyBufferRegion(counter.cpuReadback.get(), slotOffset, counter.counter.get(), 0, sizeof(uint64_t));
+    // Max of the active radius (y component of the max), the photon AABBs and grid cells of the next frames are sized for it.
+    // Radii only shrink until SPPM restarts, so a max that is a few frames old is still conservative.
+    if (!mpRadiusReduction)
+        mpRadiusReduction = std::make_unique<ParallelReduction>(mpDevice);
+    mpRadiusReduction->execute<float4>(pRenderContext, mpPhotonRadius, ParallelReduction::Type::MinMax, nullptr, counter.radiusRange, 0);
+    pRenderContext->copyBufferRegion(counter.cpuReadback.get(), slotOffset + 2 * sizeof(uint32_t), counter.radiusRange.get(), sizeof(float4) + sizeof(float), sizeof(float));
+    pRenderContext->submit(false);
+    slot.fenceValue = pRenderContext->signal(counter.fence.get());
+    // The hash grid is built from the GPU photon count and only limited by the buffer capacity.
+    const bool useGrid = mGatherMode != PhotonGatherMode::AccelerationStructure;
+    slot.asSizes[0] = useGrid ? mPhotonCapacity : mCausticPhotonBuffers.maxPhotonCount;
+    slot.asSizes[1] = useGrid ? mPhotonCapacity : mGlobalPhotonBuffers.maxPhotonCount;
+    slot.pathCount = photonNumX * photonNumX;
+    slot.globalStoreProbability = mPhotonBudget.getGlobalStoreProbability();
+    slot.stageMask = counter.stageMask;
+    slot.pending = true;
+    counter.stageMask = 0;
+    counter.nextSlot = (counter.nextSlot + 1) % PhotonCounter::kReadbackCount;
+}
+
+void SPPM::resolvePhotonCounterReadbacks()
+{
+    auto& counter = mPhotonCounter;
+    const uint64_t completedValue = counter.fence->getCurrentValue();
+    const uint32_t* pData = nullptr;
+
+    // Walk the ring from the oldest slot and consume completed readbacks in submission order.
+    for (uint32_t i = 0; i < PhotonCounter::kReadbackCount; i++)
+    {
+        const uint32_t index = (counter.nextSlot + i) % PhotonCounter::kReadbackCount;
+        auto& slot = counter.slots[index];
+        if (!slot.pending)
+            continue;
+        if (slot.fenceValue > completedValue)
+            break;
+
+        if (!pData)
+            pData = reinterpret_cast<const uint32_t*>(counter.cpuReadback->map());
+        const uint32_t* pSlot = pData + index * PhotonCounter::kSlotSize / sizeof(uint32_t);
+        std::memcpy(mPhotonCounts.data(), pSlot, sizeof(uint32_t) * 2);
+        float maxRadius;
+        std::memcpy(&maxRadius, pSlot + 2, sizeof(float));
+        if (maxRadius > 0.f) // no pixel had a valid hit otherwise
+            mGlobalRadius = std::max(maxRadius, kMinPhotonRadius);
+        slot.pending = false;
+        updateStageTimes(index);
+
+        PhotonBudgetController::Measurement measurement;
+        for (uint32_t i = 0; i < (uint32_t)PhotonStage::Count; i++)
+            if (slot.stageMask & (1u << i))
+                measurement.timeMs += (float)counter.stageTimers[index][i]->getElapsedTime();
+        measurement.pathCount = slot.pathCount;
+        measurement.globalStoreProbability = slot.globalStoreProbability;
+        measurement.storedPhotons[0] = mPhotonCounts[0];
+        measurement.storedPhotons[1] = mPhotonCounts[1];
+        mPhotonBudget.update(measurement);
+
+        // The AS for that frame was sized from an older count, photons beyond the AS size were dropped.
+        // Photons beyond the photon buffer capacity are dropped regardless of the lag and are not counted here.
+        const uint32_t capacity = mPhotonCapacity;
+        auto overflowed = [&](int i) { return mPhotonCounts[i] > slot.asSizes[i] && slot.asSizes[i] < capacity; };
+        if (overflowed(0) || overflowed(1))
+        {
+            counter.overflowCount++;
+            logWarning(
+                "SPPM: Photon budget overflow due to readback latency (caustic {} / {}, global {} / {}). Overflow count: {}.",
+                mPhotonCounts[0], slot.asSizes[0], mPhotonCounts[1], slot.asSizes[1], counter.overflowCount
+            );
+        }
     }
 }
 
+void SPPM::updateStageTimes(uint32_t slot)
+{
+    // Exponential moving average, the times of a single frame are too noisy to read in the UI.
+    // Stages that were skipped in that frame (e.g. the visible points without the cache) are shown as not run.
+    const float kWeight = 0.05f;
+    for (uint32_t i = 0; i < (uint32_t)PhotonStage::Count; i++)
+    {
+        if (!(mPhotonCounter.slots[slot].stageMask & (1u << i)))
+        {
+            mStageTimes[i] = -1.f;
+            continue;
+        }
+        const float time = (float)mPhotonCounter.stageTimers[slot][i]->getElapsedTime();
+        mStageTimes[i] = mStageTimes[i] < 0.f ? time : mStageTimes[i] + (time - mStageTimes[i]) * kWeight;
+    }
+}
+
+void SPPM::beginStage(PhotonStage stage)
+{
+    mPhotonCounter.stageMask |= 1u << (uint32_t)stage;
+    mPhotonCounter.stageTimers[mPhotonCounter.nextSlot][(uint32_t)stage]->begin();
+}
+
+void SPPM::endStage(PhotonStage stage)
+{
+    mPhotonCounter.stageTimers[mPhotonCounter.nextSlot][(uint32_t)stage]->end();
+}
+
 void SPPM::execute(RenderContext* pRenderContext, const RenderData& renderData)
 {
     // Reset if options affecting output are changed
@@ -79,6 +225,10 @@ void SPPM::execute(RenderContext* pRenderContext, const RenderData& renderData)
         return;
     }
 
+    // Per-pixel statistics are restarted with the new frame size
+    mFrameDim = renderData.getDefaultTextureDims();
+    preparePixelStats(mFrameDim);
+
     // Reset frame count if camera moves or option changes
     if (mResetIteration || is_set(mpScene->getUpdates(), Scene::UpdateFlags::CameraMoved))
     {
@@ -98,6 +248,8 @@ void SPPM::execute(RenderContext* pRenderContext, const RenderData& renderData)
         mGlobalRadius = mGlobalInitRadius;
         resetPhotonCounter(pRenderContext);
         mPhotonCounts[0] = mPhotonCounts[1] = photonNumX * photonNumX * 4; // used for building AS for the first frame
+        pRenderContext->clearUAV(mpPhotonStats->getUAV().get(), float4(0.f));
+        pRenderContext->clearUAV(mpPhotonRadius->getUAV().get(), float4(mGlobalInitRadius, 0.f, 0.f, 0.f));
     }
     // Request the light collection if emissive lights are enabled.
     if (mpScene->getRenderSettings().useEmissiveLights)
@@ -121,11 +273,22 @@ void SPPM::execute(RenderContext* pRenderContext, const RenderData& renderData)
         // If the maximum photon count is updated
         // It means that we want to resize the photon buffer and blas
         updateMaxPhotonCount = false;
+        mPhotonBudget.reset(photonNumX * photonNumX, kSeedTextureSize * kSeedTextureSize, mMaxPhotonCount * mMaxPhotonCount);
+        mCreateBuffer = true;
+        mRebuildAS = true;
+    }
+    // The adaptive budget modes pick the photon paths, the buffers are only reallocated when the controller changes the capacity.
+    if (mPhotonBudget.getSettings().mode != PhotonBudgetMode::Fixed)
+        photonNumX = (uint)std::lround(std::sqrt((double)mPhotonBudget.getPathCount()));
+    if (mPhotonBudget.getCapacity() != mPhotonCapacity)
+    {
+        mPhotonCapacity = mPhotonBudget.getCapacity();
         mCreateBuffer = true;
         mRebuildAS = true;
     }
     if (mCreateBuffer)
     {
+        mpCompactPhotonAABBs = nullptr;
         preparePhotonBuffers(mCausticPhotonBuffers);
         preparePhotonBuffers(mGlobalPhotonBuffers);
         mCreateBuffer = false;
@@ -141,31 +304,55 @@ void SPPM::execute(RenderContext* pRenderContext, const RenderData& renderData)
     }
 
     //mpEmissivePowerSampler->update(pRenderContext);
+    beginStage(PhotonStage::Trace);
     tracePhotonPass(pRenderContext, renderData);
+    endStage(PhotonStage::Trace);
 
     // estimate photons based on last iteration
     mPhotonASSizes.clear();
-    mCausticPhotonBuffers.maxPhotonCount = std::min((uint)(mPhotonCounts[0] * photonASScale), mMaxPhotonCount * mMaxPhotonCount);
-    mGlobalPhotonBuffers.maxPhotonCount = std::min((uint)(mPhotonCounts[1] * photonASScale), mMaxPhotonCount * mMaxPhotonCount);
-    buildBLAS(pRenderContext, mCausticPhotonBuffers);
-    buildBLAS(pRenderContext, mGlobalPhotonBuffers);
-    buildTLAS(pRenderContext);
+    mCausticPhotonBuffers.maxPhotonCount = std::min((uint)(mPhotonCounts[0] * photonASScale), mPhotonCapacity);
+    mGlobalPhotonBuffers.maxPhotonCount = std::min((uint)(mPhotonCounts[1] * photonASScale), mPhotonCapacity);
+    beginStage(PhotonStage::Build);
+    if (mGatherMode == PhotonGatherMode::AccelerationStructure)
+    {
+        // with the compact photon record both maps share one AABB buffer, derive the AABBs of each map right before its build
+        if (mUseCompactPhotons) derivePhotonAABBs(pRenderContext, mCausticPhotonBuffers, 0, mCausticInitRadius);
+        buildBLAS(pRenderContext, mCausticPhotonBuffers);
+        if (mUseCompactPhotons) derivePhotonAABBs(pRenderContext, mGlobalPhotonBuffers, 1, mGlobalRadius);
+        buildBLAS(pRenderContext, mGlobalPhotonBuffers);
+        buildTLAS(pRenderContext);
+    }
+    else
+    {
+        // grids are built with the gather radius of this iteration
+        buildPhotonGrid(pRenderContext, mCausticPhotonBuffers, 0, mCausticRadius);
+        buildPhotonGrid(pRenderContext, mGlobalPhotonBuffers, 1, mGlobalRadius);
+    }
+    endStage(PhotonStage::Build);
+
+    if (mUseVisiblePointCache)
+    {
+        beginStage(PhotonStage::VisiblePoints);
+        prepareVisiblePointsPass(pRenderContext, renderData);
+        endStage(PhotonStage::VisiblePoints);
+    }
 
     //showASPass(pRenderContext, renderData);
-    collectPhotonPass(pRenderContext, renderData); // after building AS for photons, we can start camera tracing
+    beginStage(PhotonStage::Gather);
+    if (mGatherMode == PhotonGatherMode::HashGridCompute)
+        collectPhotonGridPass(pRenderContext, renderData);
+    else
+        collectPhotonPass(pRenderContext, renderData); // after building AS for photons, we can start camera tracing
+    endStage(PhotonStage::Gather);
     mFrameCount++;
 
-    // copy photon counter to CPU read back buffer and shown in UI later
-    pRenderContext->copyBufferRegion(mPhotonCounter.cpuReadback.get(), 0, mPhotonCounter.counter.get(), 0, sizeof(uint64_t));
-    void* data = mPhotonCounter.cpuReadback->map();
-    std::memcpy(mPhotonCounts.data(), data, sizeof(uint32_t) * 2);
+    // copy photon counter to CPU read back buffer, the counts are picked up a few frames later for sizing the AS and shown in UI
+    readbackPhotonCounter(pRenderContext);
 
-    // update photon radius
+    // update caustic photon radius, the global photons use per-pixel radii updated in the collect pass
     float itF = static_cast<float>(mFrameCount);
-    mGlobalRadius *= sqrt((itF + mSPPMAlpha) / (itF + 1.0f));
     mCausticRadius *= sqrt((itF + mSPPMAlpha) / (itF + 1.0f));
     //Clamp to min radius
-    mGlobalRadius = std::max(mGlobalRadius, kMinPhotonRadius);
     mCausticRadius = std::max(mCausticRadius, kMinPhotonRadius);
     if (mResetCB)
         mResetCB = false;
@@ -183,17 +370,21 @@ void SPPM::tracePhotonPass(RenderContext* pRenderContext, const RenderData& rend
 
     mTracePhotonPass.pProgram->addDefine("USE_IMPORTANCE_SAMPLING", "1");
     //mTracePhotonPass.pProgram->addDefine("INFO_TEX_HEIGHT", std::to_string(mPhotonBufferHeight));
-    mTracePhotonPass.pProgram->addDefine("TOTAL_PHOTON_COUNT", std::to_string(photonNumX * photonNumX));
+    if (mTracePhotonPass.pProgram->addDefine("PHOTON_RECORD_COMPACT", mUseCompactPhotons ? "1" : "0"))
+        mTracePhotonPass.pVars = nullptr; // record layout changed, recreate vars for the new program version
 
     if (!mTracePhotonPass.pVars)
         prepareVars(mTracePhotonPass);
     FALCOR_ASSERT(mTracePhotonPass.pVars);
 
     auto var = mTracePhotonPass.pVars->getRootVar();
-    var["PerFrame"]["gFrameCount"] = mFrameCount;
-    var["PerFrame"]["gGlobalRadius"] = mGlobalRadius;
-    var["PerFrame"]["gCausticRadius"] = mCausticInitRadius;
-    var["PerFrame"]["gSeed"] = mUseFixedSeed ? mFixedSeed : mFrameCount;
+    const auto& bindings = mTracePhotonBindings;
+    var[bindings.frameCount] = mFrameCount;
+    var[bindings.globalRadius] = mGlobalRadius;
+    var[bindings.causticRadius] = mCausticInitRadius;
+    var[bindings.seed] = mUseFixedSeed ? mFixedSeed : mFrameCount;
+    bindPhotonQuantization(var[bindings.photonQuantization]);
+    var[bindings.globalStoreProbability] = mPhotonBudget.getGlobalStoreProbability();
     var["gSeeds"] = mSeeds;
     //var["PerFrame"]["gSeed"] = 0;
     if (mResetCB)
@@ -209,8 +400,8 @@ void SPPM::tracePhotonPass(RenderContext* pRenderContext, const RenderData& rend
     {
         auto& buffers = (i == 0) ? mCausticPhotonBuffers : mGlobalPhotonBuffers;
         pRenderContext->resourceBarrier(buffers.aabbs.get(), Resource::State::UnorderedAccess);
-        var["gPhotonAABB"][i] = buffers.aabbs;
-        var["gPhotonInfo"][i] = buffers.photonInfo;
+        var[bindings.photonAABB[i]] = buffers.aabbs;
+        var[bindings.photonInfo[i]] = buffers.photonInfo;
     }
 
     var["gPhotonCounter"] = mPhotonCounter.counter;
@@ -245,6 +436,13 @@ void SPPM::collectPhotonPass(RenderContext* pRenderContext, const RenderData& re
 
     mCollectPhotonPass.pProgram->addDefines(getValidResourceDefines(kInputChannels, renderData));
     mCollectPhotonPass.pProgram->addDefines(getValidResourceDefines(kOutputChannels, renderData));
+    const bool useGrid = mGatherMode == PhotonGatherMode::HashGridInline;
+    if (mCollectPhotonPass.pProgram->addDefine("PHOTON_GATHER_HASH_GRID", useGrid ? "1" : "0"))
+        mCollectPhotonPass.pVars = nullptr; // gather mode changed, recreate vars for the new program version
+    if (mCollectPhotonPass.pProgram->addDefine("USE_VISIBLE_POINT_CACHE", mUseVisiblePointCache ? "1" : "0"))
+        mCollectPhotonPass.pVars = nullptr;
+    if (mCollectPhotonPass.pProgram->addDefine("PHOTON_RECORD_COMPACT", mUseCompactPhotons ? "1" : "0"))
+        mCollectPhotonPass.pVars = nullptr;
 
     if (!mCollectPhotonPass.pVars)
         prepareVars(mCollectPhotonPass);
@@ -256,6 +454,8 @@ void SPPM::collectPhotonPass(RenderContext* pRenderContext, const RenderData& re
     var["PerFrame"]["gCausticRadius"] = mCausticRadius;
     var["PerFrame"]["gGlobalRadius"] = mGlobalRadius;
     var["PerFrame"]["gSeed"] = mUseFixedSeed ? 0 : mFrameCount;
+    var["PerFrame"]["gSPPMAlpha"] = mSPPMAlpha;
+    var["PerFrame"]["gMinRadius"] = kMinPhotonRadius;
     if (mResetCB)
     {
         var["CB"]["gCollectGlobalPhotons"] = true;
@@ -274,13 +474,17 @@ void SPPM::collectPhotonPass(RenderContext* pRenderContext, const RenderData& re
         bind(channel);
     for (auto channel : kOutputChannels)
         bind(channel);
+    var["gPhotonStats"] = mpPhotonStats;
+    var["gPhotonRadius"] = mpPhotonRadius;
+    var["gVisiblePoints"] = mpVisiblePoints;
 
-    var["gPhotonAS"].setAccelerationStructure(mTlasInfo.falcorTlas);
+    var["gPhotonAS"].setAccelerationStructure(mTlasInfo.falcorTlas); // stays bound in grid mode, but is not traced
+    if (useGrid)
+        bindPhotonGrids(var);
     for (int i = 0; i < 2; i++)
     {
         auto& buffer = (i == 0) ? mCausticPhotonBuffers : mGlobalPhotonBuffers;
-        var["gPhotonAABB"][i] = buffer.aabbs;
-        var["gPhotonInfo"][i] = buffer.photonInfo;
+        bindPhotonMap(var["gPhotonMaps"][i], buffer);
     }
 
     if (mpPixelDebug) mpPixelDebug->prepareProgram(mCollectPhotonPass.pProgram, var);
@@ -294,6 +498,84 @@ void SPPM::collectPhotonPass(RenderContext* pRenderContext, const RenderData& re
     if (mpPixelDebug) mpPixelDebug->endFrame(pRenderContext);
 }
 
+void SPPM::collectPhotonGridPass(RenderContext* pRenderContext, const RenderData& renderData)
+{
+    FALCOR_PROFILE(pRenderContext, "CollectPass");
+
+    if (!mpCollectPhotonGridPass)
+    {
+        ProgramDesc desc;
+        desc.addShaderModules(mpScene->getShaderModules());
+        desc.addShaderLibrary(kCollectPhotonGrid).csEntry("main");
+        desc.addTypeConformances(mpScene->getTypeConformances());
+
+        auto defines = mpScene->getSceneDefines();
+        defines.add(mpSampleGenerator->getDefines());
+        mpCollectPhotonGridPass = ComputePass::create(mpDevice, desc, defines, true);
+    }
+    mpCollectPhotonGridPass->getProgram()->addDefines(getValidResourceDefines(kInputChannels, renderData));
+    mpCollectPhotonGridPass->getProgram()->addDefines(getValidResourceDefines(kOutputChannels, renderData));
+    if (mpCollectPhotonGridPass->getProgram()->addDefine("USE_VISIBLE_POINT_CACHE", mUseVisiblePointCache ? "1" : "0"))
+        mpCollectPhotonGridPass->setVars(nullptr); // recreate vars for the new program version
+    if (mpCollectPhotonGridPass->getProgram()->addDefine("PHOTON_RECORD_COMPACT", mUseCompactPhotons ? "1" : "0"))
+        mpCollectPhotonGridPass->setVars(nullptr);
+
+    const uint2 targetDim = renderData.getDefaultTextureDims();
+    FALCOR_ASSERT(targetDim.x > 0 && targetDim.y > 0);
+
+    auto var = mpCollectPhotonGridPass->getRootVar();
+    mpScene->bindShaderData(var["gScene"]);
+    mpSampleGenerator->bindShaderData(var);
+
+    var["PerFrame"]["gFrameCount"] = mFrameCount;
+    var["PerFrame"]["gCausticRadius"] = mCausticRadius;
+    var["PerFrame"]["gGlobalRadius"] = mGlobalRadius;
+    var["PerFrame"]["gSeed"] = mUseFixedSeed ? 0 : mFrameCount;
+    var["PerFrame"]["gFrameDim"] = targetDim;
+    var["PerFrame"]["gSPPMAlpha"] = mSPPMAlpha;
+    var["PerFrame"]["gMinRadius"] = kMinPhotonRadius;
+    var["CB"]["gCollectGlobalPhotons"] = true;
+    var["CB"]["gCollectCausticPhotons"] = true;
+
+    for (auto channel : kInputChannels)
+        var[channel.texname] = renderData.getTexture(channel.name);
+    for (auto channel : kOutputChannels)
+        var[channel.texname] = renderData.getTexture(channel.name);
+    var["gPhotonStats"] = mpPhotonStats;
+    var["gPhotonRadius"] = mpPhotonRadius;
+    var["gVisiblePoints"] = mpVisiblePoints;
+    bindPhotonGrids(var);
+
+    if (enableCollect) mpCollectPhotonGridPass->execute(pRenderContext, uint3(targetDim, 1));
+}
+
+void SPPM::prepareVisiblePointsPass(RenderContext* pRenderContext, const RenderData& renderData)
+{
+    FALCOR_PROFILE(pRenderContext, "PrepareVisiblePoints");
+
+    if (!mpPrepareVisiblePointsPass)
+    {
+        ProgramDesc desc;
+        desc.addShaderModules(mpScene->getShaderModules());
+        desc.addShaderLibrary(kPrepareVisiblePoints).csEntry("main");
+        desc.addTypeConformances(mpScene->getTypeConformances());
+
+        mpPrepareVisiblePointsPass = ComputePass::create(mpDevice, desc, mpScene->getSceneDefines(), true);
+    }
+
+    const uint2 targetDim = renderData.getDefaultTextureDims();
+    FALCOR_ASSERT(targetDim.x > 0 && targetDim.y > 0);
+
+    auto var = mpPrepareVisiblePointsPass->getRootVar();
+    mpScene->bindShaderData(var["gScene"]);
+    var["PerFrame"]["gFrameDim"] = targetDim;
+    for (auto channel : kInputChannels)
+        var[channel.texname] = renderData.getTexture(channel.name);
+    var["gVisiblePoints"] = mpVisiblePoints;
+
+    mpPrepareVisiblePointsPass->execute(pRenderContext, uint3(targetDim, 1));
+}
+
 void SPPM::showASPass(RenderContext* pRenderContext, const RenderData& renderData)
 {
     FALCOR_PROFILE(pRenderContext, "showASPass");
@@ -363,6 +645,158 @@ void SPPM::buildTLAS(RenderContext* pRenderContext)
     pRenderContext->uavBarrier(mTlasInfo.pTlasBuffer.get()); // wait until the tlas is built
 }
 
+void SPPM::preparePhotonGrid(PhotonBuffers& photonBuffers)
+{
+    const uint maxPhotonCount = mPhotonCapacity;
+
+    // Use twice as many buckets as photons to keep the number of collisions low, same as the CPU PhotonHashGrid.
+    photonBuffers.gridBucketCount = std::max(1u, fstd::bit_ceil(2u * maxPhotonCount));
+    photonBuffers.gridBucketStart = mpDevice->createBuffer((photonBuffers.gridBucketCount + 1) * sizeof(uint32_t));
+    photonBuffers.gridBucketStart->setName("photon grid bucket start");
+    photonBuffers.gridPhotonSlot = mpDevice->createStructuredBuffer(sizeof(uint32_t), maxPhotonCount);
+    photonBuffers.gridPhotonSlot->setName("photon grid slot");
+    photonBuffers.gridPhotonIndices = mpDevice->createStructuredBuffer(sizeof(uint32_t), maxPhotonCount);
+    photonBuffers.gridPhotonIndices->setName("photon grid indices");
+}
+
+void SPPM::buildPhotonGrid(RenderContext* pRenderContext, PhotonBuffers& photonBuffers, uint32_t mapIndex, float radius)
+{
+    FALCOR_PROFILE(pRenderContext, "buildPhotonGrid");
+    const uint maxPhotonCount = mPhotonCapacity;
+
+    if (!photonBuffers.gridBucketStart)
+        preparePhotonGrid(photonBuffers);
+    if (!mpCountGridPhotonsPass)
+    {
+        mpCountGridPhotonsPass = ComputePass::create(mpDevice, kPhotonHashGridBuild, "countPhotons");
+        mpScatterGridPhotonsPass = ComputePass::create(mpDevice, kPhotonHashGridBuild, "scatterPhotons");
+        mpPrefixSum = std::make_unique<PrefixSum>(mpDevice);
+    }
+    for (auto& pPass : { mpCountGridPhotonsPass, mpScatterGridPhotonsPass })
+    {
+        if (pPass->getProgram()->addDefine("PHOTON_RECORD_COMPACT", mUseCompactPhotons ? "1" : "0"))
+            pPass->setVars(nullptr);
+    }
+
+    // The cell size is twice the gather radius, so a query touches at most 2x2x2 cells.
+    photonBuffers.gridCellSize = 2.f * radius;
+
+    auto bind = [&](const ref<ComputePass>& pPass)
+    {
+        auto var = pPass->getRootVar();
+        var["CB"]["gMapIndex"] = mapIndex;
+        var["CB"]["gPhotonCapacity"] = maxPhotonCount;
+        var["CB"]["gCellSize"] = photonBuffers.gridCellSize;
+        var["CB"]["gBucketCount"] = photonBuffers.gridBucketCount;
+        var["gPhotonCounter"] = mPhotonCounter.counter;
+        bindPhotonMap(var["gPhotons"], photonBuffers);
+        var["gBucketStart"] = photonBuffers.gridBucketStart;
+        var["gPhotonSlot"] = photonBuffers.gridPhotonSlot;
+        var["gPhotonIndices"] = photonBuffers.gridPhotonIndices;
+    };
+
+    // Counting sort: count photons per bucket, exclusive prefix sum over the counts and the extra last entry, scatter.
+    // The photon count is only known on the GPU, so all passes run over the full buffer capacity and exit early.
+    pRenderContext->clearUAV(photonBuffers.gridBucketStart->getUAV().get(), uint4(0));
+    bind(mpCountGridPhotonsPass);
+    mpCountGridPhotonsPass->execute(pRenderContext, maxPhotonCount, 1);
+
+    mpPrefixSum->execute(pRenderContext, photonBuffers.gridBucketStart, photonBuffers.gridBucketCount + 1);
+
+    bind(mpScatterGridPhotonsPass);
+    mpScatterGridPhotonsPass->execute(pRenderContext, maxPhotonCount, 1);
+
+    mPhotonASSizes.push_back(maxPhotonCount);
+}
+
+void SPPM::preparePixelStats(uint2 frameDim)
+{
+    if (mpPhotonStats && mpPhotonStats->getWidth() == frameDim.x && mpPhotonStats->getHeight() == frameDim.y)
+        return;
+
+    const auto bindFlags = ResourceBindFlags::ShaderResource | ResourceBindFlags::UnorderedAccess;
+    mpPhotonStats = mpDevice->createTexture2D(frameDim.x, frameDim.y, ResourceFormat::RGBA32Float, 1, 1, nullptr, bindFlags);
+    mpPhotonStats->setName("SPPM photon stats");
+    mpPhotonRadius = mpDevice->createTexture2D(frameDim.x, frameDim.y, ResourceFormat::RG32Float, 1, 1, nullptr, bindFlags);
+    mpPhotonRadius->setName("SPPM photon radius");
+    mpVisiblePoints = mpDevice->createStructuredBuffer(kPackedVisiblePointSize, frameDim.x * frameDim.y);
+    mpVisiblePoints->setName("SPPM visible points");
+    mResetIteration = true; // cleared at frame 0
+}
+
+void SPPM::bindPhotonGrids(const ShaderVar& var)
+{
+    for (int i = 0; i < 2; i++)
+    {
+        auto& buffers = (i == 0) ? mCausticPhotonBuffers : mGlobalPhotonBuffers;
+        auto grid = var["gPhotonGrid"][i];
+        grid["cellSize"] = buffers.gridCellSize;
+        grid["bucketCount"] = buffers.gridBucketCount;
+        grid["bucketStart"] = buffers.gridBucketStart;
+        grid["photonIndices"] = buffers.gridPhotonIndices;
+        bindPhotonMap(grid["photons"], buffers);
+    }
+}
+
+void SPPM::bindPhotonMap(const ShaderVar& var, const PhotonBuffers& photonBuffers)
+{
+    var["records"] = photonBuffers.photonInfo;
+    if (!mUseCompactPhotons)
+        var["aabbs"] = photonBuffers.aabbs; // the shared compact AABBs may be bound for writing in the same pass
+    bindPhotonQuantization(var["quantization"]);
+}
+
+void SPPM::bindPhotonQuantization(const ShaderVar& var)
+{
+    // Photons are stored on scene surfaces, so the scene bounds cover all photon positions.
+    const AABB& bounds = mpScene->getSceneBounds();
+    var["boundsMin"] = bounds.minPoint;
+    var["boundsExtent"] = max(bounds.extent(), float3(1e-6f));
+    var["fluxScale"] = 1.f / (photonNumX * photonNumX); // same normalization as the trace pass
+}
+
+void SPPM::derivePhotonAABBs(RenderContext* pRenderContext, PhotonBuffers& photonBuffers, uint32_t mapIndex, float radius)
+{
+    FALCOR_PROFILE(pRenderContext, "derivePhotonAABBs");
+
+    if (!mpPhotonAABBPass)
+    {
+        DefineList defines;
+        defines.add("PHOTON_RECORD_COMPACT", "1");
+        mpPhotonAABBPass = ComputePass::create(mpDevice, kPhotonAABBs, "main", defines);
+    }
+
+    auto var = mpPhotonAABBPass->getRootVar();
+    var["CB"]["gMapIndex"] = mapIndex;
+    var["CB"]["gPhotonCapacity"] = mPhotonCapacity;
+    var["CB"]["gAABBCount"] = photonBuffers.maxPhotonCount;
+    var["CB"]["gRadius"] = radius;
+    var["gPhotonCounter"] = mPhotonCounter.counter;
+    bindPhotonMap(var["gPhotons"], photonBuffers);
+    var["gPhotonAABB"] = photonBuffers.aabbs;
+    mpPhotonAABBPass->execute(pRenderContext, photonBuffers.maxPhotonCount, 1);
+
+    pRenderContext->resourceBarrier(photonBuffers.aabbs.get(), Resource::State::NonPixelShader); // read by the BLAS build
+}
+
+uint64_t SPPM::getPhotonMemoryUsage() const
+{
+    uint64_t size = 0;
+    auto add = [&](const ref<Buffer>& pBuffer) { if (pBuffer) size += pBuffer->getSize(); };
+    for (const PhotonBuffers* pBuffers : { &mCausticPhotonBuffers, &mGlobalPhotonBuffers })
+    {
+        add(pBuffers->photonInfo);
+        if (!mUseCompactPhotons) add(pBuffers->aabbs);
+        add(pBuffers->blasBuffer);
+        add(pBuffers->blasScratch);
+        add(pBuffers->gridBucketStart);
+        add(pBuffers->gridPhotonSlot);
+        add(pBuffers->gridPhotonIndices);
+    }
+    add(mpCompactPhotonAABBs);
+    return size;
+}
+
 void SPPM::prepareVars(SubPass& pass)
 {
     FALCOR_ASSERT(mpScene);
@@ -386,6 +820,8 @@ void SPPM::setScene(RenderContext* pRenderContext, const ref<Scene>& pScene)
 
     mTracePhotonPass.init();
     mCollectPhotonPass.init();
+    mpCollectPhotonGridPass = nullptr;
+    mpPrepareVisiblePointsPass = nullptr;
 
     if (mpScene)
     {
@@ -425,7 +861,10 @@ void SPPM::setScene(RenderContext* pRenderContext, const ref<Scene>& pScene)
             // No closest shader (because we are using photons for primary rays, No final gather now)
             // We only need intersection shader to do ray-sphere intersection and anyhit shader to accumulate flux
             sbt->setHitGroup(0, 0, desc.addHitGroup("", "anyHit", "intersection"));
-            mCollectPhotonPass.pProgram = Program::create(mpDevice, desc, mpScene->getSceneDefines());
+            auto defines = mpScene->getSceneDefines();
+            defines.add("PHOTON_GATHER_HASH_GRID", "0");
+            defines.add("USE_VISIBLE_POINT_CACHE", "0");
+            mCollectPhotonPass.pProgram = Program::create(mpDevice, desc, defines);
         }
         {
             // show AS program
@@ -447,25 +886,102 @@ void SPPM::setScene(RenderContext* pRenderContext, const ref<Scene>& pScene)
 
     // create seed buffer
     std::seed_seq seq{ time(0) };
-    std::vector<uint32_t> cpuSeeds(1024 * 1024);
+    std::vector<uint32_t> cpuSeeds(kSeedTextureSize * kSeedTextureSize);
     seq.generate(cpuSeeds.begin(), cpuSeeds.end());
-    mSeeds = mpDevice->createTexture2D(1024, 1024, ResourceFormat::R32Uint, 1, 1, cpuSeeds.data());
+    mSeeds = mpDevice->createTexture2D(kSeedTextureSize, kSeedTextureSize, ResourceFormat::R32Uint, 1, 1, cpuSeeds.data());
 }
 void SPPM::renderUI(Gui::Widgets& widget)
 {
     // render debug UI
     widget.text("Caustic Photons: " + std::to_string(mPhotonCounts[0]) + " / " + std::to_string(mPhotonASSizes[0]));
     widget.text("Global Photons: " + std::to_string(mPhotonCounts[1]) + " / " + std::to_string(mPhotonASSizes[1]));
-    widget.tooltip("Photons for current Iteration / Build Size Acceleration Structure");
-    widget.text("Current Global Radius: " + std::to_string(mGlobalRadius));
+    widget.tooltip("Photons for current Iteration / Build Size Acceleration Structure (photon buffer size for the hash grid)");
+    widget.text("Photon budget overflows: " + std::to_string(mPhotonCounter.overflowCount));
+    widget.tooltip("Number of frames where more photons were traced than the acceleration structure was sized for.\n"
+        "Photon counts are read back asynchronously, so the size estimate lags behind by up to " + std::to_string(PhotonCounter::kReadbackCount) + " frames.");
+    widget.text("Readback stalls: " + std::to_string(mPhotonCounter.stallCount));
+    {
+        // Everything allocated per photon: records, AABBs, BLAS (AS gather) or hash grid (grid gather)
+        const uint64_t photonCapacity = 2ull * mPhotonCapacity;
+        const uint64_t photonMemory = getPhotonMemoryUsage();
+        const double bytesPerPhoton = photonCapacity > 0 ? double(photonMemory) / photonCapacity : 0.0;
+        widget.text(fmt::format("Photon memory: {:.1f} MB ({:.1f} B/photon)", photonMemory / (1024.0 * 1024.0), bytesPerPhoton));
+        widget.var("Photon Memory Budget (MB)", mPhotonMemoryBudgetMB, 1u, 1u << 16);
+        const uint64_t budgetPhotons = bytesPerPhoton > 0.0 ? uint64_t(mPhotonMemoryBudgetMB * 1024.0 * 1024.0 / bytesPerPhoton) : 0;
+        widget.text("Photons per iteration at budget: " + std::to_string(budgetPhotons));
+        widget.tooltip("Number of photons the budget holds with the current record layout and gather mode, summed over both photon maps.");
+    }
+    widget.text("Max Global Radius: " + std::to_string(mGlobalRadius));
+    widget.tooltip("Largest per-pixel gather radius of the global photons, the photon AABBs and hash grid cells are sized for it.\n"
+        "Each pixel shrinks its radius with the number of photons it gathered (N, tau, R update of stochastic progressive photon mapping).");
     widget.text("Current Caustic Radius: " + std::to_string(mCausticRadius));
 
+    if (auto g = widget.group("Stage Times", true))
+    {
+        const char* kStageNames[] = { "Trace", "Build", "Visible Points", "Gather" };
+        for (uint32_t i = 0; i < (uint32_t)PhotonStage::Count; i++)
+            g.text(std::string(kStageNames[i]) + ": " + (mStageTimes[i] < 0.f ? std::string("-") : fmt::format("{:.3f} ms", mStageTimes[i])));
+        g.tooltip("GPU time of the SPPM stages (moving average).\n"
+            "Build is the photon acceleration structure build or the hash grid build, depending on the gather mode.");
+    }
+
     bool dirty = false;
 
+    dirty |= widget.dropdown("Gather Mode", mGatherMode);
+    widget.tooltip("AccelerationStructure: rebuild a BLAS over the photons every frame and collect them in any-hit shaders.\n"
+        "HashGridCompute: counting sort the photons into a hash grid and collect them in a compute pass.\n"
+        "HashGridInline: counting sort the photons into a hash grid and query it in the collect ray gen shader.");
+
+    if (widget.checkbox("Compact Photon Records", mUseCompactPhotons))
+    {
+        mCreateBuffer = true;
+        mRebuildAS = true;
+        dirty = true;
+    }
+    widget.tooltip("Store photons as 16B records: RGB9E5 flux, octahedral direction and a position quantized to the scene bounds.\n"
+        "The photon AABBs are derived right before each BLAS build into a buffer shared by both photon maps.");
+
+    dirty |= widget.checkbox("Visible Point Cache", mUseVisiblePointCache);
+    widget.tooltip("Prepare the shading data and material parameters of each pixel once per iteration.\n"
+        "The gather then only evaluates the BSDF per photon. Non-standard materials fall back to loading the shading data per photon.");
+
     dirty |= widget.var("Photon Bounces", mDepth, 0u, 1u << 16);
     dirty |= widget.checkbox("Enable Collect", enableCollect);
-    dirty |= widget.var("Photon Number", photonNumX, 0u, 1u << 16);
-    
+
+    if (auto g = widget.group("Photon Budget", true))
+    {
+        auto settings = mPhotonBudget.getSettings();
+        bool modeChanged = g.dropdown("Mode", settings.mode);
+        g.tooltip("Fixed: trace the photon number set below.\n"
+            "TargetFrameTime: scale the photon paths until the SPPM stages take the target GPU time per iteration.\n"
+            "MaxThroughput: adjust the photon paths to the most stored photons per second, for batch renders.\n\n"
+            "The adaptive modes also store global photons with a lower probability to reach the caustic fraction, "
+            "and grow or shrink the photon buffers with hysteresis.");
+        if (settings.mode == PhotonBudgetMode::TargetFrameTime)
+            g.var("Target Time (ms)", settings.targetTimeMs, 0.1f, 1000.f, 0.1f);
+        if (settings.mode != PhotonBudgetMode::Fixed)
+        {
+            g.var("Caustic Fraction", settings.targetCausticFraction, 0.f, 1.f, 0.01f);
+            g.tooltip("Fraction of the stored photons that should be caustic photons. 0 or 1 stores all global photons.");
+        }
+        mPhotonBudget.setSettings(settings);
+        if (modeChanged)
+            mPhotonBudget.reset(photonNumX * photonNumX, kSeedTextureSize * kSeedTextureSize, mMaxPhotonCount * mMaxPhotonCount);
+
+        if (settings.mode == PhotonBudgetMode::Fixed)
+        {
+            dirty |= g.var("Photon Number", photonNumX, 1u, kSeedTextureSize);
+        }
+        else
+        {
+            g.text("Photon Paths: " + std::to_string(photonNumX) + " x " + std::to_string(photonNumX));
+            g.text(fmt::format("Global Store Probability: {:.3f}", mPhotonBudget.getGlobalStoreProbability()));
+            g.text(fmt::format("Stored Photons/s: {:.2f} M", mPhotonBudget.getThroughput() * 1e-6f));
+        }
+        g.text("Photon Capacity: " + std::to_string(mPhotonCapacity));
+        g.tooltip("Photons per photon map the buffers are allocated for.");
+    }
+
     widget.var("Max Photon Count", mMaxPhotonCount, 0u, 1u << 16);
     updateMaxPhotonCount = widget.button("Apply");
     dirty |= updateMaxPhotonCount;
@@ -490,6 +1006,36 @@ void SPPM::renderUI(Gui::Widgets& widget)
     }
 }
 
+void SPPM::registerBindings(pybind11::module& m)
+{
+    using namespace pybind11::literals;
+
+    pybind11::class_<SPPM, RenderPass, ref<SPPM>> pass(m, "SPPM");
+    pass.def("render_cpu_reference", &SPPM::renderCpuReference, "iterations"_a, "path"_a);
+}
+
+void SPPM::renderCpuReference(uint32_t iterations, const std::filesystem::path& path)
+{
+    FALCOR_CHECK(mpScene, "SPPM: Can't render the CPU reference without a scene.");
+    FALCOR_CHECK(all(mFrameDim > uint2(0)), "SPPM: The pass has to be executed once before rendering the CPU reference.");
+
+    CpuSPPM::SceneDesc scene;
+    scene.addScene(*mpScene, mFrameDim);
+
+    CpuSPPM::Options options;
+    options.photonsPerIteration = photonNumX * photonNumX;
+    options.maxBounces = mDepth;
+    options.causticInitRadius = mCausticInitRadius;
+    options.globalInitRadius = mGlobalInitRadius;
+    options.alpha = mSPPMAlpha;
+    options.minRadius = kMinPhotonRadius;
+    options.seed = mUseFixedSeed ? mFixedSeed : 0;
+
+    CpuSPPM sppm(std::move(scene), options);
+    sppm.run(iterations);
+    sppm.saveImage(path);
+}
+
 void SPPM::resetSPPM()
 {
     mFrameCount = 0;
@@ -506,20 +1052,41 @@ void SPPM::resetSPPM()
 void SPPM::preparePhotonBuffers(PhotonBuffers& photonBuffers)
 {
     {
-        uint maxPhotonCount = mMaxPhotonCount * mMaxPhotonCount;
+        uint maxPhotonCount = mPhotonCapacity;
 
-        photonBuffers.aabbs = mpDevice->createStructuredBuffer(sizeof(RtAABB), maxPhotonCount);
-        photonBuffers.aabbs->setName("photon aabbs");
+        if (mUseCompactPhotons)
+        {
+            // the AABBs are derived from the records of one map at a time right before its BLAS build
+            if (!mpCompactPhotonAABBs)
+            {
+                mpCompactPhotonAABBs = mpDevice->createStructuredBuffer(sizeof(RtAABB), maxPhotonCount);
+                mpCompactPhotonAABBs->setName("photon aabbs (shared)");
+            }
+            photonBuffers.aabbs = mpCompactPhotonAABBs;
+        }
+        else
+        {
+            photonBuffers.aabbs = mpDevice->createStructuredBuffer(sizeof(RtAABB), maxPhotonCount);
+            photonBuffers.aabbs->setName("photon aabbs");
+        }
         FALCOR_ASSERT(photonBuffers.aabbs);
 
-        photonBuffers.photonInfo = mpDevice->createStructuredBuffer(sizeof(PhotonInfo), maxPhotonCount);
+        const uint32_t recordSize = mUseCompactPhotons ? sizeof(PackedPhoton) : sizeof(PhotonInfo);
+        photonBuffers.photonInfo = mpDevice->createStructuredBuffer(recordSize, maxPhotonCount);
         photonBuffers.photonInfo->setName("photon info");
         FALCOR_ASSERT(photonBuffers.photonInfo);
+
+        // recreated on demand with the new size
+        photonBuffers.gridBucketStart = nullptr;
+        photonBuffers.gridPhotonSlot = nullptr;
+        photonBuffers.gridPhotonIndices = nullptr;
     }
 }
 
 void SPPM::prepareTLAS(RenderContext* pRenderContext)
 {
+    // The TLAS is rebuilt whenever the photon buffers are recreated, it always holds exactly the two current BLASes.
+    std::vector<RtInstanceDesc> photonInstanceDescs;
     {
         RtInstanceDesc causticDesc = {};
         causticDesc.accelerationStructure = mCausticPhotonBuffers.blasBuffer->getGpuAddress();
@@ -578,7 +1145,7 @@ void SPPM::prepareBLAS(PhotonBuffers& photonBuffers)
     desc.type = RtGeometryType::ProcedurePrimitives;
     desc.flags = RtGeometryFlags::NoDuplicateAnyHitInvocation; // Each photon appears exactly once in anyhit shader
     //desc.flags = RtGeometryFlags::None;
-    desc.content.proceduralAABBs.count = mMaxPhotonCount * mMaxPhotonCount; // create a large buffer for pre built
+    desc.content.proceduralAABBs.count = mPhotonCapacity; // create a large buffer for pre built
     desc.content.proceduralAABBs.data = photonBuffers.aabbs->getGpuAddress();
     desc.content.proceduralAABBs.stride = sizeof(RtAABB);
 
@@ -8,9 +8,41 @@
 #include "Rendering/Utils/PixelStats.h"
 #include "Core/API/RtAccelerationStructure.h"
 #include "Core/API/Device.h"
+#include "Core/API/GpuTimer.h"
+#include "Core/Pass/ComputePass.h"
+#include "Utils/Algorithm/PrefixSum.h"
+#include "Utils/Algorithm/ParallelReduction.h"
+#include "PhotonBudgetController.h"
 
 using namespace Falcor;
 
+// How photons are found around the camera hits in the collect pass
+enum class PhotonGatherMode : uint32_t
+{
+    AccelerationStructure, // rebuild a BLAS over the photon AABBs every frame and collect photons in any-hit shaders
+    HashGridCompute,       // build a hash grid with a counting sort and collect photons in a compute pass
+    HashGridInline,        // build a hash grid with a counting sort and query it in the collect ray gen shader
+};
+FALCOR_ENUM_INFO(
+    PhotonGatherMode,
+    {
+        {PhotonGatherMode::AccelerationStructure, "AccelerationStructure"},
+        {PhotonGatherMode::HashGridCompute, "HashGridCompute"},
+        {PhotonGatherMode::HashGridInline, "HashGridInline"},
+    }
+);
+FALCOR_ENUM_REGISTER(PhotonGatherMode);
+
+// GPU stages of an SPPM iteration, timed separately
+enum class PhotonStage : uint32_t
+{
+    Trace,  // photon trace pass
+    Build,  // photon AS or hash grid build
+    VisiblePoints, // visible point cache preparation
+    Gather, // collect pass
+    Count
+};
+
 struct SubPass
 {
     ref<Program> pProgram;
@@ -23,6 +55,18 @@ struct SubPass
         pVars = nullptr;
     }
 };
+// Binding paths of the trace pass, they are bound every iteration and resolved by name only once per program vars
+struct TracePhotonBindings
+{
+    ShaderVarPath frameCount{"PerFrame.gFrameCount"};
+    ShaderVarPath globalRadius{"PerFrame.gGlobalRadius"};
+    ShaderVarPath causticRadius{"PerFrame.gCausticRadius"};
+    ShaderVarPath seed{"PerFrame.gSeed"};
+    ShaderVarPath photonQuantization{"PerFrame.gPhotonQuantization"};
+    ShaderVarPath globalStoreProbability{"PerFrame.gGlobalStoreProbability"};
+    ShaderVarPath photonAABB[2] = {ShaderVarPath("gPhotonAABB[0]"), ShaderVarPath("gPhotonAABB[1]")};
+    ShaderVarPath photonInfo[2] = {ShaderVarPath("gPhotonInfo[0]"), ShaderVarPath("gPhotonInfo[1]")};
+};
 struct BlasInfo
 {
     RtAccelerationStructurePrebuildInfo prebuildInfo;
@@ -45,24 +89,61 @@ struct PhotonInfo
     float3 flux;
     float3 dir;
 };
+// Compact photon record, see PackedPhoton in PhotonRecord.slang
+struct PackedPhoton
+{
+    uint4 data;
+};
 
 struct PhotonCounter {
+    // Number of readbacks in flight. The AS size estimate uses the photon count from up to kReadbackCount frames ago.
+    static constexpr uint32_t kReadbackCount = 3;
+    // Readback slot layout: caustic count, global count, max active global radius, unused
+    static constexpr uint32_t kSlotSize = 4 * sizeof(uint32_t);
+
+    struct ReadbackSlot
+    {
+        uint64_t fenceValue = 0;
+        uint32_t asSizes[2] = { 0, 0 }; // AS build sizes used in the frame the count belongs to
+        uint32_t pathCount = 0;          // photon paths traced in that frame
+        float globalStoreProbability = 1.f;
+        uint32_t stageMask = 0;          // stages timed in that frame, the timers of the other stages are stale
+        bool pending = false;
+    };
+
     ref<Buffer> counter;
     ref<Buffer> reset;
-    ref<Buffer> cpuReadback;
+    ref<Buffer> radiusRange; // min/max of the per-pixel radius texture, written by the parallel reduction
+    ref<Buffer> cpuReadback; // kReadbackCount slots of kSlotSize bytes
+    ref<Fence> fence;
+    ReadbackSlot slots[kReadbackCount];
+    // Stage timers of the frame each slot belongs to, resolved with the counter and read when the slot lands
+    ref<GpuTimer> stageTimers[kReadbackCount][(uint32_t)PhotonStage::Count];
+    uint32_t stageMask = 0; // stages begun in the current frame
+    uint32_t nextSlot = 0;
+
+    uint64_t overflowCount = 0; // frames where more photons were traced than the AS was sized for
+    uint64_t stallCount = 0;    // frames where the CPU had to wait for a readback
 };
 
 struct PhotonBuffers
 {
     uint maxPhotonCount;
-    ref<Buffer> photonInfo; // packed flux and dir
+    ref<Buffer> photonInfo; // PhotonInfo, or PackedPhoton with the compact photon record
     // ref<Texture> flux;
     // ref<Texture> dir;
-    ref<Buffer> aabbs; // aabb structured buffer built within photon trace pass, used for building blas
+    ref<Buffer> aabbs; // aabb structured buffer built within photon trace pass, used for building blas. Shared by both maps with the compact photon record
     ref<Buffer> blasScratch;
     ref<Buffer> blasBuffer;
     ref<RtAccelerationStructure> falcorBlas;
     BlasInfo blasInfo;
+
+    // Hash grid, only allocated when a hash grid gather mode is used
+    ref<Buffer> gridBucketStart;   // bucketCount + 1 uints, bucket counts turned into start offsets by a prefix sum
+    ref<Buffer> gridPhotonSlot;    // offset of each photon within its bucket
+    ref<Buffer> gridPhotonIndices; // photon indices sorted by bucket
+    uint gridBucketCount = 0;
+    float gridCellSize = 0.f;
 };
 struct Timer
 {
@@ -91,15 +172,39 @@ public:
     }
     void recordTimer();
 
+    static void registerBindings(pybind11::module& m);
+
+    /** Render the current scene with the CPU reference (CpuSPPM) using the settings of this pass and save the image.
+        Runs synchronously on the global task scheduler, the GPU is only used to read back the mesh data.
+        \param[in] iterations Number of SPPM iterations.
+        \param[in] path Output image, EXR or PFM.
+    */
+    void renderCpuReference(uint32_t iterations, const std::filesystem::path& path);
+
     // Functions for photon mapping
     void preparePhotonBuffers(PhotonBuffers& photonBuffers);
     void resetPhotonCounter(RenderContext* pRenderContext);
+    void readbackPhotonCounter(RenderContext* pRenderContext);
+    void resolvePhotonCounterReadbacks();
     void prepareBLAS(PhotonBuffers& photonBuffers);
     void prepareTLAS(RenderContext* pRenderContext);
     void tracePhotonPass(RenderContext* pRenderContext, const RenderData& renderData);
     void buildBLAS(RenderContext* pRenderContext, PhotonBuffers& photonBuffers);
     void buildTLAS(RenderContext* pRenderContext);
+    void preparePhotonGrid(PhotonBuffers& photonBuffers);
+    void buildPhotonGrid(RenderContext* pRenderContext, PhotonBuffers& photonBuffers, uint32_t mapIndex, float radius);
+    void bindPhotonGrids(const ShaderVar& var);
+    void bindPhotonMap(const ShaderVar& var, const PhotonBuffers& photonBuffers);
+    void bindPhotonQuantization(const ShaderVar& var);
+    void derivePhotonAABBs(RenderContext* pRenderContext, PhotonBuffers& photonBuffers, uint32_t mapIndex, float radius);
+    uint64_t getPhotonMemoryUsage() const;
     void collectPhotonPass(RenderContext* pRenderContext, const RenderData& renderData);
+    void collectPhotonGridPass(RenderContext* pRenderContext, const RenderData& renderData);
+    void prepareVisiblePointsPass(RenderContext* pRenderContext, const RenderData& renderData);
+    void preparePixelStats(uint2 frameDim);
+    void beginStage(PhotonStage stage);
+    void endStage(PhotonStage stage);
+    void updateStageTimes(uint32_t slot);
     void showASPass(RenderContext* pRenderContext, const RenderData& renderData);
     void resetSPPM();
     void prepareVars(SubPass& pass);
@@ -107,6 +212,7 @@ public:
     // Scene settings
     ref<Scene> mpScene;
     uint mFrameCount = 0;
+    uint2 mFrameDim = uint2(0); // output size of the last execute(), used by the CPU reference
     bool mOptionChanged = false;
     bool mResetIteration = false;
     bool mResetCB = false;
@@ -127,19 +233,28 @@ public:
     const float mSPPMAlpha = 0.7f;
     const float kMinPhotonRadius = 0.00001f;
     float mCausticRadius = 0.005f; // current radius
-    float mGlobalRadius = 0.01f;
+    float mGlobalRadius = 0.01f;   // max per-pixel radius of the global photons, read back from the GPU
     bool mResizePhotonBuffer = true; 
     bool mRebuildAS = true;
     bool mCreateBuffer = true; // need to create buffers at frame 0
 
     bool updateMaxPhotonCount = false;
-    uint mMaxPhotonCount = 1024;
+    uint mMaxPhotonCount = 1024;             // sqrt of the max photons stored per photon map
+    uint32_t mPhotonCapacity = 1024 * 1024;  // photons stored per photon map the buffers are allocated for
+    PhotonBudgetController mPhotonBudget;   // photon paths, global store probability and capacity of the adaptive budget modes
 
     float photonASScale = 1.1f;
     std::vector<uint32_t> mPhotonCounts = { 1, 1 };
     std::vector<uint32_t> mPhotonASSizes = { 1, 1 };
 
     bool enableCollect = true;
+    PhotonGatherMode mGatherMode = PhotonGatherMode::AccelerationStructure;
+    bool mUseCompactPhotons = false; // 16B quantized photon records, AABBs are derived before the BLAS build
+    uint mPhotonMemoryBudgetMB = 256; // only used to report how many photons fit with the current layout
+    bool mUseVisiblePointCache = true; // prepare the shading data of each pixel once per iteration instead of once per gathered photon
+
+    // Moving average of the GPU stage times in ms, negative until the first readback
+    float mStageTimes[(uint32_t)PhotonStage::Count] = { -1.f, -1.f, -1.f, -1.f };
 
     // Timer
     Timer mTimer;
@@ -148,16 +263,29 @@ public:
     SubPass mTracePhotonPass;
     SubPass mCollectPhotonPass;
     SubPass mShowASPass;
+    TracePhotonBindings mTracePhotonBindings;
+    ref<ComputePass> mpCountGridPhotonsPass;
+    ref<ComputePass> mpScatterGridPhotonsPass;
+    ref<ComputePass> mpCollectPhotonGridPass;
+    ref<ComputePass> mpPrepareVisiblePointsPass;
+    ref<ComputePass> mpPhotonAABBPass;
+    std::unique_ptr<PrefixSum> mpPrefixSum;
+    std::unique_ptr<ParallelReduction> mpRadiusReduction;
 
     // Photon Buffers
     PhotonBuffers mCausticPhotonBuffers;
     PhotonBuffers mGlobalPhotonBuffers;
     PhotonCounter mPhotonCounter;
+    ref<Buffer> mpCompactPhotonAABBs; // AABBs shared by both maps with the compact photon record
+
+    // Per-pixel SPPM statistics of the global photons, cleared when SPPM restarts
+    ref<Texture> mpPhotonStats;  // tau in xyz, N in w
+    ref<Texture> mpPhotonRadius; // radius in x, radius of pixels with a valid hit in y
+    ref<Buffer> mpVisiblePoints; // PackedVisiblePoint per pixel, rewritten every iteration when the cache is enabled
 
     // ref<Buffer> mPhotonCounter; // used to accumulate photon count in photon generation pass
     // ref<Buffer> mPhotonCounterReset;
     ref<Texture> mSeeds;
-    std::vector<RtInstanceDesc> photonInstanceDescs;
     TlasInfo mTlasInfo;
 
     ref<SampleGenerator> mpSampleGenerator;
@@ -55,6 +55,7 @@ int runMain(int argc, char** argv)
     args::ValueFlag<std::string> testCaseFilterFlag(parser, "regex", "Filter test cases to run.", {'f', "test-case"});
     args::ValueFlag<std::string> tagFilterFlag(parser, "tags", "Filter test cases by tags.", {'t', "tags"});
     args::ValueFlag<std::string> xmlReportFlag(parser, "path", "XML report output file.", {'x', "xml-report"});
+    args::ValueFlag<std::string> traceFlag(parser, "dir", "Write a profiler trace (chrome://tracing) of each GPU test to this directory.", {"trace"});
     args::ValueFlag<uint32_t> repeatFlag(parser, "N", "Number of times to repeat the test.", {'r', "repeat"});
     args::Flag enableDebugLayerFlag(parser, "", "Enable debug layer (enabled by default in Debug build).", {"enable-debug-layer"});
     args::Flag enableAftermathFlag(parser, "", "Enable Aftermath GPU crash dump.", {"enable-aftermath"});
@@ -125,6 +126,8 @@ int runMain(int argc, char** argv)
         options.tagFilter = args::get(tagFilterFlag);
     if (xmlReportFlag)
         options.xmlReportPath = args::get(xmlReportFlag);
+    if (traceFlag)
+        options.traceDir = args::get(traceFlag);
     if (parallelFlag)
         options.parallel = args::get(parallelFlag);
     if (repeatFlag)
@@ -62,4 +62,36 @@ GPU_TEST(BuiltinConstantBuffer2)
     EXPECT_EQ(result[1], 3);
     EXPECT_EQ(result[2], 5.5f);
 }
+
+/** GPU test for binding through cached shader var paths.
+ */
+GPU_TEST(BuiltinConstantBufferPath)
+{
+    ShaderVarPath pathA("CB.params1.a");
+    ShaderVarPath pathB("CB.params1.b");
+    ShaderVarPath pathC("CB.params1.c");
+
+    for (int i = 0; i < 2; i++)
+    {
+        // The second program has new reflection types, the paths are resolved again.
+        ctx.createProgram("Tests/Core/ConstantBufferTests.cs.slang", "testCbuffer1");
+        ctx.allocateStructuredBuffer("result", 3);
+        ShaderVar var = ctx.vars().getRootVar();
+        var[pathA] = 0;
+        var[pathA] = 1 + i; // Uses the cached offsets.
+        var[pathB] = 3u + i;
+        var[pathC] = 5.5f + i;
+        ctx.runProgram(1, 1, 1);
+
+        std::vector<float> result = ctx.readBuffer<float>("result");
+        EXPECT_EQ(result[0], 1 + i);
+        EXPECT_EQ(result[1], 3 + i);
+        EXPECT_EQ(result[2], 5.5f + i);
+    }
+
+    ShaderVar var = ctx.vars().getRootVar();
+    EXPECT_THROW(var[ShaderVarPath("CB.params1.d")]);
+    EXPECT_THROW(ShaderVarPath("CB..params1"));
+    EXPECT_THROW(ShaderVarPath("CB[x]"));
+}
 } // namespace Falcor
@@ -0,0 +1,156 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Image/Bitmap.h"
+#include "ImageCompare/ImageComparison.h"
+
+#include <nlohmann/json.hpp>
+
+#include <fstream>
+
+namespace Falcor
+{
+namespace
+{
+const uint32_t kWidth = 32;
+const uint32_t kHeight = 32;
+
+/// Compare two images of constant RGBA color with a metric and return the mean error.
+double compareConstant(const std::string& metricName, float a, float b, float* errorMap = nullptr)
+{
+    std::vector<float> dataA(kWidth * kHeight * 4, a);
+    std::vector<float> dataB(kWidth * kHeight * 4, b);
+
+    const ErrorMetric* pMetric = findMetric(metricName);
+    FALCOR_ASSERT(pMetric);
+
+    ImageTile tile;
+    tile.width = kWidth;
+    tile.height = kHeight;
+    tile.y0 = tile.dataY0 = 0;
+    tile.y1 = tile.dataY1 = kHeight;
+    tile.pDataA = dataA.data();
+    tile.pDataB = dataB.data();
+    return pMetric->compareTile(tile, errorMap) / (kWidth * kHeight);
+}
+
+void saveConstantImage(const std::filesystem::path& path, float value)
+{
+    std::vector<float> data(kWidth * kHeight * 3, value);
+    Bitmap::saveImage(path, kWidth, kHeight, Bitmap::FileFormat::ExrFile, Bitmap::ExportFlags::None, ResourceFormat::RGB32Float, true, data.data());
+}
+} // namespace
+
+CPU_TEST(ImageCompare_RelMSE)
+{
+    // Errors are evaluated in double precision, single precision is off by about 1e-8.
+    const float diff = 0.6f - 0.5f;
+    const double expected = double(diff * diff) / (0.25 + 1e-2);
+    EXPECT_LE(std::abs(compareConstant("relmse", 0.5f, 0.6f) - expected), 1e-12 * expected);
+
+    // The epsilon is 0.01, ten times the one of rmse.
+    EXPECT_LE(std::abs(compareConstant("relmse", 0.f, 0.1f) - 1.0), 1e-6);
+    EXPECT_LE(std::abs(compareConstant("rmse", 0.f, 0.1f) - 10.0), 1e-5);
+    EXPECT_EQ(compareConstant("relmse", 0.5f, 0.5f), 0.0);
+}
+
+CPU_TEST(ImageCompare_SSIM)
+{
+    EXPECT_LE(std::abs(compareConstant("ssim", 0.5f, 0.5f)), 1e-6);
+
+    // Constant images only differ in the luminance term (2 muA muB + C1) / (muA^2 + muB^2 + C1), with C1 = 0.01^2.
+    std::vector<float> errorMap(kWidth * kHeight);
+    const double expected = 1.0 - (2.0 * 0.5 * 0.6 + 1e-4) / (0.5 * 0.5 + 0.6 * 0.6 + 1e-4);
+    EXPECT_LE(std::abs(compareConstant("ssim", 0.5f, 0.6f, errorMap.data()) - expected), 1e-3);
+
+    // The image borders are clamped, so the error is the same everywhere.
+    for (float error : errorMap)
+        EXPECT_LE(std::abs(error - errorMap[0]), 1e-6f);
+}
+
+CPU_TEST(ImageCompare_Flip)
+{
+    EXPECT_EQ(compareConstant("flip", 0.5f, 0.5f), 0.0);
+
+    const double small = compareConstant("flip", 0.5f, 0.6f);
+    const double large = compareConstant("flip", 0.f, 1.f);
+    EXPECT_GT(small, 0.0);
+    EXPECT_LT(small, large);
+    EXPECT_GT(large, 0.9);
+    EXPECT_LE(large, 1.0);
+
+    // Inputs are clamped to [0, 1].
+    EXPECT_EQ(compareConstant("flip", 1.f, 2.f), 0.0);
+}
+
+CPU_TEST(ImageCompare_Batch)
+{
+    const std::filesystem::path dir = std::filesystem::current_path() / "image_compare_batch";
+    std::filesystem::create_directories(dir);
+    saveConstantImage(dir / "a.exr", 0.5f);
+    saveConstantImage(dir / "b.exr", 0.6f);
+
+    nlohmann::json manifest = {
+        {"metric", "mse"},
+        {"threshold", 0.02},
+        {"pairs",
+         {
+             {{"image1", "a.exr"}, {"image2", "b.exr"}},
+             {{"image1", "a.exr"}, {"image2", "b.exr"}, {"threshold", 0.005}},
+             {{"image1", "a.exr"}, {"image2", "missing.exr"}},
+             {{"image1", "a.exr"}, {"image2", "a.exr"}, {"metric", "ssim"}, {"threshold", 0.0}},
+         }},
+    };
+    std::ofstream(dir / "manifest.json") << manifest.dump();
+
+    // Manifest values override the defaults passed in.
+    const bool success = compareBatch(dir / "manifest.json", dir / "report.json", *findMetric("flip"), 1.f, false);
+    EXPECT(!success);
+
+    std::ifstream ifs(dir / "report.json");
+    ASSERT(ifs.good());
+    const auto report = nlohmann::json::parse(ifs);
+    EXPECT_EQ(report["passed"].get<size_t>(), 2u);
+    EXPECT_EQ(report["failed"].get<size_t>(), 2u);
+
+    const auto& results = report["results"];
+    ASSERT_EQ(results.size(), 4u);
+    const float diff = 0.6f - 0.5f;
+    EXPECT_EQ(results[0]["metric"].get<std::string>(), "mse");
+    EXPECT_LE(std::abs(results[0]["error"].get<double>() - diff * diff), 1e-9);
+    EXPECT(results[0]["success"].get<bool>());
+    EXPECT(!results[1]["success"].get<bool>());
+    EXPECT(!results[2]["success"].get<bool>());
+    EXPECT(results[2].contains("message"));
+    EXPECT(!results[2].contains("error"));
+    EXPECT_EQ(results[3]["metric"].get<std::string>(), "ssim");
+    EXPECT(results[3]["success"].get<bool>());
+
+    std::filesystem::remove_all(dir);
+}
+} // namespace Falcor
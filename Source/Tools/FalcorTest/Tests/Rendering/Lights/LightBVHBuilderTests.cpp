@@ -0,0 +1,122 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Rendering/Lights/LightBVH.h"
+#include "Rendering/Lights/LightBVHBuilder.h"
+#include "Scene/SceneBuilder.h"
+#include "Scene/Material/StandardMaterial.h"
+
+#include <cstring>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+/// Exposes the built BVH data for comparison.
+class TestLightBVH : public LightBVH
+{
+public:
+    using LightBVH::LightBVH;
+
+    std::vector<PackedNode> getNodes() const
+    {
+        syncDataToCPU();
+        return mNodes;
+    }
+    std::vector<uint32_t> getTriangleIndices() const { return mpTriangleIndicesBuffer->getElements<uint32_t>(); }
+    std::vector<uint64_t> getTriangleBitmasks() const { return mpTriangleBitmasksBuffer->getElements<uint64_t>(); }
+};
+
+/** Create a scene of randomly placed emissive spheres.
+    With 20 spheres of 4096 triangles, the top levels of the BVH are above the parallel build and binning thresholds.
+*/
+ref<Scene> createEmissiveScene(ref<Device> pDevice)
+{
+    SceneBuilder builder(pDevice, Settings());
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> u;
+
+    auto pSphere = TriangleMesh::createSphere(0.5f, 64, 32);
+    for (uint32_t i = 0; i < 20; ++i)
+    {
+        auto pMaterial = StandardMaterial::create(pDevice, fmt::format("Emissive{}", i));
+        pMaterial->setEmissiveColor(float3(u(rng), u(rng), u(rng)));
+        pMaterial->setEmissiveFactor(1.f + 10.f * u(rng));
+        MeshID meshID = builder.addTriangleMesh(pSphere, pMaterial);
+
+        SceneBuilder::Node node;
+        node.name = fmt::format("Sphere{}", i);
+        node.transform = mul(
+            math::matrixFromTranslation(float3(u(rng), u(rng), u(rng)) * 20.f), math::matrixFromScaling(float3(0.5f + 2.f * u(rng)))
+        );
+        builder.addMeshInstance(builder.addNode(node), meshID);
+    }
+
+    return builder.getScene();
+}
+} // namespace
+
+GPU_TEST(LightBVHBuilder_ParallelMatchesSerial)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    RenderContext* pRenderContext = ctx.getRenderContext();
+
+    ref<Scene> pScene = createEmissiveScene(pDevice);
+    ref<LightCollection> pLights = pScene->getLightCollection(pRenderContext);
+    ASSERT(pLights != nullptr);
+    ASSERT_GE(pLights->getTotalLightCount(), 65536u);
+
+    using SplitHeuristic = LightBVHBuilder::SplitHeuristic;
+    for (SplitHeuristic heuristic : {SplitHeuristic::Equal, SplitHeuristic::BinnedSAH, SplitHeuristic::BinnedSAOH})
+    {
+        LightBVHBuilder::Options options;
+        options.splitHeuristicSelection = heuristic;
+
+        options.parallelBuild = false;
+        TestLightBVH serialBVH(pDevice, pLights);
+        LightBVHBuilder(options).build(pRenderContext, serialBVH);
+
+        options.parallelBuild = true;
+        TestLightBVH parallelBVH(pDevice, pLights);
+        LightBVHBuilder(options).build(pRenderContext, parallelBVH);
+
+        ASSERT(serialBVH.isValid() && parallelBVH.isValid());
+
+        const auto serialNodes = serialBVH.getNodes();
+        const auto parallelNodes = parallelBVH.getNodes();
+        ASSERT_EQ(serialNodes.size(), parallelNodes.size()) << "heuristic " << enumToString(heuristic);
+        EXPECT(std::memcmp(serialNodes.data(), parallelNodes.data(), serialNodes.size() * sizeof(PackedNode)) == 0)
+            << "heuristic " << enumToString(heuristic);
+
+        EXPECT(serialBVH.getTriangleIndices() == parallelBVH.getTriangleIndices()) << "heuristic " << enumToString(heuristic);
+        EXPECT(serialBVH.getTriangleBitmasks() == parallelBVH.getTriangleBitmasks()) << "heuristic " << enumToString(heuristic);
+    }
+}
+} // namespace Falcor
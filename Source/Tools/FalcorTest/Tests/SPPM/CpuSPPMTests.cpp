@@ -0,0 +1,162 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "SPPM/CpuSPPM.h"
+#include "SPPM/PhotonHashGrid.h"
+
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+/** Closed cube [-1,1]^3 with all faces pointing inwards, every face is diffuse and emissive.
+    In such a furnace the irradiance of each bounce generation is uniform and isotropic.
+*/
+CpuSPPM::SceneDesc createFurnace(float albedo, float emission)
+{
+    CpuSPPM::SceneDesc scene;
+    CpuSPPM::MaterialDesc material;
+    material.albedo = float3(albedo);
+    material.emission = float3(emission);
+    const uint32_t materialID = scene.addMaterial(material);
+
+    auto addQuad = [&](float3 center, float3 u, float3 v)
+    {
+        // Normal is cross(u, v), all quads are passed with u and v chosen so it points to the center.
+        const float3 p00 = center - u - v, p10 = center + u - v, p11 = center + u + v, p01 = center - u + v;
+        scene.triangles.push_back({p00, p10, p11, materialID});
+        scene.triangles.push_back({p00, p11, p01, materialID});
+    };
+    const float3 x(1.f, 0.f, 0.f), y(0.f, 1.f, 0.f), z(0.f, 0.f, 1.f);
+    addQuad(-x, y, z);
+    addQuad(x, z, y);
+    addQuad(-y, z, x);
+    addQuad(y, x, z);
+    addQuad(-z, x, y);
+    addQuad(z, y, x);
+
+    scene.camera.position = float3(0.f);
+    scene.camera.target = z;
+    scene.camera.up = y;
+    scene.camera.fovY = 0.5f;
+    scene.camera.frameDim = uint2(4, 4);
+    return scene;
+}
+
+float computeRmsError(const std::vector<float3>& image, float expected)
+{
+    double sum = 0.0;
+    for (const float3& pixel : image)
+        sum += double(pixel.x - expected) * (pixel.x - expected);
+    return (float)std::sqrt(sum / image.size());
+}
+} // namespace
+
+CPU_TEST(PhotonHashGrid_Query)
+{
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> u(-1.f, 1.f);
+    std::vector<CpuPhoton> photons(10000);
+    for (auto& photon : photons)
+        photon = {float3(u(rng), u(rng), u(rng)), float3(1.f), float3(0.f, 0.f, 1.f)};
+
+    for (float radius : {0.01f, 0.1f, 0.5f})
+    {
+        PhotonHashGrid grid;
+        grid.build(photons, radius);
+        EXPECT_EQ(grid.getPhotonCount(), photons.size());
+
+        for (uint32_t i = 0; i < 1000; i++)
+        {
+            const float3 p(u(rng), u(rng), u(rng));
+            const float queryRadius = radius * (i % 2 ? 1.f : 0.5f);
+
+            size_t expected = 0;
+            for (const auto& photon : photons)
+                if (dot(photon.pos - p, photon.pos - p) < queryRadius * queryRadius)
+                    expected++;
+            size_t count = 0;
+            grid.query(p, queryRadius, [&](const CpuPhoton&) { count++; });
+            EXPECT_EQ(count, expected) << fmt::format("radius={} i={}", radius, i);
+        }
+    }
+}
+
+CPU_TEST(CpuSPPM_FurnaceConvergence)
+{
+    const float albedo = 0.5f;
+    const float emission = 1.f;
+
+    CpuSPPM::Options options;
+    options.photonsPerIteration = 256 * 1024;
+    options.maxBounces = 4;
+
+    // Photons are stored at the first maxBounces diffuse hits, so the gathered radiance is Le * sum_{k=1..maxBounces} albedo^k.
+    // The gather weights photons by bsdf * cos like the GPU pass, which scales isotropic incident light by E[cos] = 2/3.
+    float expected = 0.f;
+    for (uint32_t k = 1; k <= options.maxBounces; k++)
+        expected += emission * std::pow(albedo, (float)k);
+    expected *= 2.f / 3.f;
+
+    CpuSPPM sppm(createFurnace(albedo, emission), options);
+    sppm.run(2);
+    const float error2 = computeRmsError(sppm.getImage(), expected);
+    sppm.run(14);
+    const float error16 = computeRmsError(sppm.getImage(), expected);
+    EXPECT_EQ(sppm.getIteration(), 16u);
+
+    float mean = 0.f;
+    for (const float3& pixel : sppm.getImage())
+        mean += pixel.x;
+    mean /= sppm.getImage().size();
+
+    EXPECT_LE(std::abs(mean - expected), 0.05f * expected) << fmt::format("mean={} expected={}", mean, expected);
+    EXPECT_LT(error16, error2) << fmt::format("error after 2 iterations {}, after 16 iterations {}", error2, error16);
+
+    // Radii only shrink and photon maps are rebuilt for the largest one.
+    const auto& stats = sppm.getStats();
+    for (size_t i = 1; i < stats.size(); i++)
+        EXPECT_LE(stats[i].globalRadius, stats[i - 1].globalRadius);
+}
+
+CPU_TEST(CpuSPPM_Deterministic)
+{
+    CpuSPPM::Options options;
+    options.photonsPerIteration = 64 * 1024;
+    options.seed = 7;
+
+    CpuSPPM a(createFurnace(0.5f, 1.f), options);
+    CpuSPPM b(createFurnace(0.5f, 1.f), options);
+    a.run(2);
+    b.run(2);
+    // Photon blocks are merged in order, so the result doesn't depend on the thread scheduling.
+    for (size_t i = 0; i < a.getImage().size(); i++)
+        EXPECT_TRUE(all(a.getImage()[i] == b.getImage()[i])) << fmt::format("pixel {}", i);
+}
+} // namespace Falcor
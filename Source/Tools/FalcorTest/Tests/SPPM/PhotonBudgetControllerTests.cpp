@@ -0,0 +1,183 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "SPPM/PhotonBudgetController.h"
+
+namespace Falcor
+{
+namespace
+{
+/** Simulated SPPM stages: the time is linear in the photon paths, every path stores a fixed number of photons.
+*/
+struct Workload
+{
+    double msPerPath = 1e-5;
+    double causticPerPath = 1.0;
+    double globalPerPath = 0.0; // before the global store probability is applied
+};
+
+PhotonBudgetController::Measurement measure(const PhotonBudgetController& controller, const Workload& workload)
+{
+    PhotonBudgetController::Measurement m;
+    m.pathCount = controller.getPathCount();
+    m.globalStoreProbability = controller.getGlobalStoreProbability();
+    m.timeMs = float(m.pathCount * workload.msPerPath);
+    m.storedPhotons[0] = uint32_t(m.pathCount * workload.causticPerPath);
+    m.storedPhotons[1] = uint32_t(m.pathCount * workload.globalPerPath * m.globalStoreProbability);
+    return m;
+}
+
+void run(PhotonBudgetController& controller, const Workload& workload, uint32_t frames)
+{
+    for (uint32_t i = 0; i < frames; i++)
+        controller.update(measure(controller, workload));
+}
+
+PhotonBudgetController createController(PhotonBudgetMode mode, float targetTimeMs, uint32_t maxPathCount, uint32_t maxCapacity)
+{
+    PhotonBudgetController controller;
+    PhotonBudgetController::Settings settings;
+    settings.mode = mode;
+    settings.targetTimeMs = targetTimeMs;
+    controller.setSettings(settings);
+    controller.reset(256 * 256, maxPathCount, maxCapacity);
+    return controller;
+}
+} // namespace
+
+CPU_TEST(PhotonBudget_Fixed)
+{
+    PhotonBudgetController controller = createController(PhotonBudgetMode::Fixed, 16.f, 4096 * 4096, 1u << 24);
+    run(controller, Workload(), 200);
+    EXPECT_EQ(controller.getPathCount(), 256u * 256u);
+    EXPECT_EQ(controller.getGlobalStoreProbability(), 1.f);
+    EXPECT_EQ(controller.getCapacity(), 1u << 24);
+}
+
+CPU_TEST(PhotonBudget_TargetFrameTime)
+{
+    // Mostly global photons, the controller also has to lower the global store probability to reach the caustic fraction.
+    PhotonBudgetController controller = createController(PhotonBudgetMode::TargetFrameTime, 16.f, 4096 * 4096, 1u << 24);
+    Workload workload;
+    workload.causticPerPath = 0.1;
+    workload.globalPerPath = 0.9;
+    run(controller, workload, 1000);
+
+    auto m = measure(controller, workload);
+    EXPECT_LE(std::abs(m.timeMs - 16.f), 0.16f) << "time " << m.timeMs << " ms, " << controller.getPathCount() << " paths";
+    const float causticFraction = float(m.storedPhotons[0]) / (m.storedPhotons[0] + m.storedPhotons[1]);
+    EXPECT_LE(std::abs(causticFraction - 0.25f), 0.01f);
+
+    const uint32_t dim = (uint32_t)std::sqrt((double)controller.getPathCount());
+    EXPECT_EQ(dim * dim, controller.getPathCount());
+    EXPECT_GE(controller.getCapacity(), std::max(m.storedPhotons[0], m.storedPhotons[1]));
+
+    // Once converged the settings stay put.
+    const uint32_t pathCount = controller.getPathCount();
+    const uint32_t capacity = controller.getCapacity();
+    run(controller, workload, 200);
+    EXPECT_EQ(controller.getPathCount(), pathCount);
+    EXPECT_EQ(controller.getCapacity(), capacity);
+}
+
+CPU_TEST(PhotonBudget_MaxPhotonCount)
+{
+    // The target time can't be reached within the max photon paths.
+    {
+        PhotonBudgetController controller = createController(PhotonBudgetMode::TargetFrameTime, 1000.f, 512 * 512, 1u << 24);
+        run(controller, Workload(), 400);
+        EXPECT_EQ(controller.getPathCount(), 512u * 512u);
+    }
+
+    // Nor within the max photons stored per photon map, the paths are limited so the stored photons fit.
+    for (PhotonBudgetMode mode : {PhotonBudgetMode::TargetFrameTime, PhotonBudgetMode::MaxThroughput})
+    {
+        const uint32_t maxCapacity = 100000;
+        PhotonBudgetController controller = createController(mode, 1000.f, 4096 * 4096, maxCapacity);
+        Workload workload;
+        workload.causticPerPath = 2.0;
+        // The stored photons per path are only known after the first settled measurement.
+        run(controller, workload, PhotonBudgetController::kSettleFrames);
+        for (uint32_t i = 0; i < 400; i++)
+        {
+            controller.update(measure(controller, workload));
+            auto m = measure(controller, workload);
+            EXPECT_LE(controller.getCapacity(), maxCapacity);
+            EXPECT_LE(m.storedPhotons[0], maxCapacity) << "frame " << i << ", " << controller.getPathCount() << " paths";
+        }
+        // The capacity leaves headroom on top of the stored photons, so they settle somewhat below the limit.
+        EXPECT_GE(measure(controller, workload).storedPhotons[0], maxCapacity / 2);
+    }
+}
+
+CPU_TEST(PhotonBudget_CapacityHysteresis)
+{
+    const uint32_t kSettleFrames = PhotonBudgetController::kSettleFrames;
+    const uint32_t kShrinkFrames = PhotonBudgetController::kShrinkFrames;
+
+    PhotonBudgetController controller = createController(PhotonBudgetMode::TargetFrameTime, 16.f, 4096 * 4096, 1u << 24);
+    Workload workload;
+    run(controller, workload, 1000);
+
+    // Converged, the capacity shrunk from the max capacity to the stored photons.
+    const uint32_t pathCount = controller.getPathCount();
+    const uint32_t capacity = controller.getCapacity();
+    EXPECT_LT(capacity, 1u << 24);
+    EXPECT_GE(capacity, measure(controller, workload).storedPhotons[0]);
+
+    // Fewer stored photons within the hysteresis band keep the capacity.
+    workload.causticPerPath = 0.5;
+    run(controller, workload, 4 * kShrinkFrames);
+    EXPECT_EQ(controller.getPathCount(), pathCount);
+    EXPECT_EQ(controller.getCapacity(), capacity);
+
+    // Dropping below a quarter of the capacity shrinks it, but only after kShrinkFrames measurements.
+    workload.causticPerPath = 0.1;
+    for (uint32_t i = 0; i < kShrinkFrames - 1; i++)
+    {
+        controller.update(measure(controller, workload));
+        EXPECT_EQ(controller.getCapacity(), capacity) << "frame " << i;
+    }
+    run(controller, workload, 2 * kShrinkFrames);
+    const uint32_t shrunkCapacity = controller.getCapacity();
+    EXPECT_LT(shrunkCapacity, capacity / 4);
+    EXPECT_GE(shrunkCapacity, measure(controller, workload).storedPhotons[0]);
+
+    // Going back up within the band doesn't change it either.
+    workload.causticPerPath = 0.12;
+    run(controller, workload, 4 * kShrinkFrames);
+    EXPECT_EQ(controller.getCapacity(), shrunkCapacity);
+
+    // More photons than the capacity holds grow it without waiting. The first settled measurement may still average in frames
+    // of the old workload, the second one only has frames of the new one.
+    workload.causticPerPath = 1.0;
+    run(controller, workload, 2 * kSettleFrames);
+    EXPECT_GE(controller.getCapacity(), measure(controller, workload).storedPhotons[0]);
+    EXPECT_GT(controller.getCapacity(), shrunkCapacity);
+}
+} // namespace Falcor
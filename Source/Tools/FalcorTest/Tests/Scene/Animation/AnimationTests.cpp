@@ -0,0 +1,110 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Animation/Animation.h"
+#include <algorithm>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+const uint32_t kKeyframeCount = 64;
+const double kKeyframeSpacing = 0.5;
+
+ref<Animation> createAnimation(Animation::InterpolationMode mode)
+{
+    ref<Animation> pAnimation = Animation::create("test", NodeID{0}, kKeyframeSpacing * (kKeyframeCount - 1));
+    pAnimation->setInterpolationMode(mode);
+    pAnimation->setPostInfinityBehavior(Animation::Behavior::Cycle);
+    for (uint32_t i = 0; i < kKeyframeCount; i++)
+    {
+        Animation::Keyframe keyframe;
+        keyframe.time = i * kKeyframeSpacing;
+        keyframe.translation = float3((float)i, (float)(i * i), 0.f);
+        pAnimation->addKeyframe(keyframe);
+    }
+    return pAnimation;
+}
+
+std::vector<double> createTimes(bool ascending)
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> u(-1.0, kKeyframeSpacing * kKeyframeCount * 2.0);
+    std::vector<double> times(1000);
+    for (auto& t : times)
+        t = u(rng);
+    if (ascending)
+        std::sort(times.begin(), times.end());
+    // Keyframe times exactly.
+    times[0] = 0.0;
+    times[1] = kKeyframeSpacing * 3;
+    return times;
+}
+} // namespace
+
+CPU_TEST(Animation_LinearRandomAccess)
+{
+    ref<Animation> pAnimation = createAnimation(Animation::InterpolationMode::Linear);
+
+    // Times within the keyframe range in random order, including backward seeks.
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> u(0.0, kKeyframeSpacing * (kKeyframeCount - 1));
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        const double time = u(rng);
+        const double frame = time / kKeyframeSpacing;
+        const uint32_t i0 = std::min((uint32_t)frame, kKeyframeCount - 2);
+        const float t = (float)(frame - i0);
+        const float3 expected = math::lerp(float3((float)i0, (float)(i0 * i0), 0.f), float3((float)(i0 + 1), (float)((i0 + 1) * (i0 + 1)), 0.f), t);
+
+        const float4x4 m = pAnimation->animate(time);
+        const float3 translation = float3(m[0][3], m[1][3], m[2][3]);
+        EXPECT_LE(length(translation - expected), 1e-3f * (1.f + length(expected))) << "time " << time;
+    }
+}
+
+CPU_TEST(Animation_EvaluateMatchesAnimate)
+{
+    for (auto mode : {Animation::InterpolationMode::Linear, Animation::InterpolationMode::Hermite})
+    {
+        ref<Animation> pAnimation = createAnimation(mode);
+        for (bool ascending : {true, false})
+        {
+            const std::vector<double> times = createTimes(ascending);
+            std::vector<float4x4> transforms(times.size());
+            pAnimation->evaluate(times, transforms);
+
+            for (size_t i = 0; i < times.size(); i++)
+            {
+                EXPECT_TRUE(transforms[i] == pAnimation->animate(times[i])) << "time " << times[i];
+            }
+        }
+    }
+}
+} // namespace Falcor
@@ -0,0 +1,137 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/AssetCache.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace Falcor
+{
+namespace
+{
+AssetCache::Key createKey(const std::string& name)
+{
+    // Real keys hash the mesh data, a key of the test name can't collide with them.
+    SHA1 sha1;
+    sha1.update("AssetCacheTests/" + name);
+    return sha1.finalize();
+}
+
+SceneBuilder::ProcessedMesh createMesh()
+{
+    SceneBuilder::ProcessedMesh mesh;
+    mesh.topology = Vao::Topology::TriangleList;
+    mesh.indexCount = 6;
+    mesh.use16BitIndices = false;
+    mesh.isFrontFaceCW = true;
+    mesh.indexData = {0, 1, 2, 2, 1, 3};
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        StaticVertexData v = {};
+        v.position = float3(float(i & 1), float(i >> 1), 0.f);
+        v.normal = float3(0.f, 0.f, 1.f);
+        v.tangent = float4(1.f, 0.f, 0.f, 1.f);
+        v.texCrd = float2(v.position.x, v.position.y);
+        mesh.staticData.push_back(v);
+    }
+    return mesh;
+}
+
+size_t countTempFiles(const std::filesystem::path& path)
+{
+    size_t count = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(path.parent_path()))
+    {
+        if (entry.path().filename().string().rfind(path.filename().string() + ".tmp", 0) == 0)
+            count++;
+    }
+    return count;
+}
+} // namespace
+
+CPU_TEST(AssetCache_Mesh)
+{
+    const AssetCache::Key key = createKey("AssetCache_Mesh");
+    const std::filesystem::path path = AssetCache::getEntryPath(key);
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+
+    // Only the geometry is read from the cache, the name is kept.
+    SceneBuilder::ProcessedMesh result;
+    result.name = "AssetCacheTestMesh";
+
+    // Miss.
+    EXPECT_FALSE(AssetCache::readMesh(key, result));
+    EXPECT_EQ(result.indexCount, 0u);
+
+    // Store.
+    const SceneBuilder::ProcessedMesh mesh = createMesh();
+    AssetCache::writeMesh(key, mesh);
+    ASSERT(std::filesystem::exists(path));
+    EXPECT_EQ(countTempFiles(path), 0u);
+
+    // Hit.
+    ASSERT(AssetCache::readMesh(key, result));
+    EXPECT_EQ(result.name, "AssetCacheTestMesh");
+    EXPECT(result.topology == mesh.topology);
+    EXPECT_EQ(result.indexCount, mesh.indexCount);
+    EXPECT_EQ(result.use16BitIndices, mesh.use16BitIndices);
+    EXPECT_EQ(result.isFrontFaceCW, mesh.isFrontFaceCW);
+    EXPECT_EQ(result.isAnimated, mesh.isAnimated);
+    EXPECT(result.indexData == mesh.indexData);
+    ASSERT_EQ(result.staticData.size(), mesh.staticData.size());
+    EXPECT_EQ(std::memcmp(result.staticData.data(), mesh.staticData.data(), mesh.staticData.size() * sizeof(StaticVertexData)), 0);
+    EXPECT(result.skinningData.empty());
+
+    // Corrupt entries are misses and leave the mesh untouched.
+    const auto fileSize = std::filesystem::file_size(path);
+    std::filesystem::resize_file(path, fileSize / 2);
+    SceneBuilder::ProcessedMesh corrupt;
+    EXPECT_FALSE(AssetCache::readMesh(key, corrupt));
+    EXPECT_EQ(corrupt.indexCount, 0u);
+    EXPECT(corrupt.staticData.empty());
+
+    AssetCache::writeMesh(key, mesh);
+    EXPECT_EQ(std::filesystem::file_size(path), fileSize);
+    {
+        std::fstream fs(path, std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+        fs.write("Garbage!", 8);
+    }
+    EXPECT_FALSE(AssetCache::readMesh(key, corrupt));
+    EXPECT_EQ(corrupt.indexCount, 0u);
+
+    // Rewriting the entry repairs it.
+    AssetCache::writeMesh(key, mesh);
+    EXPECT(AssetCache::readMesh(key, corrupt));
+    EXPECT(corrupt.indexData == mesh.indexData);
+    EXPECT_EQ(countTempFiles(path), 0u);
+
+    std::filesystem::remove(path, ec);
+}
+} // namespace Falcor
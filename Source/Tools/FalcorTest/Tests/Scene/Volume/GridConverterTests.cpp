@@ -0,0 +1,139 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Volume/GridConverter.h"
+#include "Utils/HostDeviceShared.slangh"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4146 4244 4267 4275 4996 4456)
+#endif
+// TODO: GridBuilder.h uses the std::result_of type trait which is deprecated in C++17 and
+// removed in C++20. This is an ugly workaround to use C++20's invoke_result type trait.
+#define result_of invoke_result
+#include <nanovdb/util/GridBuilder.h>
+#undef result_of
+#include <nanovdb/util/Primitives.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+/** Brute force range of a brick, reading the brick and its 1-voxel halo through the accessor.
+ */
+uint32_t computeReferenceRange(const nanovdb::FloatGrid* grid, const nanovdb::Coord& ijk)
+{
+    auto a = grid->getAccessor();
+    float minorant = a.getValue(ijk), majorant = minorant;
+    if (a.probeLeaf(ijk))
+    {
+        for (int x = -1; x <= 8; ++x)
+        {
+            for (int y = -1; y <= 8; ++y)
+            {
+                for (int z = -1; z <= 8; ++z)
+                {
+                    float value = a.getValue(ijk + nanovdb::Coord(x, y, z));
+                    minorant = std::min(minorant, value);
+                    majorant = std::max(majorant, value);
+                }
+            }
+        }
+    }
+    if (minorant == majorant) return f32tof16(majorant) + (f32tof16(majorant) << 16);
+    return (uint32_t(f32tof16(majorant)) + 1) + (f32tof16(minorant) << 16);
+}
+
+void testRange(CPUUnitTestContext& ctx, NanoVDBConverterBC4& converter, const nanovdb::FloatGrid* grid)
+{
+    const auto& range = converter.getRangeData();
+    const int3 leafDim = converter.getLeafDim(0);
+    const int3 indexMin = converter.getIndexMin();
+    for (int z = 0; z < leafDim.z; ++z)
+    {
+        for (int y = 0; y < leafDim.y; ++y)
+        {
+            for (int x = 0; x < leafDim.x; ++x)
+            {
+                const nanovdb::Coord ijk(x * 8 + indexMin.x, y * 8 + indexMin.y, z * 8 + indexMin.z);
+                const size_t i = ((size_t)z * leafDim.y + y) * leafDim.x + x;
+                EXPECT_EQ(range[i], computeReferenceRange(grid, ijk)) << fmt::format("brick ({}, {}, {})", x, y, z);
+            }
+        }
+    }
+}
+}
+
+CPU_TEST(BC4Encode_SSE2MatchesScalar)
+{
+    std::mt19937 rng(0);
+    for (int t = 0; t < 100000; ++t)
+    {
+        // Mix uniform noise, narrow ranges and tiles with the 0 and 255 special codes.
+        uint8_t tile[16];
+        const int base = rng() % 256;
+        const int spread = 1 + rng() % 256;
+        for (int i = 0; i < 16; ++i)
+        {
+            switch (t % 4)
+            {
+            case 0: tile[i] = uint8_t(rng() % 256); break;
+            case 1: tile[i] = uint8_t(base); break;
+            case 2: tile[i] = uint8_t(std::min(255, base + int(rng() % spread))); break;
+            default: tile[i] = rng() % 3 == 0 ? 0 : (rng() % 3 == 0 ? 255 : uint8_t(rng() % 256)); break;
+            }
+        }
+
+        uint64_t reference = 0, block = 0;
+        CompressAlphaDxt5Scalar(tile, &reference);
+        CompressAlphaDxt5(tile, &block);
+        EXPECT_EQ(block, reference) << fmt::format("tile {}", t);
+    }
+}
+
+CPU_TEST(GridConverter_Range)
+{
+    // The halo is read from the neighbouring leaves, it must match reading every halo voxel through the accessor.
+    auto sphere = nanovdb::createFogVolumeSphere<float>(20.f, nanovdb::Vec3f(0.f), 1.f, 3.f);
+    auto box = nanovdb::createFogVolumeBox<float>(30.f, 10.f, 20.f, nanovdb::Vec3f(0.f), 1.f, 3.f);
+
+    NanoVDBConverterBC4 converter(sphere.grid<float>());
+    converter.convertBricks();
+    testRange(ctx, converter, sphere.grid<float>());
+
+    // Reuse the converter for another grid.
+    converter.reset(box.grid<float>());
+    converter.convertBricks();
+    testRange(ctx, converter, box.grid<float>());
+}
+}
@@ -0,0 +1,174 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Core/Platform/OS.h"
+#include "Scene/Volume/GridSequenceStreamer.h"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4146 4244 4267 4275 4996 4456)
+#endif
+// TODO: GridBuilder.h uses the std::result_of type trait which is deprecated in C++17 and
+// removed in C++20. This is an ugly workaround to use C++20's invoke_result type trait.
+#define result_of invoke_result
+#include <nanovdb/util/GridBuilder.h>
+#undef result_of
+#include <nanovdb/util/Primitives.h>
+#include <nanovdb/util/IO.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+namespace Falcor
+{
+namespace
+{
+const std::string kGridname = "density";
+
+/** Grid sequence files of identical fog volume spheres, removed when going out of scope.
+ */
+struct GridSequenceFiles
+{
+    std::vector<std::filesystem::path> paths;
+
+    GridSequenceFiles(uint32_t frameCount)
+    {
+        auto handle = nanovdb::createFogVolumeSphere<float>(8.f, nanovdb::Vec3f(0.f), 1.0, 2.0, nanovdb::Vec3d(0.0), kGridname);
+        for (uint32_t i = 0; i < frameCount; ++i)
+        {
+            auto path = getTempFilePath().replace_extension(".nvdb");
+            nanovdb::io::writeGrid(path.string(), handle);
+            paths.push_back(path);
+        }
+    }
+
+    ~GridSequenceFiles()
+    {
+        for (const auto& path : paths) std::filesystem::remove(path);
+    }
+};
+
+std::vector<uint32_t> getResidentFrames(const GridSequenceStreamer& streamer)
+{
+    std::vector<uint32_t> frames;
+    for (uint32_t i = 0; i < streamer.getFrameCount(); ++i)
+        if (streamer.isFrameResident(i))
+            frames.push_back(i);
+    return frames;
+}
+} // namespace
+
+CPU_TEST(GridSequenceStreamer_Window)
+{
+    GridSequenceFiles files(6);
+
+    // Without a device the frames are only loaded on the CPU.
+    GridSequenceStreamer::Options options;
+    options.framesAhead = 2;
+    options.framesBehind = 1;
+    auto pStreamer = GridSequenceStreamer::create(nullptr, files.paths, kGridname, options);
+    EXPECT_EQ(pStreamer->getFrameCount(), 6u);
+
+    auto setFrame = [&](uint32_t frame)
+    {
+        pStreamer->setFrame(frame);
+        pStreamer->finishLoads();
+    };
+
+    // First frame is a miss, the next two frames are prefetched.
+    setFrame(0);
+    EXPECT_TRUE(getResidentFrames(*pStreamer) == std::vector<uint32_t>({0, 1, 2}));
+    EXPECT_EQ(pStreamer->getStats().missCount, 1u);
+    EXPECT_EQ(pStreamer->getStats().hitCount, 0u);
+    EXPECT_EQ(pStreamer->getStats().prefetchCount, 2u);
+
+    // Setting the same frame again is not counted.
+    setFrame(0);
+    EXPECT_EQ(pStreamer->getStats().hitCount + pStreamer->getStats().missCount, 1u);
+
+    // Stepping forward hits the prefetched frames and keeps one frame behind.
+    setFrame(1);
+    EXPECT_TRUE(getResidentFrames(*pStreamer) == std::vector<uint32_t>({0, 1, 2, 3}));
+    setFrame(2);
+    EXPECT_TRUE(getResidentFrames(*pStreamer) == std::vector<uint32_t>({1, 2, 3, 4}));
+    EXPECT_EQ(pStreamer->getStats().hitCount, 2u);
+    EXPECT_EQ(pStreamer->getStats().evictionCount, 1u);
+    EXPECT_EQ(pStreamer->getStats().discardCount, 0u);
+
+    // Jumping to the last frame is a miss, the window wraps around to the start of the sequence.
+    // Frames 2 and 3 leave the window, frame 3 was prefetched but never used.
+    setFrame(5);
+    EXPECT_TRUE(getResidentFrames(*pStreamer) == std::vector<uint32_t>({0, 1, 4, 5}));
+    EXPECT_EQ(pStreamer->getStats().missCount, 2u);
+    EXPECT_EQ(pStreamer->getStats().evictionCount, 3u);
+    EXPECT_EQ(pStreamer->getStats().discardCount, 1u);
+
+    setFrame(0);
+    EXPECT_EQ(pStreamer->getStats().hitCount, 3u);
+    EXPECT_EQ(pStreamer->getStats().missCount, 2u);
+    EXPECT_EQ(pStreamer->getStats().residentFrameCount, (uint32_t)getResidentFrames(*pStreamer).size());
+    EXPECT_TRUE(pStreamer->getGrid() == nullptr);
+
+    pStreamer->resetStats();
+    EXPECT_EQ(pStreamer->getStats().hitCount, 0u);
+    EXPECT_EQ(pStreamer->getStats().missCount, 0u);
+}
+
+CPU_TEST(GridSequenceStreamer_MemoryLimit)
+{
+    GridSequenceFiles files(8);
+
+    // Measure the size of a frame, all frames are the same.
+    GridSequenceStreamer::Options options;
+    options.framesAhead = 0;
+    options.framesBehind = 0;
+    auto pStreamer = GridSequenceStreamer::create(nullptr, files.paths, kGridname, options);
+    pStreamer->setFrame(0);
+    const uint64_t frameBytes = pStreamer->getStats().residentBytes;
+    EXPECT_GT(frameBytes, 0u);
+
+    // All frames are within the window, the memory limit leaves room for two frames.
+    options.framesAhead = 7;
+    options.framesBehind = 7;
+    options.maxConcurrentLoads = 8;
+    options.memoryLimit = frameBytes * 29 / 10;
+    pStreamer = GridSequenceStreamer::create(nullptr, files.paths, kGridname, options);
+
+    pStreamer->setFrame(0);
+    pStreamer->finishLoads();
+    EXPECT_TRUE(getResidentFrames(*pStreamer) == std::vector<uint32_t>({0, 1}));
+
+    // Loading frame 3 exceeds the limit. Frame 1 has the largest distance ahead of frame 3 and is evicted first.
+    pStreamer->setFrame(3);
+    pStreamer->finishLoads();
+    EXPECT_TRUE(getResidentFrames(*pStreamer) == std::vector<uint32_t>({0, 3}));
+    EXPECT_EQ(pStreamer->getStats().evictionCount, 1u);
+    EXPECT_EQ(pStreamer->getStats().discardCount, 1u);
+    EXPECT_EQ(pStreamer->getStats().missCount, 2u);
+}
+} // namespace Falcor
@@ -27,6 +27,7 @@
  **************************************************************************/
 #include "Testing/UnitTest.h"
 #include "Utils/Math/Matrix.h"
+#include "Utils/Math/MatrixSIMD.h"
 
 #include <fmt/format.h>
 #include <iostream>
@@ -281,6 +282,38 @@ CPU_TEST(Matrix_inverse)
     }
 }
 
+CPU_TEST(Matrix_SIMD)
+{
+    // Matrix/matrix multiplication
+    {
+        float4x4 m1({1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16});
+        float4x4 m2({-1, -2, -3, -4, -5, -6, -7, -8, -9, -10, -11, -12, -13, -14, -15, -16});
+        float4x4 m3 = mulSIMD(m1, m2);
+        EXPECT_EQ(m3[0], float4(-90, -100, -110, -120));
+        EXPECT_EQ(m3[1], float4(-202, -228, -254, -280));
+        EXPECT_EQ(m3[2], float4(-314, -356, -398, -440));
+        EXPECT_EQ(m3[3], float4(-426, -484, -542, -600));
+    }
+
+    // Inverse transpose of an affine matrix
+    {
+        float4x4 m = mul(math::matrixFromTranslation(float3(1, -2, 3)), mul(math::matrixFromRotationXYZ(0.3f, -1.1f, 2.f), math::matrixFromScaling(float3(0.5f, 2, 3))));
+        float4x4 expected = transpose(inverse(m));
+        float4x4 m2 = inverseTransposeSIMD(m);
+        for (int r = 0; r < 4; ++r)
+            EXPECT_ALMOST_EQ(m2[r], expected[r]);
+    }
+
+    // Inverse transpose of a projective matrix uses the general inverse
+    {
+        float4x4 m({1, 2, 3, 4, 8, 7, 6, 5, 9, 10, 12, 11, 15, 16, 13, 14});
+        float4x4 expected = transpose(inverse(m));
+        float4x4 m2 = inverseTransposeSIMD(m);
+        for (int r = 0; r < 4; ++r)
+            EXPECT_EQ(m2[r], expected[r]);
+    }
+}
+
 CPU_TEST(Matrix_extractEulerAngleXYZ)
 {
     {
@@ -0,0 +1,170 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Timing/Profiler.h"
+#include "Utils/Threading.h"
+#include <nlohmann/json.hpp>
+
+namespace Falcor
+{
+CPU_TEST(Profiler_InternName)
+{
+    Profiler::NameId a = Profiler::internName("ProfilerTestA");
+    Profiler::NameId b = Profiler::internName("ProfilerTestB");
+    EXPECT_NE(a, Profiler::kInvalidNameId);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(Profiler::internName(std::string("ProfilerTestA")), a);
+    EXPECT_EQ(Profiler::getInternedName(a), "ProfilerTestA");
+    EXPECT_EQ(Profiler::internName("Profiler/Test"), Profiler::kInvalidNameId);
+}
+
+CPU_TEST(Profiler_NameCache)
+{
+    // Constant names are interned once, dynamic names follow their current value.
+    ProfilerNameCache cache;
+    EXPECT_EQ(cache.get("ProfilerTestCached"), Profiler::internName("ProfilerTestCached"));
+    EXPECT_EQ(cache.get("ProfilerTestCached"), Profiler::internName("ProfilerTestCached"));
+
+    ProfilerNameCache dynamicCache;
+    for (const char* name : {"ProfilerTestDynamicA", "ProfilerTestDynamicB"})
+        EXPECT_EQ(dynamicCache.get(name), Profiler::internName(name));
+    std::string name = "ProfilerTestDynamicC";
+    EXPECT_EQ(dynamicCache.get(name), Profiler::internName(name));
+}
+
+GPU_TEST(Profiler_CpuLanes)
+{
+    Profiler* pProfiler = ctx.getDevice()->getProfiler();
+    RenderContext* pRenderContext = ctx.getRenderContext();
+    bool wasEnabled = pProfiler->isEnabled();
+    pProfiler->setEnabled(true);
+    // The CPU lanes are shared by the process and may be collected by the profiler of another device.
+    const bool collecting = pProfiler->isCollectingCpuEvents();
+
+    const Profiler::NameId outer = Profiler::internName("ProfilerTestOuter");
+    const Profiler::NameId inner = Profiler::internName("ProfilerTestInner");
+
+    for (uint32_t frame = 0; frame < 2; ++frame)
+    {
+        Threading::parallelFor(
+            0,
+            64,
+            [&](size_t begin, size_t end)
+            {
+                ScopedCpuProfilerEvent outerEvent(outer);
+                for (size_t i = begin; i < end; ++i)
+                    ScopedCpuProfilerEvent innerEvent(inner);
+            },
+            1
+        );
+        pProfiler->endFrame(pRenderContext);
+    }
+
+    // Worker events show up nested under the root event of their thread's lane.
+    size_t outerCount = 0;
+    size_t innerCount = 0;
+    for (const Profiler::Event* pEvent : pProfiler->getEvents())
+    {
+        const std::string name = pEvent->getName();
+        if (name.find("/CPU thread ") != 0)
+            continue;
+        if (name.size() > 18 && name.compare(name.size() - 18, 18, "/ProfilerTestOuter") == 0)
+            outerCount++;
+        if (name.find("/ProfilerTestOuter/ProfilerTestInner") != std::string::npos)
+        {
+            innerCount++;
+            EXPECT_GE(pEvent->getCpuTime(), 0.f);
+        }
+    }
+    if (collecting)
+        EXPECT_GE(outerCount, 1u);
+    EXPECT_EQ(outerCount, innerCount);
+
+    pProfiler->setEnabled(wasEnabled);
+}
+
+GPU_TEST(Profiler_TraceExport)
+{
+    Profiler* pProfiler = ctx.getDevice()->getProfiler();
+    RenderContext* pRenderContext = ctx.getRenderContext();
+    bool wasEnabled = pProfiler->isEnabled();
+    pProfiler->setEnabled(true);
+    const bool collecting = pProfiler->isCollectingCpuEvents();
+
+    const Profiler::NameId work = Profiler::internName("ProfilerTestWork");
+
+    pProfiler->startCapture();
+    for (uint32_t frame = 0; frame < 3; ++frame)
+    {
+        {
+            FALCOR_PROFILE(pRenderContext, "ProfilerTestFrame");
+            Threading::parallelFor(0, 16, [&](size_t, size_t) { ScopedCpuProfilerEvent workEvent(work); }, 1);
+        }
+        pProfiler->recordCounter("ProfilerTestCounter", frame);
+        pProfiler->endFrame(pRenderContext);
+    }
+    auto pCapture = pProfiler->endCapture();
+    ASSERT(pCapture != nullptr);
+
+    auto trace = nlohmann::json::parse(pCapture->toTraceJsonString());
+    size_t mainCount = 0;
+    size_t laneCount = 0;
+    size_t markerCount = 0;
+    size_t counterCount = 0;
+    for (const auto& event : trace["traceEvents"])
+    {
+        const std::string ph = event["ph"];
+        if (ph == "X")
+        {
+            EXPECT_GE(event["ts"].get<double>(), 0.0);
+            EXPECT_GE(event["dur"].get<double>(), 0.0);
+            if (event["name"] == "ProfilerTestFrame" && event["tid"] == 0)
+                mainCount++;
+            if (event["name"] == "ProfilerTestWork" && event["tid"].get<uint32_t>() >= 2)
+                laneCount++;
+        }
+        else if (ph == "i")
+        {
+            markerCount++;
+        }
+        else if (ph == "C" && event["name"] == "ProfilerTestCounter")
+        {
+            counterCount++;
+        }
+    }
+    EXPECT_EQ(mainCount, 3u);
+    // CPU lanes are shared by the process, the events are missing if another profiler collects them.
+    EXPECT_LE(laneCount, 48u);
+    if (collecting)
+        EXPECT_GE(laneCount, 1u);
+    EXPECT_EQ(markerCount, 3u);
+    EXPECT_EQ(counterCount, 3u);
+
+    pProfiler->setEnabled(wasEnabled);
+}
+} // namespace Falcor
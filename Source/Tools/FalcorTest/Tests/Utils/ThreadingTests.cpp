@@ -0,0 +1,153 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Threading.h"
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace Falcor
+{
+CPU_TEST(Threading_ParallelFor)
+{
+    for (size_t count : {0, 1, 7, 1000, 100000})
+    {
+        for (size_t grainSize : {0, 1, 64})
+        {
+            std::vector<uint32_t> visits(count, 0);
+            Threading::parallelFor(
+                0,
+                count,
+                [&](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; ++i)
+                        visits[i]++;
+                },
+                grainSize
+            );
+            for (size_t i = 0; i < count; ++i)
+                EXPECT_EQ(visits[i], 1u) << fmt::format("count={} grainSize={} i={}", count, grainSize, i);
+        }
+    }
+}
+
+CPU_TEST(Threading_ParallelForNested)
+{
+    const size_t outerCount = 64;
+    const size_t innerCount = 1000;
+    std::atomic<uint64_t> sum = 0;
+    Threading::parallelForEach(
+        0,
+        outerCount,
+        [&](size_t)
+        {
+            std::atomic<uint64_t> innerSum = 0;
+            Threading::parallelForEach(0, innerCount, [&](size_t i) { innerSum += i; });
+            sum += innerSum;
+        },
+        1
+    );
+    EXPECT_EQ(sum.load(), outerCount * innerCount * (innerCount - 1) / 2);
+}
+
+CPU_TEST(Threading_ParallelForException)
+{
+    std::atomic<uint32_t> count = 0;
+    auto func = [&](size_t i)
+    {
+        count++;
+        if (i == 500)
+            throw std::runtime_error("test");
+    };
+    EXPECT_THROW_AS(Threading::parallelForEach(0, 1000, func, 1), std::runtime_error);
+    EXPECT_GE(count.load(), 1u);
+}
+
+CPU_TEST(Threading_TaskDependencies)
+{
+    // Build a chain of tasks where each task appends its index. Dependencies must enforce the order.
+    const uint32_t taskCount = 100;
+    std::vector<uint32_t> order;
+    std::vector<Threading::Task> tasks;
+    for (uint32_t i = 0; i < taskCount; ++i)
+    {
+        std::vector<Threading::Task> dependencies;
+        if (i > 0)
+            dependencies.push_back(tasks.back());
+        tasks.push_back(Threading::dispatchTask([&order, i]() { order.push_back(i); }, dependencies));
+    }
+    tasks.back().finish();
+    for (auto& task : tasks)
+        EXPECT(!task.isRunning());
+
+    ASSERT_EQ(order.size(), taskCount);
+    for (uint32_t i = 0; i < taskCount; ++i)
+        EXPECT_EQ(order[i], i);
+}
+
+CPU_TEST(Threading_TaskJoin)
+{
+    // A task depending on many independent tasks runs after all of them.
+    const uint32_t taskCount = 256;
+    std::atomic<uint32_t> finished = 0;
+    std::vector<Threading::Task> tasks;
+    for (uint32_t i = 0; i < taskCount; ++i)
+        tasks.push_back(Threading::dispatchTask([&finished]() { finished++; }));
+
+    uint32_t seen = 0;
+    Threading::Task join = Threading::dispatchTask([&]() { seen = finished.load(); }, tasks);
+    join.finish();
+    EXPECT_EQ(seen, taskCount);
+}
+
+CPU_TEST(Threading_TaskException)
+{
+    Threading::Task task = Threading::dispatchTask([]() { throw std::runtime_error("test"); });
+    EXPECT_THROW_AS(task.finish(), std::runtime_error);
+
+    Threading::Task invalid;
+    EXPECT(!invalid.isValid());
+    EXPECT(!invalid.isRunning());
+    invalid.finish();
+}
+
+CPU_TEST(Threading_StartShutdownNested)
+{
+    // FalcorTest already started the scheduler, nested calls keep it and its worker count.
+    const uint32_t workerCount = Threading::getWorkerCount();
+    Threading::start(workerCount + 1);
+    EXPECT_EQ(Threading::getWorkerCount(), workerCount);
+    Threading::shutdown();
+
+    std::atomic<uint32_t> sum = 0;
+    Threading::parallelForEach(0, 100, [&](size_t) { sum++; });
+    EXPECT_EQ(sum.load(), 100u);
+}
+} // namespace Falcor
@@ -0,0 +1,352 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Flip.h"
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+constexpr float kPi = 3.14159265358979323846f;
+
+// FLIP constants.
+constexpr float kQc = 0.7f;
+constexpr float kPc = 0.4f;
+constexpr float kPt = 0.95f;
+constexpr float kW = 0.082f;
+constexpr float kQf = 0.5f;
+
+// Contrast sensitivity function parameters a1, a2, b1, b2 of the achromatic, red-green and blue-yellow channels.
+constexpr float kCsfA[4] = {1.0f, 0.0f, 0.0047f, 1.0e-5f};
+constexpr float kCsfRG[4] = {1.0f, 0.0f, 0.0053f, 1.0e-5f};
+constexpr float kCsfBY[4] = {34.1f, 13.5f, 0.04f, 0.025f};
+
+// Columns processed at once, bounds the size of the intermediate buffers.
+constexpr uint32_t kBlockWidth = 256;
+
+using float3 = std::array<float, 3>;
+
+const float3 kD65ReferenceIlluminant = {0.950428545f, 1.000000000f, 1.088900371f};
+const float3 kInvD65ReferenceIlluminant = {1.052156925f, 1.000000000f, 0.918357670f};
+
+// Color conversions, same as Utils/Color/ColorHelpers.slang.
+
+float sRGBToLinear(float srgb)
+{
+    return srgb <= 0.04045f ? srgb * (1.0f / 12.92f) : std::pow((srgb + 0.055f) * (1.0f / 1.055f), 2.4f);
+}
+
+float3 linearRGBToXYZ(const float3& c)
+{
+    return {
+        (10135552.0f / 24577794.0f) * c[0] + (8788810.0f / 24577794.0f) * c[1] + (4435075.0f / 24577794.0f) * c[2],
+        (2613072.0f / 12288897.0f) * c[0] + (8788810.0f / 12288897.0f) * c[1] + (887015.0f / 12288897.0f) * c[2],
+        (1425312.0f / 73733382.0f) * c[0] + (8788810.0f / 73733382.0f) * c[1] + (70074185.0f / 73733382.0f) * c[2],
+    };
+}
+
+float3 XYZToLinearRGB(const float3& c)
+{
+    return {
+        3.241003275f * c[0] - 1.537398934f * c[1] - 0.498615861f * c[2],
+        -0.969224334f * c[0] + 1.875930071f * c[1] + 0.041554224f * c[2],
+        0.055639423f * c[0] - 0.204011202f * c[1] + 1.057148933f * c[2],
+    };
+}
+
+float3 XYZToCIELab(const float3& c)
+{
+    const float delta = 6.0f / 29.0f;
+    const float deltaCube = delta * delta * delta;
+    const float factor = 1.0f / (3.0f * delta * delta);
+    const float term = 4.0f / 29.0f;
+    float3 t;
+    for (int i = 0; i < 3; ++i)
+    {
+        float v = c[i] * kInvD65ReferenceIlluminant[i];
+        t[i] = v > deltaCube ? std::cbrt(v) : factor * v + term;
+    }
+    return {116.0f * t[1] - 16.0f, 500.0f * (t[0] - t[1]), 200.0f * (t[1] - t[2])};
+}
+
+float3 XYZToYCxCz(const float3& c)
+{
+    float3 t = {c[0] * kInvD65ReferenceIlluminant[0], c[1] * kInvD65ReferenceIlluminant[1], c[2] * kInvD65ReferenceIlluminant[2]};
+    return {116.0f * t[1] - 16.0f, 500.0f * (t[0] - t[1]), 200.0f * (t[1] - t[2])};
+}
+
+float3 YCxCzToXYZ(const float3& c)
+{
+    float y = (c[0] + 16.0f) / 116.0f;
+    float x = c[1] / 500.0f + y;
+    float z = y - c[2] / 200.0f;
+    return {x * kD65ReferenceIlluminant[0], y * kD65ReferenceIlluminant[1], z * kD65ReferenceIlluminant[2]};
+}
+
+float3 hunt(const float3& lab)
+{
+    float h = 0.01f * lab[0];
+    return {lab[0], h * lab[1], h * lab[2]};
+}
+
+float hyAB(const float3& a, const float3& b)
+{
+    return std::fabs(a[0] - b[0]) + std::hypot(a[1] - b[1], a[2] - b[2]);
+}
+
+float redistributeErrors(float colorDifference, float featureDifference)
+{
+    static const float maxDistance =
+        std::pow(hyAB(hunt(XYZToCIELab(linearRGBToXYZ({0.f, 1.f, 0.f}))), hunt(XYZToCIELab(linearRGBToXYZ({0.f, 0.f, 1.f})))), kQc);
+
+    float error = std::pow(colorDifference, kQc);
+    const float perceptualCutoff = kPc * maxDistance;
+    if (error < perceptualCutoff)
+        error *= kPt / perceptualCutoff;
+    else
+        error = kPt + ((error - perceptualCutoff) / (maxDistance - perceptualCutoff)) * (1.0f - kPt);
+    return std::pow(error, 1.0f - featureDifference);
+}
+
+/** 1D factors of the separable FLIP filters.
+    The 2D filters of FLIPPass are products of these, normalized the same way.
+*/
+struct Kernels
+{
+    uint32_t radius;
+    std::vector<float> csfA, csfRG, csfBY1, csfBY2; ///< Normalized Gaussians of the contrast sensitivity functions.
+    float weightBY1, weightBY2;                     ///< Weights of the two blue-yellow Gaussians.
+    std::vector<float> gaussian;                    ///< Normalized feature Gaussian.
+    std::vector<float> edge;                        ///< First derivative of the feature Gaussian.
+    std::vector<float> point;                       ///< Second derivative of the feature Gaussian.
+
+    explicit Kernels(float pixelsPerDegree) : radius(getFlipFilterRadius(pixelsPerDegree))
+    {
+        const int r = int(radius);
+        auto makeKernel = [&](auto f)
+        {
+            std::vector<float> k(2 * r + 1);
+            for (int x = -r; x <= r; ++x)
+                k[x + r] = f(float(x));
+            return k;
+        };
+        auto sum = [](const std::vector<float>& k, float sign)
+        {
+            float s = 0.f;
+            for (float v : k)
+                s += sign * v > 0.f ? sign * v : 0.f;
+            return s;
+        };
+        auto scale = [](std::vector<float>& k, float positiveScale, float negativeScale)
+        {
+            for (float& v : k)
+                v *= v >= 0.f ? positiveScale : negativeScale;
+        };
+
+        // Contrast sensitivity functions, sums of Gaussians in degrees of visual angle.
+        const float dx = 1.0f / pixelsPerDegree;
+        auto csfGaussian = [&](float b) { return makeKernel([&](float x) { return std::exp(-kPi * kPi * x * x * dx * dx / b); }); };
+        csfA = csfGaussian(kCsfA[2]);
+        csfRG = csfGaussian(kCsfRG[2]);
+        csfBY1 = csfGaussian(kCsfBY[2]);
+        csfBY2 = csfGaussian(kCsfBY[3]);
+        const float sumBY1 = sum(csfBY1, 1.f);
+        const float sumBY2 = sum(csfBY2, 1.f);
+        weightBY1 = kCsfBY[0] * std::sqrt(kPi / kCsfBY[2]) * sumBY1 * sumBY1;
+        weightBY2 = kCsfBY[1] * std::sqrt(kPi / kCsfBY[3]) * sumBY2 * sumBY2;
+        const float weightSum = weightBY1 + weightBY2;
+        weightBY1 /= weightSum;
+        weightBY2 /= weightSum;
+        for (auto* k : {&csfA, &csfRG, &csfBY1, &csfBY2})
+        {
+            float s = sum(*k, 1.f);
+            scale(*k, 1.f / s, 1.f / s);
+        }
+
+        // Feature detection, positive and negative weights of the derivative filters are normalized separately.
+        const float sigma = 0.5f * kW * pixelsPerDegree;
+        const float sigma2 = sigma * sigma;
+        gaussian = makeKernel([&](float x) { return std::exp(-x * x / (2.0f * sigma2)); });
+        edge = makeKernel([&](float x) { return -x * std::exp(-x * x / (2.0f * sigma2)); });
+        point = makeKernel([&](float x) { return (x * x / sigma2 - 1.0f) * std::exp(-x * x / (2.0f * sigma2)); });
+        scale(edge, 1.f / sum(edge, 1.f), 1.f / sum(edge, 1.f));
+        scale(point, 1.f / sum(point, 1.f), 1.f / sum(point, -1.f));
+        scale(gaussian, 1.f / sum(gaussian, 1.f), 1.f);
+    }
+};
+
+/// Horizontally filtered channels of one image, planar with one row per data row.
+struct FilteredImage
+{
+    enum Plane
+    {
+        A,
+        RG,
+        BY1,
+        BY2,
+        Edge,
+        Point,
+        Gaussian,
+        Count
+    };
+    std::vector<float> planes[Count];
+};
+
+void filterRows(
+    const ImageTile& tile,
+    bool isA,
+    uint32_t x0,
+    uint32_t width,
+    const Kernels& kernels,
+    FilteredImage& filtered,
+    std::vector<float> (&rows)[4]
+)
+{
+    const bool linear = isA ? tile.linearA : tile.linearB;
+    const uint32_t rowCount = tile.getDataRowCount();
+    for (auto& plane : filtered.planes)
+        plane.resize(size_t(rowCount) * width);
+    for (auto& row : rows)
+        row.resize(width);
+
+    for (uint32_t row = 0; row < rowCount; ++row)
+    {
+        const float* src = (isA ? tile.getRowA(tile.dataY0 + row) : tile.getRowB(tile.dataY0 + row)) + 4 * x0;
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            float3 c;
+            for (int i = 0; i < 3; ++i)
+            {
+                float v = std::clamp(src[4 * x + i], 0.f, 1.f);
+                c[i] = linear ? v : sRGBToLinear(v);
+            }
+            float3 ycxcz = XYZToYCxCz(linearRGBToXYZ(c));
+            rows[0][x] = ycxcz[0];
+            rows[1][x] = ycxcz[1];
+            rows[2][x] = ycxcz[2];
+            rows[3][x] = (ycxcz[0] + 16.0f) / 116.0f; // Normalized Y from YCxCz.
+        }
+
+        auto dst = [&](FilteredImage::Plane plane) { return filtered.planes[plane].data() + size_t(row) * width; };
+        const uint32_t r = kernels.radius;
+        convolveRow(rows[0].data(), width, kernels.csfA.data(), r, dst(FilteredImage::A));
+        convolveRow(rows[1].data(), width, kernels.csfRG.data(), r, dst(FilteredImage::RG));
+        convolveRow(rows[2].data(), width, kernels.csfBY1.data(), r, dst(FilteredImage::BY1));
+        convolveRow(rows[2].data(), width, kernels.csfBY2.data(), r, dst(FilteredImage::BY2));
+        convolveRow(rows[3].data(), width, kernels.edge.data(), r, dst(FilteredImage::Edge));
+        convolveRow(rows[3].data(), width, kernels.point.data(), r, dst(FilteredImage::Point));
+        convolveRow(rows[3].data(), width, kernels.gaussian.data(), r, dst(FilteredImage::Gaussian));
+    }
+}
+
+/// Fully filtered values of one output row.
+struct FilteredRow
+{
+    std::vector<float> a, rg, by, by2, edgeX, edgeY, pointX, pointY;
+
+    void filter(const FilteredImage& image, uint32_t width, uint32_t rowCount, uint32_t row, const Kernels& k)
+    {
+        for (auto* v : {&a, &rg, &by, &by2, &edgeX, &edgeY, &pointX, &pointY})
+            v->resize(width);
+        auto convolve = [&](FilteredImage::Plane plane, const std::vector<float>& kernel, std::vector<float>& dst)
+        { convolveColumns(image.planes[plane].data(), width, rowCount, row, kernel.data(), k.radius, dst.data()); };
+        convolve(FilteredImage::A, k.csfA, a);
+        convolve(FilteredImage::RG, k.csfRG, rg);
+        convolve(FilteredImage::BY1, k.csfBY1, by);
+        convolve(FilteredImage::BY2, k.csfBY2, by2);
+        convolve(FilteredImage::Edge, k.gaussian, edgeX);
+        convolve(FilteredImage::Gaussian, k.edge, edgeY);
+        convolve(FilteredImage::Point, k.gaussian, pointX);
+        convolve(FilteredImage::Gaussian, k.point, pointY);
+        for (uint32_t x = 0; x < width; ++x)
+            by[x] = k.weightBY1 * by[x] + k.weightBY2 * by2[x];
+    }
+
+    float3 getLab(uint32_t x) const
+    {
+        float3 rgb = XYZToLinearRGB(YCxCzToXYZ({a[x], rg[x], by[x]}));
+        for (float& v : rgb)
+            v = std::clamp(v, 0.f, 1.f);
+        return hunt(XYZToCIELab(linearRGBToXYZ(rgb)));
+    }
+};
+} // namespace
+
+uint32_t getFlipFilterRadius(float pixelsPerDegree)
+{
+    // Radius of the widest contrast sensitivity Gaussian, which is wider than the feature filters (see FLIPPass).
+    return uint32_t(std::ceil(3.0f * std::sqrt(0.04f / (2.0f * kPi * kPi)) * pixelsPerDegree));
+}
+
+double computeFlipTile(const ImageTile& tile, float* errorMap, float pixelsPerDegree)
+{
+    const Kernels kernels(pixelsPerDegree);
+    const uint32_t r = kernels.radius;
+    const uint32_t rowCount = tile.getDataRowCount();
+
+    FilteredImage filteredA, filteredB;
+    FilteredRow rowA, rowB;
+    std::vector<float> rows[4];
+    double sum = 0.0;
+
+    for (uint32_t x0 = 0; x0 < tile.width; x0 += kBlockWidth)
+    {
+        // Process the block with halo columns, the filters clamp to the image borders.
+        const uint32_t x1 = std::min(tile.width, x0 + kBlockWidth);
+        const uint32_t dataX0 = x0 >= r ? x0 - r : 0;
+        const uint32_t dataX1 = std::min(tile.width, x1 + r);
+        const uint32_t width = dataX1 - dataX0;
+
+        filterRows(tile, true, dataX0, width, kernels, filteredA, rows);
+        filterRows(tile, false, dataX0, width, kernels, filteredB, rows);
+
+        for (uint32_t y = tile.y0; y < tile.y1; ++y)
+        {
+            rowA.filter(filteredA, width, rowCount, y - tile.dataY0, kernels);
+            rowB.filter(filteredB, width, rowCount, y - tile.dataY0, kernels);
+
+            for (uint32_t x = x0; x < x1; ++x)
+            {
+                const uint32_t i = x - dataX0;
+                const float colorDifference = hyAB(rowA.getLab(i), rowB.getLab(i));
+                const float edgeDifference = std::fabs(std::hypot(rowA.edgeX[i], rowA.edgeY[i]) - std::hypot(rowB.edgeX[i], rowB.edgeY[i]));
+                const float pointDifference =
+                    std::fabs(std::hypot(rowA.pointX[i], rowA.pointY[i]) - std::hypot(rowB.pointX[i], rowB.pointY[i]));
+                const float featureDifference = std::pow(std::max(edgeDifference, pointDifference) * 0.70710678f, kQf);
+
+                const float error = redistributeErrors(colorDifference, featureDifference);
+                if (errorMap)
+                    errorMap[size_t(y - tile.y0) * tile.width + x] = error;
+                sum += error;
+            }
+        }
+    }
+
+    return sum;
+}
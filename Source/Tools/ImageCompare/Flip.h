@@ -0,0 +1,43 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "ImageTile.h"
+
+/** CPU version of LDR-FLIP, following the FLIPPass render pass.
+    See https://research.nvidia.com/publication/2020-07_FLIP.
+    Pixels are clamped to [0, 1]. sRGB encoded images are linearized first, HDR images should be tone mapped before comparing.
+*/
+
+/// Pixels per degree for a 0.7 m wide 3840 pixel monitor viewed from 0.7 m, same as the FLIPPass defaults.
+constexpr float kFlipPixelsPerDegree = 67.0206f;
+
+/// Radius of the FLIP filters in pixels.
+uint32_t getFlipFilterRadius(float pixelsPerDegree = kFlipPixelsPerDegree);
+
+/// Compute the FLIP error of the rows [tile.y0, tile.y1). Writes the per-pixel errors to errorMap if not null and returns their sum.
+double computeFlipTile(const ImageTile& tile, float* errorMap, float pixelsPerDegree = kFlipPixelsPerDegree);
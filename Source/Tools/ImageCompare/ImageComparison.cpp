@@ -0,0 +1,772 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "ImageComparison.h"
+#include "Flip.h"
+#include "Utils/Threading.h"
+
+#include <FreeImage.h>
+#include <nlohmann/json.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <map>
+#include <functional>
+#include <filesystem>
+#include <chrono>
+
+#include <cmath>
+#include <cstring>
+
+using Falcor::Threading;
+
+namespace
+{
+template<typename T>
+T sqr(T x)
+{
+    return x * x;
+}
+
+template<typename T>
+T lerp(T a, T b, T t)
+{
+    return a + t * (b - a);
+}
+
+template<typename T>
+T clamp(T x, T lo, T hi)
+{
+    return std::max(lo, std::min(hi, x));
+}
+
+class Image
+{
+public:
+    Image(uint32_t width, uint32_t height) : mWidth(width), mHeight(height), mData(std::make_unique<float[]>(width * height * 4)) {}
+
+    uint32_t getWidth() const { return mWidth; }
+    uint32_t getHeight() const { return mHeight; }
+    const float* getData() const { return mData.get(); }
+    float* getData() { return mData.get(); }
+
+    static std::shared_ptr<Image> create(uint32_t width, uint32_t height) { return std::make_shared<Image>(width, height); }
+
+    void saveToFile(const std::filesystem::path& path, bool writeAlpha = true) const
+    {
+        FREE_IMAGE_FORMAT fifFormat = FIF_UNKNOWN;
+
+        auto pathStr = path.string();
+
+        // Determine file format.
+        fifFormat = FreeImage_GetFIFFromFilename(pathStr.c_str());
+        if (fifFormat == FIF_UNKNOWN)
+            throw std::runtime_error("Unknown image format");
+        if (!FreeImage_FIFSupportsWriting(fifFormat))
+            throw std::runtime_error("Unsupported image format");
+
+        bool writeFloat = fifFormat == FIF_EXR || fifFormat == FIF_PFM || fifFormat == FIF_HDR;
+        if (fifFormat != FIF_EXR && fifFormat != FIF_PNG)
+            writeAlpha = false;
+
+        // Create bitmap.
+        FIBITMAP* bitmap;
+        const float* src = getData();
+        if (writeFloat)
+        {
+            bitmap = FreeImage_AllocateT(writeAlpha ? FIT_RGBAF : FIT_RGBF, mWidth, mHeight);
+            for (uint32_t y = 0; y < mHeight; y++)
+            {
+                float* dst = reinterpret_cast<float*>(FreeImage_GetScanLine(bitmap, mHeight - y - 1));
+                if (writeAlpha)
+                {
+                    std::memcpy(dst, src, mWidth * 4 * sizeof(float));
+                    src += mWidth * 4;
+                }
+                else
+                {
+                    for (uint32_t x = 0; x < mWidth; ++x)
+                    {
+                        dst[0] = src[0];
+                        dst[1] = src[1];
+                        dst[2] = src[2];
+                        dst += 3;
+                        src += 4;
+                    }
+                }
+            }
+        }
+        else
+        {
+            bitmap = FreeImage_Allocate(mWidth, mHeight, writeAlpha ? 32 : 24);
+            for (uint32_t y = 0; y < mHeight; y++)
+            {
+                uint8_t* dst = reinterpret_cast<uint8_t*>(FreeImage_GetScanLine(bitmap, mHeight - y - 1));
+                for (uint32_t x = 0; x < mWidth; ++x)
+                {
+                    dst[2] = clamp(int(src[0] * 255.f), 0, 255);
+                    dst[1] = clamp(int(src[1] * 255.f), 0, 255);
+                    dst[0] = clamp(int(src[2] * 255.f), 0, 255);
+                    if (writeAlpha)
+                        dst[3] = clamp(int(src[3] * 255.f), 0, 255);
+                    dst += writeAlpha ? 4 : 3;
+                    src += 4;
+                }
+            }
+        }
+
+        // Write image.
+        FreeImage_Save(fifFormat, bitmap, pathStr.c_str());
+        FreeImage_Unload(bitmap);
+    }
+
+private:
+    uint32_t mWidth;
+    uint32_t mHeight;
+    std::unique_ptr<float[]> mData;
+};
+
+/** Image loaded from file in its native pixel format.
+    Pixels are converted to RGBA float a range of rows at a time, so comparing does not need full float copies of the images.
+*/
+class SourceImage
+{
+public:
+    ~SourceImage() { FreeImage_Unload(mpBitmap); }
+
+    uint32_t getWidth() const { return mWidth; }
+    uint32_t getHeight() const { return mHeight; }
+
+    /// True for floating-point images, false for integer images, which are assumed to be sRGB encoded.
+    bool isLinear() const { return mType == FIT_FLOAT || mType == FIT_RGBF || mType == FIT_RGBAF; }
+
+    static std::shared_ptr<SourceImage> loadFromFile(const std::filesystem::path& path)
+    {
+        FREE_IMAGE_FORMAT fifFormat = FIF_UNKNOWN;
+
+        auto pathStr = path.string();
+
+        // Determine file format.
+        fifFormat = FreeImage_GetFileType(pathStr.c_str(), 0);
+        if (fifFormat == FIF_UNKNOWN)
+            fifFormat = FreeImage_GetFIFFromFilename(pathStr.c_str());
+        if (fifFormat == FIF_UNKNOWN)
+            throw std::runtime_error("Unknown image format");
+        if (!FreeImage_FIFSupportsReading(fifFormat))
+            throw std::runtime_error("Unsupported image format");
+
+        // Read image.
+        FIBITMAP* bitmap = FreeImage_Load(fifFormat, pathStr.c_str());
+        if (!bitmap)
+            throw std::runtime_error("Cannot read image");
+
+        // Convert formats readRows() does not handle directly.
+        FIBITMAP* converted = nullptr;
+        switch (FreeImage_GetImageType(bitmap))
+        {
+        case FIT_BITMAP:
+            if (FreeImage_GetBPP(bitmap) != 24 && FreeImage_GetBPP(bitmap) != 32)
+                converted = FreeImage_ConvertTo32Bits(bitmap);
+            break;
+        case FIT_UINT16:
+        case FIT_RGB16:
+        case FIT_RGBA16:
+        case FIT_FLOAT:
+        case FIT_RGBF:
+        case FIT_RGBAF:
+            break;
+        default:
+            converted = FreeImage_ConvertToRGBAF(bitmap);
+            break;
+        }
+        if (converted)
+        {
+            FreeImage_Unload(bitmap);
+            bitmap = converted;
+        }
+        if (!isSupported(bitmap))
+        {
+            FreeImage_Unload(bitmap);
+            throw std::runtime_error("Cannot convert to RGBA float format");
+        }
+
+        return std::shared_ptr<SourceImage>(new SourceImage(bitmap));
+    }
+
+    /// Convert the rows [y0, y1) to RGBA float. Rows are ordered top to bottom.
+    void readRows(uint32_t y0, uint32_t y1, float* dst) const
+    {
+        for (uint32_t y = y0; y < y1; ++y)
+        {
+            const BYTE* src = FreeImage_GetScanLine(mpBitmap, mHeight - y - 1);
+            switch (mType)
+            {
+            case FIT_BITMAP:
+            {
+                const uint32_t stride = FreeImage_GetBPP(mpBitmap) / 8;
+                for (uint32_t x = 0; x < mWidth; ++x, src += stride, dst += 4)
+                {
+                    dst[0] = src[FI_RGBA_RED] * (1.f / 255.f);
+                    dst[1] = src[FI_RGBA_GREEN] * (1.f / 255.f);
+                    dst[2] = src[FI_RGBA_BLUE] * (1.f / 255.f);
+                    dst[3] = stride == 4 ? src[FI_RGBA_ALPHA] * (1.f / 255.f) : 1.f;
+                }
+                break;
+            }
+            case FIT_UINT16:
+            {
+                auto pixels = reinterpret_cast<const uint16_t*>(src);
+                for (uint32_t x = 0; x < mWidth; ++x, dst += 4)
+                {
+                    dst[0] = dst[1] = dst[2] = pixels[x] * (1.f / 65535.f);
+                    dst[3] = 1.f;
+                }
+                break;
+            }
+            case FIT_RGB16:
+            {
+                auto pixels = reinterpret_cast<const FIRGB16*>(src);
+                for (uint32_t x = 0; x < mWidth; ++x, dst += 4)
+                {
+                    dst[0] = pixels[x].red * (1.f / 65535.f);
+                    dst[1] = pixels[x].green * (1.f / 65535.f);
+                    dst[2] = pixels[x].blue * (1.f / 65535.f);
+                    dst[3] = 1.f;
+                }
+                break;
+            }
+            case FIT_RGBA16:
+            {
+                auto pixels = reinterpret_cast<const FIRGBA16*>(src);
+                for (uint32_t x = 0; x < mWidth; ++x, dst += 4)
+                {
+                    dst[0] = pixels[x].red * (1.f / 65535.f);
+                    dst[1] = pixels[x].green * (1.f / 65535.f);
+                    dst[2] = pixels[x].blue * (1.f / 65535.f);
+                    dst[3] = pixels[x].alpha * (1.f / 65535.f);
+                }
+                break;
+            }
+            case FIT_FLOAT:
+            {
+                auto pixels = reinterpret_cast<const float*>(src);
+                for (uint32_t x = 0; x < mWidth; ++x, dst += 4)
+                {
+                    dst[0] = dst[1] = dst[2] = pixels[x];
+                    dst[3] = 1.f;
+                }
+                break;
+            }
+            case FIT_RGBF:
+            {
+                auto pixels = reinterpret_cast<const FIRGBF*>(src);
+                for (uint32_t x = 0; x < mWidth; ++x, dst += 4)
+                {
+                    dst[0] = pixels[x].red;
+                    dst[1] = pixels[x].green;
+                    dst[2] = pixels[x].blue;
+                    dst[3] = 1.f;
+                }
+                break;
+            }
+            case FIT_RGBAF:
+                std::memcpy(dst, src, mWidth * 4 * sizeof(float));
+                dst += mWidth * 4;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+private:
+    SourceImage(FIBITMAP* pBitmap)
+        : mpBitmap(pBitmap)
+        , mType(FreeImage_GetImageType(pBitmap))
+        , mWidth(FreeImage_GetWidth(pBitmap))
+        , mHeight(FreeImage_GetHeight(pBitmap))
+    {}
+
+    static bool isSupported(FIBITMAP* pBitmap)
+    {
+        switch (FreeImage_GetImageType(pBitmap))
+        {
+        case FIT_BITMAP:
+            return FreeImage_GetBPP(pBitmap) == 24 || FreeImage_GetBPP(pBitmap) == 32;
+        case FIT_UINT16:
+        case FIT_RGB16:
+        case FIT_RGBA16:
+        case FIT_FLOAT:
+        case FIT_RGBF:
+        case FIT_RGBAF:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    FIBITMAP* mpBitmap;
+    FREE_IMAGE_TYPE mType;
+    uint32_t mWidth;
+    uint32_t mHeight;
+};
+
+// Per-channel metrics, the error of a pixel is the mean over its channels.
+// Errors are evaluated and accumulated in double precision.
+
+struct MSE
+{
+    static double eval(float a, float b) { return sqr(a - b); }
+};
+
+struct RMSE
+{
+    static double eval(float a, float b) { return sqr(a - b) / (sqr(a) + 1e-3); }
+};
+
+struct RelMSE
+{
+    static double eval(float a, float b) { return sqr(a - b) / (sqr(a) + 1e-2); }
+};
+
+struct MAE
+{
+    static double eval(float a, float b) { return std::fabs(sqr(a - b)); }
+};
+
+struct MAPE
+{
+    static double eval(float a, float b) { return 100.0 * std::fabs((a - b) / (a + 1e-3)); }
+};
+
+template<typename Metric, uint32_t kChannels>
+double compareTile(const ImageTile& tile, float* errorMap)
+{
+    double sum = 0.0;
+    for (uint32_t y = tile.y0; y < tile.y1; ++y)
+    {
+        const float* a = tile.getRowA(y);
+        const float* b = tile.getRowB(y);
+        for (uint32_t x = 0; x < tile.width; ++x)
+        {
+            double error = 0.0;
+            for (uint32_t c = 0; c < kChannels; ++c)
+                error += Metric::eval(a[4 * x + c], b[4 * x + c]);
+            error /= kChannels;
+            if (errorMap)
+                *errorMap++ = float(error);
+            sum += error;
+        }
+    }
+    return sum;
+}
+
+template<typename Metric>
+double compareTile(const ImageTile& tile, float* errorMap)
+{
+    return tile.alpha ? compareTile<Metric, 4>(tile, errorMap) : compareTile<Metric, 3>(tile, errorMap);
+}
+
+/** Structural dissimilarity (1 - SSIM) of the luminance, with a 11x11 Gaussian window with sigma 1.5.
+    See Wang et al. 2004, "Image Quality Assessment: From Error Visibility to Structural Similarity".
+*/
+constexpr uint32_t kSSIMRadius = 5;
+
+double compareTileSSIM(const ImageTile& tile, float* errorMap)
+{
+    static const std::vector<float> kernel = []()
+    {
+        std::vector<float> k(2 * kSSIMRadius + 1);
+        float sum = 0.f;
+        for (int x = -int(kSSIMRadius); x <= int(kSSIMRadius); ++x)
+            sum += k[x + kSSIMRadius] = std::exp(-float(x * x) / (2.f * 1.5f * 1.5f));
+        for (float& v : k)
+            v /= sum;
+        return k;
+    }();
+    const float C1 = sqr(0.01f);
+    const float C2 = sqr(0.03f);
+
+    // Horizontally filtered a, b, a^2, b^2 and ab, planar with one row per data row.
+    const uint32_t width = tile.width;
+    const uint32_t rowCount = tile.getDataRowCount();
+    std::vector<float> planes[5];
+    for (auto& plane : planes)
+        plane.resize(size_t(rowCount) * width);
+    std::vector<float> rows[5];
+    for (auto& row : rows)
+        row.resize(width);
+
+    auto luminance = [](const float* p) { return 0.2126f * p[0] + 0.7152f * p[1] + 0.0722f * p[2]; };
+    for (uint32_t row = 0; row < rowCount; ++row)
+    {
+        const float* a = tile.getRowA(tile.dataY0 + row);
+        const float* b = tile.getRowB(tile.dataY0 + row);
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            float la = luminance(a + 4 * x);
+            float lb = luminance(b + 4 * x);
+            rows[0][x] = la;
+            rows[1][x] = lb;
+            rows[2][x] = la * la;
+            rows[3][x] = lb * lb;
+            rows[4][x] = la * lb;
+        }
+        for (uint32_t i = 0; i < 5; ++i)
+            convolveRow(rows[i].data(), width, kernel.data(), kSSIMRadius, planes[i].data() + size_t(row) * width);
+    }
+
+    double sum = 0.0;
+    for (uint32_t y = tile.y0; y < tile.y1; ++y)
+    {
+        for (uint32_t i = 0; i < 5; ++i)
+            convolveColumns(planes[i].data(), width, rowCount, y - tile.dataY0, kernel.data(), kSSIMRadius, rows[i].data());
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const float muA = rows[0][x];
+            const float muB = rows[1][x];
+            const float varA = rows[2][x] - muA * muA;
+            const float varB = rows[3][x] - muB * muB;
+            const float covar = rows[4][x] - muA * muB;
+            const float ssim = ((2.f * muA * muB + C1) * (2.f * covar + C2)) / ((muA * muA + muB * muB + C1) * (varA + varB + C2));
+            const float error = 1.f - ssim;
+            if (errorMap)
+                *errorMap++ = error;
+            sum += error;
+        }
+    }
+    return sum;
+}
+} // namespace
+
+static const std::vector<ErrorMetric> kErrorMetrics = {
+    {"mse", "Mean Squared Error", 0, compareTile<MSE>},
+    {"rmse", "Relative Mean Squared Error", 0, compareTile<RMSE>},
+    {"relmse", "Relative Mean Squared Error with epsilon 0.01", 0, compareTile<RelMSE>},
+    {"mae", "Mean Absolute Error", 0, compareTile<MAE>},
+    {"mape", "Mean Absolute Percentage Error", 0, compareTile<MAPE>},
+    {"ssim", "Structural Dissimilarity (1 - SSIM) of the luminance", kSSIMRadius, compareTileSSIM},
+    {"flip", "LDR-FLIP, inputs clamped to [0, 1]", getFlipFilterRadius(), [](const ImageTile& tile, float* errorMap)
+     { return computeFlipTile(tile, errorMap); }},
+};
+
+const std::vector<ErrorMetric>& getErrorMetrics()
+{
+    return kErrorMetrics;
+}
+
+const ErrorMetric* findMetric(const std::string& name)
+{
+    auto it = std::find_if(kErrorMetrics.begin(), kErrorMetrics.end(), [&name](const ErrorMetric& metric) { return metric.name == name; });
+    return it != kErrorMetrics.end() ? &*it : nullptr;
+}
+
+/** Compare two images of the same size and return the mean of the per-pixel errors.
+    The images are processed in tiles of rows on all threads. Each tile only converts its rows to float.
+*/
+static double compare(const SourceImage& imageA, const SourceImage& imageB, const ErrorMetric& metric, bool alpha, float* errorMap)
+{
+    const uint32_t kTileHeight = 32;
+
+    const uint32_t width = imageA.getWidth();
+    const uint32_t height = imageA.getHeight();
+    const uint32_t tileCount = (height + kTileHeight - 1) / kTileHeight;
+    std::vector<double> tileErrors(tileCount);
+
+    Threading::parallelForEach(
+        0,
+        tileCount,
+        [&](size_t tileIndex)
+        {
+            // Reuse the row buffers of the thread across tiles.
+            thread_local std::vector<float> rowsA, rowsB;
+
+            ImageTile tile;
+            tile.width = width;
+            tile.height = height;
+            tile.y0 = uint32_t(tileIndex) * kTileHeight;
+            tile.y1 = std::min(height, tile.y0 + kTileHeight);
+            tile.dataY0 = tile.y0 >= metric.halo ? tile.y0 - metric.halo : 0;
+            tile.dataY1 = std::min(height, tile.y1 + metric.halo);
+            tile.linearA = imageA.isLinear();
+            tile.linearB = imageB.isLinear();
+            tile.alpha = alpha;
+
+            const size_t dataSize = size_t(width) * tile.getDataRowCount() * 4;
+            rowsA.resize(dataSize);
+            rowsB.resize(dataSize);
+            imageA.readRows(tile.dataY0, tile.dataY1, rowsA.data());
+            imageB.readRows(tile.dataY0, tile.dataY1, rowsB.data());
+            tile.pDataA = rowsA.data();
+            tile.pDataB = rowsB.data();
+
+            tileErrors[tileIndex] = metric.compareTile(tile, errorMap ? errorMap + size_t(tile.y0) * width : nullptr);
+        },
+        1
+    );
+
+    // Sum in tile order so the result does not depend on the thread count.
+    double sum = 0.0;
+    for (double error : tileErrors)
+        sum += error;
+    return sum / (double(width) * height);
+}
+
+static std::shared_ptr<Image> generateHeatMap(uint32_t width, uint32_t height, const float* errorMap)
+{
+    auto writeColor = [](float t, float* dst)
+    {
+        static const float colors[5][3] = {
+            {0.f, 0.f, 1.f}, // blue
+            {0.f, 1.f, 1.f}, // teal
+            {0.f, 1.f, 0.f}, // green
+            {1.f, 1.f, 0.f}, // yellow
+            {1.f, 0.f, 0.f}, // red
+        };
+
+        int c = clamp(int(std::floor(t * 4.f)), 0, 3);
+        for (size_t i = 0; i < 3; ++i)
+            *dst++ = lerp(colors[c][i], colors[c + 1][i], t * 4.f - c);
+        *dst++ = 1.f;
+    };
+
+    const auto [minValue, maxValue] = std::minmax_element(errorMap, errorMap + width * height);
+    const float range = std::max(1e-5f, *maxValue - *minValue);
+    auto image = Image::create(width, height);
+    float* dst = image->getData();
+    for (size_t i = 0; i < width * height; ++i)
+    {
+        float t = clamp((errorMap[i] - *minValue) / range, 0.f, 1.f);
+        writeColor(t, dst);
+        dst += 4;
+    }
+
+    return image;
+}
+
+CompareResult compareImages(
+    const std::filesystem::path& pathA,
+    const std::filesystem::path& pathB,
+    const ErrorMetric& metric,
+    float threshold,
+    bool alpha,
+    const std::filesystem::path& heatMapPath
+)
+{
+    CompareResult result;
+
+    auto loadImage = [](const std::filesystem::path& path, std::string& message)
+    {
+        try
+        {
+            return SourceImage::loadFromFile(path);
+        }
+        catch (const std::runtime_error& e)
+        {
+            message = "Cannot load image from '" + path.string() + "' (Error: " + e.what() + ").";
+            return std::shared_ptr<SourceImage>{};
+        }
+    };
+
+    auto saveImage = [](const Image& image, const std::filesystem::path& path)
+    {
+        try
+        {
+            image.saveToFile(path);
+        }
+        catch (const std::runtime_error& e)
+        {
+            std::cerr << "Cannot save image to '" << path.string() << "' (Error: " << e.what() << ")." << std::endl;
+        }
+    };
+
+    // Load images, the second one on another thread.
+    std::shared_ptr<SourceImage> imageB;
+    std::string messageB;
+    auto loadTask = Threading::dispatchTask([&]() { imageB = loadImage(pathB, messageB); });
+    auto imageA = loadImage(pathA, result.message);
+    loadTask.finish();
+    if (!imageA)
+        return result;
+    if (!imageB)
+    {
+        result.message = messageB;
+        return result;
+    }
+
+    // Check resolution.
+    if (imageA->getWidth() != imageB->getWidth() || imageA->getHeight() != imageB->getHeight())
+    {
+        result.message = "Cannot compare images with different resolutions.";
+        return result;
+    }
+
+    uint32_t width = imageA->getWidth();
+    uint32_t height = imageB->getHeight();
+
+    // Compare images.
+    std::unique_ptr<float[]> errorMap = heatMapPath.empty() ? nullptr : std::make_unique<float[]>(size_t(width) * height);
+    result.error = compare(*imageA, *imageB, metric, alpha, errorMap.get());
+
+    // Generate heat map.
+    if (errorMap)
+    {
+        auto heatMap = generateHeatMap(width, height, errorMap.get());
+        saveImage(*heatMap, heatMapPath);
+    }
+
+    // Treat nans and infs as errors.
+    result.success = !std::isnan(result.error) && !std::isinf(result.error) && result.error <= threshold;
+    return result;
+}
+
+bool compareBatch(
+    const std::filesystem::path& manifestPath,
+    const std::filesystem::path& reportPath,
+    const ErrorMetric& defaultMetric,
+    float defaultThreshold,
+    bool defaultAlpha
+)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    nlohmann::json manifest;
+    try
+    {
+        std::ifstream ifs(manifestPath);
+        if (!ifs)
+            throw std::runtime_error("Cannot open file");
+        manifest = nlohmann::json::parse(ifs);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Cannot read manifest '" << manifestPath.string() << "' (Error: " << e.what() << ")." << std::endl;
+        return false;
+    }
+
+    const auto baseDir = manifestPath.parent_path();
+    auto resolvePath = [&baseDir](const std::string& path) { return path.empty() ? std::filesystem::path() : baseDir / path; };
+
+    struct Pair
+    {
+        std::filesystem::path pathA;
+        std::filesystem::path pathB;
+        std::filesystem::path heatMapPath;
+        const ErrorMetric* pMetric = nullptr;
+        float threshold = 0.f;
+        bool alpha = false;
+        CompareResult result;
+    };
+
+    std::vector<Pair> pairs;
+    try
+    {
+        const std::string metricName = manifest.value("metric", defaultMetric.name);
+        const float threshold = manifest.value("threshold", defaultThreshold);
+        const bool alpha = manifest.value("alpha", defaultAlpha);
+        for (const auto& entry : manifest.at("pairs"))
+        {
+            Pair pair;
+            pair.pathA = resolvePath(entry.at("image1").get<std::string>());
+            pair.pathB = resolvePath(entry.at("image2").get<std::string>());
+            pair.heatMapPath = resolvePath(entry.value("heatMap", std::string()));
+            pair.threshold = entry.value("threshold", threshold);
+            pair.alpha = entry.value("alpha", alpha);
+            const std::string name = entry.value("metric", metricName);
+            pair.pMetric = findMetric(name);
+            if (!pair.pMetric)
+                throw std::runtime_error("Unknown error metric '" + name + "'");
+            pairs.push_back(std::move(pair));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Invalid manifest '" << manifestPath.string() << "' (Error: " << e.what() << ")." << std::endl;
+        return false;
+    }
+
+    // Compare several pairs at once, which keeps all threads busy with small images.
+    Threading::parallelForEach(
+        0,
+        pairs.size(),
+        [&](size_t i)
+        {
+            Pair& pair = pairs[i];
+            pair.result = compareImages(pair.pathA, pair.pathB, *pair.pMetric, pair.threshold, pair.alpha, pair.heatMapPath);
+        },
+        1
+    );
+
+    nlohmann::json results = nlohmann::json::array();
+    size_t passedCount = 0;
+    for (const auto& pair : pairs)
+    {
+        nlohmann::json result = {
+            {"image1", pair.pathA.string()},
+            {"image2", pair.pathB.string()},
+            {"metric", pair.pMetric->name},
+            {"threshold", pair.threshold},
+            {"success", pair.result.success},
+        };
+        if (pair.result.message.empty())
+            result["error"] = pair.result.error;
+        else
+            result["message"] = pair.result.message;
+        results.push_back(std::move(result));
+        if (pair.result.success)
+            passedCount++;
+    }
+
+    const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    nlohmann::json report = {
+        {"results", std::move(results)},
+        {"passed", passedCount},
+        {"failed", pairs.size() - passedCount},
+        {"time", time},
+    };
+
+    if (reportPath.empty())
+    {
+        std::cout << report.dump(4) << std::endl;
+    }
+    else
+    {
+        std::ofstream ofs(reportPath);
+        ofs << report.dump(4) << std::endl;
+        if (!ofs)
+        {
+            std::cerr << "Cannot write report to '" << reportPath.string() << "'." << std::endl;
+            return false;
+        }
+    }
+
+    return passedCount == pairs.size();
+}
@@ -0,0 +1,88 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "ImageTile.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct ErrorMetric
+{
+    std::string name;
+    std::string desc;
+    uint32_t halo; ///< Rows above and below a tile read by the metric.
+    std::function<double(const ImageTile& tile, float* errorMap)> compareTile; ///< Returns the sum of the per-pixel errors of the tile.
+};
+
+/// Get the available error metrics. The first one is the default.
+const std::vector<ErrorMetric>& getErrorMetrics();
+
+/// Find an error metric by name. Returns nullptr if there is no such metric.
+const ErrorMetric* findMetric(const std::string& name);
+
+struct CompareResult
+{
+    double error = 0.0;
+    bool success = false;
+    std::string message; ///< Reason the images could not be compared, empty if they were compared.
+};
+
+/** Compare two image files and return the mean of the per-pixel errors.
+    The comparison succeeds if the error is finite and not above the threshold. Writes an error heat map if heatMapPath is not empty.
+*/
+CompareResult compareImages(
+    const std::filesystem::path& pathA,
+    const std::filesystem::path& pathB,
+    const ErrorMetric& metric,
+    float threshold,
+    bool alpha,
+    const std::filesystem::path& heatMapPath
+);
+
+/** Compare the image pairs of a manifest and write a JSON report.
+    The manifest is a JSON file with a list of pairs, paths are relative to the manifest:
+    {
+        "metric": "mse", "threshold": 0.0, "alpha": false,    // Optional defaults, override the command line.
+        "pairs": [
+            {"image1": "ref.exr", "image2": "result.exr"},
+            {"image1": "ref.png", "image2": "result.png", "metric": "flip", "threshold": 0.05, "heatMap": "error.png"}
+        ]
+    }
+    The report is written to stdout if reportPath is empty.
+    Returns true if all pairs were compared successfully and are within their threshold.
+*/
+bool compareBatch(
+    const std::filesystem::path& manifestPath,
+    const std::filesystem::path& reportPath,
+    const ErrorMetric& defaultMetric,
+    float defaultThreshold,
+    bool defaultAlpha
+);
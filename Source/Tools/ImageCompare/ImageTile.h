@@ -0,0 +1,101 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+/** Range of rows of two images of the same size, in RGBA float.
+    Metrics compute the error of the rows [y0, y1). The pixel data covers [dataY0, dataY1), which includes the halo rows
+    above and below requested by the metric, except at the image borders.
+*/
+struct ImageTile
+{
+    uint32_t width = 0;
+    uint32_t height = 0;        ///< Height of the whole image.
+    uint32_t y0 = 0;
+    uint32_t y1 = 0;
+    uint32_t dataY0 = 0;
+    uint32_t dataY1 = 0;
+    const float* pDataA = nullptr;
+    const float* pDataB = nullptr;
+    bool linearA = true;        ///< False if the pixels of image A are sRGB encoded.
+    bool linearB = true;        ///< False if the pixels of image B are sRGB encoded.
+    bool alpha = false;         ///< Include the alpha channel.
+
+    uint32_t getDataRowCount() const { return dataY1 - dataY0; }
+    const float* getRowA(uint32_t y) const { return pDataA + size_t(y - dataY0) * width * 4; }
+    const float* getRowB(uint32_t y) const { return pDataB + size_t(y - dataY0) * width * 4; }
+};
+
+/** Convolve a row with a kernel of size 2 * radius + 1, clamping to the row ends.
+    The interior is computed one kernel tap at a time so the inner loop vectorizes.
+*/
+inline void convolveRow(const float* src, uint32_t width, const float* kernel, uint32_t radius, float* dst)
+{
+    const int r = int(radius);
+    const int w = int(width);
+    const int interiorBegin = std::min(r, w);
+    const int interiorEnd = std::max(interiorBegin, w - r);
+
+    std::fill(dst + interiorBegin, dst + interiorEnd, 0.f);
+    for (int k = -r; k <= r; ++k)
+    {
+        const float weight = kernel[k + r];
+        const float* s = src + k;
+        for (int x = interiorBegin; x < interiorEnd; ++x)
+            dst[x] += weight * s[x];
+    }
+
+    auto convolveClamped = [&](int x)
+    {
+        float sum = 0.f;
+        for (int k = -r; k <= r; ++k)
+            sum += kernel[k + r] * src[std::clamp(x + k, 0, w - 1)];
+        dst[x] = sum;
+    };
+    for (int x = 0; x < interiorBegin; ++x)
+        convolveClamped(x);
+    for (int x = interiorEnd; x < w; ++x)
+        convolveClamped(x);
+}
+
+/** Convolve row y of a planar buffer of rowCount rows vertically with a kernel of size 2 * radius + 1, clamping to the first and last row.
+*/
+inline void convolveColumns(const float* src, uint32_t width, uint32_t rowCount, uint32_t y, const float* kernel, uint32_t radius, float* dst)
+{
+    const int r = int(radius);
+    std::fill(dst, dst + width, 0.f);
+    for (int k = -r; k <= r; ++k)
+    {
+        const float weight = kernel[k + r];
+        const float* s = src + size_t(std::clamp(int(y) + k, 0, int(rowCount) - 1)) * width;
+        for (uint32_t x = 0; x < width; ++x)
+            dst[x] += weight * s[x];
+    }
+}
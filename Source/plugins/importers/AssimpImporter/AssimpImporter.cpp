@@ -30,7 +30,7 @@
 #include "Core/API/Device.h"
 #include "Utils/Logger.h"
 #include "Utils/StringUtils.h"
-#include "Utils/NumericRange.h"
+#include "Utils/Threading.h"
 #include "Utils/Timing/TimeReport.h"
 #include "Utils/Math/Common.h"
 #include "Utils/Math/FalcorMath.h"
@@ -46,7 +46,6 @@
 
 #include <pybind11/pybind11.h>
 
-#include <execution>
 #include <fstream>
 
 namespace Falcor
@@ -586,11 +585,9 @@ void createMeshes(ImporterData& data)
 
     // Pre-process meshes.
     std::vector<SceneBuilder::ProcessedMesh> processedMeshes(meshes.size());
-    auto range = NumericRange<size_t>(0, meshes.size());
-    std::for_each(
-        std::execution::par,
-        range.begin(),
-        range.end(),
+    Threading::parallelForEach(
+        0,
+        meshes.size(),
         [&](size_t i)
         {
             const aiMesh* pAiMesh = meshes[i];
@@ -652,18 +649,15 @@ void createMeshes(ImporterData& data)
             mesh.pMaterial = data.materialMap.at(pAiMesh->mMaterialIndex);
 
             processedMeshes[i] = data.builder.processMesh(mesh);
-        }
+        },
+        1
     );
 
     // Add meshes to the scene.
-    // We retain a deterministic order of the meshes in the global scene buffer by adding
-    // them sequentially after being processed in parallel.
-    uint32_t i = 0;
-    for (const auto& mesh : processedMeshes)
-    {
-        MeshID meshID = data.builder.addProcessedMesh(mesh);
-        data.meshMap[i++] = meshID;
-    }
+    // The scene builder adds them sequentially to retain a deterministic order in the global scene buffer.
+    auto meshIDs = data.builder.addProcessedMeshes(processedMeshes);
+    for (uint32_t i = 0; i < (uint32_t)meshIDs.size(); i++)
+        data.meshMap[i] = meshIDs[i];
 }
 
 bool isBone(ImporterData& data, const std::string& name)
@@ -63,11 +63,13 @@
 #include "Builder.h"
 #include "Helpers.h"
 #include "LoopSubdivide.h"
+#include "PlyReader.h"
 #include "EnvMapConverter.h"
 #include "Core/Error.h"
 #include "Core/API/Device.h"
 #include "Utils/Settings/Settings.h"
 #include "Utils/Logger.h"
+#include "Utils/Threading.h"
 #include "Utils/Timing/TimeReport.h"
 #include "Utils/Math/FalcorMath.h"
 #include "Utils/Math/FNVHash.h"
@@ -226,6 +228,13 @@ struct BuilderContext
 
     std::map<std::string, InstanceDefinition> instanceDefinitions;
 
+    struct PlyMesh
+    {
+        Falcor::ref<Falcor::TriangleMesh> pTriangleMesh;
+        size_t useCount = 0; ///< Number of shapes referencing the file that have not been created yet.
+    };
+    std::map<std::filesystem::path, PlyMesh> plyMeshes; ///< PLY meshes loaded up front by loadPlyMeshes().
+
     size_t curveCount = 0;
 
     bool usePBRTMaterials = false;
@@ -260,6 +269,24 @@ struct BuilderContext
     }
 
     Resolver resolver = [this](const std::filesystem::path& path) { return scene.resolvePath(path); };
+
+    /**
+     * Get the triangle mesh for a "plymesh" shape.
+     * Shapes modify their mesh, so the last shape referencing a file gets the loaded mesh and the others get a copy.
+     */
+    Falcor::ref<Falcor::TriangleMesh> getPlyMesh(const std::filesystem::path& path)
+    {
+        auto it = plyMeshes.find(path);
+        if (it == plyMeshes.end())
+            return loadPlyMesh(path);
+
+        auto pTriangleMesh = it->second.pTriangleMesh;
+        if (--it->second.useCount == 0)
+            plyMeshes.erase(it);
+        else if (pTriangleMesh)
+            pTriangleMesh = Falcor::TriangleMesh::create(pTriangleMesh->getVertices(), pTriangleMesh->getIndices());
+        return pTriangleMesh;
+    }
 };
 
 inline void warnUnsupportedType(const FileLoc& loc, const std::string_view category, const std::string_view name)
@@ -1593,7 +1620,7 @@ Shape createShape(BuilderContext& ctx, const ShapeSceneEntity& entity)
         auto filename = params.getString("filename", "");
         auto path = ctx.resolver(filename);
 
-        shape.pTriangleMesh = Falcor::TriangleMesh::createFromFile(path.string());
+        shape.pTriangleMesh = ctx.getPlyMesh(path);
         if (shape.pTriangleMesh)
             shape.pTriangleMesh->setName(filename);
         shape.transform = entity.transform;
@@ -1791,6 +1818,31 @@ InstanceDefinition createInstanceDefinition(BuilderContext& ctx, const InstanceD
     return instanceDefinition;
 }
 
+/**
+ * Load the meshes of all "plymesh" shapes in parallel, including shapes in object instance definitions.
+ * Each file is loaded once, the meshes are picked up by createShape() through BuilderContext::getPlyMesh().
+ */
+void loadPlyMeshes(BuilderContext& ctx)
+{
+    auto addShape = [&ctx](const ShapeSceneEntity& entity)
+    {
+        if (entity.name == "plymesh")
+            ctx.plyMeshes[ctx.resolver(entity.params.getString("filename", ""))].useCount++;
+    };
+    for (const auto& entity : ctx.scene.getShapes())
+        addShape(entity);
+    for (const auto& [_, definition] : ctx.scene.getInstanceDefinitions())
+        for (const auto& entity : definition.shapes)
+            addShape(entity);
+
+    std::vector<std::pair<const std::filesystem::path, BuilderContext::PlyMesh>*> plyMeshes;
+    for (auto& entry : ctx.plyMeshes)
+        plyMeshes.push_back(&entry);
+    Threading::parallelForEach(
+        0, plyMeshes.size(), [&](size_t i) { plyMeshes[i]->second.pTriangleMesh = loadPlyMesh(plyMeshes[i]->first); }, 1
+    );
+}
+
 void buildScene(BuilderContext& ctx)
 {
     // Load float textures.
@@ -1842,17 +1894,27 @@ void buildScene(BuilderContext& ctx)
         }
     }
 
+    // Load PLY meshes up front so that files are read in parallel.
+    loadPlyMeshes(ctx);
+
     // Process shapes and create meshes.
+    // Shapes are created serially, the resulting triangle meshes are then added as a batch so that they are processed in parallel.
+    std::vector<NodeID> meshNodeIDs;
+    std::vector<Falcor::ref<Falcor::TriangleMesh>> triangleMeshes;
+    std::vector<Falcor::ref<Falcor::Material>> meshMaterials;
     for (const auto& entity : ctx.scene.getShapes())
     {
         auto shape = createShape(ctx, entity);
         if (shape.pTriangleMesh)
         {
-            auto nodeID = ctx.builder.addNode({entity.name, shape.transform});
-            auto meshID = ctx.builder.addTriangleMesh(shape.pTriangleMesh, shape.pMaterial);
-            ctx.builder.addMeshInstance(nodeID, meshID);
+            meshNodeIDs.push_back(ctx.builder.addNode({entity.name, shape.transform}));
+            triangleMeshes.push_back(shape.pTriangleMesh);
+            meshMaterials.push_back(shape.pMaterial);
         }
     }
+    auto meshIDs = ctx.builder.addTriangleMeshes(triangleMeshes, meshMaterials);
+    for (size_t i = 0; i < meshIDs.size(); ++i)
+        ctx.builder.addMeshInstance(meshNodeIDs[i], meshIDs[i]);
 
     // Create curves from curve aggregates assembled during the processing step above.
     for (const auto& [_, curveAggregate] : ctx.curveAggregates)
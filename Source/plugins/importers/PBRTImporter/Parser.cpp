@@ -36,10 +36,13 @@
 #include "Core/Error.h"
 #include "Core/Platform/OS.h"
 #include "Utils/Logger.h"
+#include "Utils/Threading.h"
 
 #include <fast_float/fast_float.h>
 
+#include <array>
 #include <atomic>
+#include <mutex>
 #include <utility>
 #include <charconv>
 
@@ -109,7 +112,12 @@ Tokenizer::Tokenizer(std::string str, const std::filesystem::path& path) : mPath
 {
     auto pFilename = std::make_unique<std::string>(path.string());
     mLoc = FileLoc(*pFilename);
-    getFilenames().push_back(std::move(pFilename));
+    {
+        // Imported files are tokenized on worker threads.
+        static std::mutex filenamesMutex;
+        std::lock_guard<std::mutex> lock(filenamesMutex);
+        getFilenames().push_back(std::move(pFilename));
+    }
 
     mPos = mContents.data();
     mEnd = mPos + mContents.size();
@@ -448,19 +456,248 @@ static ParsedParameterVector parseParameters(Next nextToken, Unget ungetToken)
     return parameterVector;
 }
 
-void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
+/**
+ * Parser target that records all calls so they can be replayed later.
+ * Used to parse imported files on worker threads and apply them to the real target in file order.
+ */
+class RecordingTarget : public ParserTarget
+{
+public:
+    void replay(ParserTarget& target)
+    {
+        for (auto& call : mCalls)
+            call(target);
+        mCalls.clear();
+    }
+
+    void onScale(Float sx, Float sy, Float sz, FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onScale(sx, sy, sz, loc); });
+    }
+    void onShape(const std::string& name, ParsedParameterVector params, FileLoc loc) override
+    {
+        record([=, params = std::move(params)](ParserTarget& t) mutable { t.onShape(name, std::move(params), loc); });
+    }
+    void onOption(const std::string& name, const std::string& value, FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onOption(name, value, loc); });
+    }
+    void onIdentity(FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onIdentity(loc); });
+    }
+    void onTranslate(Float dx, Float dy, Float dz, FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onTranslate(dx, dy, dz, loc); });
+    }
+    void onRotate(Float angle, Float ax, Float ay, Float az, FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onRotate(angle, ax, ay, az, loc); });
+    }
+    void onLookAt(Float ex, Float ey, Float ez, Float lx, Float ly, Float lz, Float ux, Float uy, Float uz, FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onLookAt(ex, ey, ez, lx, ly, lz, ux, uy, uz, loc); });
+    }
+    void onConcatTransform(Float transform[16], FileLoc loc) override
+    {
+        record([=, m = toArray(transform)](ParserTarget& t) mutable { t.onConcatTransform(m.data(), loc); });
+    }
+    void onTransform(Float transform[16], FileLoc loc) override
+    {
+        record([=, m = toArray(transform)](ParserTarget& t) mutable { t.onTransform(m.data(), loc); });
+    }
+    void onCoordinateSystem(const std::string& name, FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onCoordinateSystem(name, loc); });
+    }
+    void onCoordSysTransform(const std::string& name, FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onCoordSysTransform(name, loc); });
+    }
+    void onActiveTransformAll(FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onActiveTransformAll(loc); });
+    }
+    void onActiveTransformEndTime(FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onActiveTransformEndTime(loc); });
+    }
+    void onActiveTransformStartTime(FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onActiveTransformStartTime(loc); });
+    }
+    void onTransformTimes(Float start, Float end, FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onTransformTimes(start, end, loc); });
+    }
+    void onColorSpace(const std::string& n, FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onColorSpace(n, loc); });
+    }
+    void onPixelFilter(const std::string& name, ParsedParameterVector params, FileLoc loc) override
+    {
+        record([=, params = std::move(params)](ParserTarget& t) mutable { t.onPixelFilter(name, std::move(params), loc); });
+    }
+    void onFilm(const std::string& type, ParsedParameterVector params, FileLoc loc) override
+    {
+        record([=, params = std::move(params)](ParserTarget& t) mutable { t.onFilm(type, std::move(params), loc); });
+    }
+    void onAccelerator(const std::string& name, ParsedParameterVector params, FileLoc loc) override
+    {
+        record([=, params = std::move(params)](ParserTarget& t) mutable { t.onAccelerator(name, std::move(params), loc); });
+    }
+    void onIntegrator(const std::string& name, ParsedParameterVector params, FileLoc loc) override
+    {
+        record([=, params = std::move(params)](ParserTarget& t) mutable { t.onIntegrator(name, std::move(params), loc); });
+    }
+    void onCamera(const std::string& name, ParsedParameterVector params, FileLoc loc) override
+    {
+        record([=, params = std::move(params)](ParserTarget& t) mutable { t.onCamera(name, std::move(params), loc); });
+    }
+    void onMakeNamedMedium(const std::string& name, ParsedParameterVector params, FileLoc loc) override
+    {
+        record([=, params = std::move(params)](ParserTarget& t) mutable { t.onMakeNamedMedium(name, std::move(params), loc); });
+    }
+    void onMediumInterface(const std::string& insideName, const std::string& outsideName, FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onMediumInterface(insideName, outsideName, loc); });
+    }
+    void onSampler(const std::string& name, ParsedParameterVector params, FileLoc loc) override
+    {
+        record([=, params = std::move(params)](ParserTarget& t) mutable { t.onSampler(name, std::move(params), loc); });
+    }
+    void onWorldBegin(FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onWorldBegin(loc); });
+    }
+    void onAttributeBegin(FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onAttributeBegin(loc); });
+    }
+    void onAttributeEnd(FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onAttributeEnd(loc); });
+    }
+    void onAttribute(const std::string& target, ParsedParameterVector params, FileLoc loc) override
+    {
+        record([=, params = std::move(params)](ParserTarget& t) mutable { t.onAttribute(target, std::move(params), loc); });
+    }
+    void onTexture(const std::string& name, const std::string& type, const std::string& texname, ParsedParameterVector params, FileLoc loc)
+        override
+    {
+        record([=, params = std::move(params)](ParserTarget& t) mutable { t.onTexture(name, type, texname, std::move(params), loc); });
+    }
+    void onMaterial(const std::string& name, ParsedParameterVector params, FileLoc loc) override
+    {
+        record([=, params = std::move(params)](ParserTarget& t) mutable { t.onMaterial(name, std::move(params), loc); });
+    }
+    void onMakeNamedMaterial(const std::string& name, ParsedParameterVector params, FileLoc loc) override
+    {
+        record([=, params = std::move(params)](ParserTarget& t) mutable { t.onMakeNamedMaterial(name, std::move(params), loc); });
+    }
+    void onNamedMaterial(const std::string& name, FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onNamedMaterial(name, loc); });
+    }
+    void onLightSource(const std::string& name, ParsedParameterVector params, FileLoc loc) override
+    {
+        record([=, params = std::move(params)](ParserTarget& t) mutable { t.onLightSource(name, std::move(params), loc); });
+    }
+    void onAreaLightSource(const std::string& name, ParsedParameterVector params, FileLoc loc) override
+    {
+        record([=, params = std::move(params)](ParserTarget& t) mutable { t.onAreaLightSource(name, std::move(params), loc); });
+    }
+    void onReverseOrientation(FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onReverseOrientation(loc); });
+    }
+    void onObjectBegin(const std::string& name, FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onObjectBegin(name, loc); });
+    }
+    void onObjectEnd(FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onObjectEnd(loc); });
+    }
+    void onObjectInstance(const std::string& name, FileLoc loc) override
+    {
+        record([=](ParserTarget& t) { t.onObjectInstance(name, loc); });
+    }
+
+    void onEndOfFiles() override { FALCOR_UNREACHABLE(); }
+
+private:
+    static std::array<Float, 16> toArray(const Float m[16])
+    {
+        std::array<Float, 16> a;
+        std::copy(m, m + 16, a.begin());
+        return a;
+    }
+
+    template<typename F>
+    void record(F&& func)
+    {
+        mCalls.emplace_back(std::forward<F>(func));
+    }
+
+    std::vector<std::function<void(ParserTarget&)>> mCalls;
+};
+
+/**
+ * File imported with the 'Import' directive.
+ * The file is parsed into its own recording on a worker thread. Directives following the 'Import'
+ * in the importing file are recorded into a separate continuation so everything can be replayed in file order.
+ */
+struct ImportedFile
+{
+    FileLoc loc;
+    std::unique_ptr<RecordingTarget> pRecording;
+    std::unique_ptr<RecordingTarget> pContinuation;
+    Threading::Task task;
+};
+
+/**
+ * Parse a token stream into the target.
+ * Imported files are parsed with the search path of the scene file and start inside the world block.
+ */
+void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer, std::filesystem::path searchPath = {}, bool worldBlock = false)
 {
     static std::atomic<bool> warnedTransformBeginEndDeprecated{false};
 
     logInfo("PBRTImporter: Started parsing '{}'.", tokenizer->getPath().string());
 
-    auto searchPath = tokenizer->getPath().parent_path();
+    if (searchPath.empty())
+        searchPath = tokenizer->getPath().parent_path();
 
     std::vector<std::unique_ptr<Tokenizer>> fileStack;
     fileStack.push_back(std::move(tokenizer));
 
     std::optional<Token> ungetToken;
 
+    // Directives are sent to the target until the first 'Import', after that they are recorded into the
+    // continuation of the last imported file.
+    ParserTarget* pTarget = &target;
+    std::vector<ImportedFile> imports;
+
+    // Imported files are parsed in parallel. If parsing fails, make sure they are done before the recordings go out of scope.
+    struct ImportGuard
+    {
+        std::vector<ImportedFile>& imports;
+        ~ImportGuard()
+        {
+            for (auto& import : imports)
+            {
+                try
+                {
+                    import.task.finish();
+                }
+                catch (...)
+                {
+                }
+            }
+        }
+    } importGuard{imports};
+
     /**
      * Helper function that handles the file stack, returning the next token from
      * the file until reaching EOF, at which point it switches to the next file (if any).
@@ -515,7 +752,7 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
         std::string_view dequoted = dequoteString(t);
         std::string n = toString(dequoted);
         ParsedParameterVector parameterVector = parseParameters(nextToken, unget);
-        (target.*apiFunc)(n, std::move(parameterVector), loc);
+        (pTarget->*apiFunc)(n, std::move(parameterVector), loc);
     };
 
     auto syntaxError = [&](const Token& t)
@@ -539,11 +776,11 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
         case 'A':
             if (tok->token == "AttributeBegin")
             {
-                target.onAttributeBegin(tok->loc);
+                pTarget->onAttributeBegin(tok->loc);
             }
             else if (tok->token == "AttributeEnd")
             {
-                target.onAttributeEnd(tok->loc);
+                pTarget->onAttributeEnd(tok->loc);
             }
             else if (tok->token == "Attribute")
             {
@@ -553,11 +790,11 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
             {
                 Token a = *nextToken(TokenRequired);
                 if (a.token == "All")
-                    target.onActiveTransformAll(tok->loc);
+                    pTarget->onActiveTransformAll(tok->loc);
                 else if (a.token == "EndTime")
-                    target.onActiveTransformEndTime(tok->loc);
+                    pTarget->onActiveTransformEndTime(tok->loc);
                 else if (a.token == "StartTime")
-                    target.onActiveTransformStartTime(tok->loc);
+                    pTarget->onActiveTransformStartTime(tok->loc);
                 else
                     syntaxError(*tok);
             }
@@ -585,22 +822,22 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
                     m[i] = parseFloat(*nextToken(TokenRequired));
                 if (nextToken(TokenRequired)->token != "]")
                     syntaxError(*tok);
-                target.onConcatTransform(m, tok->loc);
+                pTarget->onConcatTransform(m, tok->loc);
             }
             else if (tok->token == "CoordinateSystem")
             {
                 std::string_view n = dequoteString(*nextToken(TokenRequired));
-                target.onCoordinateSystem(toString(n), tok->loc);
+                pTarget->onCoordinateSystem(toString(n), tok->loc);
             }
             else if (tok->token == "CoordSysTransform")
             {
                 std::string_view n = dequoteString(*nextToken(TokenRequired));
-                target.onCoordSysTransform(toString(n), tok->loc);
+                pTarget->onCoordSysTransform(toString(n), tok->loc);
             }
             else if (tok->token == "ColorSpace")
             {
                 std::string_view n = dequoteString(*nextToken(TokenRequired));
-                target.onColorSpace(toString(n), tok->loc);
+                pTarget->onColorSpace(toString(n), tok->loc);
             }
             else if (tok->token == "Camera")
             {
@@ -639,11 +876,26 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
             }
             else if (tok->token == "Import")
             {
-                throwError(tok->loc, "'Import' directive not supported yet.");
+                if (!worldBlock)
+                    throwError(tok->loc, "'Import' is only allowed inside the world block.");
+
+                Token filenameToken = *nextToken(TokenRequired);
+                std::string filename = toString(dequoteString(filenameToken));
+                auto path = searchPath / filename;
+
+                // Unlike 'Include', the imported file cannot change the graphics state of the importing file,
+                // so it can be tokenized and parsed independently.
+                ImportedFile import{tok->loc, std::make_unique<RecordingTarget>(), std::make_unique<RecordingTarget>()};
+                import.task = Threading::dispatchTask(
+                    [path, searchPath, pRecording = import.pRecording.get()]()
+                    { parse(*pRecording, Tokenizer::createFromFile(path), searchPath, true); }
+                );
+                pTarget = import.pContinuation.get();
+                imports.push_back(std::move(import));
             }
             else if (tok->token == "Identity")
             {
-                target.onIdentity(tok->loc);
+                pTarget->onIdentity(tok->loc);
             }
             else
             {
@@ -661,7 +913,7 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
                 Float v[9];
                 for (int i = 0; i < 9; ++i)
                     v[i] = parseFloat(*nextToken(TokenRequired));
-                target.onLookAt(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8], tok->loc);
+                pTarget->onLookAt(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8], tok->loc);
             }
             else
             {
@@ -703,7 +955,7 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
                 else
                     names[1] = names[0];
 
-                target.onMediumInterface(names[0], names[1], tok->loc);
+                pTarget->onMediumInterface(names[0], names[1], tok->loc);
             }
             else
             {
@@ -715,7 +967,7 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
             if (tok->token == "NamedMaterial")
             {
                 std::string_view n = dequoteString(*nextToken(TokenRequired));
-                target.onNamedMaterial(toString(n), tok->loc);
+                pTarget->onNamedMaterial(toString(n), tok->loc);
             }
             else
             {
@@ -727,22 +979,22 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
             if (tok->token == "ObjectBegin")
             {
                 std::string_view n = dequoteString(*nextToken(TokenRequired));
-                target.onObjectBegin(toString(n), tok->loc);
+                pTarget->onObjectBegin(toString(n), tok->loc);
             }
             else if (tok->token == "ObjectEnd")
             {
-                target.onObjectEnd(tok->loc);
+                pTarget->onObjectEnd(tok->loc);
             }
             else if (tok->token == "ObjectInstance")
             {
                 std::string_view n = dequoteString(*nextToken(TokenRequired));
-                target.onObjectInstance(toString(n), tok->loc);
+                pTarget->onObjectInstance(toString(n), tok->loc);
             }
             else if (tok->token == "Option")
             {
                 std::string name = toString(dequoteString(*nextToken(TokenRequired)));
                 std::string value = toString(nextToken(TokenRequired)->token);
-                target.onOption(name, value, tok->loc);
+                pTarget->onOption(name, value, tok->loc);
             }
             else
             {
@@ -764,14 +1016,14 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
         case 'R':
             if (tok->token == "ReverseOrientation")
             {
-                target.onReverseOrientation(tok->loc);
+                pTarget->onReverseOrientation(tok->loc);
             }
             else if (tok->token == "Rotate")
             {
                 Float v[4];
                 for (int i = 0; i < 4; ++i)
                     v[i] = parseFloat(*nextToken(TokenRequired));
-                target.onRotate(v[0], v[1], v[2], v[3], tok->loc);
+                pTarget->onRotate(v[0], v[1], v[2], v[3], tok->loc);
             }
             else
             {
@@ -793,7 +1045,7 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
                 Float v[3];
                 for (int i = 0; i < 3; ++i)
                     v[i] = parseFloat(*nextToken(TokenRequired));
-                target.onScale(v[0], v[1], v[2], tok->loc);
+                pTarget->onScale(v[0], v[1], v[2], tok->loc);
             }
             else
             {
@@ -809,11 +1061,11 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
                     logWarning(tok->loc, "TransformBegin/End are deprecated and should be replaced with AttributeBegin/End.");
                     warnedTransformBeginEndDeprecated = true;
                 }
-                target.onAttributeBegin(tok->loc);
+                pTarget->onAttributeBegin(tok->loc);
             }
             else if (tok->token == "TransformEnd")
             {
-                target.onAttributeEnd(tok->loc);
+                pTarget->onAttributeEnd(tok->loc);
             }
             else if (tok->token == "Transform")
             {
@@ -824,21 +1076,21 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
                     m[i] = parseFloat(*nextToken(TokenRequired));
                 if (nextToken(TokenRequired)->token != "]")
                     syntaxError(*tok);
-                target.onTransform(m, tok->loc);
+                pTarget->onTransform(m, tok->loc);
             }
             else if (tok->token == "Translate")
             {
                 Float v[3];
                 for (int i = 0; i < 3; ++i)
                     v[i] = parseFloat(*nextToken(TokenRequired));
-                target.onTranslate(v[0], v[1], v[2], tok->loc);
+                pTarget->onTranslate(v[0], v[1], v[2], tok->loc);
             }
             else if (tok->token == "TransformTimes")
             {
                 Float v[2];
                 for (int i = 0; i < 2; ++i)
                     v[i] = parseFloat(*nextToken(TokenRequired));
-                target.onTransformTimes(v[0], v[1], tok->loc);
+                pTarget->onTransformTimes(v[0], v[1], tok->loc);
             }
             else if (tok->token == "Texture")
             {
@@ -851,7 +1103,7 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
                 std::string_view dequoted = dequoteString(t);
                 std::string texName = toString(dequoted);
                 ParsedParameterVector params = parseParameters(nextToken, unget);
-                target.onTexture(name, type, texName, std::move(params), tok->loc);
+                pTarget->onTexture(name, type, texName, std::move(params), tok->loc);
             }
             else
             {
@@ -862,7 +1114,8 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
         case 'W':
             if (tok->token == "WorldBegin")
             {
-                target.onWorldBegin(tok->loc);
+                pTarget->onWorldBegin(tok->loc);
+                worldBlock = true;
             }
             else
             {
@@ -874,6 +1127,17 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
             syntaxError(*tok);
         }
     }
+
+    // Apply the imported files and the directives following them in file order.
+    // Each imported file is scoped like an attribute block so its graphics state does not leak.
+    for (auto& import : imports)
+    {
+        import.task.finish();
+        target.onAttributeBegin(import.loc);
+        import.pRecording->replay(target);
+        target.onAttributeEnd(import.loc);
+        import.pContinuation->replay(target);
+    }
 }
 
 void parseFile(ParserTarget& target, const std::filesystem::path& path)
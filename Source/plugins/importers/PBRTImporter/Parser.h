@@ -132,7 +132,7 @@ public:
 private:
     /**
      * Static list of filenames to allow file locations (FileLoc::filename) to be valid
-     * even after the tokenizer is destroyed.
+     * even after the tokenizer is destroyed. Guarded by a mutex in the constructor.
      */
     static std::vector<std::unique_ptr<std::string>>& getFilenames()
     {
@@ -0,0 +1,522 @@
+/***************************************************************************
+ # Copyright (c) 2015-22, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "PlyReader.h"
+#include "Core/Error.h"
+#include "Core/Platform/MemoryMappedFile.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Logger.h"
+#include "Utils/Threading.h"
+#include "Utils/Timing/Profiler.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Falcor::pbrt
+{
+
+namespace
+{
+
+enum class PlyType
+{
+    Int8,
+    UInt8,
+    Int16,
+    UInt16,
+    Int32,
+    UInt32,
+    Float32,
+    Float64,
+};
+
+struct PlyProperty
+{
+    std::string name;
+    PlyType type = PlyType::Float32;
+    bool isList = false;
+    PlyType countType = PlyType::UInt8; ///< Type of the list length, only used for list properties.
+};
+
+struct PlyElement
+{
+    std::string name;
+    size_t count = 0;
+    std::vector<PlyProperty> properties;
+
+    bool hasLists() const
+    {
+        for (const auto& property : properties)
+            if (property.isList)
+                return true;
+        return false;
+    }
+
+    int findProperty(std::initializer_list<std::string_view> names) const
+    {
+        for (auto name : names)
+            for (size_t i = 0; i < properties.size(); ++i)
+                if (properties[i].name == name)
+                    return (int)i;
+        return -1;
+    }
+};
+
+struct PlyHeader
+{
+    bool isAscii = false;
+    bool isBigEndian = false;
+    std::vector<PlyElement> elements;
+    size_t dataOffset = 0; ///< Byte offset of the element data.
+};
+
+std::optional<PlyType> parseType(std::string_view name)
+{
+    if (name == "char" || name == "int8")
+        return PlyType::Int8;
+    if (name == "uchar" || name == "uint8")
+        return PlyType::UInt8;
+    if (name == "short" || name == "int16")
+        return PlyType::Int16;
+    if (name == "ushort" || name == "uint16")
+        return PlyType::UInt16;
+    if (name == "int" || name == "int32")
+        return PlyType::Int32;
+    if (name == "uint" || name == "uint32")
+        return PlyType::UInt32;
+    if (name == "float" || name == "float32")
+        return PlyType::Float32;
+    if (name == "double" || name == "float64")
+        return PlyType::Float64;
+    return {};
+}
+
+size_t getTypeSize(PlyType type)
+{
+    switch (type)
+    {
+    case PlyType::Int8:
+    case PlyType::UInt8:
+        return 1;
+    case PlyType::Int16:
+    case PlyType::UInt16:
+        return 2;
+    case PlyType::Int32:
+    case PlyType::UInt32:
+    case PlyType::Float32:
+        return 4;
+    case PlyType::Float64:
+        return 8;
+    }
+    FALCOR_UNREACHABLE();
+}
+
+std::vector<std::string_view> splitTokens(std::string_view line)
+{
+    std::vector<std::string_view> tokens;
+    size_t pos = 0;
+    while (pos < line.size())
+    {
+        size_t start = line.find_first_not_of(" \t\r", pos);
+        if (start == std::string_view::npos)
+            break;
+        size_t end = line.find_first_of(" \t\r", start);
+        if (end == std::string_view::npos)
+            end = line.size();
+        tokens.push_back(line.substr(start, end - start));
+        pos = end;
+    }
+    return tokens;
+}
+
+PlyHeader parseHeader(std::string_view data)
+{
+    PlyHeader header;
+    bool hasFormat = false;
+    size_t pos = 0;
+    size_t lineIndex = 0;
+
+    while (true)
+    {
+        size_t end = data.find('\n', pos);
+        if (end == std::string_view::npos)
+            FALCOR_THROW("Missing 'end_header'.");
+        auto tokens = splitTokens(data.substr(pos, end - pos));
+        pos = end + 1;
+
+        if (lineIndex++ == 0)
+        {
+            if (tokens.size() != 1 || tokens[0] != "ply")
+                FALCOR_THROW("Not a PLY file.");
+            continue;
+        }
+        if (tokens.empty() || tokens[0] == "comment" || tokens[0] == "obj_info")
+            continue;
+
+        if (tokens[0] == "end_header")
+            break;
+
+        if (tokens[0] == "format" && tokens.size() >= 2)
+        {
+            if (tokens[1] == "ascii")
+                header.isAscii = true;
+            else if (tokens[1] == "binary_big_endian")
+                header.isBigEndian = true;
+            else if (tokens[1] != "binary_little_endian")
+                FALCOR_THROW("Unknown format '{}'.", tokens[1]);
+            hasFormat = true;
+        }
+        else if (tokens[0] == "element" && tokens.size() == 3)
+        {
+            PlyElement element;
+            element.name = tokens[1];
+            auto [_, ec] = std::from_chars(tokens[2].data(), tokens[2].data() + tokens[2].size(), element.count);
+            if (ec != std::errc())
+                FALCOR_THROW("Invalid element count '{}'.", tokens[2]);
+            header.elements.push_back(std::move(element));
+        }
+        else if (tokens[0] == "property" && !header.elements.empty())
+        {
+            PlyProperty property;
+            std::optional<PlyType> type, countType;
+            if (tokens.size() == 5 && tokens[1] == "list")
+            {
+                countType = parseType(tokens[2]);
+                type = parseType(tokens[3]);
+                property.name = tokens[4];
+                property.isList = true;
+            }
+            else if (tokens.size() == 3)
+            {
+                countType = PlyType::UInt8;
+                type = parseType(tokens[1]);
+                property.name = tokens[2];
+            }
+            if (!type || !countType)
+                FALCOR_THROW("Invalid property on line {}.", lineIndex);
+            property.type = *type;
+            property.countType = *countType;
+            header.elements.back().properties.push_back(std::move(property));
+        }
+        else
+        {
+            FALCOR_THROW("Unexpected header line {}.", lineIndex);
+        }
+    }
+
+    if (!hasFormat)
+        FALCOR_THROW("Missing 'format'.");
+
+    header.dataOffset = pos;
+    return header;
+}
+
+/// Reads binary element data. Values in big endian files are byte swapped, Falcor only runs on little endian hosts.
+class PlyDataReader
+{
+public:
+    PlyDataReader(const uint8_t* pBegin, const uint8_t* pEnd, bool swapBytes) : mpCurrent(pBegin), mpEnd(pEnd), mSwapBytes(swapBytes) {}
+
+    const uint8_t* getCurrent() const { return mpCurrent; }
+
+    /// Reserve size bytes and return a pointer to them.
+    const uint8_t* advance(size_t size)
+    {
+        if (size_t(mpEnd - mpCurrent) < size)
+            FALCOR_THROW("Unexpected end of file.");
+        const uint8_t* p = mpCurrent;
+        mpCurrent += size;
+        return p;
+    }
+
+    template<typename T>
+    static T load(const uint8_t* p, bool swapBytes)
+    {
+        uint8_t bytes[sizeof(T)];
+        std::memcpy(bytes, p, sizeof(T));
+        if (swapBytes)
+            std::reverse(bytes, bytes + sizeof(T));
+        T value;
+        std::memcpy(&value, bytes, sizeof(T));
+        return value;
+    }
+
+    template<typename T>
+    static T load(const uint8_t* p, PlyType type, bool swapBytes)
+    {
+        switch (type)
+        {
+        case PlyType::Int8:
+            return T(load<int8_t>(p, false));
+        case PlyType::UInt8:
+            return T(load<uint8_t>(p, false));
+        case PlyType::Int16:
+            return T(load<int16_t>(p, swapBytes));
+        case PlyType::UInt16:
+            return T(load<uint16_t>(p, swapBytes));
+        case PlyType::Int32:
+            return T(load<int32_t>(p, swapBytes));
+        case PlyType::UInt32:
+            return T(load<uint32_t>(p, swapBytes));
+        case PlyType::Float32:
+            return T(load<float>(p, swapBytes));
+        case PlyType::Float64:
+            return T(load<double>(p, swapBytes));
+        }
+        FALCOR_UNREACHABLE();
+    }
+
+    template<typename T>
+    T read(PlyType type)
+    {
+        return load<T>(advance(getTypeSize(type)), type, mSwapBytes);
+    }
+
+    void skipElement(const PlyElement& element)
+    {
+        if (!element.hasLists())
+        {
+            size_t stride = 0;
+            for (const auto& property : element.properties)
+                stride += getTypeSize(property.type);
+            advance(stride * element.count);
+            return;
+        }
+        for (size_t i = 0; i < element.count; ++i)
+            for (const auto& property : element.properties)
+                advance(property.isList ? read<size_t>(property.countType) * getTypeSize(property.type) : getTypeSize(property.type));
+    }
+
+private:
+    const uint8_t* mpCurrent;
+    const uint8_t* mpEnd;
+    bool mSwapBytes;
+};
+
+/// Decode the vertex element, which must have fixed size rows. Vertices are decoded in parallel.
+void readVertices(
+    PlyDataReader& reader,
+    const PlyElement& element,
+    bool swapBytes,
+    TriangleMesh::VertexList& vertices,
+    bool& hasNormals
+)
+{
+    if (element.hasLists())
+        FALCOR_THROW("List properties in 'vertex' element are not supported.");
+
+    std::vector<size_t> offsets(element.properties.size());
+    size_t stride = 0;
+    for (size_t i = 0; i < element.properties.size(); ++i)
+    {
+        offsets[i] = stride;
+        stride += getTypeSize(element.properties[i].type);
+    }
+
+    const int x = element.findProperty({"x"});
+    const int y = element.findProperty({"y"});
+    const int z = element.findProperty({"z"});
+    const int nx = element.findProperty({"nx"});
+    const int ny = element.findProperty({"ny"});
+    const int nz = element.findProperty({"nz"});
+    const int u = element.findProperty({"u", "s", "texture_u", "texture_s"});
+    const int v = element.findProperty({"v", "t", "texture_v", "texture_t"});
+
+    if (x < 0 || y < 0 || z < 0)
+        FALCOR_THROW("Vertex positions are missing.");
+    hasNormals = nx >= 0 && ny >= 0 && nz >= 0;
+    const bool hasTexCoords = u >= 0 && v >= 0;
+
+    const uint8_t* pData = reader.advance(stride * element.count);
+    vertices.resize(element.count);
+
+    auto loadFloat = [&](const uint8_t* pRow, int property)
+    { return PlyDataReader::load<float>(pRow + offsets[property], element.properties[property].type, swapBytes); };
+
+    Threading::parallelFor(
+        0,
+        element.count,
+        [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const uint8_t* pRow = pData + i * stride;
+                auto& vertex = vertices[i];
+                vertex.position = float3(loadFloat(pRow, x), loadFloat(pRow, y), loadFloat(pRow, z));
+                vertex.normal = hasNormals ? float3(loadFloat(pRow, nx), loadFloat(pRow, ny), loadFloat(pRow, nz)) : float3(0.f);
+                vertex.texCoord = hasTexCoords ? float2(loadFloat(pRow, u), 1.f - loadFloat(pRow, v)) : float2(0.f);
+            }
+        },
+        65536
+    );
+}
+
+/// Decode the face element and triangulate polygons as fans.
+void readFaces(PlyDataReader& reader, const PlyElement& element, size_t vertexCount, TriangleMesh::IndexList& indices)
+{
+    const int vertexIndices = element.findProperty({"vertex_indices", "vertex_index"});
+    if (vertexIndices < 0 || !element.properties[vertexIndices].isList)
+        FALCOR_THROW("Face vertex indices are missing.");
+
+    // Most files only have triangles and quads.
+    indices.reserve(element.count * 3);
+
+    std::vector<uint32_t> polygon;
+    for (size_t i = 0; i < element.count; ++i)
+    {
+        for (size_t p = 0; p < element.properties.size(); ++p)
+        {
+            const auto& property = element.properties[p];
+            if ((int)p != vertexIndices)
+            {
+                // Skip 'face_indices' and other per-face properties.
+                size_t count = property.isList ? reader.read<size_t>(property.countType) : 1;
+                reader.advance(count * getTypeSize(property.type));
+                continue;
+            }
+
+            const size_t count = reader.read<size_t>(property.countType);
+            polygon.resize(count);
+            for (size_t j = 0; j < count; ++j)
+            {
+                int64_t index = reader.read<int64_t>(property.type);
+                if (index < 0 || (size_t)index >= vertexCount)
+                    FALCOR_THROW("Vertex index {} of face {} is out of bounds.", index, i);
+                polygon[j] = (uint32_t)index;
+            }
+            for (size_t j = 2; j < count; ++j)
+            {
+                indices.push_back(polygon[0]);
+                indices.push_back(polygon[j - 1]);
+                indices.push_back(polygon[j]);
+            }
+        }
+    }
+}
+
+/// Un-index the mesh and assign facet normals to all triangle vertices.
+void generateFacetNormals(TriangleMesh::VertexList& vertices, TriangleMesh::IndexList& indices)
+{
+    TriangleMesh::VertexList facetVertices(indices.size());
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        const auto& v0 = vertices[indices[i]];
+        const auto& v1 = vertices[indices[i + 1]];
+        const auto& v2 = vertices[indices[i + 2]];
+        float3 normal = cross(v1.position - v0.position, v2.position - v0.position);
+        float len = length(normal);
+        normal = len > 0.f ? normal / len : float3(0.f, 0.f, 1.f);
+        facetVertices[i] = {v0.position, normal, v0.texCoord};
+        facetVertices[i + 1] = {v1.position, normal, v1.texCoord};
+        facetVertices[i + 2] = {v2.position, normal, v2.texCoord};
+    }
+    for (size_t i = 0; i < indices.size(); ++i)
+        indices[i] = (uint32_t)i;
+    vertices = std::move(facetVertices);
+}
+
+ref<TriangleMesh> loadBinaryPlyMesh(const MemoryMappedFile& file, const PlyHeader& header)
+{
+    FALCOR_ASSERT(!header.isAscii);
+    const uint8_t* pBegin = static_cast<const uint8_t*>(file.getData());
+    const uint8_t* pEnd = pBegin + file.getSize();
+
+    PlyDataReader reader(pBegin + header.dataOffset, pEnd, header.isBigEndian);
+
+    TriangleMesh::VertexList vertices;
+    TriangleMesh::IndexList indices;
+    bool hasVertices = false;
+    bool hasNormals = false;
+
+    for (const auto& element : header.elements)
+    {
+        if (element.name == "vertex")
+        {
+            readVertices(reader, element, header.isBigEndian, vertices, hasNormals);
+            hasVertices = true;
+        }
+        else if (element.name == "face")
+        {
+            if (!hasVertices)
+                FALCOR_THROW("Element 'face' before element 'vertex' is not supported.");
+            readFaces(reader, element, vertices.size(), indices);
+        }
+        else
+        {
+            reader.skipElement(element);
+        }
+    }
+
+    if (vertices.empty() || indices.empty())
+        FALCOR_THROW("Mesh has no triangles.");
+
+    if (!hasNormals)
+        generateFacetNormals(vertices, indices);
+
+    return TriangleMesh::create(vertices, indices);
+}
+
+} // namespace
+
+ref<TriangleMesh> loadPlyMesh(const std::filesystem::path& path)
+{
+    FALCOR_PROFILE_CPU("loadPlyMesh");
+
+    // Compressed files are left to the generic loader.
+    if (hasExtension(path, "gz"))
+        return TriangleMesh::createFromFile(path);
+
+    MemoryMappedFile file(path, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::SequentialScan);
+    if (!file.isOpen())
+    {
+        logWarning("Failed to load triangle mesh from '{}': Failed to open file", path);
+        return nullptr;
+    }
+
+    try
+    {
+        // Peek the format, ASCII files are left to the generic loader.
+        PlyHeader header = parseHeader(std::string_view(static_cast<const char*>(file.getData()), file.getSize()));
+        if (header.isAscii)
+        {
+            file.close();
+            return TriangleMesh::createFromFile(path);
+        }
+        return loadBinaryPlyMesh(file, header);
+    }
+    catch (const RuntimeError& e)
+    {
+        logWarning("Failed to load triangle mesh from '{}': {}", path, e.what());
+        return nullptr;
+    }
+}
+
+} // namespace Falcor::pbrt
@@ -0,0 +1,53 @@
+/***************************************************************************
+ # Copyright (c) 2015-22, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Object.h"
+#include "Scene/TriangleMesh.h"
+#include <filesystem>
+
+namespace Falcor::pbrt
+{
+
+/**
+ * Load a triangle mesh from a PLY file as referenced by the "plymesh" shape.
+ *
+ * Binary little and big endian files are decoded directly from a memory-mapped file into the triangle mesh.
+ * Vertex positions, normals and texture coordinates are read using the property names supported by pbrt.
+ * Faces with more than three vertices (quads) are triangulated as fans.
+ * The per-face 'face_indices' property is skipped, it is only used for Ptex lookups in pbrt.
+ * If the file has no normals, the mesh gets facet normals. Texture coordinates are flipped in v to match
+ * TriangleMesh::createFromFile(), which is used for ASCII and compressed files.
+ *
+ * This function is thread safe.
+ *
+ * @param[in] path File path.
+ * @return Returns the triangle mesh or nullptr if the mesh failed to load. A warning is logged on failure.
+ */
+ref<TriangleMesh> loadPlyMesh(const std::filesystem::path& path);
+
+} // namespace Falcor::pbrt
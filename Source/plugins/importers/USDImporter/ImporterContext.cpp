@@ -33,13 +33,12 @@
 #include "Scene/Material/HairMaterial.h"
 #include "Scene/Material/StandardMaterial.h"
 #include "Utils/Settings/Settings.h"
+#include "Utils/Threading.h"
 #include "USDUtils/USDHelpers.h"
 #include "USDUtils/USDUtils.h"
 #include "USDUtils/USDScene1Utils.h"
 #include "USDUtils/Tessellator/Tessellation.h"
 
-#include <tbb/parallel_for.h>
-
 BEGIN_DISABLE_USD_WARNINGS
 #include <pxr/usd/usd/primRange.h>
 #include <pxr/usd/usd/stage.h>
@@ -1085,12 +1084,12 @@ namespace Falcor
         void addMeshesToSceneBuilder(ImporterContext& ctx, TimeReport& timeReport)
         {
             // Process collected mesh tasks.
-            tbb::parallel_for<size_t>(0, ctx.meshTasks.size(),
+            Threading::parallelForEach(0, ctx.meshTasks.size(),
                 [&](size_t i)
                 {
                     FALCOR_ASSERT(ctx.meshTasks[i].sampleIdx == 0);
                     processMesh(ctx.meshes[ctx.meshTasks[i].meshId], ctx);
-                }
+                }, 1
             );
 
             // Add processed meshes to scene builder.
@@ -1120,12 +1119,12 @@ namespace Falcor
                 }
 
                 // Process time-sampled mesh keyframes
-                tbb::parallel_for<size_t>(0, ctx.meshKeyframeTasks.size(),
+                Threading::parallelForEach(0, ctx.meshKeyframeTasks.size(),
                     [&](size_t i)
                     {
                         auto& task = ctx.meshKeyframeTasks[i];
                         processMeshKeyframe(ctx.meshes[task.meshId], task.meshId, task.sampleIdx, ctx);
-                    }
+                    }, 1
                 );
 
                 for (auto& m : ctx.meshes)
@@ -1262,8 +1261,8 @@ namespace Falcor
         void addCurvesToSceneBuilder(ImporterContext& ctx, TimeReport& timeReport)
         {
             // Process collected curves.
-            tbb::parallel_for<size_t>(0, ctx.curves.size(),
-                [&](size_t i) { processCurve(ctx.curves[i], ctx); }
+            Threading::parallelForEach(0, ctx.curves.size(),
+                [&](size_t i) { processCurve(ctx.curves[i], ctx); }, 1
             );
 
             // Add processed curves or meshes (of the first keyframe) to scene builder.
@@ -1747,7 +1746,7 @@ namespace Falcor
                 break;
             }
 
-            tbb::parallel_for<size_t>(0, indexData.size(),
+            Threading::parallelForEach(0, indexData.size(),
                 [&](size_t j)
                 {
                     isSameTopology |= (indexData[j] == refIndexData[j]);